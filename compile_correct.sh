@@ -4,7 +4,7 @@ echo "Compiling with corrected include paths..."
 
 # Create list of all source files
 FILES=""
-for dir in src src/core src/algorithms src/visualization src/utils; do
+for dir in src src/core src/algorithms src/trace src/allocators src/visualization src/utils; do
     if [ -d "$dir" ]; then
         for file in "$dir"/*.c; do
             if [ -f "$file" ]; then
@@ -17,7 +17,7 @@ done
 
 echo ""
 echo "Compiling..."
-gcc -Wall -Wextra -Iinclude -o memory_visualizer $FILES
+gcc -Wall -Wextra -Iinclude -o memory_visualizer $FILES -lm -lpthread
 
 if [ $? -eq 0 ]; then
     echo "✅ Compilation successful!"
@@ -33,5 +33,5 @@ if [ $? -eq 0 ]; then
 else
     echo "❌ Compilation failed!"
     echo "Remaining errors:"
-    gcc -Wall -Wextra -Iinclude -o memory_visualizer $FILES 2>&1 | head -20
+    gcc -Wall -Wextra -Iinclude -o memory_visualizer $FILES -lm -lpthread 2>&1 | head -20
 fi
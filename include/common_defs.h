@@ -19,6 +19,7 @@ typedef struct {
     int reference_bit;
     bool dirty;
     bool is_free;
+    int ref_count;   // Page table entries mapping the frame (more than 1 after fork)
 } MemoryFrame;
 
 typedef struct {
@@ -29,6 +30,7 @@ typedef struct {
     bool referenced;
     bool modified;
     int protection;
+    bool cow;        // Shared copy-on-write; the first write copies the frame
 } PageTableEntry;
 
 typedef struct {
@@ -47,8 +49,17 @@ typedef struct {
     int page_faults;
     int memory_usage;
     int page_count;  // ADDED THIS
+    bool suspended;  // Swapped out by load control
 } Process;
 
+// One memory reference from a trace or a generated workload
+typedef struct {
+    unsigned long long address;    // Virtual address as seen by the source
+    unsigned long long timestamp;  // Source timestamp or sequence number
+    int pid;
+    bool is_write;
+} MemoryReference;
+
 typedef struct {
     int total_page_faults;
     int total_hits;
@@ -29,7 +29,7 @@ echo -e "${BLUE}Step 1: Checking project structure...${NC}"
 if [ ! -d "src" ]; then
     echo -e "${YELLOW}Warning: src/ directory not found${NC}"
     echo "Creating directory structure..."
-    mkdir -p src/{core,algorithms,visualization,utils}
+    mkdir -p src/{core,algorithms,trace,allocators,visualization,utils}
     mkdir -p include
 fi
 
@@ -69,9 +69,11 @@ gcc -Wall -Wextra -g -Iinclude -DLOG_COLORS \
     src/main.c \
     src/core/*.c \
     src/algorithms/*.c \
+    src/trace/*.c \
+    src/allocators/*.c \
     src/visualization/*.c \
     src/utils/*.c \
-    -o memory_visualizer
+    -o memory_visualizer -lm -lpthread
 
 # Check if compilation was successful
 if [ $? -eq 0 ]; then
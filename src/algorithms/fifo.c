@@ -34,27 +34,38 @@ void init_fifo() {
         }
     }
     
-    printf("FIFO algorithm initialized\n");
-    printf("Queue size: %d frames\n", fifo_queue.count);
+    VPRINTF("FIFO algorithm initialized\n");
+    VPRINTF("Queue size: %d frames\n", fifo_queue.count);
+}
+
+// Keep a migrated page's queue position: frames from and to trade places
+void fifo_migrate_frame(int from_frame, int to_frame) {
+    for(int i = 0; i < MAX_FRAMES; i++) {
+        if(fifo_queue.frames[i] == from_frame) {
+            fifo_queue.frames[i] = to_frame;
+        } else if(fifo_queue.frames[i] == to_frame) {
+            fifo_queue.frames[i] = from_frame;
+        }
+    }
 }
 
 // Replace a page using FIFO
 int fifo_replace_page() {
     if(fifo_queue.count == 0) {
-        printf("FIFO Error: Queue is empty\n");
+        VPRINTF("FIFO Error: Queue is empty\n");
         return -1;
     }
     
     // Get the front frame (oldest)
     int frame_to_replace = fifo_queue.frames[fifo_queue.front];
     
-    printf("\nFIFO Page Replacement:\n");
-    printf("=====================\n");
-    printf("Selected frame: %d (oldest in memory)\n", frame_to_replace);
-    printf("Page in frame: %d (Process %d)\n", 
-           physical_memory[frame_to_replace].page_number,
-           physical_memory[frame_to_replace].process_id);
-    printf("Loaded at time: %d\n", physical_memory[frame_to_replace].load_time);
+    VPRINTF("\nFIFO Page Replacement:\n");
+    VPRINTF("=====================\n");
+    VPRINTF("Selected frame: %d (oldest in memory)\n", frame_to_replace);
+    VPRINTF("Page in frame: %d (Process %d)\n", 
+            physical_memory[frame_to_replace].page_number,
+            physical_memory[frame_to_replace].process_id);
+    VPRINTF("Loaded at time: %d\n", physical_memory[frame_to_replace].load_time);
     
     // Remove from front
     fifo_queue.front = (fifo_queue.front + 1) % MAX_FRAMES;
@@ -13,5 +13,6 @@ int fifo_replace_page();
 void fifo_access_page(int pid, int page_number);
 void init_fifo();
 void display_fifo_queue();
+void fifo_migrate_frame(int from_frame, int to_frame);
 
 #endif // FIFO_H
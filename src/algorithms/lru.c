@@ -32,14 +32,14 @@ void init_lru() {
         }
     }
     
-    printf("LRU algorithm initialized\n");
-    printf("Stack size: %d frames\n", lru_stack.size);
+    VPRINTF("LRU algorithm initialized\n");
+    VPRINTF("Stack size: %d frames\n", lru_stack.size);
 }
 
 // Replace a page using LRU
 int lru_replace_page() {
     if(lru_stack.size == 0) {
-        printf("LRU Error: Stack is empty\n");
+        VPRINTF("LRU Error: Stack is empty\n");
         return -1;
     }
     
@@ -58,14 +58,14 @@ int lru_replace_page() {
     
     int frame_to_replace = lru_stack.frames[lru_index];
     
-    printf("\nLRU Page Replacement:\n");
-    printf("====================\n");
-    printf("Selected frame: %d (least recently used)\n", frame_to_replace);
-    printf("Page in frame: %d (Process %d)\n", 
-           physical_memory[frame_to_replace].page_number,
-           physical_memory[frame_to_replace].process_id);
-    printf("Last accessed at time: %d\n", min_time);
-    printf("Current time: %d\n", current_time);
+    VPRINTF("\nLRU Page Replacement:\n");
+    VPRINTF("====================\n");
+    VPRINTF("Selected frame: %d (least recently used)\n", frame_to_replace);
+    VPRINTF("Page in frame: %d (Process %d)\n", 
+            physical_memory[frame_to_replace].page_number,
+            physical_memory[frame_to_replace].process_id);
+    VPRINTF("Last accessed at time: %d\n", min_time);
+    VPRINTF("Current time: %d\n", current_time);
     
     // Move the replaced frame to the end (it will be reused)
     for(int i = lru_index; i < lru_stack.size - 1; i++) {
@@ -100,6 +100,17 @@ void update_lru(int frame_id) {
     }
 }
 
+// Keep a migrated page's recency: frames from and to trade places
+void lru_migrate_frame(int from_frame, int to_frame) {
+    for(int i = 0; i < lru_stack.size; i++) {
+        if(lru_stack.frames[i] == from_frame) {
+            lru_stack.frames[i] = to_frame;
+        } else if(lru_stack.frames[i] == to_frame) {
+            lru_stack.frames[i] = from_frame;
+        }
+    }
+}
+
 // Access a page using LRU
 void lru_access_page(int pid, int page_number) {
     printf("\nLRU Algorithm Processing:\n");
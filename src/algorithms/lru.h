@@ -14,5 +14,6 @@ void lru_access_page(int pid, int page_number);
 void update_lru(int frame_id);
 void init_lru();
 void display_lru_stack();
+void lru_migrate_frame(int from_frame, int to_frame);
 
 #endif // LRU_H
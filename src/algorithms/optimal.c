@@ -11,6 +11,7 @@
 #include "optimal.h"
 #include "../../include/common_defs.h"
 #include "../core/memory_manager.h"
+#include "../trace/workload.h"
 
 // Initialize Optimal algorithm
 void init_optimal() {
@@ -99,21 +100,21 @@ int* predict_future_references(int pid, int lookahead) {
     printf("Lookahead: %d references\n", lookahead);
     
     // Simple prediction: assume some locality of reference
-    srand(time(NULL));
+    WorkloadRng* rng = workload_global_rng();
     
     int current_page = 0;
     if(processes[pid].page_count > 0) {
         // Start with a random page from process
-        current_page = rand() % MAX_PAGES;
+        current_page = (int)workload_rng_bounded(rng, MAX_PAGES);
     }
     
     for(int i = 0; i < lookahead; i++) {
         // 80% chance to stay near current page, 20% chance to jump
-        if(rand() % 100 < 80) {
-            current_page = (current_page + (rand() % 3) - 1) % MAX_PAGES;
+        if(workload_rng_bounded(rng, 100) < 80) {
+            current_page = (current_page + (int)workload_rng_bounded(rng, 3) - 1) % MAX_PAGES;
             if(current_page < 0) current_page = 0;
         } else {
-            current_page = rand() % MAX_PAGES;
+            current_page = (int)workload_rng_bounded(rng, MAX_PAGES);
         }
         future_refs[i] = current_page;
         
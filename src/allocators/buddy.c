@@ -0,0 +1,345 @@
+/**
+ * buddy.c
+ * Binary buddy allocator implementation
+ *
+ * A block of order k covers 2^k frames starting at a multiple of 2^k; its
+ * buddy starts at frame ^ 2^k. Free blocks sit on a doubly linked list
+ * per order (threaded through next/prev by first frame) and are marked in
+ * that order's bitmap, so finding and unlinking a free buddy is O(1) and
+ * allocate/free cost O(max_order). The first frame of every allocated
+ * block records the block's order, so a free is checked against what was
+ * actually handed out in O(1) instead of scanning the block for free
+ * frames. Frame counts that are not a power of two are covered by the
+ * largest aligned blocks that fit; blocks whose buddy would run past the
+ * end simply never merge.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "buddy.h"
+#include "../trace/workload.h"
+
+static int test_bit(const uint64_t* map, int bit) {
+    return (map[bit >> 6] >> (bit & 63)) & 1;
+}
+
+static void set_bit(uint64_t* map, int bit) {
+    map[bit >> 6] |= 1ULL << (bit & 63);
+}
+
+static void clear_bit(uint64_t* map, int bit) {
+    map[bit >> 6] &= ~(1ULL << (bit & 63));
+}
+
+// ==================== FREE LISTS ====================
+
+static void push_block(BuddyAllocator* buddy, int frame, int order) {
+    int head = buddy->free_head[order];
+    buddy->next[frame] = head;
+    buddy->prev[frame] = -1;
+    if(head != -1) {
+        buddy->prev[head] = frame;
+    }
+    buddy->free_head[order] = frame;
+    set_bit(buddy->free_map[order], frame);
+    buddy->free_blocks[order]++;
+    buddy->free_frames += 1 << order;
+}
+
+static void unlink_block(BuddyAllocator* buddy, int frame, int order) {
+    int next = buddy->next[frame];
+    int prev = buddy->prev[frame];
+    if(prev != -1) {
+        buddy->next[prev] = next;
+    } else {
+        buddy->free_head[order] = next;
+    }
+    if(next != -1) {
+        buddy->prev[next] = prev;
+    }
+    clear_bit(buddy->free_map[order], frame);
+    buddy->free_blocks[order]--;
+    buddy->free_frames -= 1 << order;
+}
+
+// Order of the free block containing frame, -1 if the frame is in use
+static int containing_order(const BuddyAllocator* buddy, int frame) {
+    for(int order = 0; order <= buddy->max_order; order++) {
+        int head = frame & ~((1 << order) - 1);
+        if(test_bit(buddy->free_map[order], head)) {
+            return order;
+        }
+    }
+    return -1;
+}
+
+// ==================== ALLOCATOR ====================
+
+// Cover frames with the largest aligned free blocks
+int buddy_init(BuddyAllocator* buddy, int frames) {
+    memset(buddy, 0, sizeof(BuddyAllocator));
+    if(frames <= 0) {
+        printf("Error: Invalid frame count %d\n", frames);
+        return -1;
+    }
+
+    buddy->frames = frames;
+    while(buddy->max_order < BUDDY_MAX_ORDER && (2 << buddy->max_order) <= frames) {
+        buddy->max_order++;
+    }
+
+    int words = (frames + 63) / 64;
+    buddy->next = (int*)malloc(frames * sizeof(int));
+    buddy->prev = (int*)malloc(frames * sizeof(int));
+    buddy->alloc_order = (int8_t*)malloc(frames * sizeof(int8_t));
+    int failed = (buddy->next == NULL || buddy->prev == NULL || buddy->alloc_order == NULL);
+    for(int order = 0; order <= buddy->max_order; order++) {
+        buddy->free_head[order] = -1;
+        buddy->free_map[order] = (uint64_t*)calloc(words, sizeof(uint64_t));
+        failed |= (buddy->free_map[order] == NULL);
+    }
+    if(failed) {
+        printf("Error: Memory allocation failed\n");
+        buddy_destroy(buddy);
+        return -1;
+    }
+    memset(buddy->alloc_order, -1, frames * sizeof(int8_t));
+
+    int frame = 0;
+    while(frame < frames) {
+        int order = buddy->max_order;
+        while((frame & ((1 << order) - 1)) != 0 || frame + (1 << order) > frames) {
+            order--;
+        }
+        push_block(buddy, frame, order);
+        frame += 1 << order;
+    }
+    return 0;
+}
+
+// Release the allocator's tables
+void buddy_destroy(BuddyAllocator* buddy) {
+    free(buddy->next);
+    free(buddy->prev);
+    free(buddy->alloc_order);
+    for(int order = 0; order <= BUDDY_MAX_ORDER; order++) {
+        free(buddy->free_map[order]);
+    }
+    memset(buddy, 0, sizeof(BuddyAllocator));
+}
+
+static int first_order_with_space(const BuddyAllocator* buddy, int order) {
+    for(int k = order; k <= buddy->max_order; k++) {
+        if(buddy->free_head[k] != -1) {
+            return k;
+        }
+    }
+    return -1;
+}
+
+// Allocate 2^order contiguous frames, returns the first frame or -1
+int buddy_alloc(BuddyAllocator* buddy, int order) {
+    if(order < 0 || order > buddy->max_order) {
+        buddy->failures++;
+        return -1;
+    }
+
+    int k = first_order_with_space(buddy, order);
+    if(k == -1) {
+        buddy->failures++;
+        return -1;
+    }
+
+    int frame = buddy->free_head[k];
+    unlink_block(buddy, frame, k);
+
+    // Keep the lower half, return the upper half to the next list down
+    while(k > order) {
+        k--;
+        push_block(buddy, frame + (1 << k), k);
+        buddy->splits++;
+    }
+    buddy->alloc_order[frame] = (int8_t)order;
+    buddy->allocations++;
+    return frame;
+}
+
+// Frame buddy_alloc would return for this order, without allocating
+int buddy_peek(const BuddyAllocator* buddy, int order) {
+    if(order < 0 || order > buddy->max_order) {
+        return -1;
+    }
+    int k = first_order_with_space(buddy, order);
+    return (k == -1) ? -1 : buddy->free_head[k];
+}
+
+// Allocate one specific frame, splitting the free block around it
+int buddy_claim(BuddyAllocator* buddy, int frame) {
+    if(frame < 0 || frame >= buddy->frames) {
+        return -1;
+    }
+
+    int order = containing_order(buddy, frame);
+    if(order == -1) {
+        return -1;
+    }
+
+    int head = frame & ~((1 << order) - 1);
+    unlink_block(buddy, head, order);
+    while(order > 0) {
+        order--;
+        int half = 1 << order;
+        if(frame < head + half) {
+            push_block(buddy, head + half, order);
+        } else {
+            push_block(buddy, head, order);
+            head += half;
+        }
+        buddy->splits++;
+    }
+    buddy->alloc_order[frame] = 0;
+    buddy->allocations++;
+    return 0;
+}
+
+// Free a block, merging with its buddy for as long as the buddy is free
+int buddy_free(BuddyAllocator* buddy, int frame, int order) {
+    if(order < 0 || order > buddy->max_order || frame < 0 ||
+       frame + (1 << order) > buddy->frames || (frame & ((1 << order) - 1)) != 0) {
+        printf("Error: Invalid buddy block %d (order %d)\n", frame, order);
+        return -1;
+    }
+    if(buddy->alloc_order[frame] != order) {
+        if(containing_order(buddy, frame) != -1) {
+            printf("Error: Block %d (order %d) is already free\n", frame, order);
+        } else if(buddy->alloc_order[frame] == -1) {
+            printf("Error: Block %d (order %d) was not allocated\n", frame, order);
+        } else {
+            printf("Error: Block %d was allocated with order %d, not %d\n",
+                   frame, buddy->alloc_order[frame], order);
+        }
+        return -1;
+    }
+    buddy->alloc_order[frame] = -1;
+
+    while(order < buddy->max_order) {
+        int mate = frame ^ (1 << order);
+        if(mate + (1 << order) > buddy->frames || !test_bit(buddy->free_map[order], mate)) {
+            break;
+        }
+        unlink_block(buddy, mate, order);
+        frame &= mate;
+        order++;
+        buddy->merges++;
+    }
+    push_block(buddy, frame, order);
+    return 0;
+}
+
+// 1 if the frame is part of a free block
+int buddy_is_free(const BuddyAllocator* buddy, int frame) {
+    if(frame < 0 || frame >= buddy->frames) {
+        return 0;
+    }
+    return containing_order(buddy, frame) != -1;
+}
+
+// Share of free frames unusable for an order-sized request (0 = none)
+double buddy_unusable_index(const BuddyAllocator* buddy, int order) {
+    if(buddy->free_frames == 0) {
+        return 0.0;
+    }
+
+    long long usable = 0;
+    for(int k = order; k <= buddy->max_order; k++) {
+        usable += (long long)buddy->free_blocks[k] << k;
+    }
+    return (double)(buddy->free_frames - usable) / buddy->free_frames;
+}
+
+// ==================== REPORTS ====================
+
+// Free lists and unusable free space index per order
+void display_buddy_report(const BuddyAllocator* buddy) {
+    printf("\n==================== BUDDY ALLOCATOR ====================\n");
+    printf("Frames: %d, Free: %d (%.1f%%), Max order: %d\n",
+           buddy->frames, buddy->free_frames,
+           buddy->frames ? 100.0 * buddy->free_frames / buddy->frames : 0.0,
+           buddy->max_order);
+    printf("Allocations: %llu, Failed: %llu, Splits: %llu, Merges: %llu\n",
+           buddy->allocations, buddy->failures, buddy->splits, buddy->merges);
+
+    printf("\nOrder  Frames/block  Free blocks  Free frames  Unusable\n");
+    printf("-----  ------------  -----------  -----------  --------\n");
+    for(int order = 0; order <= buddy->max_order; order++) {
+        printf("%5d  %12d  %11d  %11d  %7.1f%%\n",
+               order, 1 << order, buddy->free_blocks[order],
+               buddy->free_blocks[order] << order,
+               100.0 * buddy_unusable_index(buddy, order));
+    }
+    printf("Unusable = free frames in blocks smaller than the order\n");
+    printf("=========================================================\n");
+}
+
+// Random allocate/free churn of mostly small orders, then report
+void run_buddy_benchmark(int frames, unsigned long long operations, uint64_t seed) {
+    BuddyAllocator buddy;
+    WorkloadRng rng;
+    int* live_frame;
+    int* live_order;
+    int live = 0;
+
+    if(buddy_init(&buddy, frames) != 0) {
+        return;
+    }
+    live_frame = (int*)malloc(frames * sizeof(int));
+    live_order = (int*)malloc(frames * sizeof(int));
+    if(live_frame == NULL || live_order == NULL) {
+        printf("Error: Memory allocation failed\n");
+        free(live_frame);
+        free(live_order);
+        buddy_destroy(&buddy);
+        return;
+    }
+    workload_rng_seed(&rng, seed);
+
+    struct timespec begin, end;
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+
+    for(unsigned long long op = 0; op < operations; op++) {
+        // Hover around three quarters full so larger orders start failing
+        double alloc_probability = (buddy.free_frames > frames / 4) ? 0.6 : 0.4;
+        if(live == 0 || workload_rng_double(&rng) < alloc_probability) {
+            int order = 0;
+            while(order < buddy.max_order && order < 10 && workload_rng_double(&rng) < 0.4) {
+                order++;
+            }
+            int frame = buddy_alloc(&buddy, order);
+            if(frame != -1) {
+                live_frame[live] = frame;
+                live_order[live] = order;
+                live++;
+            }
+        } else {
+            int victim = (int)workload_rng_bounded(&rng, (uint32_t)live);
+            buddy_free(&buddy, live_frame[victim], live_order[victim]);
+            live--;
+            live_frame[victim] = live_frame[live];
+            live_order[victim] = live_order[live];
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double seconds = (end.tv_sec - begin.tv_sec) + (end.tv_nsec - begin.tv_nsec) / 1e9;
+
+    printf("\nBuddy churn: %llu operations, seed %llu, %d live blocks, %.0f ns/op\n",
+           operations, (unsigned long long)seed, live,
+           operations ? seconds * 1e9 / operations : 0.0);
+    display_buddy_report(&buddy);
+
+    free(live_frame);
+    free(live_order);
+    buddy_destroy(&buddy);
+}
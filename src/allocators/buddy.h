@@ -0,0 +1,44 @@
+/**
+ * buddy.h
+ * Binary buddy allocator over a range of physical frames
+ */
+
+#ifndef BUDDY_H
+#define BUDDY_H
+
+#include <stdint.h>
+#include "../../include/common_defs.h"
+
+#define BUDDY_MAX_ORDER 20              // Largest block: 2^20 frames
+
+// Per-order free lists threaded through the frame index, plus one bitmap
+// per order marking which frames head a free block of that order
+typedef struct {
+    int frames;
+    int max_order;
+    int* next;
+    int* prev;
+    int8_t* alloc_order;                // Order of the allocated block a frame heads, -1 if none
+    uint64_t* free_map[BUDDY_MAX_ORDER + 1];
+    int free_head[BUDDY_MAX_ORDER + 1];
+    int free_blocks[BUDDY_MAX_ORDER + 1];
+    int free_frames;
+    unsigned long long allocations;
+    unsigned long long failures;
+    unsigned long long splits;
+    unsigned long long merges;
+} BuddyAllocator;
+
+// Function Prototypes
+int buddy_init(BuddyAllocator* buddy, int frames);
+void buddy_destroy(BuddyAllocator* buddy);
+int buddy_alloc(BuddyAllocator* buddy, int order);
+int buddy_free(BuddyAllocator* buddy, int frame, int order);
+int buddy_peek(const BuddyAllocator* buddy, int order);
+int buddy_claim(BuddyAllocator* buddy, int frame);
+int buddy_is_free(const BuddyAllocator* buddy, int frame);
+double buddy_unusable_index(const BuddyAllocator* buddy, int order);
+void display_buddy_report(const BuddyAllocator* buddy);
+void run_buddy_benchmark(int frames, unsigned long long operations, uint64_t seed);
+
+#endif // BUDDY_H
@@ -0,0 +1,611 @@
+/**
+ * heap_sim.c
+ * Heap allocator simulator implementation
+ *
+ * Blocks are laid out back to back from HEAP_SIM_BASE. Each block has a
+ * header tag (size + allocated bit) and free blocks also carry a footer,
+ * so freeing coalesces with both neighbours in O(1) exactly like a
+ * boundary-tag allocator. The tags live in hash tables keyed by address
+ * rather than in simulated memory. Free blocks are indexed according to
+ * the strategy: an address-ordered tree for first/next fit, a
+ * (size, address) tree for best/worst fit, or 64 size-class bins plus a
+ * non-empty bitmap for segregated fit. Every index is O(log n), so traces
+ * with millions of live blocks replay in seconds.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "heap_sim.h"
+#include "../trace/workload.h"
+#include "../shim/heap_shim.h"
+#include "../trace/heap_events.h"
+
+#define HEAP_PAGE 4096ULL
+#define HEAP_ALLOCATED 1ULL
+
+static const char* strategy_names[FIT_COUNT] = {
+    "first", "next", "best", "worst", "segregated"
+};
+
+// Name of a placement strategy
+const char* fit_strategy_name(FitStrategy strategy) {
+    return ((unsigned)strategy < FIT_COUNT) ? strategy_names[strategy] : "unknown";
+}
+
+static uint64_t align_up(uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+// Block size holding a request, including the header tag
+static uint64_t block_size_for(uint64_t request) {
+    uint64_t size = align_up(request + HEAP_TAG_SIZE, HEAP_ALIGNMENT);
+    return size < HEAP_MIN_BLOCK ? HEAP_MIN_BLOCK : size;
+}
+
+static int bin_index(uint64_t size) {
+    if(size < HEAP_MIN_BLOCK + HEAP_SMALL_BINS * HEAP_ALIGNMENT) {
+        return (int)((size - HEAP_MIN_BLOCK) / HEAP_ALIGNMENT);
+    }
+    int bin = HEAP_SMALL_BINS + (63 - __builtin_clzll(size)) - 9;
+    return bin < HEAP_BINS ? bin : HEAP_BINS - 1;
+}
+
+// ==================== FREE BLOCK INDEX ====================
+
+static void index_insert(HeapSim* sim, uint64_t address, uint64_t size) {
+    switch(sim->strategy) {
+        case FIT_FIRST:
+        case FIT_NEXT:
+            extent_tree_insert(&sim->by_address, address, 0, size);
+            break;
+        case FIT_BEST:
+        case FIT_WORST:
+            extent_tree_insert(&sim->by_size, size, address, size);
+            break;
+        default: {
+            int bin = bin_index(size);
+            extent_tree_insert(&sim->bins[bin], size, address, size);
+            sim->bin_map |= 1ULL << bin;
+            break;
+        }
+    }
+    sim->stats.free_blocks++;
+    sim->stats.free_bytes += size;
+}
+
+static void index_remove(HeapSim* sim, uint64_t address, uint64_t size) {
+    switch(sim->strategy) {
+        case FIT_FIRST:
+        case FIT_NEXT:
+            extent_tree_remove(&sim->by_address, address, 0);
+            break;
+        case FIT_BEST:
+        case FIT_WORST:
+            extent_tree_remove(&sim->by_size, size, address);
+            break;
+        default: {
+            int bin = bin_index(size);
+            extent_tree_remove(&sim->bins[bin], size, address);
+            if(sim->bins[bin].count == 0) {
+                sim->bin_map &= ~(1ULL << bin);
+            }
+            break;
+        }
+    }
+    sim->stats.free_blocks--;
+    sim->stats.free_bytes -= size;
+}
+
+// Free block chosen for a request, 0 when none fits
+static uint64_t index_find(HeapSim* sim, uint64_t size) {
+    ExtentNode* node = NULL;
+    ExtentTree* tree = &sim->by_address;
+
+    switch(sim->strategy) {
+        case FIT_FIRST:
+            node = extent_tree_first_fit(tree, size);
+            break;
+        case FIT_NEXT:
+            node = extent_tree_first_fit_from(tree, sim->rover, size);
+            if(node == NULL) {
+                node = extent_tree_first_fit(tree, size);
+            }
+            break;
+        case FIT_BEST:
+            tree = &sim->by_size;
+            node = extent_tree_lower_bound(tree, size, 0);
+            break;
+        case FIT_WORST:
+            tree = &sim->by_size;
+            node = extent_tree_max(tree);
+            if(node != NULL && node->length < size) {
+                node = NULL;
+            }
+            break;
+        default: {
+            int bin = bin_index(size);
+            tree = &sim->bins[bin];
+            node = extent_tree_lower_bound(tree, size, 0);
+            if(node == NULL) {
+                // Any block of a higher class fits: take its smallest
+                uint64_t higher = (bin + 1 < HEAP_BINS) ? sim->bin_map >> (bin + 1) << (bin + 1) : 0;
+                sim->stats.search_steps += tree->visits + 1;
+                tree->visits = 0;
+                if(higher != 0) {
+                    tree = &sim->bins[__builtin_ctzll(higher)];
+                    node = extent_tree_min(tree);
+                }
+            }
+            break;
+        }
+    }
+
+    sim->stats.search_steps += tree->visits;
+    tree->visits = 0;
+    if(node == NULL) {
+        return 0;
+    }
+    return (sim->strategy == FIT_FIRST || sim->strategy == FIT_NEXT) ? node->key : node->tie;
+}
+
+// Largest free block; not charged as search cost
+uint64_t heap_sim_largest_free(HeapSim* sim) {
+    ExtentTree* tree;
+    switch(sim->strategy) {
+        case FIT_FIRST:
+        case FIT_NEXT:
+            return sim->by_address.root ? sim->by_address.root->max_length : 0;
+        case FIT_BEST:
+        case FIT_WORST:
+            tree = &sim->by_size;
+            break;
+        default:
+            if(sim->bin_map == 0) {
+                return 0;
+            }
+            tree = &sim->bins[63 - __builtin_clzll(sim->bin_map)];
+            break;
+    }
+
+    uint64_t visits = tree->visits;
+    ExtentNode* node = extent_tree_max(tree);
+    tree->visits = visits;
+    return node ? node->length : 0;
+}
+
+// ==================== BLOCKS ====================
+
+// Empty heap using one placement strategy
+void heap_sim_init(HeapSim* sim, FitStrategy strategy) {
+    memset(sim, 0, sizeof(HeapSim));
+    sim->strategy = strategy;
+    sim->top = HEAP_SIM_BASE;
+    sim->rover = HEAP_SIM_BASE;
+    address_table_init(&sim->tags);
+    address_table_init(&sim->footers);
+    address_table_init(&sim->requested);
+    extent_tree_init(&sim->by_address);
+    extent_tree_init(&sim->by_size);
+    for(int bin = 0; bin < HEAP_BINS; bin++) {
+        extent_tree_init(&sim->bins[bin]);
+    }
+}
+
+// Release everything the simulator holds
+void heap_sim_free(HeapSim* sim) {
+    address_table_free(&sim->tags);
+    address_table_free(&sim->footers);
+    address_table_free(&sim->requested);
+    extent_tree_free(&sim->by_address);
+    extent_tree_free(&sim->by_size);
+    for(int bin = 0; bin < HEAP_BINS; bin++) {
+        extent_tree_free(&sim->bins[bin]);
+    }
+}
+
+static void add_free_block(HeapSim* sim, uint64_t address, uint64_t size) {
+    address_table_put(&sim->tags, address, size);
+    address_table_put(&sim->footers, address + size, address);
+    index_insert(sim, address, size);
+}
+
+static void remove_free_block(HeapSim* sim, uint64_t address, uint64_t size) {
+    index_remove(sim, address, size);
+    address_table_take(&sim->footers, address + size, NULL);
+}
+
+// Grow the heap by whole pages so a free block of at least size ends at top
+static uint64_t extend_heap(HeapSim* sim, uint64_t size) {
+    uint64_t start = sim->top;
+    uint64_t tail_size = 0;
+    uint64_t tail;
+
+    // A free block at the top only needs the difference
+    if(address_table_get(&sim->footers, sim->top, &tail)) {
+        address_table_get(&sim->tags, tail, &tail_size);
+        remove_free_block(sim, tail, tail_size);
+        start = tail;
+    }
+
+    uint64_t grow = align_up(size - tail_size, HEAP_PAGE);
+    if(sim->top + grow > HEAP_SIM_LIMIT) {
+        if(tail_size > 0) {
+            add_free_block(sim, start, tail_size);
+        }
+        return 0;
+    }
+
+    sim->top += grow;
+    sim->stats.extends++;
+    sim->stats.heap_size = sim->top - HEAP_SIM_BASE;
+    if(sim->stats.heap_size > sim->stats.peak_heap) {
+        sim->stats.peak_heap = sim->stats.heap_size;
+    }
+    add_free_block(sim, start, sim->top - start);
+    return start;
+}
+
+// Give a large free tail back, keeping the heap page aligned
+static void trim_heap(HeapSim* sim, uint64_t address, uint64_t size) {
+    if(address + size != sim->top || size < HEAP_TRIM_THRESHOLD) {
+        return;
+    }
+
+    uint64_t keep_end = (address % HEAP_PAGE == 0) ? address :
+                        align_up(address + HEAP_MIN_BLOCK, HEAP_PAGE);
+    remove_free_block(sim, address, size);
+    address_table_take(&sim->tags, address, NULL);
+    if(keep_end > address) {
+        add_free_block(sim, address, keep_end - address);
+    }
+    sim->top = keep_end;
+    sim->stats.trims++;
+    sim->stats.heap_size = sim->top - HEAP_SIM_BASE;
+}
+
+static void sample_fragmentation(HeapSim* sim) {
+    unsigned long long ops = sim->stats.allocs + sim->stats.frees;
+    if(ops % HEAP_FRAG_SAMPLE == 0) {
+        sim->stats.external_sum += heap_sim_external_fragmentation(sim);
+        sim->stats.external_samples++;
+    }
+}
+
+// Allocate a block for size bytes, returns the payload address or 0
+uint64_t heap_sim_malloc(HeapSim* sim, uint64_t size) {
+    uint64_t need = block_size_for(size);
+    uint64_t address = index_find(sim, need);
+    if(address == 0) {
+        address = extend_heap(sim, need);
+        if(address == 0) {
+            sim->stats.failed++;
+            return 0;
+        }
+    }
+
+    uint64_t block;
+    address_table_get(&sim->tags, address, &block);
+    remove_free_block(sim, address, block);
+
+    // Split off the remainder when it can stand as a block of its own
+    if(block - need >= HEAP_MIN_BLOCK) {
+        add_free_block(sim, address + need, block - need);
+        sim->stats.splits++;
+        block = need;
+    }
+    address_table_put(&sim->tags, address, block | HEAP_ALLOCATED);
+    address_table_put(&sim->requested, address, size);
+    sim->rover = address + block;
+
+    sim->stats.allocs++;
+    sim->stats.live_blocks++;
+    sim->stats.live_bytes += block;
+    sim->stats.live_requested += size;
+    if(sim->stats.live_requested > sim->stats.peak_requested) {
+        sim->stats.peak_requested = sim->stats.live_requested;
+    }
+    sample_fragmentation(sim);
+    return address + HEAP_TAG_SIZE;
+}
+
+// Free a payload address, coalescing with free neighbours
+int heap_sim_release(HeapSim* sim, uint64_t address) {
+    uint64_t start = address - HEAP_TAG_SIZE;
+    uint64_t tag, requested;
+
+    if(address < HEAP_SIM_BASE + HEAP_TAG_SIZE || !address_table_get(&sim->tags, start, &tag) ||
+       !(tag & HEAP_ALLOCATED)) {
+        sim->stats.bad_frees++;
+        return -1;
+    }
+    address_table_take(&sim->requested, start, &requested);
+
+    uint64_t size = tag & ~HEAP_ALLOCATED;
+    sim->stats.frees++;
+    sim->stats.live_blocks--;
+    sim->stats.live_bytes -= size;
+    sim->stats.live_requested -= requested;
+
+    // Following block: its header sits right after ours
+    uint64_t next_tag;
+    if(address_table_get(&sim->tags, start + size, &next_tag) && !(next_tag & HEAP_ALLOCATED)) {
+        remove_free_block(sim, start + size, next_tag);
+        address_table_take(&sim->tags, start + size, NULL);
+        size += next_tag;
+        sim->stats.coalesces++;
+    }
+
+    // Preceding block: a footer ends where we start
+    uint64_t previous;
+    if(address_table_get(&sim->footers, start, &previous)) {
+        uint64_t previous_size;
+        address_table_get(&sim->tags, previous, &previous_size);
+        remove_free_block(sim, previous, previous_size);
+        address_table_take(&sim->tags, start, NULL);
+        start = previous;
+        size += previous_size;
+        sim->stats.coalesces++;
+    }
+
+    add_free_block(sim, start, size);
+    trim_heap(sim, start, size);
+    sample_fragmentation(sim);
+    return 0;
+}
+
+// 1 - largest free block / free bytes: 0 when all free memory is one block
+double heap_sim_external_fragmentation(HeapSim* sim) {
+    if(sim->stats.free_bytes == 0) {
+        return 0.0;
+    }
+    return 1.0 - (double)heap_sim_largest_free(sim) / sim->stats.free_bytes;
+}
+
+// Share of allocated block bytes not asked for (tags, alignment, split slack)
+double heap_sim_internal_fragmentation(const HeapSim* sim) {
+    if(sim->stats.live_bytes == 0) {
+        return 0.0;
+    }
+    return 1.0 - (double)sim->stats.live_requested / sim->stats.live_bytes;
+}
+
+// ==================== TRACES ====================
+
+// Add one operation to a trace
+int heap_trace_append(HeapTrace* trace, uint32_t id, uint32_t size, uint32_t thread) {
+    if(trace->count == trace->capacity) {
+        uint64_t capacity = trace->capacity ? trace->capacity * 2 : 65536;
+        HeapOp* ops = (HeapOp*)realloc(trace->ops, capacity * sizeof(HeapOp));
+        if(ops == NULL) {
+            printf("Error: Memory allocation failed\n");
+            return -1;
+        }
+        trace->ops = ops;
+        trace->capacity = capacity;
+    }
+    trace->ops[trace->count].id = id;
+    trace->ops[trace->count].size = size;
+    trace->ops[trace->count].thread = thread;
+    if(thread >= trace->threads) {
+        trace->threads = thread + 1;
+    }
+    trace->count++;
+    return 0;
+}
+
+// Release a trace
+void heap_trace_free(HeapTrace* trace) {
+    free(trace->ops);
+    memset(trace, 0, sizeof(HeapTrace));
+}
+
+// Seeded trace that grows the live set for the first half, then shrinks it
+int heap_trace_synthetic(HeapTrace* trace, uint64_t operations, uint64_t seed) {
+    WorkloadRng rng;
+    uint32_t* live = (uint32_t*)malloc(operations * sizeof(uint32_t) + sizeof(uint32_t));
+    uint64_t live_count = 0;
+
+    memset(trace, 0, sizeof(HeapTrace));
+    if(live == NULL || operations > UINT32_MAX) {
+        printf("Error: Memory allocation failed\n");
+        free(live);
+        return -1;
+    }
+    workload_rng_seed(&rng, seed);
+
+    for(uint64_t op = 0; op < operations; op++) {
+        double alloc_probability = (op < operations / 2) ? 0.6 : 0.45;
+        int status;
+
+        if(live_count == 0 || workload_rng_double(&rng) < alloc_probability) {
+            // Mostly small objects, some buffers, a few large arrays
+            double kind = workload_rng_double(&rng);
+            uint32_t size;
+            if(kind < 0.70) {
+                size = 8 + workload_rng_bounded(&rng, 248);
+            } else if(kind < 0.95) {
+                size = 256 + workload_rng_bounded(&rng, 3840);
+            } else {
+                size = 4096 + workload_rng_bounded(&rng, 61440);
+            }
+            live[live_count++] = trace->ids;
+            status = heap_trace_append(trace, trace->ids++, size, 0);
+        } else {
+            uint64_t victim = workload_rng_bounded(&rng, (uint32_t)live_count);
+            status = heap_trace_append(trace, live[victim], 0, 0);
+            live[victim] = live[--live_count];
+        }
+        if(status != 0) {
+            free(live);
+            heap_trace_free(trace);
+            return -1;
+        }
+    }
+
+    free(live);
+    return 0;
+}
+
+// Conversion state while reading an event stream
+typedef struct {
+    HeapTrace* trace;
+    AddressTable ids;                   // Live address -> block id + 1
+    AddressTable threads;               // Kernel thread id + 1 -> dense index
+} EventConversion;
+
+// Turn one event into trace operations, as a heap_events_read sink
+static int event_to_ops(const HeapEvent* event, void* context) {
+    EventConversion* conversion = (EventConversion*)context;
+    HeapTrace* trace = conversion->trace;
+    uint64_t id;
+    uint64_t thread;
+
+    if(event->type == HEAP_EVENT_DROPPED) {
+        trace->dropped += event->size;
+        return 0;
+    }
+    if(!address_table_get(&conversion->threads, (uint64_t)event->thread + 1, &thread)) {
+        thread = conversion->threads.count;
+        address_table_put(&conversion->threads, (uint64_t)event->thread + 1, thread);
+    }
+
+    // realloc is modelled as free + malloc, as a moving realloc would do
+    if(event->type == HEAP_EVENT_FREE || event->type == HEAP_EVENT_REALLOC) {
+        uint64_t old = (event->type == HEAP_EVENT_FREE) ? event->address : event->old_address;
+        if(old != 0 && address_table_take(&conversion->ids, old, &id)) {
+            if(heap_trace_append(trace, (uint32_t)(id - 1), 0, (uint32_t)thread) != 0) return -1;
+        }
+    }
+    if(event->type == HEAP_EVENT_MALLOC || event->type == HEAP_EVENT_CALLOC ||
+       event->type == HEAP_EVENT_MEMALIGN || event->type == HEAP_EVENT_REALLOC) {
+        if(event->address == 0) {
+            return 0;
+        }
+        uint32_t size = event->size > UINT32_MAX ? UINT32_MAX : (uint32_t)event->size;
+        address_table_put(&conversion->ids, event->address, (uint64_t)trace->ids + 1);
+        if(heap_trace_append(trace, trace->ids++, size ? size : 1, (uint32_t)thread) != 0) return -1;
+    }
+    return 0;
+}
+
+// Allocation trace from a heap event file recorded by the shim, read in
+// sequence order so cross-thread frees follow their allocations
+int heap_trace_from_events(HeapTrace* trace, const char* path) {
+    FILE* file = fopen(path, "rb");
+    HeapEventHeader header;
+    EventConversion conversion;
+
+    memset(trace, 0, sizeof(HeapTrace));
+    if(file == NULL) {
+        printf("Error: Could not open heap events '%s'\n", path);
+        return -1;
+    }
+    if(heap_events_read_header(fileno(file), path, &header) != 0) {
+        fclose(file);
+        return -1;
+    }
+
+    conversion.trace = trace;
+    address_table_init(&conversion.ids);
+    address_table_init(&conversion.threads);
+    int status = heap_events_read(fileno(file), event_to_ops, &conversion);
+
+    address_table_free(&conversion.ids);
+    address_table_free(&conversion.threads);
+    fclose(file);
+    if(status != 0) {
+        heap_trace_free(trace);
+    }
+    return status;
+}
+
+// Run a trace through a simulator, timing the whole replay
+int heap_sim_replay(HeapSim* sim, const HeapTrace* trace) {
+    uint64_t* payloads = (uint64_t*)calloc(trace->ids + 1, sizeof(uint64_t));
+    if(payloads == NULL) {
+        printf("Error: Memory allocation failed\n");
+        return -1;
+    }
+
+    struct timespec begin, end;
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+
+    for(uint64_t i = 0; i < trace->count; i++) {
+        const HeapOp* op = &trace->ops[i];
+        if(op->size != 0) {
+            payloads[op->id] = heap_sim_malloc(sim, op->size);
+        } else if(payloads[op->id] != 0) {
+            heap_sim_release(sim, payloads[op->id]);
+            payloads[op->id] = 0;
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    sim->stats.elapsed_ns += (uint64_t)(end.tv_sec - begin.tv_sec) * 1000000000ULL +
+                             (uint64_t)(end.tv_nsec - begin.tv_nsec);
+    free(payloads);
+    return 0;
+}
+
+// Replay one trace under every strategy and tabulate the outcome
+int run_heap_sim_comparison(const HeapTrace* trace) {
+    uint64_t peak_live = 0;
+    uint64_t live = 0;
+    for(uint64_t i = 0; i < trace->count; i++) {
+        live += trace->ops[i].size ? 1 : 0;
+        live -= trace->ops[i].size ? 0 : 1;
+        if(live > peak_live) peak_live = live;
+    }
+
+    printf("\n============================= HEAP ALLOCATOR SIMULATION =============================\n");
+    printf("Operations: %llu, Blocks: %u, Peak live blocks: %llu\n",
+           (unsigned long long)trace->count, trace->ids, (unsigned long long)peak_live);
+    if(trace->dropped > 0) {
+        printf("Dropped by the shim: %llu events; their blocks are missing or never freed\n",
+               (unsigned long long)trace->dropped);
+    }
+    printf("\nStrategy    Peak heap   Peak req.   Util.  Int.frag  Ext.frag  Ext.end  Steps/op  ns/op\n");
+    printf("----------  ----------  ----------  -----  --------  --------  -------  --------  -----\n");
+
+    for(int strategy = 0; strategy < FIT_COUNT; strategy++) {
+        HeapSim* sim = (HeapSim*)malloc(sizeof(HeapSim));
+        if(sim == NULL) {
+            printf("Error: Memory allocation failed\n");
+            return -1;
+        }
+        heap_sim_init(sim, (FitStrategy)strategy);
+        if(heap_sim_replay(sim, trace) != 0) {
+            heap_sim_free(sim);
+            free(sim);
+            return -1;
+        }
+
+        HeapSimStats* s = &sim->stats;
+        unsigned long long ops = s->allocs + s->frees;
+        printf("%-10s  %9lluK  %9lluK  %4.0f%%  %7.1f%%  %7.1f%%  %6.1f%%  %8.1f  %5.0f\n",
+               fit_strategy_name((FitStrategy)strategy),
+               (unsigned long long)(s->peak_heap / 1024),
+               (unsigned long long)(s->peak_requested / 1024),
+               s->peak_heap ? 100.0 * s->peak_requested / s->peak_heap : 0.0,
+               100.0 * heap_sim_internal_fragmentation(sim),
+               s->external_samples ? 100.0 * s->external_sum / s->external_samples : 0.0,
+               100.0 * heap_sim_external_fragmentation(sim),
+               ops ? (double)s->search_steps / ops : 0.0,
+               ops ? (double)s->elapsed_ns / ops : 0.0);
+        if(s->failed > 0 || s->bad_frees > 0) {
+            printf("            (%llu failed allocations, %llu invalid frees)\n",
+                   s->failed, s->bad_frees);
+        }
+
+        heap_sim_free(sim);
+        free(sim);
+    }
+
+    printf("\nUtil. = peak requested / peak heap; Int.frag = live block bytes not requested;\n");
+    printf("Ext.frag = 1 - largest free / free bytes, averaged every %d ops (Ext.end: at end)\n",
+           HEAP_FRAG_SAMPLE);
+    printf("=====================================================================================\n");
+    return 0;
+}
@@ -0,0 +1,105 @@
+/**
+ * heap_sim.h
+ * Heap allocator simulator with pluggable placement strategies
+ */
+
+#ifndef HEAP_SIM_H
+#define HEAP_SIM_H
+
+#include <stdint.h>
+#include "../../include/common_defs.h"
+#include "../utils/address_table.h"
+#include "../utils/extent_tree.h"
+
+#define HEAP_SIM_BASE 0x10000ULL        // Address of the first block
+#define HEAP_SIM_LIMIT (1ULL << 40)     // Largest heap the simulator will grow to
+#define HEAP_TAG_SIZE 8                 // Header, and footer while the block is free
+#define HEAP_ALIGNMENT 16
+#define HEAP_MIN_BLOCK 32
+#define HEAP_TRIM_THRESHOLD (128 * 1024) // Free tail returned to the system
+#define HEAP_SMALL_BINS 30              // Exact bins for 32..496 bytes
+#define HEAP_BINS 64                    // Then one bin per power of two
+#define HEAP_FRAG_SAMPLE 1024           // Operations between fragmentation samples
+
+// Where a request is placed among the free blocks
+typedef enum {
+    FIT_FIRST,          // Lowest address that fits
+    FIT_NEXT,           // First fit resuming after the last placement
+    FIT_BEST,           // Smallest block that fits
+    FIT_WORST,          // Largest free block
+    FIT_SEGREGATED,     // Size-class bins, best fit within the first usable bin
+    FIT_COUNT
+} FitStrategy;
+
+// One trace operation: size 0 frees block id, anything else allocates it
+typedef struct {
+    uint32_t id;
+    uint32_t size;
+    uint32_t thread;                    // Dense index of the issuing thread
+} HeapOp;
+
+// Allocation trace, independent of the addresses of the recording program
+typedef struct {
+    HeapOp* ops;
+    uint64_t count;
+    uint64_t capacity;
+    uint32_t ids;
+    uint32_t threads;
+    uint64_t dropped;                   // Events the recording shim lost
+} HeapTrace;
+
+typedef struct {
+    unsigned long long allocs;
+    unsigned long long frees;
+    unsigned long long failed;          // Heap limit reached
+    unsigned long long bad_frees;       // Not a live block
+    unsigned long long splits;
+    unsigned long long coalesces;
+    unsigned long long extends;
+    unsigned long long trims;
+    unsigned long long search_steps;    // Index nodes examined to place requests
+    uint64_t live_blocks;
+    uint64_t live_requested;            // Bytes the program asked for
+    uint64_t live_bytes;                // Bytes of the blocks that hold them
+    uint64_t free_blocks;
+    uint64_t free_bytes;
+    uint64_t heap_size;
+    uint64_t peak_heap;
+    uint64_t peak_requested;
+    double external_sum;
+    unsigned long long external_samples;
+    uint64_t elapsed_ns;
+} HeapSimStats;
+
+typedef struct {
+    FitStrategy strategy;
+    uint64_t top;                       // End of the heap
+    uint64_t rover;                     // Next fit resume address
+    AddressTable tags;                  // Block start -> size | allocated bit
+    AddressTable footers;               // Free block end -> start
+    AddressTable requested;             // Allocated block start -> requested size
+    ExtentTree by_address;              // FIRST/NEXT: address -> size
+    ExtentTree by_size;                 // BEST/WORST: (size, address)
+    ExtentTree bins[HEAP_BINS];         // SEGREGATED: (size, address) per class
+    uint64_t bin_map;                   // Non-empty bins
+    HeapSimStats stats;
+} HeapSim;
+
+// Function Prototypes
+void heap_sim_init(HeapSim* sim, FitStrategy strategy);
+void heap_sim_free(HeapSim* sim);
+uint64_t heap_sim_malloc(HeapSim* sim, uint64_t size);
+int heap_sim_release(HeapSim* sim, uint64_t address);
+uint64_t heap_sim_largest_free(HeapSim* sim);
+double heap_sim_external_fragmentation(HeapSim* sim);
+double heap_sim_internal_fragmentation(const HeapSim* sim);
+const char* fit_strategy_name(FitStrategy strategy);
+
+int heap_trace_append(HeapTrace* trace, uint32_t id, uint32_t size, uint32_t thread);
+int heap_trace_synthetic(HeapTrace* trace, uint64_t operations, uint64_t seed);
+int heap_trace_from_events(HeapTrace* trace, const char* path);
+void heap_trace_free(HeapTrace* trace);
+int heap_sim_replay(HeapSim* sim, const HeapTrace* trace);
+int run_heap_sim_comparison(const HeapTrace* trace);
+
+#endif // HEAP_SIM_H
@@ -0,0 +1,54 @@
+/**
+ * segment_alloc.h
+ * Segment placement over a physical range with overlap and reverse lookup
+ */
+
+#ifndef SEGMENT_ALLOC_H
+#define SEGMENT_ALLOC_H
+
+#include <stdint.h>
+#include "../../include/common_defs.h"
+#include "../utils/extent_tree.h"
+#include "heap_sim.h"
+
+// Owner tag stored with every placed segment
+#define SEGMENT_OWNER(pid, segment) (((uint64_t)(uint32_t)(pid) << 32) | (uint32_t)(segment))
+#define SEGMENT_OWNER_PID(owner) ((int)((owner) >> 32))
+#define SEGMENT_OWNER_ID(owner) ((int)((owner) & 0xFFFFFFFFu))
+
+typedef struct {
+    unsigned long long placements;
+    unsigned long long reservations;
+    unsigned long long releases;
+    unsigned long long failed;          // No free extent large enough
+    unsigned long long overlaps;        // Fixed placements that hit a used extent
+    unsigned long long lookups;
+    uint64_t search_steps;              // Tree nodes examined by placements
+} SegmentAllocStats;
+
+// Free extents indexed by address (max-length augmented) and by
+// (length, address); used extents by (base, owner) for reverse lookup
+typedef struct {
+    uint64_t space;
+    FitStrategy strategy;               // First, next, best or worst fit
+    ExtentTree free_by_address;
+    ExtentTree free_by_size;
+    ExtentTree used;
+    uint64_t rover;                     // Next fit resumes here
+    uint64_t free_bytes;
+    SegmentAllocStats stats;
+} SegmentAllocator;
+
+// Function Prototypes
+int segment_alloc_init(SegmentAllocator* alloc, uint64_t space, FitStrategy strategy);
+void segment_alloc_destroy(SegmentAllocator* alloc);
+int64_t segment_alloc_place(SegmentAllocator* alloc, uint64_t owner, uint64_t limit);
+int segment_alloc_reserve(SegmentAllocator* alloc, uint64_t owner, uint64_t base, uint64_t limit);
+int segment_alloc_release(SegmentAllocator* alloc, uint64_t base);
+int segment_alloc_overlap(SegmentAllocator* alloc, uint64_t base, uint64_t limit, uint64_t* owner);
+int segment_alloc_lookup(SegmentAllocator* alloc, uint64_t physical,
+                         uint64_t* owner, uint64_t* base);
+uint64_t segment_alloc_largest_free(const SegmentAllocator* alloc);
+void run_segment_benchmark(int segments, unsigned long long operations, uint64_t seed);
+
+#endif // SEGMENT_ALLOC_H
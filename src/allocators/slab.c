@@ -0,0 +1,695 @@
+/**
+ * slab.c
+ * Slab object cache model implementation
+ *
+ * Three layers, as in Bonwick's magazine allocator: each CPU keeps a
+ * loaded and a previous magazine per cache and serves most operations
+ * from them without locking; a per-cache depot trades full and empty
+ * magazines under the depot lock; the slab layer carves 2^order frames
+ * from a buddy allocator into objects under the cache lock. Time is
+ * simulated per CPU: every operation adds its cost to the issuing CPU's
+ * clock, and a lock taken before its holder's release time stalls the
+ * CPU until then, which is counted as contention. Replays always advance
+ * the CPU with the earliest clock, so lock hand-offs happen in time order.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "slab.h"
+#include "../trace/workload.h"
+
+static const uint32_t cache_sizes[SLAB_CACHE_COUNT] = {
+    8, 16, 32, 64, 96, 128, 192, 256, 512, 1024, 2048, 4096, 8192
+};
+
+// ==================== SIMULATED TIME ====================
+
+// Take a lock at the CPU's current time, waiting out any holder
+static void take_lock(SlabAllocator* slab, int cpu, SimLock* lock, uint64_t cost, uint64_t hold) {
+    uint64_t now = slab->clock[cpu];
+    lock->acquisitions++;
+    if(lock->busy_until > now) {
+        lock->contended++;
+        lock->wait_ns += lock->busy_until - now;
+        now = lock->busy_until;
+    }
+    lock->busy_until = now + hold;
+    slab->clock[cpu] = now + cost;
+}
+
+static int cache_index(uint32_t size) {
+    for(int i = 0; i < SLAB_CACHE_COUNT; i++) {
+        if(size <= cache_sizes[i]) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static Magazine* new_magazine(int capacity) {
+    Magazine* magazine = (Magazine*)malloc(sizeof(Magazine) + capacity * sizeof(uint64_t));
+    if(magazine != NULL) {
+        magazine->next = NULL;
+        magazine->rounds = 0;
+    }
+    return magazine;
+}
+
+static void free_magazine_list(Magazine* magazine) {
+    while(magazine != NULL) {
+        Magazine* next = magazine->next;
+        free(magazine);
+        magazine = next;
+    }
+}
+
+// ==================== SLAB LAYER ====================
+
+static void list_remove(SlabCache* cache, Slab* s) {
+    if(s->prev != NULL) {
+        s->prev->next = s->next;
+    } else {
+        cache->lists[s->list] = s->next;
+    }
+    if(s->next != NULL) {
+        s->next->prev = s->prev;
+    }
+    cache->list_length[s->list]--;
+}
+
+static void list_push(SlabCache* cache, Slab* s, SlabList list) {
+    s->list = list;
+    s->prev = NULL;
+    s->next = cache->lists[list];
+    if(s->next != NULL) {
+        s->next->prev = s;
+    }
+    cache->lists[list] = s;
+    cache->list_length[list]++;
+}
+
+static SlabList list_for(const SlabCache* cache, const Slab* s) {
+    if(s->in_use == 0) return SLAB_EMPTY;
+    if(s->in_use == cache->objects_per_slab) return SLAB_FULL;
+    return SLAB_PARTIAL;
+}
+
+static Slab* grow_cache(SlabAllocator* slab, SlabCache* cache, int cpu) {
+    take_lock(slab, cpu, &slab->page_lock, SLAB_COST_PAGE, SLAB_HOLD_PAGE);
+    int frame = buddy_alloc(&slab->pages, cache->order);
+    if(frame == -1) {
+        return NULL;
+    }
+
+    Slab* s = (Slab*)malloc(sizeof(Slab));
+    uint16_t* stack = (uint16_t*)malloc(cache->objects_per_slab * sizeof(uint16_t));
+    if(s == NULL || stack == NULL) {
+        free(s);
+        free(stack);
+        buddy_free(&slab->pages, frame, cache->order);
+        return NULL;
+    }
+
+    s->cache = cache;
+    s->first_frame = frame;
+    s->base = SLAB_ADDRESS_BASE + (uint64_t)frame * PAGE_SIZE;
+    s->in_use = 0;
+    s->free_count = (uint16_t)cache->objects_per_slab;
+    s->free_stack = stack;
+    for(int i = 0; i < cache->objects_per_slab; i++) {
+        stack[i] = (uint16_t)(cache->objects_per_slab - 1 - i);
+    }
+    for(int f = frame; f < frame + (1 << cache->order); f++) {
+        slab->frame_slab[f] = s;
+    }
+
+    list_push(cache, s, SLAB_EMPTY);
+    cache->slabs_created++;
+    return s;
+}
+
+static void release_slab(SlabAllocator* slab, SlabCache* cache, Slab* s, int cpu) {
+    list_remove(cache, s);
+    take_lock(slab, cpu, &slab->page_lock, SLAB_COST_PAGE, SLAB_HOLD_PAGE);
+    for(int f = s->first_frame; f < s->first_frame + (1 << cache->order); f++) {
+        slab->frame_slab[f] = NULL;
+    }
+    buddy_free(&slab->pages, s->first_frame, cache->order);
+    cache->slabs_released++;
+    free(s->free_stack);
+    free(s);
+}
+
+// One object from the slab lists under the cache lock
+static uint64_t slab_layer_alloc(SlabAllocator* slab, SlabCache* cache, int cpu) {
+    take_lock(slab, cpu, &cache->slab_lock, SLAB_COST_SLAB, SLAB_HOLD_SLAB);
+    slab->stats.slab_allocs++;
+
+    Slab* s = cache->lists[SLAB_PARTIAL];
+    if(s == NULL) s = cache->lists[SLAB_EMPTY];
+    if(s == NULL) s = grow_cache(slab, cache, cpu);
+    if(s == NULL) {
+        return 0;
+    }
+
+    uint16_t index = s->free_stack[--s->free_count];
+    list_remove(cache, s);
+    s->in_use++;
+    list_push(cache, s, list_for(cache, s));
+    return s->base + (uint64_t)index * cache->object_size;
+}
+
+// Return an object to its slab under the cache lock
+static void slab_layer_free(SlabAllocator* slab, Slab* s, uint64_t address, int cpu) {
+    SlabCache* cache = s->cache;
+    take_lock(slab, cpu, &cache->slab_lock, SLAB_COST_SLAB, SLAB_HOLD_SLAB);
+    slab->stats.slab_frees++;
+
+    s->free_stack[s->free_count++] = (uint16_t)((address - s->base) / cache->object_size);
+    list_remove(cache, s);
+    s->in_use--;
+    list_push(cache, s, list_for(cache, s));
+
+    if(s->in_use == 0 && cache->list_length[SLAB_EMPTY] > SLAB_EMPTY_KEEP) {
+        release_slab(slab, cache, s, cpu);
+    }
+}
+
+// ==================== MAGAZINE LAYER ====================
+
+static int magazine_alloc(SlabAllocator* slab, SlabCache* cache, int cpu, uint64_t* address) {
+    CpuMagazines* mags = &cache->cpu[cpu];
+    slab->clock[cpu] += SLAB_COST_MAGAZINE;
+
+    if(mags->loaded->rounds == 0 && mags->previous->rounds > 0) {
+        Magazine* swap = mags->loaded;
+        mags->loaded = mags->previous;
+        mags->previous = swap;
+    }
+    if(mags->loaded->rounds > 0) {
+        *address = mags->loaded->objects[--mags->loaded->rounds];
+        slab->stats.cpu_alloc_hits++;
+        return 1;
+    }
+
+    // Both empty: trade the previous one for a full magazine from the depot
+    take_lock(slab, cpu, &cache->depot_lock, SLAB_COST_DEPOT, SLAB_HOLD_DEPOT);
+    if(cache->depot_full == NULL) {
+        return 0;
+    }
+    Magazine* full = cache->depot_full;
+    cache->depot_full = full->next;
+    cache->depot_full_count--;
+    mags->previous->next = cache->depot_empty;
+    cache->depot_empty = mags->previous;
+    mags->previous = mags->loaded;
+    mags->loaded = full;
+    slab->stats.depot_exchanges++;
+
+    *address = full->objects[--full->rounds];
+    return 1;
+}
+
+static int magazine_free(SlabAllocator* slab, SlabCache* cache, int cpu, uint64_t address) {
+    CpuMagazines* mags = &cache->cpu[cpu];
+    slab->clock[cpu] += SLAB_COST_MAGAZINE;
+
+    if(mags->loaded->rounds == slab->magazine_size && mags->previous->rounds == 0) {
+        Magazine* swap = mags->loaded;
+        mags->loaded = mags->previous;
+        mags->previous = swap;
+    }
+    if(mags->loaded->rounds < slab->magazine_size) {
+        mags->loaded->objects[mags->loaded->rounds++] = address;
+        slab->stats.cpu_free_hits++;
+        return 1;
+    }
+
+    // Both full: park the previous one in the depot if it has room
+    take_lock(slab, cpu, &cache->depot_lock, SLAB_COST_DEPOT, SLAB_HOLD_DEPOT);
+    if(cache->depot_full_count >= slab->cpus * SLAB_DEPOT_PER_CPU) {
+        return 0;
+    }
+    Magazine* empty = cache->depot_empty;
+    if(empty != NULL) {
+        cache->depot_empty = empty->next;
+    } else if((empty = new_magazine(slab->magazine_size)) == NULL) {
+        return 0;
+    }
+    mags->previous->next = cache->depot_full;
+    cache->depot_full = mags->previous;
+    cache->depot_full_count++;
+    mags->previous = mags->loaded;
+    mags->loaded = empty;
+    slab->stats.depot_exchanges++;
+
+    empty->objects[empty->rounds++] = address;
+    return 1;
+}
+
+// ==================== ALLOCATOR ====================
+
+// Caches for every size class over a fresh page allocator
+int slab_init(SlabAllocator* slab, int cpus, int magazine_size) {
+    memset(slab, 0, sizeof(SlabAllocator));
+    if(cpus < 1 || cpus > SLAB_MAX_CPUS || magazine_size < 0) {
+        printf("Error: Invalid slab configuration (%d CPUs, magazine %d)\n", cpus, magazine_size);
+        return -1;
+    }
+    slab->cpus = cpus;
+    slab->magazine_size = magazine_size;
+    slab->page_lock.name = "page";
+    address_table_init(&slab->large_blocks);
+
+    slab->frame_slab = (Slab**)calloc(SLAB_BACKING_FRAMES, sizeof(Slab*));
+    if(slab->frame_slab == NULL || buddy_init(&slab->pages, SLAB_BACKING_FRAMES) != 0) {
+        printf("Error: Memory allocation failed\n");
+        free(slab->frame_slab);
+        return -1;
+    }
+
+    for(int i = 0; i < SLAB_CACHE_COUNT; i++) {
+        SlabCache* cache = &slab->caches[i];
+        cache->object_size = cache_sizes[i];
+        cache->depot_lock.name = "depot";
+        cache->slab_lock.name = "slab";
+        while(cache->order < SLAB_MAX_ORDER &&
+              (PAGE_SIZE << cache->order) / cache->object_size < SLAB_MIN_OBJECTS) {
+            cache->order++;
+        }
+        cache->objects_per_slab = (PAGE_SIZE << cache->order) / cache->object_size;
+
+        for(int cpu = 0; cpu < cpus && magazine_size > 0; cpu++) {
+            cache->cpu[cpu].loaded = new_magazine(magazine_size);
+            cache->cpu[cpu].previous = new_magazine(magazine_size);
+            if(cache->cpu[cpu].loaded == NULL || cache->cpu[cpu].previous == NULL) {
+                printf("Error: Memory allocation failed\n");
+                slab_destroy(slab);
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+// Release slabs, magazines and the page allocator
+void slab_destroy(SlabAllocator* slab) {
+    for(int i = 0; i < SLAB_CACHE_COUNT; i++) {
+        SlabCache* cache = &slab->caches[i];
+        for(int list = 0; list < SLAB_LIST_COUNT; list++) {
+            Slab* s = cache->lists[list];
+            while(s != NULL) {
+                Slab* next = s->next;
+                free(s->free_stack);
+                free(s);
+                s = next;
+            }
+        }
+        for(int cpu = 0; cpu < SLAB_MAX_CPUS; cpu++) {
+            free(cache->cpu[cpu].loaded);
+            free(cache->cpu[cpu].previous);
+        }
+        free_magazine_list(cache->depot_full);
+        free_magazine_list(cache->depot_empty);
+    }
+    address_table_free(&slab->large_blocks);
+    buddy_destroy(&slab->pages);
+    free(slab->frame_slab);
+    memset(slab, 0, sizeof(SlabAllocator));
+}
+
+// Allocate an object on a CPU, returns its address or 0
+uint64_t slab_alloc(SlabAllocator* slab, int cpu, uint32_t size) {
+    int index = cache_index(size);
+    uint64_t address = 0;
+    slab->stats.allocs++;
+
+    if(index == -1) {
+        // Too big for any cache: whole pages from the buddy allocator
+        int order = 0;
+        while(((uint64_t)PAGE_SIZE << order) < size) {
+            order++;
+        }
+        take_lock(slab, cpu, &slab->page_lock, SLAB_COST_PAGE, SLAB_HOLD_PAGE);
+        int frame = buddy_alloc(&slab->pages, order);
+        if(frame == -1) {
+            slab->stats.failed++;
+            return 0;
+        }
+        address = SLAB_ADDRESS_BASE + (uint64_t)frame * PAGE_SIZE;
+        address_table_put(&slab->large_blocks, address, (uint64_t)order);
+        slab->stats.large_allocs++;
+        return address;
+    }
+
+    SlabCache* cache = &slab->caches[index];
+    if(slab->magazine_size == 0 || !magazine_alloc(slab, cache, cpu, &address)) {
+        address = slab_layer_alloc(slab, cache, cpu);
+        if(address == 0) {
+            slab->stats.failed++;
+            return 0;
+        }
+    }
+    cache->live_objects++;
+    cache->allocations++;
+    cache->requested_bytes += size;
+    return address;
+}
+
+// Free an object on a CPU (not necessarily the one that allocated it)
+int slab_free(SlabAllocator* slab, int cpu, uint64_t address) {
+    uint64_t order;
+    if(address < SLAB_ADDRESS_BASE) {
+        return -1;
+    }
+    slab->stats.frees++;
+
+    if(address_table_take(&slab->large_blocks, address, &order)) {
+        slab->stats.large_frees++;
+        take_lock(slab, cpu, &slab->page_lock, SLAB_COST_PAGE, SLAB_HOLD_PAGE);
+        return buddy_free(&slab->pages, (int)((address - SLAB_ADDRESS_BASE) / PAGE_SIZE), (int)order);
+    }
+
+    uint64_t frame = (address - SLAB_ADDRESS_BASE) / PAGE_SIZE;
+    Slab* s = (frame < SLAB_BACKING_FRAMES) ? slab->frame_slab[frame] : NULL;
+    if(s == NULL) {
+        printf("Error: Address 0x%llx is not a slab object\n", (unsigned long long)address);
+        return -1;
+    }
+
+    s->cache->live_objects--;
+    if(slab->magazine_size == 0 || !magazine_free(slab, s->cache, cpu, address)) {
+        slab_layer_free(slab, s, address, cpu);
+    }
+    return 0;
+}
+
+// Share of cache operations served by the CPU's own magazines
+double slab_cpu_hit_rate(const SlabAllocator* slab) {
+    unsigned long long ops = slab->stats.allocs + slab->stats.frees -
+                             slab->stats.large_allocs - slab->stats.large_frees;
+    if(ops == 0) {
+        return 0.0;
+    }
+    return (double)(slab->stats.cpu_alloc_hits + slab->stats.cpu_free_hits) / ops;
+}
+
+// Live object bytes over the bytes of all slabs
+double slab_utilisation(const SlabAllocator* slab) {
+    uint64_t slab_bytes = 0;
+    uint64_t object_bytes = 0;
+    for(int i = 0; i < SLAB_CACHE_COUNT; i++) {
+        const SlabCache* cache = &slab->caches[i];
+        int slabs = cache->list_length[SLAB_FULL] + cache->list_length[SLAB_PARTIAL] +
+                    cache->list_length[SLAB_EMPTY];
+        slab_bytes += (uint64_t)slabs * (PAGE_SIZE << cache->order);
+        object_bytes += cache->live_objects * cache->object_size;
+    }
+    return slab_bytes ? (double)object_bytes / slab_bytes : 0.0;
+}
+
+// ==================== TRACES ====================
+
+// Bursty multi-CPU object churn with a share of remote (cross-CPU) frees
+int slab_trace_synthetic(HeapTrace* trace, uint64_t operations, int cpus, uint64_t seed) {
+    // kmalloc-like size mix: mostly small, a tail into the large path
+    static const uint32_t limits[] = {8, 16, 32, 64, 96, 128, 192, 256, 512, 1024, 2048, 4096, 8192, 32768};
+    static const double weights[] = {5, 10, 20, 20, 8, 10, 6, 8, 6, 3, 2, 1, 0.6, 0.4};
+    const int classes = sizeof(limits) / sizeof(limits[0]);
+    double total = 0;
+    for(int i = 0; i < classes; i++) total += weights[i];
+
+    uint32_t* live[SLAB_MAX_CPUS] = {0};
+    uint64_t live_count[SLAB_MAX_CPUS] = {0};
+    int allocating[SLAB_MAX_CPUS];
+    int burst[SLAB_MAX_CPUS] = {0};
+    uint64_t live_total = 0;
+    uint64_t target = operations / 20 > 1000 ? operations / 20 : 1000;
+    WorkloadRng rng;
+    int status = 0;
+
+    memset(trace, 0, sizeof(HeapTrace));
+    if(cpus < 1 || cpus > SLAB_MAX_CPUS || operations > UINT32_MAX) {
+        printf("Error: Invalid slab trace (%d CPUs)\n", cpus);
+        return -1;
+    }
+    workload_rng_seed(&rng, seed);
+    for(int cpu = 0; cpu < cpus && status == 0; cpu++) {
+        live[cpu] = (uint32_t*)malloc(operations * sizeof(uint32_t) + sizeof(uint32_t));
+        allocating[cpu] = 1;
+        if(live[cpu] == NULL) {
+            printf("Error: Memory allocation failed\n");
+            status = -1;
+        }
+    }
+
+    for(uint64_t op = 0; op < operations && status == 0; op++) {
+        int cpu = (int)workload_rng_bounded(&rng, (uint32_t)cpus);
+        if(burst[cpu] == 0) {
+            allocating[cpu] = (live_total < target) ? 1 : (workload_rng_double(&rng) < 0.5);
+            burst[cpu] = 1 + (int)workload_rng_bounded(&rng, 64);
+        }
+        burst[cpu]--;
+
+        // One free in five releases another CPU's object
+        int owner = cpu;
+        if(workload_rng_double(&rng) < 0.2) {
+            owner = (int)workload_rng_bounded(&rng, (uint32_t)cpus);
+        }
+
+        if(allocating[cpu] || live_count[owner] == 0) {
+            double pick = workload_rng_double(&rng) * total;
+            int c = 0;
+            while(c < classes - 1 && pick >= weights[c]) {
+                pick -= weights[c];
+                c++;
+            }
+            uint32_t low = (c == 0) ? 1 : limits[c - 1] + 1;
+            uint32_t size = low + workload_rng_bounded(&rng, limits[c] - low + 1);
+            live[cpu][live_count[cpu]++] = trace->ids;
+            live_total++;
+            status = heap_trace_append(trace, trace->ids++, size, (uint32_t)cpu);
+        } else {
+            // Most recent object first: frees follow allocations closely
+            uint64_t depth = workload_rng_bounded(&rng, live_count[owner] < 8 ? (uint32_t)live_count[owner] : 8);
+            uint64_t victim = live_count[owner] - 1 - depth;
+            status = heap_trace_append(trace, live[owner][victim], 0, (uint32_t)cpu);
+            live[owner][victim] = live[owner][--live_count[owner]];
+            live_total--;
+        }
+    }
+
+    for(int cpu = 0; cpu < cpus; cpu++) {
+        free(live[cpu]);
+    }
+    if(status != 0) {
+        heap_trace_free(trace);
+    }
+    return status;
+}
+
+// Replay a trace, each thread on CPU thread % cpus, earliest CPU clock first
+int slab_replay(SlabAllocator* slab, const HeapTrace* trace) {
+    int cpus = slab->cpus;
+    uint64_t* addresses = (uint64_t*)calloc(trace->ids + 1, sizeof(uint64_t));
+    uint64_t* ready_at = (uint64_t*)calloc(trace->ids + 1, sizeof(uint64_t));
+    uint8_t* allocated = (uint8_t*)calloc(trace->ids + 1, 1);
+    uint64_t* queue = (uint64_t*)malloc((trace->count + 1) * sizeof(uint64_t));
+    uint64_t start[SLAB_MAX_CPUS + 1] = {0};
+    uint64_t cursor[SLAB_MAX_CPUS];
+
+    if(addresses == NULL || ready_at == NULL || allocated == NULL || queue == NULL) {
+        printf("Error: Memory allocation failed\n");
+        free(addresses);
+        free(ready_at);
+        free(allocated);
+        free(queue);
+        return -1;
+    }
+
+    // Per-CPU operation queues, in trace order
+    for(uint64_t i = 0; i < trace->count; i++) {
+        start[trace->ops[i].thread % cpus + 1]++;
+    }
+    for(int cpu = 0; cpu < cpus; cpu++) {
+        start[cpu + 1] += start[cpu];
+        cursor[cpu] = start[cpu];
+    }
+    for(uint64_t i = 0; i < trace->count; i++) {
+        queue[cursor[trace->ops[i].thread % cpus]++] = i;
+    }
+    for(int cpu = 0; cpu < cpus; cpu++) {
+        cursor[cpu] = start[cpu];
+    }
+
+    for(uint64_t done = 0; done < trace->count; done++) {
+        // Earliest CPU whose next operation does not free a not-yet-allocated object
+        int cpu = -1;
+        for(int c = 0; c < cpus; c++) {
+            if(cursor[c] == start[c + 1]) continue;
+            const HeapOp* next = &trace->ops[queue[cursor[c]]];
+            if(next->size == 0 && !allocated[next->id]) continue;
+            if(cpu == -1 || slab->clock[c] < slab->clock[cpu]) cpu = c;
+        }
+        if(cpu == -1) {
+            break;
+        }
+
+        const HeapOp* op = &trace->ops[queue[cursor[cpu]++]];
+        slab->clock[cpu] += SLAB_COST_THINK;
+        if(op->size != 0) {
+            addresses[op->id] = slab_alloc(slab, cpu, op->size);
+            ready_at[op->id] = slab->clock[cpu];
+            allocated[op->id] = 1;
+        } else if(addresses[op->id] != 0) {
+            // A remote free cannot happen before the allocation finished
+            if(ready_at[op->id] > slab->clock[cpu]) {
+                slab->clock[cpu] = ready_at[op->id];
+            }
+            slab_free(slab, cpu, addresses[op->id]);
+            addresses[op->id] = 0;
+        }
+    }
+
+    for(int cpu = 0; cpu < cpus; cpu++) {
+        if(slab->clock[cpu] > slab->stats.elapsed_ns) {
+            slab->stats.elapsed_ns = slab->clock[cpu];
+        }
+    }
+
+    free(addresses);
+    free(ready_at);
+    free(allocated);
+    free(queue);
+    return 0;
+}
+
+// ==================== REPORTS ====================
+
+static void lock_totals(const SlabAllocator* slab, const char* name, unsigned long long* acquisitions,
+                        unsigned long long* contended, uint64_t* wait_ns) {
+    *acquisitions = 0;
+    *contended = 0;
+    *wait_ns = 0;
+    for(int i = 0; i < SLAB_CACHE_COUNT; i++) {
+        const SimLock* lock = (strcmp(name, "depot") == 0) ? &slab->caches[i].depot_lock :
+                              &slab->caches[i].slab_lock;
+        *acquisitions += lock->acquisitions;
+        *contended += lock->contended;
+        *wait_ns += lock->wait_ns;
+    }
+}
+
+// Per-layer hit rates, lock contention and per-cache slab usage
+void display_slab_report(const SlabAllocator* slab) {
+    const SlabStats* s = &slab->stats;
+    unsigned long long ops = s->allocs + s->frees;
+
+    printf("\n========================== SLAB ALLOCATOR ==========================\n");
+    printf("CPUs: %d, Magazine: %d objects, Operations: %llu (%llu large)\n",
+           slab->cpus, slab->magazine_size, ops, s->large_allocs);
+    printf("Per-CPU hits: %.1f%% (alloc %llu, free %llu), Depot exchanges: %llu\n",
+           100.0 * slab_cpu_hit_rate(slab), s->cpu_alloc_hits, s->cpu_free_hits,
+           s->depot_exchanges);
+    printf("Slab layer: %llu allocs, %llu frees, Failed: %llu\n",
+           s->slab_allocs, s->slab_frees, s->failed);
+    printf("Simulated time: %.3f ms, %.1f ns/op per CPU\n", s->elapsed_ns / 1e6,
+           ops ? (double)s->elapsed_ns * slab->cpus / ops : 0.0);
+
+    printf("\nLock    Acquisitions  Contended  Avg wait\n");
+    printf("------  ------------  ---------  --------\n");
+    const char* names[] = {"depot", "slab"};
+    for(int i = 0; i < 3; i++) {
+        unsigned long long acquisitions, contended;
+        uint64_t wait_ns;
+        if(i < 2) {
+            lock_totals(slab, names[i], &acquisitions, &contended, &wait_ns);
+        } else {
+            acquisitions = slab->page_lock.acquisitions;
+            contended = slab->page_lock.contended;
+            wait_ns = slab->page_lock.wait_ns;
+        }
+        printf("%-6s  %12llu  %8.1f%%  %6.0fns\n", i < 2 ? names[i] : slab->page_lock.name,
+               acquisitions, acquisitions ? 100.0 * contended / acquisitions : 0.0,
+               contended ? (double)wait_ns / contended : 0.0);
+    }
+
+    printf("\nCache   Order  Objs/slab  Full  Partial  Empty     Live  Util.  Rounding\n");
+    printf("------  -----  ---------  ----  -------  -----  -------  -----  --------\n");
+    for(int i = 0; i < SLAB_CACHE_COUNT; i++) {
+        const SlabCache* cache = &slab->caches[i];
+        int slabs = cache->list_length[SLAB_FULL] + cache->list_length[SLAB_PARTIAL] +
+                    cache->list_length[SLAB_EMPTY];
+        if(cache->allocations == 0) {
+            continue;
+        }
+        uint64_t slab_bytes = (uint64_t)slabs * (PAGE_SIZE << cache->order);
+        printf("%6u  %5d  %9d  %4d  %7d  %5d  %7llu  %4.0f%%  %7.1f%%\n",
+               cache->object_size, cache->order, cache->objects_per_slab,
+               cache->list_length[SLAB_FULL], cache->list_length[SLAB_PARTIAL],
+               cache->list_length[SLAB_EMPTY], cache->live_objects,
+               slab_bytes ? 100.0 * cache->live_objects * cache->object_size / slab_bytes : 0.0,
+               100.0 - 100.0 * cache->requested_bytes /
+                       ((double)cache->allocations * cache->object_size));
+    }
+    printf("Util. = live object bytes / slab bytes (objects parked in magazines count as free)\n");
+    printf("Rounding = bytes lost rounding requests up to the object size\n");
+    printf("====================================================================\n");
+}
+
+// Replay one trace with several magazine sizes and compare
+int run_slab_comparison(const HeapTrace* trace, int cpus) {
+    static const int magazine_sizes[] = {0, 8, 32, 128};
+    SlabAllocator* slab = (SlabAllocator*)malloc(sizeof(SlabAllocator));
+    if(slab == NULL) {
+        printf("Error: Memory allocation failed\n");
+        return -1;
+    }
+
+    printf("\n====================== SLAB MAGAZINE COMPARISON ======================\n");
+    printf("Operations: %llu, Objects: %u, Threads: %u on %d CPUs\n",
+           (unsigned long long)trace->count, trace->ids, trace->threads, cpus);
+    if(trace->dropped > 0) {
+        printf("Dropped by the shim: %llu events; their objects are missing or never freed\n",
+               (unsigned long long)trace->dropped);
+    }
+    printf("\nMagazine  CPU hits  Locks/op  Contended  Wait/op  Sim ns/op  Slab util.\n");
+    printf("--------  --------  --------  ---------  -------  ---------  ----------\n");
+
+    for(int m = 0; m < 4; m++) {
+        if(slab_init(slab, cpus, magazine_sizes[m]) != 0 || slab_replay(slab, trace) != 0) {
+            free(slab);
+            return -1;
+        }
+
+        unsigned long long ops = slab->stats.allocs + slab->stats.frees;
+        unsigned long long acquisitions = slab->page_lock.acquisitions;
+        unsigned long long contended = slab->page_lock.contended;
+        uint64_t wait_ns = slab->page_lock.wait_ns;
+        for(int i = 0; i < SLAB_CACHE_COUNT; i++) {
+            acquisitions += slab->caches[i].depot_lock.acquisitions + slab->caches[i].slab_lock.acquisitions;
+            contended += slab->caches[i].depot_lock.contended + slab->caches[i].slab_lock.contended;
+            wait_ns += slab->caches[i].depot_lock.wait_ns + slab->caches[i].slab_lock.wait_ns;
+        }
+        printf("%8d  %7.1f%%  %8.3f  %8.1f%%  %5.1fns  %9.1f  %9.1f%%\n",
+               magazine_sizes[m], 100.0 * slab_cpu_hit_rate(slab),
+               ops ? (double)acquisitions / ops : 0.0,
+               acquisitions ? 100.0 * contended / acquisitions : 0.0,
+               ops ? (double)wait_ns / ops : 0.0,
+               ops ? (double)slab->stats.elapsed_ns * cpus / ops : 0.0,
+               100.0 * slab_utilisation(slab));
+
+        slab_destroy(slab);
+    }
+    printf("======================================================================\n");
+
+    // Details for the default configuration
+    if(slab_init(slab, cpus, SLAB_DEFAULT_MAGAZINE) == 0) {
+        slab_replay(slab, trace);
+        display_slab_report(slab);
+        slab_destroy(slab);
+    }
+    free(slab);
+    return 0;
+}
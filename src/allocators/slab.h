@@ -0,0 +1,134 @@
+/**
+ * slab.h
+ * Slab object cache model with per-CPU magazines
+ */
+
+#ifndef SLAB_H
+#define SLAB_H
+
+#include <stdint.h>
+#include "../../include/common_defs.h"
+#include "buddy.h"
+#include "heap_sim.h"
+
+#define SLAB_MAX_CPUS 64
+#define SLAB_CACHE_COUNT 13             // kmalloc-8 .. kmalloc-8192
+#define SLAB_MIN_OBJECTS 8              // Slab order grows until this many fit
+#define SLAB_MAX_ORDER 3
+#define SLAB_EMPTY_KEEP 2               // Empty slabs kept per cache before release
+#define SLAB_BACKING_FRAMES (1 << 20)   // Frames behind the slab layer (4 GB)
+#define SLAB_DEFAULT_MAGAZINE 32
+#define SLAB_DEPOT_PER_CPU 2            // Full magazines the depot holds per CPU
+#define SLAB_ADDRESS_BASE (1ULL << 32)  // Address of frame 0
+
+// Simulated costs in ns; hold times are how long the lock stays taken
+#define SLAB_COST_THINK 100             // Caller work between operations
+#define SLAB_COST_MAGAZINE 10
+#define SLAB_COST_DEPOT 60
+#define SLAB_HOLD_DEPOT 40
+#define SLAB_COST_SLAB 150
+#define SLAB_HOLD_SLAB 120
+#define SLAB_COST_PAGE 800
+#define SLAB_HOLD_PAGE 600
+
+typedef enum {
+    SLAB_FULL,
+    SLAB_PARTIAL,
+    SLAB_EMPTY,
+    SLAB_LIST_COUNT
+} SlabList;
+
+// One slab: 2^order frames cut into equal objects
+typedef struct Slab {
+    struct Slab* next;
+    struct Slab* prev;
+    struct SlabCache* cache;
+    uint64_t base;                      // Address of object 0
+    int first_frame;
+    SlabList list;
+    uint16_t in_use;
+    uint16_t free_count;
+    uint16_t* free_stack;               // Indices of free objects
+} Slab;
+
+// Stack of cached object addresses
+typedef struct Magazine {
+    struct Magazine* next;
+    int rounds;
+    uint64_t objects[];
+} Magazine;
+
+// A lock in the simulated timeline
+typedef struct {
+    const char* name;
+    uint64_t busy_until;
+    unsigned long long acquisitions;
+    unsigned long long contended;
+    uint64_t wait_ns;
+} SimLock;
+
+// Loaded and previous magazine of one CPU for one cache
+typedef struct {
+    Magazine* loaded;
+    Magazine* previous;
+} CpuMagazines;
+
+typedef struct SlabCache {
+    uint32_t object_size;
+    int order;
+    int objects_per_slab;
+    Slab* lists[SLAB_LIST_COUNT];
+    int list_length[SLAB_LIST_COUNT];
+    CpuMagazines cpu[SLAB_MAX_CPUS];
+    Magazine* depot_full;
+    Magazine* depot_empty;
+    int depot_full_count;
+    SimLock depot_lock;
+    SimLock slab_lock;
+    unsigned long long live_objects;
+    unsigned long long allocations;
+    unsigned long long requested_bytes; // Over all allocations, for rounding waste
+    unsigned long long slabs_created;
+    unsigned long long slabs_released;
+} SlabCache;
+
+typedef struct {
+    unsigned long long allocs;
+    unsigned long long frees;
+    unsigned long long cpu_alloc_hits;  // Served by the loaded or previous magazine
+    unsigned long long cpu_free_hits;
+    unsigned long long depot_exchanges;
+    unsigned long long slab_allocs;
+    unsigned long long slab_frees;
+    unsigned long long large_allocs;    // Above the largest cache, straight to pages
+    unsigned long long large_frees;
+    unsigned long long failed;
+    uint64_t elapsed_ns;                // Simulated, latest CPU clock
+} SlabStats;
+
+typedef struct {
+    int cpus;
+    int magazine_size;                  // 0 disables the per-CPU layer
+    SlabCache caches[SLAB_CACHE_COUNT];
+    BuddyAllocator pages;
+    Slab** frame_slab;                  // Frame -> slab owning it
+    AddressTable large_blocks;          // Address -> buddy order
+    SimLock page_lock;
+    uint64_t clock[SLAB_MAX_CPUS];
+    SlabStats stats;
+} SlabAllocator;
+
+// Function Prototypes
+int slab_init(SlabAllocator* slab, int cpus, int magazine_size);
+void slab_destroy(SlabAllocator* slab);
+uint64_t slab_alloc(SlabAllocator* slab, int cpu, uint32_t size);
+int slab_free(SlabAllocator* slab, int cpu, uint64_t address);
+double slab_cpu_hit_rate(const SlabAllocator* slab);
+double slab_utilisation(const SlabAllocator* slab);
+
+int slab_trace_synthetic(HeapTrace* trace, uint64_t operations, int cpus, uint64_t seed);
+int slab_replay(SlabAllocator* slab, const HeapTrace* trace);
+void display_slab_report(const SlabAllocator* slab);
+int run_slab_comparison(const HeapTrace* trace, int cpus);
+
+#endif // SLAB_H
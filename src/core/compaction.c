@@ -0,0 +1,432 @@
+/**
+ * compaction.c
+ * Frame and segment compaction implementation
+ *
+ * Compaction is planned up front and applied in budgeted steps, the way a
+ * kernel compacts a zone a few pages at a time. For frames the goal is one
+ * free buddy block of the target order; two plans are costed and the one
+ * moving fewer pages wins: a two-pointer pass that slides every page to
+ * the top of memory, or evacuating the aligned window that holds the
+ * fewest pages. Segments slide down to close the holes between them.
+ * Every move goes through migrate_page / migrate_segment, which update the
+ * frame, page table, TLB, replacement order and segment extents together,
+ * and is checked again before it runs since the system keeps changing
+ * between steps.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "compaction.h"
+#include "memory_manager.h"
+#include "segmentation.h"
+#include "../trace/workload.h"
+
+#define FRAME_FREE 0
+#define FRAME_MOVABLE 1
+#define FRAME_PINNED 2
+
+CompactionStats compaction_stats;
+
+// Pending plan
+static FrameMove frame_moves[MAX_FRAMES];
+static SegmentMove segment_moves[MAX_PROCESSES * MAX_SEGMENTS];
+static int frame_move_count = 0;
+static int segment_move_count = 0;
+static int next_frame_move = 0;
+static int next_segment_move = 0;
+
+// ==================== FRAGMENTATION ====================
+
+static void frame_states(int* state) {
+    for(int i = 0; i < MAX_FRAMES; i++) {
+        if(physical_memory[i].is_free) {
+            state[i] = FRAME_FREE;
+        } else {
+            state[i] = is_frame_reserved(i) ? FRAME_PINNED : FRAME_MOVABLE;
+        }
+    }
+}
+
+// Largest order with an aligned, entirely free window in state
+static int largest_free_order(const int* state) {
+    for(int order = frame_buddy.max_order; order >= 0; order--) {
+        int size = 1 << order;
+        for(int start = 0; start + size <= frame_buddy.frames; start += size) {
+            int free_window = 1;
+            for(int i = start; i < start + size && free_window; i++) {
+                free_window = (state[i] == FRAME_FREE);
+            }
+            if(free_window) {
+                return order;
+            }
+        }
+    }
+    return -1;
+}
+
+static int buddy_largest_order() {
+    for(int order = frame_buddy.max_order; order >= 0; order--) {
+        if(frame_buddy.free_blocks[order] > 0) {
+            return order;
+        }
+    }
+    return -1;
+}
+
+// ==================== PLANNING ====================
+
+// Two-pointer pass: lowest page moves into highest free frame until they cross
+static int plan_two_pointer(const int* state, FrameMove* moves) {
+    int count = 0;
+    int low = 0;
+    int high = MAX_FRAMES - 1;
+
+    while(1) {
+        while(low < MAX_FRAMES && state[low] != FRAME_MOVABLE) low++;
+        while(high >= 0 && state[high] != FRAME_FREE) high--;
+        if(low >= high) {
+            break;
+        }
+        moves[count].from = low++;
+        moves[count].to = high--;
+        count++;
+    }
+    return count;
+}
+
+// Evacuate the aligned window of the order holding the fewest pages, -1 if none can be
+static int plan_window(const int* state, int order, FrameMove* moves) {
+    int size = 1 << order;
+    int total_free = 0;
+    int best = -1;
+    int best_cost = MAX_FRAMES + 1;
+
+    for(int i = 0; i < MAX_FRAMES; i++) {
+        total_free += (state[i] == FRAME_FREE);
+    }
+
+    for(int start = 0; start + size <= frame_buddy.frames; start += size) {
+        int cost = 0;
+        int pinned = 0;
+        for(int i = start; i < start + size; i++) {
+            cost += (state[i] == FRAME_MOVABLE);
+            pinned |= (state[i] == FRAME_PINNED);
+        }
+        int free_outside = total_free - (size - cost);
+        if(!pinned && cost <= free_outside && cost < best_cost) {
+            best = start;
+            best_cost = cost;
+        }
+    }
+    if(best == -1) {
+        return -1;
+    }
+
+    int count = 0;
+    int to = MAX_FRAMES - 1;
+    for(int from = best; from < best + size; from++) {
+        if(state[from] != FRAME_MOVABLE) {
+            continue;
+        }
+        while(state[to] != FRAME_FREE || (to >= best && to < best + size)) {
+            to--;
+        }
+        moves[count].from = from;
+        moves[count].to = to--;
+        count++;
+    }
+    return count;
+}
+
+static int order_after(const int* state, const FrameMove* moves, int count) {
+    int after[MAX_FRAMES];
+    memcpy(after, state, sizeof(after));
+    for(int i = 0; i < count; i++) {
+        after[moves[i].to] = FRAME_MOVABLE;
+        after[moves[i].from] = FRAME_FREE;
+    }
+    return largest_free_order(after);
+}
+
+static int compare_segment_base(const void* a, const void* b) {
+    const SegmentMove* x = (const SegmentMove*)a;
+    const SegmentMove* y = (const SegmentMove*)b;
+    return (x->from > y->from) - (x->from < y->from);
+}
+
+// Slide every segment down onto the end of the one below it
+static int plan_segments(SegmentMove* moves) {
+    SegmentMove live[MAX_PROCESSES * MAX_SEGMENTS];
+    int live_count = 0;
+
+    // A single free extent is already as compact as sliding can make it
+    if(segment_space_fragmentation() == 0.0) {
+        return 0;
+    }
+
+    for(int pid = 0; pid < MAX_PROCESSES; pid++) {
+        if(processes[pid].pid == -1) {
+            continue;
+        }
+        for(int i = 0; i < MAX_SEGMENTS; i++) {
+            SegmentTableEntry* segment = &processes[pid].segment_table[i];
+            if(segment->valid) {
+                live[live_count].pid = pid;
+                live[live_count].segment_id = i;
+                live[live_count].from = segment->base_address;
+                live[live_count].limit = segment->limit;
+                live_count++;
+            }
+        }
+    }
+    qsort(live, live_count, sizeof(SegmentMove), compare_segment_base);
+
+    int count = 0;
+    int cursor = 0;
+    for(int i = 0; i < live_count; i++) {
+        if(live[i].from != cursor) {
+            moves[count] = live[i];
+            moves[count].to = cursor;
+            count++;
+        }
+        cursor += live[i].limit;
+    }
+    return count;
+}
+
+// Plan compaction towards one free block of target_order, returns the moves planned
+int compaction_plan(int target_order) {
+    int state[MAX_FRAMES];
+    FrameMove window[MAX_FRAMES];
+    FrameMove sliding[MAX_FRAMES];
+
+    if(frame_buddy.frames == 0) {
+        printf("Error: Memory system not initialized\n");
+        return -1;
+    }
+    if(target_order < COMPACTION_AUTO_ORDER || target_order > frame_buddy.max_order) {
+        printf("Error: Invalid compaction order %d\n", target_order);
+        return -1;
+    }
+
+    frame_states(state);
+    int automatic = (target_order == COMPACTION_AUTO_ORDER);
+    if(automatic) {
+        target_order = 0;
+        while(target_order < frame_buddy.max_order &&
+              (2 << target_order) <= frame_buddy.free_frames) {
+            target_order++;
+        }
+    }
+
+    // Pinned blocks may rule a window out; automatic runs settle for less
+    int order = target_order;
+    int window_count = plan_window(state, order, window);
+    while(window_count == -1 && automatic && order > 0) {
+        order--;
+        window_count = plan_window(state, order, window);
+    }
+    if(window_count == -1) {
+        printf("Error: No block of order %d can be freed by migration\n", target_order);
+        return -1;
+    }
+
+    compaction_stats.runs++;
+    compaction_stats.target_order = order;
+    compaction_stats.largest_order_before = buddy_largest_order();
+    compaction_stats.unusable_before = buddy_unusable_index(&frame_buddy, order);
+    compaction_stats.segment_frag_before = segment_space_fragmentation();
+
+    frame_move_count = 0;
+    compaction_stats.plan_name = "none needed";
+    if(compaction_stats.largest_order_before < order) {
+        int sliding_count = plan_two_pointer(state, sliding);
+        if(sliding_count <= window_count && order_after(state, sliding, sliding_count) >= order) {
+            memcpy(frame_moves, sliding, sliding_count * sizeof(FrameMove));
+            frame_move_count = sliding_count;
+            compaction_stats.plan_name = "two-pointer";
+        } else {
+            memcpy(frame_moves, window, window_count * sizeof(FrameMove));
+            frame_move_count = window_count;
+            compaction_stats.plan_name = "fewest-pages window";
+        }
+    }
+    segment_move_count = plan_segments(segment_moves);
+    next_frame_move = 0;
+    next_segment_move = 0;
+
+    VPRINTF("Compaction plan (%s): %d page moves, %d segment moves for order %d\n",
+            compaction_stats.plan_name, frame_move_count, segment_move_count, order);
+    return frame_move_count + segment_move_count;
+}
+
+// ==================== EXECUTION ====================
+
+// 1 while planned moves remain
+int compaction_pending() {
+    return next_frame_move < frame_move_count || next_segment_move < segment_move_count;
+}
+
+static void finish_run() {
+    compaction_stats.largest_order_after = buddy_largest_order();
+    compaction_stats.unusable_after = buddy_unusable_index(&frame_buddy, compaction_stats.target_order);
+    compaction_stats.segment_frag_after = segment_space_fragmentation();
+}
+
+// Apply planned moves until budget_bytes are copied, returns the bytes moved
+int compaction_step(int budget_bytes) {
+    int bytes = 0;
+    int moves = 0;
+
+    if(!compaction_pending()) {
+        return 0;
+    }
+
+    while(next_frame_move < frame_move_count) {
+        if(bytes > 0 && bytes + PAGE_SIZE > budget_bytes) {
+            break;
+        }
+        FrameMove* move = &frame_moves[next_frame_move++];
+        if(migrate_page(move->from, move->to) == 0) {
+            bytes += PAGE_SIZE;
+            moves++;
+            compaction_stats.frame_moves++;
+        } else {
+            compaction_stats.stale_moves++;
+        }
+    }
+
+    while(next_frame_move == frame_move_count && next_segment_move < segment_move_count) {
+        SegmentMove* move = &segment_moves[next_segment_move];
+        if(bytes > 0 && bytes + move->limit > budget_bytes) {
+            break;
+        }
+        next_segment_move++;
+        SegmentTableEntry* segment = &processes[move->pid].segment_table[move->segment_id];
+        if(processes[move->pid].pid != -1 && segment->valid &&
+           segment->base_address == move->from && segment->limit == move->limit &&
+           migrate_segment(move->pid, move->segment_id, move->to) == 0) {
+            bytes += move->limit;
+            moves++;
+            compaction_stats.segment_moves++;
+        } else {
+            compaction_stats.stale_moves++;
+        }
+    }
+
+    uint64_t stall = (uint64_t)bytes * COMPACTION_COPY_NS_PER_KB / 1024 +
+                     (uint64_t)moves * COMPACTION_REMAP_NS;
+    compaction_stats.steps++;
+    compaction_stats.bytes_moved += bytes;
+    compaction_stats.stall_ns += stall;
+    if(stall > compaction_stats.max_step_stall_ns) {
+        compaction_stats.max_step_stall_ns = stall;
+    }
+
+    if(!compaction_pending()) {
+        finish_run();
+    }
+    return bytes;
+}
+
+// Compact frames and segments now, in budgeted steps
+void compact_memory() {
+    if(compaction_plan(COMPACTION_AUTO_ORDER) < 0) {
+        return;
+    }
+    if(!compaction_pending()) {
+        finish_run();
+    }
+    while(compaction_pending()) {
+        compaction_step(COMPACTION_STEP_BUDGET);
+    }
+    display_compaction_report();
+}
+
+// ==================== REPORTS ====================
+
+// Moves, stalls and fragmentation before/after the last run
+void display_compaction_report() {
+    CompactionStats* s = &compaction_stats;
+
+    printf("\n==================== MEMORY COMPACTION ====================\n");
+    printf("Runs: %llu, Steps: %llu, Plan: %s (target order %d)\n",
+           s->runs, s->steps, s->plan_name ? s->plan_name : "--", s->target_order);
+    printf("Pages moved: %llu, Segments moved: %llu, Stale moves skipped: %llu\n",
+           s->frame_moves, s->segment_moves, s->stale_moves);
+    printf("Bytes moved: %llu (%.1f KB)\n", s->bytes_moved, s->bytes_moved / 1024.0);
+    printf("Stall: %.1f us total, %.1f us longest step\n",
+           s->stall_ns / 1000.0, s->max_step_stall_ns / 1000.0);
+
+    printf("\n                        Before     After\n");
+    printf("----------------------  --------  --------\n");
+    printf("Largest free order      %8d  %8d\n", s->largest_order_before, s->largest_order_after);
+    printf("Unusable at target      %7.1f%%  %7.1f%%\n",
+           100.0 * s->unusable_before, 100.0 * s->unusable_after);
+    printf("Segment fragmentation   %7.1f%%  %7.1f%%\n",
+           100.0 * s->segment_frag_before, 100.0 * s->segment_frag_after);
+    printf("Segment fragmentation = 1 - largest free extent / free segment space\n");
+    printf("===========================================================\n");
+}
+
+// Fragment frames and segments with a seeded workload, then compact step by step
+void run_compaction_demo(int budget_bytes, uint64_t seed) {
+    WorkloadRng rng;
+    int pids[3];
+
+    if(budget_bytes <= 0) {
+        printf("Error: Invalid step budget %d\n", budget_bytes);
+        return;
+    }
+
+    verbose_mode = 0;
+    init_memory_system();
+    memset(&compaction_stats, 0, sizeof(compaction_stats));
+    workload_rng_seed(&rng, seed);
+
+    pids[0] = create_process("compact-a");
+    pids[1] = create_process("compact-b");
+    pids[2] = create_process("compact-c");
+
+    // Fill memory, then free every other frame's page
+    for(int frame = 0; frame < MAX_FRAMES; frame++) {
+        int pid = pids[workload_rng_bounded(&rng, 3)];
+        allocate_page(pid, (int)workload_rng_bounded(&rng, MAX_PAGES));
+    }
+    for(int frame = 1; frame < MAX_FRAMES; frame += 2) {
+        if(!physical_memory[frame].is_free) {
+            deallocate_page(physical_memory[frame].process_id, physical_memory[frame].page_number);
+        }
+    }
+
+    // Segments placed back to back, then every other one deleted
+    for(int i = 0; i < MAX_SEGMENTS; i++) {
+        for(int p = 0; p < 3; p++) {
+            create_segment(pids[p], i, -1, 1 + (int)workload_rng_bounded(&rng, SEGMENT_SIZE));
+        }
+    }
+    for(int i = 0; i < MAX_SEGMENTS; i += 2) {
+        for(int p = 0; p < 3; p++) {
+            delete_segment(pids[p], i);
+        }
+    }
+
+    if(compaction_plan(COMPACTION_AUTO_ORDER) < 0) {
+        return;
+    }
+    printf("\nCompaction: step budget %d bytes, seed %llu\n", budget_bytes, (unsigned long long)seed);
+    printf("\nStep     Bytes  Pages  Segments\n");
+    printf("----  --------  -----  --------\n");
+    for(int step = 1; compaction_pending(); step++) {
+        unsigned long long pages = compaction_stats.frame_moves;
+        unsigned long long segments = compaction_stats.segment_moves;
+        int bytes = compaction_step(budget_bytes);
+        printf("%4d  %8d  %5llu  %8llu\n", step, bytes,
+               compaction_stats.frame_moves - pages, compaction_stats.segment_moves - segments);
+    }
+    if(compaction_stats.steps == 0) {
+        finish_run();
+    }
+    display_compaction_report();
+}
@@ -0,0 +1,62 @@
+/**
+ * compaction.h
+ * Frame and segment compaction module header
+ */
+
+#ifndef COMPACTION_H
+#define COMPACTION_H
+
+#include <stdint.h>
+#include "../../include/common_defs.h"
+
+#define COMPACTION_AUTO_ORDER -1        // Largest order the free frames allow
+#define COMPACTION_STEP_BUDGET (2 * PAGE_SIZE)
+
+// Simulated stall costs
+#define COMPACTION_COPY_NS_PER_KB 100   // Roughly 10 GB/s copy bandwidth
+#define COMPACTION_REMAP_NS 500         // Table update and TLB shootdown per move
+
+typedef struct {
+    int from;
+    int to;
+} FrameMove;
+
+typedef struct {
+    int pid;
+    int segment_id;
+    int from;
+    int to;
+    int limit;
+} SegmentMove;
+
+typedef struct {
+    unsigned long long runs;
+    unsigned long long steps;
+    unsigned long long frame_moves;
+    unsigned long long segment_moves;
+    unsigned long long stale_moves;     // Skipped: state changed since planning
+    unsigned long long bytes_moved;
+    uint64_t stall_ns;
+    uint64_t max_step_stall_ns;
+
+    // Last run
+    int target_order;
+    const char* plan_name;
+    int largest_order_before;
+    int largest_order_after;
+    double unusable_before;             // Free frames unusable at the target order
+    double unusable_after;
+    double segment_frag_before;
+    double segment_frag_after;
+} CompactionStats;
+
+extern CompactionStats compaction_stats;
+
+// Function Prototypes
+int compaction_plan(int target_order);
+int compaction_step(int budget_bytes);
+int compaction_pending();
+void display_compaction_report();
+void run_compaction_demo(int budget_bytes, uint64_t seed);
+
+#endif // COMPACTION_H
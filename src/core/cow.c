@@ -0,0 +1,321 @@
+/**
+ * cow.c
+ * Reverse mapping and copy-on-write fork implementation
+ *
+ * Every frame keeps the list of page table entries that map it. The first
+ * entry is the frame's owner as shown by physical_memory[].process_id /
+ * page_number, and ref_count is the length of the list. fork_process()
+ * adds the child to the reverse map of each resident frame of the parent
+ * and marks both entries copy-on-write. The first write through either
+ * entry copies the frame, unless it is the last mapping left, which just
+ * takes the frame back. Eviction and migration walk the reverse map, so
+ * shared frames are unmapped or moved for every process at once.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cow.h"
+#include "memory_manager.h"
+#include "virtual_memory.h"
+#include "segmentation.h"
+#include "tlb.h"
+#include "ksm.h"
+#include "overcommit.h"
+#include "page_cache.h"
+#include "vma.h"
+#include "../trace/workload.h"
+
+FrameRmap frame_rmap[MAX_FRAMES];
+CowStats cow_stats;
+
+// Clear every reverse map and the fork counters
+void reset_cow() {
+    memset(frame_rmap, 0, sizeof(frame_rmap));
+    memset(&cow_stats, 0, sizeof(cow_stats));
+}
+
+// ==================== REVERSE MAP ====================
+
+static void update_owner(int frame_id) {
+    FrameRmap* rmap = &frame_rmap[frame_id];
+    physical_memory[frame_id].ref_count = rmap->count;
+    physical_memory[frame_id].process_id = rmap->count ? rmap->entries[0].pid : -1;
+    physical_memory[frame_id].page_number = rmap->count ? rmap->entries[0].page_number : -1;
+}
+
+// Record that a page maps the frame
+void rmap_add(int frame_id, int pid, int page_number) {
+    FrameRmap* rmap = &frame_rmap[frame_id];
+    if(rmap->count == RMAP_MAX_MAPPINGS) {
+        printf("Error: Frame %d already mapped by every page\n", frame_id);
+        return;
+    }
+    rmap->entries[rmap->count].pid = pid;
+    rmap->entries[rmap->count].page_number = page_number;
+    rmap->count++;
+    update_owner(frame_id);
+}
+
+// Forget a page's mapping of the frame, returns the mappings left
+int rmap_remove(int frame_id, int pid, int page_number) {
+    FrameRmap* rmap = &frame_rmap[frame_id];
+    for(int i = 0; i < rmap->count; i++) {
+        if(rmap->entries[i].pid == pid && rmap->entries[i].page_number == page_number) {
+            // Keep the order so the oldest remaining mapper becomes the owner
+            memmove(&rmap->entries[i], &rmap->entries[i + 1],
+                    (rmap->count - i - 1) * sizeof(RmapEntry));
+            rmap->count--;
+            break;
+        }
+    }
+    update_owner(frame_id);
+    return rmap->count;
+}
+
+// Hand every mapping of one frame to another
+void rmap_move(int from_frame, int to_frame) {
+    frame_rmap[to_frame] = frame_rmap[from_frame];
+    frame_rmap[from_frame].count = 0;
+    update_owner(to_frame);
+    update_owner(from_frame);
+}
+
+// Frames saved by sharing: every mapping beyond the first
+int cow_saved_pages() {
+    int saved = 0;
+    for(int i = 0; i < MAX_FRAMES; i++) {
+        if(physical_memory[i].ref_count > 1) {
+            saved += physical_memory[i].ref_count - 1;
+        }
+    }
+    return saved;
+}
+
+// ==================== FORK ====================
+
+// Create a child sharing every resident page of pid copy-on-write, returns its pid or -1
+int fork_process(int pid) {
+    if(pid < 0 || pid >= MAX_PROCESSES || processes[pid].pid == -1) {
+        printf("Error: Invalid process ID %d\n", pid);
+        return -1;
+    }
+
+    // Swapped pages are duplicated in swap rather than shared
+    if(swap_free_slots() < swap_pages(pid)) {
+        printf("Error: Not enough swap to fork Process %d\n", pid);
+        return -1;
+    }
+
+    char name[50];
+    snprintf(name, sizeof(name), "%.40s-fork", processes[pid].name);
+    int child = create_process(name);
+    if(child == -1) {
+        return -1;
+    }
+
+    // The child's private pages must be committed too
+    if(overcommit_fork(pid, child) != 0) {
+        printf("Error: Not enough commit to fork Process %d\n", pid);
+        terminate_process(child);
+        return -1;
+    }
+
+    // The child copies the parent's regions; shared file mappings stay shared
+    // and everything else becomes copy-on-write
+    vma_fork(pid, child);
+    int shared = 0;
+    for(int page = 0; page < MAX_PAGES; page++) {
+        PageTableEntry* parent_entry = &processes[pid].page_table[page];
+        PageTableEntry* child_entry = &processes[child].page_table[page];
+        Vma* mapping = find_file_mapping(pid, page);
+        bool private_page = mapping == NULL || !(mapping->flags & VMA_SHARED);
+
+        if(parent_entry->present) {
+            map_page(child, page, parent_entry->frame_number);
+            parent_entry->cow = private_page;
+            child_entry->cow = private_page;
+            child_entry->modified = parent_entry->modified;
+            shared++;
+        } else if(swap_duplicate(pid, page, child) != -1) {
+            child_entry->valid = true;
+        }
+    }
+
+    // The parent's cached translations were writable
+    tlb_flush_asid(pid);
+
+    for(int i = 0; i < MAX_SEGMENTS; i++) {
+        if(processes[pid].segment_table[i].valid) {
+            create_segment(child, i, -1, processes[pid].segment_table[i].limit);
+        }
+    }
+
+    cow_stats.forks++;
+    cow_stats.pages_shared += shared;
+    int saved = cow_saved_pages();
+    if(saved > cow_stats.peak_saved_pages) {
+        cow_stats.peak_saved_pages = saved;
+    }
+
+    VPRINTF("✓ Process %d forked into Process %d, %d pages shared copy-on-write\n",
+            pid, child, shared);
+    return child;
+}
+
+// Give a process its own copy of a shared page, returns the frame now mapped or -1
+int cow_fault(int pid, int page_number) {
+    PageTableEntry* entry = &processes[pid].page_table[page_number];
+    if(!entry->present || !entry->cow) {
+        return entry->present ? entry->frame_number : -1;
+    }
+
+    cow_stats.cow_faults++;
+    int old_frame = entry->frame_number;
+    if(ksm_is_merged(old_frame)) {
+        ksm_stats.pages_unmerged++;
+    }
+
+    // The last mapper keeps the frame, which can no longer be merged into;
+    // the zero frame and page cache frames are never handed over
+    if(physical_memory[old_frame].ref_count == 1 && old_frame != zero_frame &&
+       !page_cache_holds(old_frame)) {
+        ksm_forget_frame(old_frame);
+        entry->cow = false;
+        cow_stats.pages_reused++;
+        VPRINTF("  ✓ COW: Page %d of Process %d is no longer shared, Frame %d reused\n",
+                page_number, pid, old_frame);
+        return old_frame;
+    }
+
+    // Reclaim may pick the shared frame itself, so copy it out first
+    unsigned char contents[PAGE_SIZE];
+    bool dirty = physical_memory[old_frame].dirty;
+    memcpy(contents, frame_data[old_frame], PAGE_SIZE);
+
+    int frame_id = find_free_frame();
+    if(frame_id == -1) {
+        frame_id = reclaim_frame();
+    }
+
+    if(processes[pid].pid == -1) {
+        return -1;  // Killed to free memory
+    }
+
+    // An evicted anonymous page is faulted back privately; a cached file
+    // page has no swap copy and is copied from what was read above
+    bool file_page = find_file_mapping(pid, page_number) != NULL;
+    if(!entry->present && (!file_page || swap_lookup(pid, page_number) != -1)) {
+        if(swap_lookup(pid, page_number) != -1) {
+            swap_in(pid, page_number);
+        } else {
+            allocate_page(pid, page_number);
+        }
+        return entry->present ? entry->frame_number : -1;
+    }
+    if(frame_id == -1) {
+        printf("Error: No frame available to copy page %d\n", page_number);
+        return -1;
+    }
+
+    physical_memory[frame_id].load_time = current_time;
+    physical_memory[frame_id].last_access = current_time;
+    physical_memory[frame_id].reference_bit = 1;
+    physical_memory[frame_id].dirty = dirty;
+    memcpy(frame_data[frame_id], contents, PAGE_SIZE);
+    mark_frame_used(frame_id);
+
+    if(entry->present) {
+        unmap_page(pid, page_number);
+    }
+    map_page(pid, page_number, frame_id);
+    entry->referenced = true;
+    cow_stats.pages_copied++;
+
+    VPRINTF("  ✓ COW: Page %d of Process %d copied from Frame %d to Frame %d\n",
+            page_number, pid, old_frame, frame_id);
+    return frame_id;
+}
+
+// ==================== REPORTS ====================
+
+// Fork and copy-on-write counters with the memory sharing saves now
+void display_cow_stats() {
+    int shared_frames = 0;
+    for(int i = 0; i < MAX_FRAMES; i++) {
+        shared_frames += (physical_memory[i].ref_count > 1);
+    }
+
+    printf("\n==================== COPY-ON-WRITE ====================\n");
+    printf("Forks: %d, Pages shared at fork: %d\n", cow_stats.forks, cow_stats.pages_shared);
+    printf("CoW faults: %d (%d copied, %d reused by the last mapper)\n",
+           cow_stats.cow_faults, cow_stats.pages_copied, cow_stats.pages_reused);
+    printf("Shared frames now: %d\n", shared_frames);
+    printf("Memory saved: %d KB now, %d KB at peak\n",
+           cow_saved_pages() * PAGE_SIZE / 1024, cow_stats.peak_saved_pages * PAGE_SIZE / 1024);
+    printf("=======================================================\n");
+}
+
+// Fork pre-warmed workers and follow their RSS as writes break sharing
+void run_fork_simulation(int workers, int refs, int write_percent, uint64_t seed) {
+    WorkloadRng rng;
+    int children[MAX_PROCESSES];
+    int warm_pages = MAX_FRAMES / 2;
+
+    if(workers < 1 || workers > MAX_PROCESSES - 1 || refs <= 0 ||
+       write_percent < 0 || write_percent > 100) {
+        printf("Error: Need 1-%d workers, a positive reference count and a write share of 0-100%%\n",
+               MAX_PROCESSES - 1);
+        return;
+    }
+
+    verbose_mode = 0;
+    init_memory_system();
+    workload_rng_seed(&rng, seed);
+
+    // The parent warms its working set, dirtying every page
+    int parent = create_process("prewarmed");
+    for(int page = 0; page < warm_pages; page++) {
+        access_memory_ex(parent, page * PAGE_SIZE, true);
+    }
+    for(int i = 0; i < workers; i++) {
+        children[i] = fork_process(parent);
+    }
+
+    printf("\nFork: %d workers from a parent with %d resident pages, %d%% writes, seed %llu\n",
+           workers, warm_pages, write_percent, (unsigned long long)seed);
+    printf("\n  Refs  RSS (KB)  Frames  Shared  Saved (KB)  CoW faults  Copies\n");
+    printf("------  --------  ------  ------  ----------  ----------  ------\n");
+
+    int interval = refs / 10 > 0 ? refs / 10 : 1;
+    for(int ref = 0; ref <= refs; ref++) {
+        if(ref % interval == 0 || ref == refs) {
+            int rss = 0;
+            int used = 0;
+            int shared = 0;
+            for(int p = 0; p < MAX_PROCESSES; p++) {
+                if(processes[p].pid != -1) rss += processes[p].memory_usage;
+            }
+            for(int f = 0; f < MAX_FRAMES; f++) {
+                used += !physical_memory[f].is_free;
+                shared += (physical_memory[f].ref_count > 1);
+            }
+            printf("%6d  %8d  %6d  %6d  %10d  %10d  %6d\n",
+                   ref, rss, used, shared, cow_saved_pages() * PAGE_SIZE / 1024,
+                   cow_stats.cow_faults, cow_stats.pages_copied);
+        }
+        if(ref == refs) {
+            break;
+        }
+
+        // Workers stay in the inherited working set
+        int pid = children[ref % workers];
+        int page = (int)workload_rng_bounded(&rng, (uint32_t)warm_pages);
+        bool is_write = (int)workload_rng_bounded(&rng, 100) < write_percent;
+        if(pid != -1) {
+            access_memory_ex(pid, page * PAGE_SIZE, is_write);
+        }
+    }
+
+    display_cow_stats();
+}
@@ -0,0 +1,51 @@
+/**
+ * cow.h
+ * Reverse mapping and copy-on-write fork module header
+ */
+
+#ifndef COW_H
+#define COW_H
+
+#include <stdint.h>
+#include "../../include/common_defs.h"
+
+// One page table entry mapping a frame
+typedef struct {
+    int pid;
+    int page_number;
+} RmapEntry;
+
+// Same-page merging can map one frame from every page of every process
+#define RMAP_MAX_MAPPINGS (MAX_PROCESSES * MAX_PAGES)
+
+// Every mapping of a frame, oldest first
+typedef struct {
+    RmapEntry entries[RMAP_MAX_MAPPINGS];
+    int count;
+} FrameRmap;
+
+// Copy-on-write counters
+typedef struct {
+    int forks;
+    int pages_shared;       // Resident pages shared at fork time
+    int cow_faults;         // Writes to a shared page
+    int pages_copied;       // Faults that had to copy the frame
+    int pages_reused;       // Faults by the last mapper, which keeps the frame
+    int peak_saved_pages;
+} CowStats;
+
+extern FrameRmap frame_rmap[MAX_FRAMES];
+extern CowStats cow_stats;
+
+// Function Prototypes
+void reset_cow();
+void rmap_add(int frame_id, int pid, int page_number);
+int rmap_remove(int frame_id, int pid, int page_number);
+void rmap_move(int from_frame, int to_frame);
+int fork_process(int pid);
+int cow_fault(int pid, int page_number);
+int cow_saved_pages();
+void display_cow_stats();
+void run_fork_simulation(int workers, int refs, int write_percent, uint64_t seed);
+
+#endif // COW_H
@@ -0,0 +1,378 @@
+/**
+ * ksm.c
+ * Same-page merging scanner implementation
+ *
+ * Like Linux KSM, the scanner walks every resident page a few pages per
+ * tick. Frames already merged form the stable tree; candidates seen this
+ * pass form the unstable tree, which is rebuilt on every pass because
+ * its pages can change under it. A page is only offered to the unstable
+ * tree once its checksum matched on two passes in a row, so pages that
+ * are still being written are left alone. Both trees are treaps keyed by
+ * a 64-bit hash of the contents rather than ordered by memcmp; a hash
+ * match is confirmed with a full compare before merging. Merged pages
+ * are mapped copy-on-write, so a write breaks them apart through
+ * cow_fault().
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ksm.h"
+#include "memory_manager.h"
+#include "virtual_memory.h"
+#include "cow.h"
+#include "page_cache.h"
+#include "../utils/extent_tree.h"
+#include "../trace/workload.h"
+
+// Unstable tree entries are tagged with the page they came from
+#define KSM_PAGE_TAG(pid, page) (((uint64_t)(uint32_t)(pid) << 32) | (uint32_t)(page))
+#define KSM_TAG_PID(tag) ((int)((tag) >> 32))
+#define KSM_TAG_PAGE(tag) ((int)((tag) & 0xFFFFFFFFu))
+
+#define KSM_PRIME1 0x9E3779B185EBCA87ULL
+#define KSM_PRIME2 0xC2B2AE3D27D4EB4FULL
+
+KsmStats ksm_stats;
+int ksm_pages_per_tick = KSM_DEFAULT_PAGES_PER_TICK;
+
+static ExtentTree stable_tree;          // (hash, frame) of every merged frame
+static ExtentTree unstable_tree;        // (hash, page tag) of this pass's candidates
+static bool stable_frame[MAX_FRAMES];
+static uint64_t stable_hash[MAX_FRAMES];
+static uint64_t page_checksum[MAX_PROCESSES][MAX_PAGES];
+static int cursor_pid;
+static int cursor_page;
+
+// Drop both trees, the checksums and the counters
+void reset_ksm() {
+    extent_tree_free(&stable_tree);
+    extent_tree_free(&unstable_tree);
+    memset(stable_frame, 0, sizeof(stable_frame));
+    memset(page_checksum, 0, sizeof(page_checksum));
+    memset(&ksm_stats, 0, sizeof(ksm_stats));
+    cursor_pid = 0;
+    cursor_page = 0;
+}
+
+static uint64_t rotate_left(uint64_t value, int bits) {
+    return (value << bits) | (value >> (64 - bits));
+}
+
+// Four-lane multiply-rotate hash of a whole page, in the style of xxHash64
+uint64_t ksm_page_hash(const unsigned char* data) {
+    uint64_t lanes[4] = {KSM_PRIME1, KSM_PRIME2, 0, ~KSM_PRIME1};
+
+    for(int i = 0; i < PAGE_SIZE; i += 32) {
+        for(int lane = 0; lane < 4; lane++) {
+            uint64_t word;
+            memcpy(&word, data + i + lane * 8, sizeof(word));
+            lanes[lane] = rotate_left(lanes[lane] + word * KSM_PRIME2, 31) * KSM_PRIME1;
+        }
+    }
+
+    uint64_t hash = rotate_left(lanes[0], 1) + rotate_left(lanes[1], 7) +
+                    rotate_left(lanes[2], 12) + rotate_left(lanes[3], 18);
+    hash ^= hash >> 33;
+    hash *= KSM_PRIME2;
+    hash ^= hash >> 29;
+    return hash;
+}
+
+// ==================== FRAME TRACKING ====================
+
+// True if the frame is a shared frame in the stable tree
+bool ksm_is_merged(int frame_id) {
+    return frame_id >= 0 && frame_id < MAX_FRAMES && stable_frame[frame_id];
+}
+
+// Take a frame out of the stable tree once it is freed or written in place
+void ksm_forget_frame(int frame_id) {
+    if(!ksm_is_merged(frame_id)) {
+        return;
+    }
+    extent_tree_remove(&stable_tree, stable_hash[frame_id], (uint64_t)frame_id);
+    stable_frame[frame_id] = false;
+}
+
+// Follow a merged frame moved by compaction
+void ksm_migrate_frame(int from_frame, int to_frame) {
+    if(!ksm_is_merged(from_frame)) {
+        return;
+    }
+    uint64_t hash = stable_hash[from_frame];
+    ksm_forget_frame(from_frame);
+    stable_frame[to_frame] = true;
+    stable_hash[to_frame] = hash;
+    extent_tree_insert(&stable_tree, hash, (uint64_t)to_frame, 1);
+}
+
+// Merged frames in use
+int ksm_pages_shared() {
+    int shared = 0;
+    for(int i = 0; i < MAX_FRAMES; i++) {
+        shared += stable_frame[i];
+    }
+    return shared;
+}
+
+// Mappings of merged frames beyond the first, i.e. frames saved
+int ksm_pages_sharing() {
+    int sharing = 0;
+    for(int i = 0; i < MAX_FRAMES; i++) {
+        if(stable_frame[i] && physical_memory[i].ref_count > 1) {
+            sharing += physical_memory[i].ref_count - 1;
+        }
+    }
+    return sharing;
+}
+
+// ==================== SCANNER ====================
+
+static bool same_contents(int frame_a, int frame_b) {
+    ksm_stats.bytes_compared += PAGE_SIZE;
+    ksm_stats.scan_ns += PAGE_SIZE / 1024 * KSM_COMPARE_NS_PER_KB;
+    return memcmp(frame_data[frame_a], frame_data[frame_b], PAGE_SIZE) == 0;
+}
+
+// Point a page at a shared frame; its own frame is freed if nothing else maps it
+static void merge_page(int pid, int page_number, int target) {
+    PageTableEntry* entry = &processes[pid].page_table[page_number];
+    bool modified = entry->modified;
+
+    unmap_page(pid, page_number);
+    map_page(pid, page_number, target);
+    entry->cow = true;
+    entry->modified = modified;
+    ksm_stats.scan_ns += KSM_MERGE_NS;
+
+    VPRINTF("  ✓ KSM: Page %d of Process %d merged into Frame %d (%d mappings)\n",
+            page_number, pid, target, physical_memory[target].ref_count);
+}
+
+// Try the stable tree, then the unstable tree, for one resident page
+static void scan_page(int pid, int page_number) {
+    int frame_id = processes[pid].page_table[page_number].frame_number;
+
+    // Merged frames need no work; frames shared by fork or the zero frame are
+    // left to copy-on-write, and file pages are already shared by the page cache
+    if(stable_frame[frame_id] || physical_memory[frame_id].ref_count > 1 ||
+       frame_id == zero_frame || page_cache_holds(frame_id)) {
+        return;
+    }
+
+    ksm_stats.pages_scanned++;
+    ksm_stats.bytes_hashed += PAGE_SIZE;
+    ksm_stats.scan_ns += PAGE_SIZE / 1024 * KSM_HASH_NS_PER_KB;
+    uint64_t hash = ksm_page_hash(frame_data[frame_id]);
+
+    for(ExtentNode* node = extent_tree_lower_bound(&stable_tree, hash, 0);
+        node != NULL && node->key == hash;
+        node = extent_tree_lower_bound(&stable_tree, hash, node->tie + 1)) {
+        if(same_contents(frame_id, (int)node->tie)) {
+            merge_page(pid, page_number, (int)node->tie);
+            ksm_stats.stable_hits++;
+            return;
+        }
+    }
+
+    // Only pages that stayed unchanged since the last pass are candidates
+    if(page_checksum[pid][page_number] != hash) {
+        page_checksum[pid][page_number] = hash;
+        ksm_stats.pages_volatile++;
+        return;
+    }
+
+    for(ExtentNode* node = extent_tree_lower_bound(&unstable_tree, hash, 0);
+        node != NULL && node->key == hash;
+        node = extent_tree_lower_bound(&unstable_tree, hash, node->tie + 1)) {
+        int other_pid = KSM_TAG_PID(node->tie);
+        int other_page = KSM_TAG_PAGE(node->tie);
+        PageTableEntry* other = &processes[other_pid].page_table[other_page];
+
+        // Unstable entries may have been unmapped, merged or rewritten since
+        if(processes[other_pid].pid == -1 || !other->present ||
+           (other_pid == pid && other_page == page_number)) {
+            continue;
+        }
+        int other_frame = other->frame_number;
+        if(stable_frame[other_frame] || physical_memory[other_frame].ref_count > 1 ||
+           other_frame == zero_frame || page_cache_holds(other_frame) ||
+           !same_contents(frame_id, other_frame)) {
+            continue;
+        }
+
+        // The other page's frame becomes the shared frame
+        extent_tree_remove(&unstable_tree, hash, node->tie);
+        stable_frame[other_frame] = true;
+        stable_hash[other_frame] = hash;
+        extent_tree_insert(&stable_tree, hash, (uint64_t)other_frame, 1);
+        other->cow = true;
+        merge_page(pid, page_number, other_frame);
+        ksm_stats.unstable_hits++;
+        return;
+    }
+
+    extent_tree_insert(&unstable_tree, hash, KSM_PAGE_TAG(pid, page_number), 1);
+}
+
+// Scan up to pages resident pages from the cursor, returns how many were examined
+int ksm_scan(int pages) {
+    uint64_t visits_before = stable_tree.visits + unstable_tree.visits;
+    int examined = 0;
+
+    // Every page table entry is looked at no more than once per call
+    for(int step = 0; step < MAX_PROCESSES * MAX_PAGES && examined < pages; step++) {
+        int pid = cursor_pid;
+        int page_number = cursor_page;
+
+        if(++cursor_page == MAX_PAGES) {
+            cursor_page = 0;
+            if(++cursor_pid == MAX_PROCESSES) {
+                // End of a pass: candidates are collected again from scratch
+                cursor_pid = 0;
+                extent_tree_free(&unstable_tree);
+                ksm_stats.full_scans++;
+            }
+        }
+
+        if(processes[pid].pid != -1 && processes[pid].page_table[page_number].present) {
+            scan_page(pid, page_number);
+            examined++;
+        }
+    }
+
+    ksm_stats.tree_steps += stable_tree.visits + unstable_tree.visits - visits_before;
+    return examined;
+}
+
+// One scanner wake-up at the configured rate
+int ksm_tick() {
+    ksm_stats.ticks++;
+    return ksm_scan(ksm_pages_per_tick);
+}
+
+// ==================== REPORTS ====================
+
+// Sharing achieved and what the scanner spent on it
+void display_ksm_stats() {
+    double busy = ksm_stats.ticks ?
+                  (double)ksm_stats.scan_ns * 100.0 / (ksm_stats.ticks * KSM_TICK_NS) : 0.0;
+
+    printf("\n==================== SAME-PAGE MERGING ====================\n");
+    printf("Pages shared: %d frames, %d more mappings of them (%d KB saved)\n",
+           ksm_pages_shared(), ksm_pages_sharing(), ksm_pages_sharing() * PAGE_SIZE / 1024);
+    printf("Unstable candidates this pass: %llu\n", (unsigned long long)unstable_tree.count);
+    printf("Merges: %llu into stable frames, %llu new pairs; %llu broken by writes\n",
+           ksm_stats.stable_hits, ksm_stats.unstable_hits, ksm_stats.pages_unmerged);
+    printf("Scanned: %llu pages, %llu volatile, %llu full passes, %d pages per tick\n",
+           ksm_stats.pages_scanned, ksm_stats.pages_volatile, ksm_stats.full_scans,
+           ksm_pages_per_tick);
+    printf("Scan cost: %llu KB hashed, %llu KB compared, %llu tree steps\n",
+           ksm_stats.bytes_hashed / 1024, ksm_stats.bytes_compared / 1024, ksm_stats.tree_steps);
+    printf("Scanner CPU: %.1f us over %llu ticks (%.4f%% of one CPU)\n",
+           ksm_stats.scan_ns / 1000.0, ksm_stats.ticks, busy);
+    printf("===========================================================\n");
+}
+
+// Fill a page with the bytes of one image page; equal seeds give equal pages
+static void fill_page(int pid, int page_number, uint64_t content_seed) {
+    unsigned char data[PAGE_SIZE];
+    WorkloadRng rng;
+    workload_rng_seed(&rng, content_seed);
+    for(int i = 0; i < PAGE_SIZE; i++) {
+        data[i] = (unsigned char)workload_rng_bounded(&rng, 256);
+    }
+    write_memory(pid, page_number * PAGE_SIZE, data, PAGE_SIZE);
+}
+
+// Run near-identical VMs with the scanner off and on
+void run_ksm_simulation(int vms, int pages_per_tick, int ticks, uint64_t seed) {
+    const int image_pages = 3;                  // Same in every VM
+    const int zero_page = image_pages;          // Touched but never written
+    const int private_page = image_pages + 1;   // Rewritten now and then
+    const int vm_pages = image_pages + 2;
+    const int refs_per_tick = 1;
+    int faults[2] = {0, 0};
+
+    if(vms < 2 || vms > MAX_PROCESSES || pages_per_tick < 1 || ticks <= 0) {
+        printf("Error: Need 2-%d VMs, at least one page per tick and a positive tick count\n",
+               MAX_PROCESSES);
+        return;
+    }
+
+    verbose_mode = 0;
+    printf("\n%d VMs x %d pages (%d image, 1 zero, 1 private) on %d frames, seed %llu\n",
+           vms, vm_pages, image_pages, MAX_FRAMES, (unsigned long long)seed);
+
+    for(int run = 0; run < 2; run++) {
+        WorkloadRng rng;
+        int pids[MAX_PROCESSES];
+        bool merging = (run == 1);
+
+        init_memory_system();
+        workload_rng_seed(&rng, seed);
+        ksm_pages_per_tick = pages_per_tick;
+
+        // Boot every VM from the same image
+        for(int v = 0; v < vms; v++) {
+            pids[v] = create_process("vm");
+            for(int page = 0; page < image_pages; page++) {
+                fill_page(pids[v], page, seed + page);
+            }
+            access_memory(pids[v], zero_page * PAGE_SIZE);
+            fill_page(pids[v], private_page, seed * 31 + v + 1000);
+        }
+        int faults_before = stats.total_page_faults;
+
+        if(merging) {
+            printf("\n  Tick  Frames  Mapped  Shared  Sharing  Faults  Scan (us)\n");
+            printf("------  ------  ------  ------  -------  ------  ---------\n");
+        }
+
+        int interval = ticks / 10 > 0 ? ticks / 10 : 1;
+        for(int tick = 0; tick <= ticks; tick++) {
+            if(merging && (tick % interval == 0 || tick == ticks)) {
+                int used = 0;
+                int mapped = 0;
+                for(int f = 0; f < MAX_FRAMES; f++) {
+                    used += !physical_memory[f].is_free;
+                }
+                for(int v = 0; v < vms; v++) {
+                    mapped += processes[pids[v]].page_count;
+                }
+                printf("%6d  %6d  %6d  %6d  %7d  %6d  %9.1f\n",
+                       tick, used, mapped, ksm_pages_shared(), ksm_pages_sharing(),
+                       stats.total_page_faults - faults_before, ksm_stats.scan_ns / 1000.0);
+            }
+            if(tick == ticks) {
+                break;
+            }
+
+            // Mostly reads across the image; a few writes, mostly to private data
+            for(int v = 0; v < vms; v++) {
+                for(int r = 0; r < refs_per_tick; r++) {
+                    int page = (int)workload_rng_bounded(&rng, (uint32_t)vm_pages);
+                    int address = page * PAGE_SIZE + (int)workload_rng_bounded(&rng, PAGE_SIZE / 8) * 8;
+                    if(workload_rng_double(&rng) < 0.05) {
+                        if(workload_rng_double(&rng) < 0.8) {
+                            address = private_page * PAGE_SIZE + address % PAGE_SIZE;
+                        }
+                        uint64_t word = workload_rng_next(&rng);
+                        write_memory(pids[v], address, &word, sizeof(word));
+                    } else {
+                        access_memory(pids[v], address);
+                    }
+                }
+            }
+            if(merging) {
+                ksm_tick();
+            }
+        }
+        faults[run] = stats.total_page_faults - faults_before;
+    }
+
+    printf("\nPage faults over %d ticks: %d without merging, %d with merging\n",
+           ticks, faults[0], faults[1]);
+    display_ksm_stats();
+}
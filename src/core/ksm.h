@@ -0,0 +1,51 @@
+/**
+ * ksm.h
+ * Same-page merging scanner (KSM) module header
+ */
+
+#ifndef KSM_H
+#define KSM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../../include/common_defs.h"
+
+#define KSM_DEFAULT_PAGES_PER_TICK 4
+
+// Simulated scanner cost
+#define KSM_HASH_NS_PER_KB 50           // Roughly 20 GB/s hashing
+#define KSM_COMPARE_NS_PER_KB 30
+#define KSM_MERGE_NS 500                // Table update and TLB shootdown, as for compaction
+#define KSM_TICK_NS 20000000ULL         // The scanner wakes every 20 ms
+
+typedef struct {
+    unsigned long long ticks;
+    unsigned long long pages_scanned;
+    unsigned long long pages_volatile;  // Changed since the last pass, not worth merging yet
+    unsigned long long stable_hits;     // Merged into an existing shared frame
+    unsigned long long unstable_hits;   // Merged with another candidate into a new shared frame
+    unsigned long long pages_unmerged;  // Writes that broke a merged page apart
+    unsigned long long full_scans;
+    unsigned long long bytes_hashed;
+    unsigned long long bytes_compared;
+    unsigned long long tree_steps;
+    unsigned long long scan_ns;
+} KsmStats;
+
+extern KsmStats ksm_stats;
+extern int ksm_pages_per_tick;
+
+// Function Prototypes
+void reset_ksm();
+uint64_t ksm_page_hash(const unsigned char* data);
+int ksm_scan(int pages);
+int ksm_tick();
+bool ksm_is_merged(int frame_id);
+void ksm_forget_frame(int frame_id);
+void ksm_migrate_frame(int from_frame, int to_frame);
+int ksm_pages_shared();
+int ksm_pages_sharing();
+void display_ksm_stats();
+void run_ksm_simulation(int vms, int pages_per_tick, int ticks, uint64_t seed);
+
+#endif // KSM_H
@@ -0,0 +1,71 @@
+/**
+ * latency.h
+ * Multi-component memory access latency model module header
+ */
+
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../../include/common_defs.h"
+#include "../utils/hdr_histogram.h"
+
+// Where the time of a reference goes
+typedef enum {
+    LAT_TLB_HIT,
+    LAT_PAGE_WALK,          // TLB miss on the way to the page table
+    LAT_DRAM,               // The access itself, plus any slow-tier or remote-node cost
+    LAT_MINOR_FAULT,        // Served from memory: zero fill, copy-on-write, page cache, hints
+    LAT_MAJOR_FAULT,        // Read from swap or a file
+    LAT_WRITEBACK,          // Dirty page written out to make room
+    LAT_COMPRESSION,        // Compressed swap instead of disk I/O
+    LAT_COMPONENT_COUNT
+} LatencyComponent;
+
+// Cost of one event of each component, in ns
+typedef struct {
+    int tlb_hit_ns;
+    int page_walk_ns;
+    int dram_ns;
+    int minor_fault_ns;
+    int major_fault_ns;
+    int writeback_ns;
+    int compress_ns;
+    int decompress_ns;
+    bool compressed_swap;   // Swap goes to compressed memory: compress and decompress replace the I/O
+} LatencyConfig;
+
+// One shard of the accounting; only its own process's references write it
+typedef struct {
+    unsigned long long events[LAT_COMPONENT_COUNT];
+    unsigned long long ns[LAT_COMPONENT_COUNT];
+    unsigned long long references;
+    unsigned long long total_ns;
+    HdrHistogram access;                // Every reference
+    HdrHistogram fault;                 // References that took a fault
+} LatencyAccount;
+
+extern LatencyConfig latency_config;
+extern LatencyAccount latency_process[MAX_PROCESSES];
+extern LatencyAccount latency_background;             // Work outside any reference
+
+// Function Prototypes
+LatencyConfig latency_default_config();
+int latency_config_set(const char* assignment);
+const char* latency_component_name(LatencyComponent component);
+void reset_latency();
+void latency_on_create(int pid);
+void latency_begin(int pid);
+void latency_charge(LatencyComponent component, unsigned long long ns);
+void latency_event(LatencyComponent component);
+void latency_swap_out();
+void latency_swap_in();
+unsigned long long latency_end();
+void latency_totals(LatencyAccount* total);
+void latency_merge(LatencyAccount* into, const LatencyAccount* from);
+double latency_mean_ns();
+void display_latency_stats();
+void run_latency_simulation(int refs, uint64_t seed);
+
+#endif // LATENCY_H
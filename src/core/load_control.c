@@ -0,0 +1,503 @@
+/**
+ * load_control.c
+ * Thrashing detection and load control implementation
+ *
+ * The monitor watches the page fault rate over fixed windows of memory
+ * references. When faults crowd out useful work (hits) the system is
+ * declared to be thrashing and, if load control is enabled, the process
+ * contributing the most faults is suspended by swapping out its whole
+ * resident set. Suspended processes are resumed once pressure drops and
+ * enough frames are free to hold the pages they had when suspended.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "load_control.h"
+#include "../../include/common_defs.h"
+#include "memory_manager.h"
+#include "virtual_memory.h"
+#include "../algorithms/lru.h"
+#include "../utils/logger.h"
+
+LoadControlConfig load_control_config = {0, 20, 50.0, 10.0, 1};
+LoadControlStats load_control_stats;
+
+// Current observation window
+static int window_refs = 0;
+static int window_faults = 0;
+static int process_window_refs[MAX_PROCESSES];
+static int process_window_faults[MAX_PROCESSES];
+
+// Resident set size at suspension time and suspension order
+static int saved_resident[MAX_PROCESSES];
+static int suspend_sequence[MAX_PROCESSES];
+static int next_sequence = 0;
+
+// Initialize load control with custom thresholds
+void init_load_control(int window_size, double thrash_threshold, double resume_threshold) {
+    if(window_size <= 0 || thrash_threshold <= resume_threshold) {
+        printf("Error: Invalid load control thresholds\n");
+        return;
+    }
+
+    load_control_config.window_size = window_size;
+    load_control_config.thrash_threshold = thrash_threshold;
+    load_control_config.resume_threshold = resume_threshold;
+    reset_load_control();
+
+    VPRINTF("Load control: window %d refs, thrash at %.1f%% faults, resume below %.1f%%\n",
+            window_size, thrash_threshold, resume_threshold);
+}
+
+// Clear monitor state (called on memory system initialization)
+void reset_load_control() {
+    window_refs = 0;
+    window_faults = 0;
+    next_sequence = 0;
+
+    for(int i = 0; i < MAX_PROCESSES; i++) {
+        process_window_refs[i] = 0;
+        process_window_faults[i] = 0;
+        saved_resident[i] = 0;
+        suspend_sequence[i] = -1;
+    }
+
+    load_control_stats.windows_observed = 0;
+    load_control_stats.thrashing_windows = 0;
+    load_control_stats.thrashing = 0;
+    load_control_stats.last_fault_rate = 0.0;
+    load_control_stats.suspensions = 0;
+    load_control_stats.resumptions = 0;
+    load_control_stats.admissions_deferred = 0;
+    load_control_stats.pages_swapped_out = 0;
+    load_control_stats.pages_prepaged = 0;
+}
+
+// Turn the load controller on or off
+void set_load_control_enabled(int enabled) {
+    load_control_config.enabled = enabled ? 1 : 0;
+}
+
+// Check whether a process may issue memory references
+int is_process_runnable(int pid) {
+    if(pid < 0 || pid >= MAX_PROCESSES || processes[pid].pid == -1) {
+        return 0;
+    }
+    return processes[pid].suspended ? 0 : 1;
+}
+
+// Count runnable processes
+static int runnable_count() {
+    int count = 0;
+    for(int i = 0; i < MAX_PROCESSES; i++) {
+        if(is_process_runnable(i)) {
+            count++;
+        }
+    }
+    return count;
+}
+
+// Count free physical frames
+static int free_frame_count() {
+    int count = 0;
+    for(int i = 0; i < MAX_FRAMES; i++) {
+        if(physical_memory[i].is_free) {
+            count++;
+        }
+    }
+    return count;
+}
+
+// Process faulting most in the current window (ties: largest resident set)
+static int select_suspend_victim() {
+    int victim = -1;
+
+    for(int i = 0; i < MAX_PROCESSES; i++) {
+        if(!is_process_runnable(i) || processes[i].page_count == 0) {
+            continue;
+        }
+        if(victim == -1 ||
+           process_window_faults[i] > process_window_faults[victim] ||
+           (process_window_faults[i] == process_window_faults[victim] &&
+            processes[i].page_count > processes[victim].page_count)) {
+            victim = i;
+        }
+    }
+
+    return victim;
+}
+
+// Suspended process that has waited longest and now fits in free frames
+static int select_resume_candidate() {
+    int candidate = -1;
+    int free_frames = free_frame_count();
+
+    for(int i = 0; i < MAX_PROCESSES; i++) {
+        if(processes[i].pid == -1 || !processes[i].suspended) {
+            continue;
+        }
+
+        int needed = saved_resident[i] > 0 ? saved_resident[i] : 1;
+        if(needed > free_frames && runnable_count() > 0) {
+            continue;
+        }
+
+        if(candidate == -1 || suspend_sequence[i] < suspend_sequence[candidate]) {
+            candidate = i;
+        }
+    }
+
+    return candidate;
+}
+
+// Suspend a process by swapping out its entire resident set
+int suspend_process(int pid) {
+    if(pid < 0 || pid >= MAX_PROCESSES || processes[pid].pid == -1) {
+        printf("Error: Invalid process ID %d\n", pid);
+        return -1;
+    }
+
+    if(processes[pid].suspended) {
+        return 0;
+    }
+
+    int swapped = 0;
+    for(int page = 0; page < MAX_PAGES; page++) {
+        if(!processes[pid].page_table[page].present) {
+            continue;
+        }
+        if(swap_out(pid, page) != 0) {
+            break;  // Swap space exhausted; keep the rest resident
+        }
+        swapped++;
+    }
+
+    processes[pid].suspended = true;
+    saved_resident[pid] = swapped;
+    suspend_sequence[pid] = next_sequence++;
+
+    load_control_stats.suspensions++;
+    load_control_stats.pages_swapped_out += swapped;
+
+    VPRINTF("⏸  Load control: suspended Process %d (%s), %d pages swapped out\n",
+            pid, processes[pid].name, swapped);
+    LOG_INFO("Load control suspended process %d (%d pages swapped out)", pid, swapped);
+
+    return swapped;
+}
+
+// Resume a suspended process, pre-paging what fits in free frames
+int resume_process(int pid) {
+    if(pid < 0 || pid >= MAX_PROCESSES || processes[pid].pid == -1) {
+        printf("Error: Invalid process ID %d\n", pid);
+        return -1;
+    }
+
+    if(!processes[pid].suspended) {
+        return 0;
+    }
+
+    processes[pid].suspended = false;
+    process_window_refs[pid] = 0;
+    process_window_faults[pid] = 0;
+
+    // Bring the saved resident set back while frames are free; anything
+    // else is demand-paged from swap on the next reference
+    int prepaged = 0;
+    for(int page = 0; page < MAX_PAGES && free_frame_count() > 0; page++) {
+        if(swap_lookup(pid, page) != -1) {
+            swap_in(pid, page);
+            prepaged++;
+        }
+    }
+
+    saved_resident[pid] = 0;
+    suspend_sequence[pid] = -1;
+    load_control_stats.resumptions++;
+    load_control_stats.pages_prepaged += prepaged;
+
+    VPRINTF("▶  Load control: resumed Process %d (%s), %d pages pre-paged\n",
+            pid, processes[pid].name, prepaged);
+    LOG_INFO("Load control resumed process %d (%d pages pre-paged)", pid, prepaged);
+
+    return prepaged;
+}
+
+// Resume the next waiting process if memory allows
+static void try_resume() {
+    if(!load_control_config.enabled || load_control_stats.thrashing) {
+        return;
+    }
+
+    int candidate = select_resume_candidate();
+    if(candidate != -1) {
+        resume_process(candidate);
+    }
+}
+
+// Close the current window and act on the verdict
+static void evaluate_window() {
+    double fault_rate = (window_faults * 100.0) / window_refs;
+
+    load_control_stats.windows_observed++;
+    load_control_stats.last_fault_rate = fault_rate;
+
+    if(fault_rate >= load_control_config.thrash_threshold) {
+        if(!load_control_stats.thrashing) {
+            LOG_INFO("Thrashing detected: %.1f%% of the last %d references faulted",
+                     fault_rate, window_refs);
+        }
+        load_control_stats.thrashing = 1;
+        load_control_stats.thrashing_windows++;
+
+        if(load_control_config.enabled && runnable_count() > load_control_config.min_active) {
+            int victim = select_suspend_victim();
+            if(victim != -1) {
+                suspend_process(victim);
+            }
+        }
+    } else if(fault_rate <= load_control_config.resume_threshold) {
+        load_control_stats.thrashing = 0;
+        try_resume();
+    }
+
+    window_refs = 0;
+    window_faults = 0;
+    for(int i = 0; i < MAX_PROCESSES; i++) {
+        process_window_refs[i] = 0;
+        process_window_faults[i] = 0;
+    }
+}
+
+// Record one memory reference (called from access_memory)
+void load_control_observe(int pid, int was_fault) {
+    if(pid < 0 || pid >= MAX_PROCESSES) {
+        return;
+    }
+
+    window_refs++;
+    process_window_refs[pid]++;
+    if(was_fault) {
+        window_faults++;
+        process_window_faults[pid]++;
+    }
+
+    if(window_refs >= load_control_config.window_size) {
+        evaluate_window();
+    }
+}
+
+// Admission control: new processes wait while the system thrashes
+void load_control_on_create(int pid) {
+    process_window_refs[pid] = 0;
+    process_window_faults[pid] = 0;
+    saved_resident[pid] = 0;
+    suspend_sequence[pid] = -1;
+
+    if(load_control_config.enabled && load_control_stats.thrashing &&
+       runnable_count() > load_control_config.min_active) {
+        processes[pid].suspended = true;
+        suspend_sequence[pid] = next_sequence++;
+        load_control_stats.admissions_deferred++;
+        VPRINTF("⏸  Load control: Process %d admitted suspended (system thrashing)\n", pid);
+    }
+}
+
+// A terminating process frees frames that a waiting process can use
+void load_control_on_terminate(int pid) {
+    process_window_refs[pid] = 0;
+    process_window_faults[pid] = 0;
+    saved_resident[pid] = 0;
+    suspend_sequence[pid] = -1;
+
+    try_resume();
+}
+
+// Display load control state
+void display_load_control_status() {
+    printf("\n================== LOAD CONTROL ==================\n");
+    printf("Load control: %s\n", load_control_config.enabled ? "ENABLED" : "monitor only");
+    printf("Window: %d references\n", load_control_config.window_size);
+    printf("Thrashing threshold: %.1f%% faults\n", load_control_config.thrash_threshold);
+    printf("Resume threshold: %.1f%% faults\n", load_control_config.resume_threshold);
+    printf("Current state: %s (last window %.1f%% faults)\n",
+           load_control_stats.thrashing ? "THRASHING" : "normal",
+           load_control_stats.last_fault_rate);
+    printf("Windows observed: %d (%d thrashing)\n",
+           load_control_stats.windows_observed, load_control_stats.thrashing_windows);
+    printf("Suspensions: %d, Resumptions: %d, Deferred admissions: %d\n",
+           load_control_stats.suspensions, load_control_stats.resumptions,
+           load_control_stats.admissions_deferred);
+    printf("Pages swapped out: %d, Pages pre-paged: %d\n",
+           load_control_stats.pages_swapped_out, load_control_stats.pages_prepaged);
+    printf("==================================================\n");
+
+    printf("\nPID  Name          State      Resident  Swapped\n");
+    printf("---  ------------  ---------  --------  -------\n");
+    for(int i = 0; i < MAX_PROCESSES; i++) {
+        if(processes[i].pid == -1) {
+            continue;
+        }
+        int swapped = 0;
+        for(int page = 0; page < MAX_PAGES; page++) {
+            if(swap_lookup(i, page) != -1) {
+                swapped++;
+            }
+        }
+        printf("%3d  %-12s  %-9s  %8d  %7d\n",
+               i, processes[i].name,
+               processes[i].suspended ? "SUSPENDED" : "RUNNABLE",
+               processes[i].page_count, swapped);
+    }
+}
+
+// ==================== THROUGHPUT COMPARISON ====================
+
+#define LC_WORKERS 4
+#define LC_WORKING_SET 5
+#define LC_QUANTUM 5
+
+typedef struct {
+    int references;
+    int faults;
+    long sim_time;
+    int suspensions;
+    int resumptions;
+    int pages_swapped_out;
+} LoadControlRun;
+
+// Run a workload whose combined working sets exceed physical memory
+static void run_thrashing_workload(int enabled, int refs_per_process, LoadControlRun* run) {
+    int remaining[MAX_PROCESSES] = {0};
+    int position[MAX_PROCESSES] = {0};
+    int pids[LC_WORKERS];
+
+    init_memory_system();
+    init_lru();
+    set_load_control_enabled(enabled);
+
+    for(int i = 0; i < LC_WORKERS; i++) {
+        char name[50];
+        snprintf(name, sizeof(name), "Worker %d", i + 1);
+        pids[i] = create_process(name);
+        remaining[pids[i]] = refs_per_process;
+    }
+
+    run->references = 0;
+    run->faults = 0;
+    run->sim_time = 0;
+
+    int cursor = 0;
+    int live = LC_WORKERS;
+
+    while(live > 0) {
+        // Round robin over runnable workers
+        int pid = -1;
+        for(int n = 0; n < LC_WORKERS; n++) {
+            int candidate = pids[(cursor + n) % LC_WORKERS];
+            if(remaining[candidate] > 0 && is_process_runnable(candidate)) {
+                pid = candidate;
+                cursor = (cursor + n + 1) % LC_WORKERS;
+                break;
+            }
+        }
+
+        // Everyone left is suspended: wake the longest-waiting one
+        if(pid == -1) {
+            for(int n = 0; n < LC_WORKERS; n++) {
+                if(remaining[pids[n]] > 0 && processes[pids[n]].suspended) {
+                    if(pid == -1 || suspend_sequence[pids[n]] < suspend_sequence[pid]) {
+                        pid = pids[n];
+                    }
+                }
+            }
+            resume_process(pid);
+        }
+
+        for(int q = 0; q < LC_QUANTUM && remaining[pid] > 0; q++) {
+            int swapped_before = load_control_stats.pages_swapped_out;
+            int faults_before = processes[pid].page_faults;
+
+            // Each worker loops over its own working set
+            int page = position[pid] % LC_WORKING_SET;
+            access_memory(pid, page * PAGE_SIZE);
+            position[pid]++;
+            remaining[pid]--;
+            run->references++;
+
+            if(processes[pid].page_faults != faults_before) {
+                run->faults++;
+                run->sim_time += LC_FAULT_SERVICE_TIME;
+            } else {
+                run->sim_time += LC_HIT_TIME;
+            }
+            run->sim_time += (long)(load_control_stats.pages_swapped_out - swapped_before) *
+                             LC_SWAP_WRITE_TIME;
+
+            if(processes[pid].suspended) {
+                break;
+            }
+        }
+
+        if(remaining[pid] == 0) {
+            terminate_process(pid);
+            live--;
+        }
+    }
+
+    run->suspensions = load_control_stats.suspensions;
+    run->resumptions = load_control_stats.resumptions;
+    run->pages_swapped_out = load_control_stats.pages_swapped_out;
+}
+
+// Compare throughput of a thrashing workload with and without load control
+void run_load_control_comparison(int refs_per_process) {
+    LoadControlRun runs[2];
+    int saved_verbose = verbose_mode;
+    int saved_algorithm = algorithm_type;
+    int saved_enabled = load_control_config.enabled;
+    int saved_zero_page = zero_page_enabled;
+
+    if(refs_per_process <= 0) {
+        printf("Error: Reference count must be positive\n");
+        return;
+    }
+
+    verbose_mode = 0;
+    algorithm_type = 1;  // LRU
+    zero_page_enabled = 0;  // Working sets hold data; they must not collapse onto the zero frame
+
+    for(int mode = 0; mode < 2; mode++) {
+        run_thrashing_workload(mode, refs_per_process, &runs[mode]);
+    }
+
+    verbose_mode = saved_verbose;
+    algorithm_type = saved_algorithm;
+    set_load_control_enabled(saved_enabled);
+    zero_page_enabled = saved_zero_page;
+
+    printf("\n============== LOAD CONTROL THROUGHPUT ==============\n");
+    printf("Workload: %d processes x %d-page working set (%d pages) on %d frames\n",
+           LC_WORKERS, LC_WORKING_SET, LC_WORKERS * LC_WORKING_SET, MAX_FRAMES);
+    printf("Quantum: %d refs, hit %d, fault %d, swap write %d time units\n\n",
+           LC_QUANTUM, LC_HIT_TIME, LC_FAULT_SERVICE_TIME, LC_SWAP_WRITE_TIME);
+
+    printf("Mode           Refs   Faults  Fault%%   Sim Time  Refs/1000t  Susp  Swapped\n");
+    printf("-------------  -----  ------  ------  ---------  ----------  ----  -------\n");
+    for(int mode = 0; mode < 2; mode++) {
+        LoadControlRun* run = &runs[mode];
+        printf("%-13s  %5d  %6d  %5.1f%%  %9ld  %10.2f  %4d  %7d\n",
+               mode ? "Load control" : "Uncontrolled",
+               run->references, run->faults,
+               (run->faults * 100.0) / run->references,
+               run->sim_time,
+               (run->references * 1000.0) / run->sim_time,
+               run->suspensions, run->pages_swapped_out);
+    }
+
+    if(runs[0].sim_time > 0 && runs[1].sim_time > 0) {
+        printf("\nSpeedup with load control: %.2fx\n",
+               (double)runs[0].sim_time / runs[1].sim_time);
+    }
+    printf("=====================================================\n");
+}
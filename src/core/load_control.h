@@ -0,0 +1,54 @@
+/**
+ * load_control.h
+ * Thrashing detection and load control module header
+ */
+
+#ifndef LOAD_CONTROL_H
+#define LOAD_CONTROL_H
+
+#include "../../include/common_defs.h"
+
+// Simulated service times used by the throughput comparison
+#define LC_HIT_TIME 1            // Resident access
+#define LC_FAULT_SERVICE_TIME 100 // Page read from backing store
+#define LC_SWAP_WRITE_TIME 50     // Page written out on suspension
+
+// Load control tuning
+typedef struct {
+    int enabled;              // Act on thrashing (monitoring is always on)
+    int window_size;          // References per observation window
+    double thrash_threshold;  // Window fault rate (%) that declares thrashing
+    double resume_threshold;  // Window fault rate (%) that ends thrashing
+    int min_active;           // Never suspend below this many runnable processes
+} LoadControlConfig;
+
+// Load control counters
+typedef struct {
+    int windows_observed;
+    int thrashing_windows;
+    int thrashing;            // Current verdict
+    double last_fault_rate;
+    int suspensions;
+    int resumptions;
+    int admissions_deferred;
+    int pages_swapped_out;
+    int pages_prepaged;
+} LoadControlStats;
+
+extern LoadControlConfig load_control_config;
+extern LoadControlStats load_control_stats;
+
+// Function Prototypes
+void init_load_control(int window_size, double thrash_threshold, double resume_threshold);
+void reset_load_control();
+void set_load_control_enabled(int enabled);
+void load_control_observe(int pid, int was_fault);
+void load_control_on_create(int pid);
+void load_control_on_terminate(int pid);
+int suspend_process(int pid);
+int resume_process(int pid);
+int is_process_runnable(int pid);
+void display_load_control_status();
+void run_load_control_comparison(int refs_per_process);
+
+#endif // LOAD_CONTROL_H
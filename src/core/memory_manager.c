@@ -11,6 +11,21 @@
 #include "../algorithms/fifo.h"
 #include "../algorithms/lru.h"
 #include "../algorithms/optimal.h"
+#include "virtual_memory.h"
+#include "load_control.h"
+#include "tlb.h"
+#include "segmentation.h"
+#include "cow.h"
+#include "ksm.h"
+#include "overcommit.h"
+#include "page_cache.h"
+#include "prefetch.h"
+#include "vma.h"
+#include "tiering.h"
+#include "numa.h"
+#include "latency.h"
+#include "timeline.h"
+#include "../allocators/buddy.h"
 
 // Global variables (defined in main.c, declared here as extern)
 extern MemoryFrame physical_memory[MAX_FRAMES];
@@ -19,10 +34,24 @@ extern Statistics stats;
 extern int current_time;
 extern int algorithm_type;
 
+// Per-access console tracing (batch runs switch it off)
+int verbose_mode = 1;
+
+// Free frame pool; every is_free change goes through mark_frame_used/free
+BuddyAllocator frame_buddy;
+
+// Page contents held by each frame
+unsigned char frame_data[MAX_FRAMES][PAGE_SIZE];
+
+// Reads of untouched pages share one zero-filled frame until written
+int zero_page_enabled = 1;
+int zero_frame = -1;
+int zero_page_maps = 0;
+
 // Initialize memory system
 void init_memory_system() {
-    printf("\nInitializing Memory System...\n");
-    printf("==============================\n");
+    VPRINTF("\nInitializing Memory System...\n");
+    VPRINTF("==============================\n");
     
     // Initialize physical memory frames
     for(int i = 0; i < MAX_FRAMES; i++) {
@@ -34,7 +63,24 @@ void init_memory_system() {
         physical_memory[i].reference_bit = 0;
         physical_memory[i].dirty = false;
         physical_memory[i].is_free = true;
+        physical_memory[i].ref_count = 0;
     }
+    memset(frame_data, 0, sizeof(frame_data));
+    zero_frame = -1;
+    zero_page_maps = 0;
+    reset_cow();
+    reset_ksm();
+    reset_overcommit();
+    reset_page_cache();
+    reset_prefetch();
+    reset_vma();
+    reset_tiering();
+    reset_numa();
+    reset_latency();
+    reset_timeline();
+    
+    buddy_destroy(&frame_buddy);
+    buddy_init(&frame_buddy, MAX_FRAMES);
     
     // Initialize processes
     for(int i = 0; i < MAX_PROCESSES; i++) {
@@ -42,6 +88,8 @@ void init_memory_system() {
         processes[i].name[0] = '\0';
         processes[i].page_faults = 0;
         processes[i].memory_usage = 0;
+        processes[i].page_count = 0;
+        processes[i].suspended = false;
         
         // Initialize page table
         for(int j = 0; j < MAX_PAGES; j++) {
@@ -52,6 +100,7 @@ void init_memory_system() {
             processes[i].page_table[j].referenced = false;
             processes[i].page_table[j].modified = false;
             processes[i].page_table[j].protection = 0;
+            processes[i].page_table[j].cow = false;
         }
         
         // Initialize segment table
@@ -66,14 +115,18 @@ void init_memory_system() {
     
     // Initialize statistics
     reset_statistics();
+    reset_swap_space();
+    reset_load_control();
+    init_tlb();
+    reset_segment_space();
     
     current_time = 0;
     
-    printf("✓ Physical Memory: %d frames (%d KB total)\n", 
-           MAX_FRAMES, (MAX_FRAMES * PAGE_SIZE) / 1024);
-    printf("✓ Virtual Memory: %d pages\n", MAX_PAGES);
-    printf("✓ Processes array initialized\n");
-    printf("✓ Statistics reset\n");
+    VPRINTF("✓ Physical Memory: %d frames (%d KB total)\n", 
+            MAX_FRAMES, (MAX_FRAMES * PAGE_SIZE) / 1024);
+    VPRINTF("✓ Virtual Memory: %d pages\n", MAX_PAGES);
+    VPRINTF("✓ Processes array initialized\n");
+    VPRINTF("✓ Statistics reset\n");
 }
 
 // Reset simulation
@@ -95,8 +148,12 @@ void init_process(int pid, const char* name) {
     processes[pid].page_faults = 0;
     processes[pid].memory_usage = 0;
     processes[pid].page_count = 0;
+    processes[pid].suspended = false;
+    vma_default_layout(pid);
+    numa_on_create(pid);
+    latency_on_create(pid);
     
-    printf("Process %d '%s' initialized.\n", pid, name);
+    VPRINTF("Process %d '%s' initialized.\n", pid, name);
 }
 
 // Allocate a page to a process
@@ -113,64 +170,38 @@ int allocate_page(int pid, int page_number) {
     
     // Check if page is already allocated
     if(processes[pid].page_table[page_number].present) {
-        printf("Page %d is already allocated to process %d\n", page_number, pid);
+        VPRINTF("Page %d is already allocated to process %d\n", page_number, pid);
         return 0;
     }
     
-    // Find a free frame
+    // Find a free frame, on the node the placement policy picks
+    numa_set_context(pid, page_number);
     int frame_id = find_free_frame();
     if(frame_id == -1) {
-        printf("No free frames available! Need page replacement.\n");
-        
-        // Call page replacement algorithm
-        int replaced_frame;
-        switch(algorithm_type) {
-            case 0: // FIFO
-                replaced_frame = fifo_replace_page();
-                break;
-            case 1: // LRU
-                replaced_frame = lru_replace_page();
-                break;
-            case 2: // Optimal
-                // For demo, we'll use FIFO as default
-                replaced_frame = fifo_replace_page();
-                break;
-            default:
-                replaced_frame = fifo_replace_page();
-        }
-        
-        // Free the replaced frame
-        int old_pid = physical_memory[replaced_frame].process_id;
-        int old_page = physical_memory[replaced_frame].page_number;
-        
-        if(old_pid != -1 && old_page != -1) {
-            processes[old_pid].page_table[old_page].present = false;
-            processes[old_pid].page_table[old_page].frame_number = -1;
-            processes[old_pid].memory_usage -= PAGE_SIZE / 1024;
-        }
-        
-        frame_id = replaced_frame;
-        printf("Frame %d freed by replacement algorithm\n", frame_id);
+        VPRINTF("No free frames available! Need page replacement.\n");
+        frame_id = reclaim_frame();
+        VPRINTF("Frame %d freed by replacement algorithm\n", frame_id);
+    }
+    if(frame_id == -1) {
+        printf("Error: No frame available for page %d\n", page_number);
+        return -1;
+    }
+    if(processes[pid].pid == -1) {
+        return -1;  // Killed to free memory
     }
     
     // Allocate the frame
-    physical_memory[frame_id].page_number = page_number;
-    physical_memory[frame_id].process_id = pid;
     physical_memory[frame_id].load_time = current_time;
     physical_memory[frame_id].last_access = current_time;
-    physical_memory[frame_id].is_free = false;
-    
-    // Update page table
-    processes[pid].page_table[page_number].frame_number = frame_id;
-    processes[pid].page_table[page_number].present = true;
-    processes[pid].page_table[page_number].valid = true;
-    processes[pid].memory_usage += PAGE_SIZE / 1024;
-    processes[pid].page_count++;
+    physical_memory[frame_id].dirty = false;
+    memset(frame_data[frame_id], 0, PAGE_SIZE);
+    mark_frame_used(frame_id);
+    map_page(pid, page_number, frame_id);
     
     current_time++;
     
-    printf("✓ Page %d allocated to Frame %d for Process %d\n", 
-           page_number, frame_id, pid);
+    VPRINTF("✓ Page %d allocated to Frame %d for Process %d\n", 
+            page_number, frame_id, pid);
     
     return 0;
 }
@@ -181,58 +212,164 @@ int deallocate_page(int pid, int page_number) {
         return -1;
     }
     
-    if(!processes[pid].page_table[page_number].present) {
-        printf("Page %d is not allocated to process %d\n", page_number, pid);
+    if(page_number < 0 || page_number >= MAX_PAGES ||
+       !processes[pid].page_table[page_number].present) {
+        VPRINTF("Page %d is not allocated to process %d\n", page_number, pid);
         return -1;
     }
     
     int frame_id = processes[pid].page_table[page_number].frame_number;
     
-    // Free the frame
-    physical_memory[frame_id].is_free = true;
-    physical_memory[frame_id].page_number = -1;
-    physical_memory[frame_id].process_id = -1;
-    
-    // Update page table
-    processes[pid].page_table[page_number].present = false;
-    processes[pid].page_table[page_number].frame_number = -1;
-    processes[pid].memory_usage -= PAGE_SIZE / 1024;
-    processes[pid].page_count--;
+    // The frame is freed once no other process shares it
+    unmap_page(pid, page_number);
+    uncharge_page(pid, page_number);
     
-    printf("Page %d deallocated from Frame %d\n", page_number, frame_id);
+    VPRINTF("Page %d deallocated from Frame %d\n", page_number, frame_id);
     
     return 0;
 }
 
-// Access memory (simulate memory access)
+// Access memory (simulate a read)
 int access_memory(int pid, int address) {
+    return access_memory_ex(pid, address, false);
+}
+
+// Map a page read-only onto the shared zero frame, allocating the frame on first use
+int map_zero_page(int pid, int page_number) {
+    if(zero_frame == -1) {
+        int frame_id = find_free_frame();
+        if(frame_id == -1) {
+            frame_id = reclaim_frame();
+        }
+        if(frame_id == -1 || processes[pid].pid == -1) {
+            return -1;
+        }
+        
+        physical_memory[frame_id].load_time = current_time;
+        physical_memory[frame_id].last_access = current_time;
+        physical_memory[frame_id].dirty = false;
+        memset(frame_data[frame_id], 0, PAGE_SIZE);
+        mark_frame_used(frame_id);
+        zero_frame = frame_id;
+    }
+    
+    map_page(pid, page_number, zero_frame);
+    processes[pid].page_table[page_number].cow = true;
+    zero_page_maps++;
+    current_time++;
+    
+    VPRINTF("✓ Page %d of Process %d mapped to the zero frame (Frame %d)\n",
+            page_number, pid, zero_frame);
+    return 0;
+}
+
+// Write bytes within one page, returns the physical address or -1
+int write_memory(int pid, int address, const void* data, int length) {
+    if(length < 0 || address % PAGE_SIZE + length > PAGE_SIZE) {
+        printf("Error: Write of %d bytes at %d crosses a page boundary\n", length, address);
+        return -1;
+    }
+    
+    int physical_address = access_memory_ex(pid, address, true);
+    if(physical_address == -1) {
+        return -1;
+    }
+    memcpy(&frame_data[physical_address / PAGE_SIZE][physical_address % PAGE_SIZE], data, length);
+    return physical_address;
+}
+
+// Bring a non-resident page in as a fault would: back from swap if it was
+// paged out, from the page cache if a file backs it, onto the zero frame
+// for a read of an untouched page, otherwise into a fresh frame.
+// Returns 0, or -1 if no frame was found or the process was killed
+int fault_in_page(int pid, int page_number, bool is_write) {
+    if(swap_lookup(pid, page_number) != -1) {
+        latency_swap_in();
+        swap_in(pid, page_number);
+    } else if(find_file_mapping(pid, page_number) != NULL) {
+        page_cache_fault(pid, page_number);
+    } else if(!is_write && zero_page_enabled) {
+        latency_event(LAT_MINOR_FAULT);
+        map_zero_page(pid, page_number);
+    } else {
+        latency_event(LAT_MINOR_FAULT);
+        allocate_page(pid, page_number);
+    }
+    
+    if(processes[pid].pid == -1 || !processes[pid].page_table[page_number].present) {
+        return -1;
+    }
+    return 0;
+}
+
+// Access memory as a read or a write
+int access_memory_ex(int pid, int address, bool is_write) {
+    // Prefetches issued earlier land before this reference is served, and
+    // tier migrations and NUMA hinting scans run once per scan interval
+    prefetch_tick();
+    tiering_tick();
+    numa_tick();
+    
     if(pid < 0 || pid >= MAX_PROCESSES || processes[pid].pid == -1) {
         printf("Error: Invalid process %d\n", pid);
         return -1;
     }
     
+    if(address < 0 || address >= MAX_PAGES * PAGE_SIZE) {
+        printf("Error: Address %d outside virtual address space\n", address);
+        return -1;
+    }
+    
     int page_number = address / PAGE_SIZE;
     int offset = address % PAGE_SIZE;
+    int faults_before = processes[pid].page_faults;
+    numa_set_context(pid, page_number);
+    
+    // The page must lie in a region that allows the access
+    if(vma_check_access(pid, page_number, is_write) != 0) {
+        return -1;
+    }
+    
+    // The first write makes the page private memory, which the overcommit policy
+    // must allow; writes to a shared file mapping go to the file instead
+    Vma* mapping = find_file_mapping(pid, page_number);
+    bool shared_file = mapping != NULL && (mapping->flags & VMA_SHARED);
+    if(is_write && !shared_file && charge_page(pid, page_number) != 0) {
+        VPRINTF("  ✗ COMMIT REFUSED: Write to page %d of Process %d\n", page_number, pid);
+        return -1;
+    }
     
     // Update statistics
     stats.total_references++;
-    
-    printf("\nMemory Access Request:\n");
-    printf("  Process: %d (%s)\n", pid, processes[pid].name);
-    printf("  Address: %d\n", address);
-    printf("  Page: %d, Offset: %d\n", page_number, offset);
+    latency_begin(pid);
+    
+    VPRINTF("\nMemory Access Request:\n");
+    VPRINTF("  Process: %d (%s)\n", pid, processes[pid].name);
+    VPRINTF("  Address: %d\n", address);
+    VPRINTF("  Page: %d, Offset: %d\n", page_number, offset);
+    VPRINTF("  Type: %s\n", is_write ? "Write" : "Read");
+    
+    // Consult the TLB before walking the page table
+    int tlb_frame = tlb_lookup(pid, page_number);
+    if(tlb_frame != -1) {
+        VPRINTF("  ✓ TLB HIT: Page %d -> Frame %d\n", page_number, tlb_frame);
+        latency_event(LAT_TLB_HIT);
+    } else {
+        latency_event(LAT_PAGE_WALK);
+    }
     
     // Check if page is in memory
     if(!processes[pid].page_table[page_number].present) {
         // PAGE FAULT
-        printf("  ✗ PAGE FAULT: Page %d not in memory\n", page_number);
+        VPRINTF("  ✗ PAGE FAULT: Page %d not in memory\n", page_number);
         
         processes[pid].page_faults++;
         stats.total_page_faults++;
-        update_statistics(1);  // 1 = fault
         
-        // Handle page fault by allocating the page
-        allocate_page(pid, page_number);
+        // No frame could be found, or the process was killed to free one
+        if(fault_in_page(pid, page_number, is_write) != 0) {
+            return -1;
+        }
         
         // Update reference
         processes[pid].page_table[page_number].referenced = true;
@@ -242,10 +379,9 @@ int access_memory(int pid, int address) {
         
     } else {
         // PAGE HIT
-        printf("  ✓ PAGE HIT: Page %d is in memory\n", page_number);
+        VPRINTF("  ✓ PAGE HIT: Page %d is in memory\n", page_number);
         
         stats.total_hits++;
-        update_statistics(0);  // 0 = hit
         
         // Update access info
         processes[pid].page_table[page_number].referenced = true;
@@ -254,28 +390,318 @@ int access_memory(int pid, int address) {
         physical_memory[frame_id].reference_bit = 1;
     }
     
+    // A write to a page shared since fork gets a private copy first
+    if(is_write && processes[pid].page_table[page_number].cow) {
+        latency_event(LAT_MINOR_FAULT);
+        if(cow_fault(pid, page_number) == -1) {
+            return -1;
+        }
+        tlb_frame = -1;
+    }
+    
+    // A hinting fault may move the page to a faster tier
+    if(tiering_access(pid, page_number)) {
+        tlb_frame = -1;
+    }
+    
+    // Remote references cost more, and a hinting fault may pull the page to
+    // this process's node
+    int node_frame = processes[pid].page_table[page_number].frame_number;
+    latency_event(LAT_DRAM);
+    numa_access(pid, page_number);
+    if(processes[pid].page_table[page_number].frame_number != node_frame) {
+        tlb_frame = -1;
+    }
+    
     // Calculate physical address
     int frame_id = processes[pid].page_table[page_number].frame_number;
     int physical_address = (frame_id * PAGE_SIZE) + offset;
     
+    if(tlb_frame == -1) {
+        tlb_insert(pid, page_number, frame_id);
+    }
+    
+    if(is_write) {
+        processes[pid].page_table[page_number].modified = true;
+        physical_memory[frame_id].dirty = true;
+    }
+    
     current_time++;
     
+    // Feed the prefetcher and the thrashing monitor once the reference has completed
+    prefetch_observe(pid, page_number, processes[pid].page_faults != faults_before);
+    load_control_observe(pid, processes[pid].page_faults != faults_before);
+    
+    // Everything this reference cost has been charged
+    timeline_observe(processes[pid].page_faults != faults_before, latency_end());
+    
     return physical_address;
 }
 
-// Find a free frame
+// Find a free frame, preferring ones that do not break up larger free blocks
 int find_free_frame() {
+    if(frame_buddy.frames == 0) {
+        return -1;  // Memory system not initialized
+    }
+    if(numa_node_count > 1) {
+        return numa_find_free_frame();
+    }
+    if(tier_count > 1) {
+        return tier_find_free_frame(-1);  // Fastest tier first
+    }
+    return buddy_peek(&frame_buddy, 0);
+}
+
+// Take a frame out of the free pool
+void mark_frame_used(int frame_id) {
+    if(physical_memory[frame_id].is_free) {
+        buddy_claim(&frame_buddy, frame_id);
+        physical_memory[frame_id].is_free = false;
+    }
+}
+
+// Return a frame to the free pool, merging it with free buddies
+void mark_frame_free(int frame_id) {
+    if(!physical_memory[frame_id].is_free) {
+        buddy_free(&frame_buddy, frame_id, 0);
+        physical_memory[frame_id].is_free = true;
+        tiering_forget_frame(frame_id);
+        numa_forget_frame(frame_id);
+    }
+}
+
+// Reserve 2^order physically contiguous frames, returns the first or -1
+int allocate_frame_block(int order) {
+    int first = buddy_alloc(&frame_buddy, order);
+    if(first == -1) {
+        VPRINTF("No free block of %d contiguous frames\n", 1 << order);
+        return -1;
+    }
+    
+    for(int i = first; i < first + (1 << order); i++) {
+        physical_memory[i].page_number = -1;
+        physical_memory[i].process_id = -1;
+        physical_memory[i].load_time = current_time;
+        physical_memory[i].last_access = current_time;
+        physical_memory[i].dirty = false;
+        physical_memory[i].is_free = false;
+    }
+    
+    VPRINTF("✓ Frames %d-%d reserved (order %d)\n", first, first + (1 << order) - 1, order);
+    return first;
+}
+
+// Release a block reserved by allocate_frame_block
+int free_frame_block(int first_frame, int order) {
+    if(first_frame < 0 || order < 0 || first_frame + (1 << order) > MAX_FRAMES) {
+        printf("Error: Invalid frame block %d (order %d)\n", first_frame, order);
+        return -1;
+    }
+    for(int i = first_frame; i < first_frame + (1 << order); i++) {
+        if(!is_frame_reserved(i)) {
+            printf("Error: Frame %d is not part of a reserved block\n", i);
+            return -1;
+        }
+    }
+    if(buddy_free(&frame_buddy, first_frame, order) != 0) {
+        return -1;
+    }
+    
+    for(int i = first_frame; i < first_frame + (1 << order); i++) {
+        physical_memory[i].is_free = true;
+    }
+    VPRINTF("Frames %d-%d released\n", first_frame, first_frame + (1 << order) - 1);
+    return 0;
+}
+
+// Frame held by a contiguous block rather than a process page
+int is_frame_reserved(int frame_id) {
+    return !physical_memory[frame_id].is_free && physical_memory[frame_id].process_id == -1 &&
+           !page_cache_holds(frame_id);
+}
+
+// True if the frame can be written out; pages holding data need a swap slot per
+// mapping, cached file pages go back to their file
+static int frame_evictable(int frame_id) {
+    if(page_cache_holds(frame_id)) {
+        return 1;
+    }
+    bool keep = physical_memory[frame_id].dirty || !page_is_zero(frame_data[frame_id]);
+    return !keep || swap_free_slots() >= physical_memory[frame_id].ref_count;
+}
+
+// Oldest resident frame, used when the replacement queues are not primed
+static int oldest_resident_frame(bool evictable_only) {
+    int victim = -1;
     for(int i = 0; i < MAX_FRAMES; i++) {
-        if(physical_memory[i].is_free) {
-            return i;
+        if(physical_memory[i].is_free || is_frame_reserved(i) ||
+           (evictable_only && !frame_evictable(i))) {
+            continue;
+        }
+        if(victim == -1 || physical_memory[i].load_time < physical_memory[victim].load_time) {
+            victim = i;
         }
     }
-    return -1;  // No free frames
+    return victim;
+}
+
+// Pick a victim with the active replacement algorithm and evict its page
+int reclaim_frame() {
+    int victim;
+    switch(algorithm_type) {
+        case 0: // FIFO
+            victim = fifo_replace_page();
+            break;
+        case 1: // LRU
+            victim = lru_replace_page();
+            break;
+        case 2: // Optimal needs the future reference string; use FIFO here
+        default:
+            victim = fifo_replace_page();
+    }
+    
+    // The FIFO/LRU structures are only primed from the algorithms menu
+    if(victim < 0 || victim >= MAX_FRAMES || physical_memory[victim].is_free ||
+       is_frame_reserved(victim) || !frame_evictable(victim)) {
+        victim = oldest_resident_frame(true);
+    }
+    
+    if(victim != -1) {
+        evict_frame(victim);
+        return victim;
+    }
+    
+    // Memory and swap are both full: kill processes until a frame is free
+    while(victim == -1 && oldest_resident_frame(false) != -1 && oom_kill() != -1) {
+        victim = find_free_frame();
+    }
+    return victim;
+}
+
+// True if every byte of a page is zero
+int page_is_zero(const unsigned char* data) {
+    for(int i = 0; i < PAGE_SIZE; i++) {
+        if(data[i]) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Unmap the page held by a frame and return the frame to the free pool
+void evict_frame(int frame_id) {
+    if(frame_id < 0 || frame_id >= MAX_FRAMES || physical_memory[frame_id].is_free ||
+       is_frame_reserved(frame_id)) {
+        return;
+    }
+    
+    // Unmap every page sharing the frame; modified pages must survive
+    // eviction, so each mapper gets a swap copy. Swap-in frees the slot,
+    // so a clean page holding data needs one too. A cached file page is
+    // written back to its file instead and needs no swap
+    bool cached = page_cache_evict_frame(frame_id);
+    bool keep = !cached && (physical_memory[frame_id].dirty || !page_is_zero(frame_data[frame_id]));
+    if(keep && physical_memory[frame_id].dirty) {
+        latency_swap_out();  // A clean copy would still be in the swap cache
+    }
+    while(frame_rmap[frame_id].count > 0) {
+        RmapEntry mapping = frame_rmap[frame_id].entries[0];
+        if(keep) {
+            swap_store(mapping.pid, mapping.page_number);
+        }
+        unmap_page(mapping.pid, mapping.page_number);
+    }
+    
+    // A cached page nobody had mapped
+    if(!physical_memory[frame_id].is_free) {
+        physical_memory[frame_id].dirty = false;
+        mark_frame_free(frame_id);
+    }
+}
+
+// Point a page at a frame and record the mapping in the frame's reverse map
+void map_page(int pid, int page_number, int frame_id) {
+    rmap_add(frame_id, pid, page_number);
+    
+    processes[pid].page_table[page_number].frame_number = frame_id;
+    processes[pid].page_table[page_number].present = true;
+    processes[pid].page_table[page_number].valid = true;
+    processes[pid].memory_usage += PAGE_SIZE / 1024;
+    processes[pid].page_count++;
+}
+
+// Drop one page's mapping; the frame is freed when nothing maps it any more,
+// unless the page cache holds it. Returns how many mappings the frame has left
+int unmap_page(int pid, int page_number) {
+    int frame_id = processes[pid].page_table[page_number].frame_number;
+    
+    processes[pid].page_table[page_number].present = false;
+    processes[pid].page_table[page_number].frame_number = -1;
+    processes[pid].page_table[page_number].cow = false;
+    processes[pid].memory_usage -= PAGE_SIZE / 1024;
+    processes[pid].page_count--;
+    tlb_invalidate(pid, page_number);
+    
+    int left = rmap_remove(frame_id, pid, page_number);
+    if(left == 0 && !page_cache_holds(frame_id)) {
+        if(frame_id == zero_frame) {
+            zero_frame = -1;
+        }
+        physical_memory[frame_id].dirty = false;
+        ksm_forget_frame(frame_id);
+        mark_frame_free(frame_id);
+    }
+    return left;
+}
+
+// Move a resident page to a free frame; page table, TLB and replacement
+// order follow it so the move is invisible to the owning process
+int migrate_page(int from_frame, int to_frame) {
+    if(from_frame < 0 || from_frame >= MAX_FRAMES || to_frame < 0 || to_frame >= MAX_FRAMES ||
+       physical_memory[from_frame].is_free || is_frame_reserved(from_frame) ||
+       !physical_memory[to_frame].is_free) {
+        return -1;
+    }
+    
+    int pid = physical_memory[from_frame].process_id;
+    int page_number = physical_memory[from_frame].page_number;
+    
+    mark_frame_used(to_frame);
+    physical_memory[to_frame].load_time = physical_memory[from_frame].load_time;
+    physical_memory[to_frame].last_access = physical_memory[from_frame].last_access;
+    physical_memory[to_frame].reference_bit = physical_memory[from_frame].reference_bit;
+    physical_memory[to_frame].dirty = physical_memory[from_frame].dirty;
+    memcpy(frame_data[to_frame], frame_data[from_frame], PAGE_SIZE);
+    
+    // Every page table sharing the frame follows it
+    rmap_move(from_frame, to_frame);
+    for(int i = 0; i < frame_rmap[to_frame].count; i++) {
+        RmapEntry* mapping = &frame_rmap[to_frame].entries[i];
+        processes[mapping->pid].page_table[mapping->page_number].frame_number = to_frame;
+        tlb_invalidate(mapping->pid, mapping->page_number);
+    }
+    fifo_migrate_frame(from_frame, to_frame);
+    lru_migrate_frame(from_frame, to_frame);
+    ksm_migrate_frame(from_frame, to_frame);
+    page_cache_migrate_frame(from_frame, to_frame);
+    tiering_migrate_frame(from_frame, to_frame);
+    numa_migrate_frame(from_frame, to_frame);
+    if(from_frame == zero_frame) {
+        zero_frame = to_frame;
+    }
+    
+    physical_memory[from_frame].reference_bit = 0;
+    physical_memory[from_frame].dirty = false;
+    mark_frame_free(from_frame);
+    
+    VPRINTF("Page %d of Process %d migrated: Frame %d -> Frame %d\n",
+            page_number, pid, from_frame, to_frame);
+    return 0;
 }
 
 // Check if page is in memory
 int is_page_in_memory(int pid, int page_number) {
-    if(pid < 0 || pid >= MAX_PROCESSES) {
+    if(pid < 0 || pid >= MAX_PROCESSES || page_number < 0 || page_number >= MAX_PAGES) {
         return 0;
     }
     return processes[pid].page_table[page_number].present ? 1 : 0;
@@ -287,6 +713,7 @@ int create_process(const char* name) {
     for(int i = 0; i < MAX_PROCESSES; i++) {
         if(processes[i].pid == -1) {
             init_process(i, name);
+            load_control_on_create(i);
             return i;
         }
     }
@@ -302,7 +729,7 @@ void terminate_process(int pid) {
         return;
     }
     
-    printf("Terminating Process %d (%s)...\n", pid, processes[pid].name);
+    VPRINTF("Terminating Process %d (%s)...\n", pid, processes[pid].name);
     
     // Deallocate all pages
     for(int i = 0; i < MAX_PAGES; i++) {
@@ -310,14 +737,24 @@ void terminate_process(int pid) {
             deallocate_page(pid, i);
         }
     }
+    swap_release_process(pid);
+    release_process_segments(pid);
+    release_commit(pid);
+    vma_release_process(pid);
+    prefetch_release_process(pid);
+    numa_release_process(pid);
     
     // Reset process
     processes[pid].pid = -1;
     processes[pid].name[0] = '\0';
     processes[pid].page_faults = 0;
     processes[pid].memory_usage = 0;
+    processes[pid].suspended = false;
+    
+    VPRINTF("Process %d terminated.\n", pid);
     
-    printf("Process %d terminated.\n", pid);
+    // Freed frames may let a suspended process back in
+    load_control_on_terminate(pid);
 }
 
 // Display process information
@@ -334,6 +771,8 @@ void display_process_info(int pid) {
     printf("Page Faults: %d\n", processes[pid].page_faults);
     printf("Memory Usage: %d KB\n", processes[pid].memory_usage);
     printf("Pages Allocated: %d\n", processes[pid].page_count);
+    printf("State: %s\n", processes[pid].suspended ? "Suspended (swapped out)" : "Runnable");
+    display_vmas(pid);
     
     printf("\nAllocated Pages:\n");
     for(int i = 0; i < MAX_PAGES; i++) {
@@ -344,19 +783,21 @@ void display_process_info(int pid) {
     }
 }
 
-// Update statistics
-void update_statistics(int was_fault) {
-    (void)was_fault;
-
+// Derive the ratios from the counters; only done when they are shown
+void update_statistics() {
     if(stats.total_references > 0) {
         stats.hit_ratio = (double)stats.total_hits / stats.total_references * 100.0;
         stats.fault_ratio = (double)stats.total_page_faults / stats.total_references * 100.0;
-        stats.avg_access_time = 100.0 + (stats.total_page_faults * 10000000.0 / stats.total_references);
+        stats.avg_access_time = latency_mean_ns();
     }
 }
 
 // Display statistics
 void display_statistics() {
+    static LatencyAccount latency;
+    update_statistics();
+    latency_totals(&latency);
+    
     printf("\n==================== STATISTICS ====================\n");
     printf("Total Memory References: %d\n", stats.total_references);
     printf("Page Hits: %d\n", stats.total_hits);
@@ -364,6 +805,14 @@ void display_statistics() {
     printf("Hit Ratio: %.2f%%\n", stats.hit_ratio);
     printf("Fault Ratio: %.2f%%\n", stats.fault_ratio);
     printf("Average Access Time: %.2f ns\n", stats.avg_access_time);
+    printf("Access Latency: p50 %llu, p99 %llu, p99.9 %llu ns\n",
+           (unsigned long long)hdr_value_at_percentile(&latency.access, 50.0),
+           (unsigned long long)hdr_value_at_percentile(&latency.access, 99.0),
+           (unsigned long long)hdr_value_at_percentile(&latency.access, 99.9));
+    printf("Fault Latency: p50 %llu, p99 %llu, p99.9 %llu ns\n",
+           (unsigned long long)hdr_value_at_percentile(&latency.fault, 50.0),
+           (unsigned long long)hdr_value_at_percentile(&latency.fault, 99.0),
+           (unsigned long long)hdr_value_at_percentile(&latency.fault, 99.9));
     printf("====================================================\n");
     
     printf("\nProcess Statistics:\n");
@@ -400,10 +849,18 @@ int get_physical_address(int pid, int logical_addr) {
     int page_number = logical_addr / PAGE_SIZE;
     int offset = logical_addr % PAGE_SIZE;
     
-    if(!processes[pid].page_table[page_number].present) {
+    if(page_number < 0 || page_number >= MAX_PAGES ||
+       !processes[pid].page_table[page_number].present) {
         return -1;  // Page not in memory
     }
     
     int frame_id = processes[pid].page_table[page_number].frame_number;
     return (frame_id * PAGE_SIZE) + offset;
 }
+
+// Fold an arbitrary virtual address into the simulated address space,
+// keeping the page offset and wrapping the page number
+int fold_virtual_address(unsigned long long address) {
+    unsigned long long page = (address / PAGE_SIZE) % MAX_PAGES;
+    return (int)(page * PAGE_SIZE + address % PAGE_SIZE);
+}
@@ -6,7 +6,9 @@
 #ifndef MEMORY_MANAGER_H
 #define MEMORY_MANAGER_H
 
+#include <stdio.h>
 #include "../../include/common_defs.h"
+#include "../allocators/buddy.h"
 
 // ==================== GLOBAL VARIABLES ====================
 extern MemoryFrame physical_memory[MAX_FRAMES];
@@ -14,6 +16,15 @@ extern Process processes[MAX_PROCESSES];
 extern Statistics stats;
 extern int current_time;
 extern int algorithm_type;  // 0=FIFO, 1=LRU, 2=Optimal
+extern int verbose_mode;    // 0 silences per-access tracing for batch runs
+extern BuddyAllocator frame_buddy;
+extern unsigned char frame_data[MAX_FRAMES][PAGE_SIZE];
+extern int zero_page_enabled;
+extern int zero_frame;      // Shared zero-filled frame, -1 until a read needs it
+extern int zero_page_maps;
+
+// Print only when per-access tracing is enabled
+#define VPRINTF(...) do { if(verbose_mode) printf(__VA_ARGS__); } while(0)
 
 // ==================== FUNCTION PROTOTYPES ====================
 
@@ -26,6 +37,10 @@ void reset_simulation();
 int allocate_page(int pid, int page_number);
 int deallocate_page(int pid, int page_number);
 int access_memory(int pid, int address);
+int access_memory_ex(int pid, int address, bool is_write);
+int write_memory(int pid, int address, const void* data, int length);
+int map_zero_page(int pid, int page_number);
+int fault_in_page(int pid, int page_number, bool is_write);
 void compact_memory();
 
 // Process Management
@@ -34,13 +49,25 @@ void terminate_process(int pid);
 void display_process_info(int pid);
 
 // Statistics
-void update_statistics(int was_fault);
+void update_statistics();
 void display_statistics();
 void reset_statistics();
 
 // Utility Functions
 int find_free_frame();
+void mark_frame_used(int frame_id);
+void mark_frame_free(int frame_id);
+int allocate_frame_block(int order);
+int free_frame_block(int first_frame, int order);
+int is_frame_reserved(int frame_id);
+int reclaim_frame();
+void evict_frame(int frame_id);
+int migrate_page(int from_frame, int to_frame);
+void map_page(int pid, int page_number, int frame_id);
+int unmap_page(int pid, int page_number);
+int page_is_zero(const unsigned char* data);
 int is_page_in_memory(int pid, int page_number);
 int get_physical_address(int pid, int logical_addr);
+int fold_virtual_address(unsigned long long address);
 
 #endif // MEMORY_MANAGER_H
@@ -0,0 +1,452 @@
+/**
+ * numa.c
+ * NUMA nodes, placement policies and automatic page balancing
+ *
+ * Frames are split evenly across nodes, one per socket, and every process
+ * runs on a home node. A reference to a frame on another node pays the
+ * interconnect hop. Where a new page goes is decided by the placement
+ * policy: first touch puts it on the faulting process's node, interleave
+ * spreads pages round-robin by page number, and preferred fills one node
+ * first; all fall back to the next node when theirs is full.
+ *
+ * Balancing follows AutoNUMA: every scan interval the resident pages of
+ * each process are armed, so their next access takes a hinting fault
+ * that reports which node used the page. A page found on a remote node
+ * by two hinting faults in a row from the same node moves there, which
+ * keeps pages shared across nodes from bouncing; migrations per interval
+ * are rate limited. Hinting faults are not free, so a process whose
+ * faults all came back local is scanned half as often next time, up to
+ * NUMA_SCAN_BACKOFF_MAX intervals apart. Home nodes are pinned; tasks are
+ * not moved.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "numa.h"
+#include "memory_manager.h"
+#include "latency.h"
+#include "../trace/workload.h"
+
+NumaNode numa_nodes[MAX_NUMA_NODES] = {
+    { 0, MAX_FRAMES }
+};
+int numa_node_count = 1;
+NumaPolicy numa_policy = NUMA_FIRST_TOUCH;
+int numa_preferred_node = 0;
+bool numa_balancing = false;
+int numa_scan_interval = NUMA_DEFAULT_SCAN_INTERVAL;
+int numa_migrate_limit = NUMA_DEFAULT_MIGRATE_LIMIT;
+int numa_home[MAX_PROCESSES];
+NumaStats numa_stats;
+
+static bool hint_armed[MAX_PROCESSES][MAX_PAGES];
+static int last_node[MAX_FRAMES];      // Node of the last hinting fault, -1 before one
+static int alloc_pid = -1;              // Process and page the next frame is for
+static int alloc_page;
+static unsigned long long next_scan[MAX_PROCESSES];
+static int scan_period[MAX_PROCESSES];  // References between scans, 0 before the first
+static bool remote_seen[MAX_PROCESSES]; // A hinting fault since the last scan was remote
+static unsigned long long next_budget;
+static int budget;                      // Migrations left in this interval
+
+static const char* policy_names[NUMA_POLICY_COUNT] = {
+    "First touch", "Interleave", "Preferred"
+};
+
+// Clear the hinting state and the counters; the node layout and policy are kept
+void reset_numa() {
+    memset(hint_armed, 0, sizeof(hint_armed));
+    memset(&numa_stats, 0, sizeof(numa_stats));
+    for(int f = 0; f < MAX_FRAMES; f++) {
+        last_node[f] = -1;
+    }
+    alloc_pid = -1;
+    alloc_page = 0;
+    memset(next_scan, 0, sizeof(next_scan));
+    memset(scan_period, 0, sizeof(scan_period));
+    memset(remote_seen, 0, sizeof(remote_seen));
+    next_budget = 0;
+    budget = 0;
+}
+
+// Split the frames evenly across nodes; returns 0 or -1
+int numa_configure(int nodes) {
+    if(nodes < 1 || nodes > MAX_NUMA_NODES || nodes > MAX_FRAMES) {
+        printf("Error: Between 1 and %d NUMA nodes are supported\n", MAX_NUMA_NODES);
+        return -1;
+    }
+
+    int first = 0;
+    for(int n = 0; n < nodes; n++) {
+        numa_nodes[n].first_frame = first;
+        numa_nodes[n].frames = MAX_FRAMES / nodes + (n < MAX_FRAMES % nodes);
+        first += numa_nodes[n].frames;
+    }
+    numa_node_count = nodes;
+
+    for(int pid = 0; pid < MAX_PROCESSES; pid++) {
+        numa_home[pid] %= nodes;
+    }
+    if(numa_preferred_node >= nodes) {
+        numa_preferred_node = 0;
+    }
+    return 0;
+}
+
+// Display name of a policy
+const char* numa_policy_name(NumaPolicy policy) {
+    return (policy >= 0 && policy < NUMA_POLICY_COUNT) ? policy_names[policy] : "Unknown";
+}
+
+// Node a frame is attached to
+int frame_node(int frame_id) {
+    for(int n = 0; n < numa_node_count - 1; n++) {
+        if(frame_id < numa_nodes[n].first_frame + numa_nodes[n].frames) {
+            return n;
+        }
+    }
+    return numa_node_count - 1;
+}
+
+// Pin a process to a node
+int numa_set_home(int pid, int node) {
+    if(pid < 0 || pid >= MAX_PROCESSES || node < 0 || node >= numa_node_count) {
+        printf("Error: Invalid process %d or node %d\n", pid, node);
+        return -1;
+    }
+    numa_home[pid] = node;
+    return 0;
+}
+
+// New processes are spread across the nodes by slot
+void numa_on_create(int pid) {
+    numa_home[pid] = pid % numa_node_count;
+    numa_release_process(pid);
+}
+
+// Record which process and page the next frame allocation serves
+void numa_set_context(int pid, int page_number) {
+    alloc_pid = pid;
+    alloc_page = page_number;
+}
+
+static int node_free_frame(int node) {
+    for(int i = 0; i < numa_nodes[node].frames; i++) {
+        int frame_id = numa_nodes[node].first_frame + i;
+        if(physical_memory[frame_id].is_free) {
+            return frame_id;
+        }
+    }
+    return -1;
+}
+
+// Free frame on the node the policy picks, else on the nodes after it; -1 if none
+int numa_find_free_frame() {
+    int node;
+    switch(numa_policy) {
+        case NUMA_INTERLEAVE:
+            node = alloc_page % numa_node_count;
+            break;
+        case NUMA_PREFERRED:
+            node = numa_preferred_node;
+            break;
+        default:
+            node = (alloc_pid >= 0 && alloc_pid < MAX_PROCESSES) ? numa_home[alloc_pid] : 0;
+            break;
+    }
+
+    for(int i = 0; i < numa_node_count; i++) {
+        int frame_id = node_free_frame((node + i) % numa_node_count);
+        if(frame_id != -1) {
+            return frame_id;
+        }
+    }
+    return -1;
+}
+
+// ==================== BALANCING ====================
+
+// Refill the migration budget each interval and arm the pages of every
+// process whose scan is due
+void numa_tick() {
+    unsigned long long now = stats.total_references;
+    int interval = numa_scan_interval > 0 ? numa_scan_interval : 1;
+
+    if(now >= next_budget) {
+        next_budget = now + interval;
+        budget = numa_migrate_limit;
+    }
+    if(!numa_balancing || numa_node_count < 2) {
+        return;
+    }
+
+    for(int pid = 0; pid < MAX_PROCESSES; pid++) {
+        if(processes[pid].pid == -1 || now < next_scan[pid]) {
+            continue;
+        }
+
+        // Back off while the process's pages are already where it runs
+        if(scan_period[pid] == 0 || remote_seen[pid]) {
+            scan_period[pid] = interval;
+        } else if(scan_period[pid] < interval * NUMA_SCAN_BACKOFF_MAX) {
+            scan_period[pid] *= 2;
+        }
+        remote_seen[pid] = false;
+        next_scan[pid] = now + scan_period[pid];
+
+        numa_stats.scans++;
+        for(int page = 0; page < MAX_PAGES; page++) {
+            hint_armed[pid][page] = processes[pid].page_table[page].present;
+        }
+    }
+}
+
+// Move a remotely used page to the faulting process's node, returns its frame
+static int hint_fault(int pid, int page_number, int frame_id) {
+    int home = numa_home[pid];
+
+    numa_stats.hint_faults++;
+    latency_charge(LAT_MINOR_FAULT, NUMA_HINT_FAULT_NS);
+    VPRINTF("  ✗ NUMA HINT FAULT: Page %d of Process %d on node %d, runs on node %d\n",
+            page_number, pid, frame_node(frame_id), home);
+
+    // Only a second fault in a row from the same node moves the page
+    bool repeat = last_node[frame_id] == home;
+    last_node[frame_id] = home;
+    if(frame_node(frame_id) == home) {
+        return frame_id;
+    }
+    remote_seen[pid] = true;
+    if(!repeat) {
+        return frame_id;
+    }
+
+    int target = node_free_frame(home);
+    if(target == -1 || budget < 1 || migrate_page(frame_id, target) != 0) {
+        numa_stats.migrate_failed++;
+        return frame_id;
+    }
+
+    budget--;
+    numa_stats.migrations++;
+    VPRINTF("  ✓ NUMA MIGRATION: Frame %d -> Frame %d (node %d)\n", frame_id, target, home);
+    return target;
+}
+
+// Account a reference to a resident page as local or remote
+void numa_access(int pid, int page_number) {
+    int frame_id = processes[pid].page_table[page_number].frame_number;
+
+    if(hint_armed[pid][page_number]) {
+        hint_armed[pid][page_number] = false;
+        frame_id = hint_fault(pid, page_number, frame_id);
+    }
+
+    if(frame_node(frame_id) == numa_home[pid]) {
+        numa_stats.local_accesses++;
+    } else {
+        numa_stats.remote_accesses++;
+        latency_charge(LAT_DRAM, NUMA_REMOTE_LATENCY_NS - NUMA_LOCAL_LATENCY_NS);
+    }
+}
+
+// A freed frame forgets who used it
+void numa_forget_frame(int frame_id) {
+    last_node[frame_id] = -1;
+}
+
+// Hinting history follows a migrated page
+void numa_migrate_frame(int from_frame, int to_frame) {
+    last_node[to_frame] = last_node[from_frame];
+    last_node[from_frame] = -1;
+}
+
+// Drop the hinting state of a terminating process
+void numa_release_process(int pid) {
+    memset(hint_armed[pid], 0, sizeof(hint_armed[pid]));
+    next_scan[pid] = 0;
+    scan_period[pid] = 0;
+    remote_seen[pid] = false;
+}
+
+// ==================== REPORTING ====================
+
+static double local_share() {
+    unsigned long long total = numa_stats.local_accesses + numa_stats.remote_accesses;
+    return total ? numa_stats.local_accesses * 100.0 / total : 0.0;
+}
+
+// Memory latency per access, hinting faults included
+static double memory_latency() {
+    unsigned long long total = numa_stats.local_accesses + numa_stats.remote_accesses;
+    if(total == 0) {
+        return 0.0;
+    }
+    return (numa_stats.local_accesses * (double)NUMA_LOCAL_LATENCY_NS +
+            numa_stats.remote_accesses * (double)NUMA_REMOTE_LATENCY_NS +
+            numa_stats.hint_faults * (double)NUMA_HINT_FAULT_NS) / total;
+}
+
+// Pages of a process on its home node, and in total
+static int local_pages(int pid, int* total) {
+    int local = 0;
+    *total = 0;
+    for(int page = 0; page < MAX_PAGES; page++) {
+        if(processes[pid].page_table[page].present) {
+            (*total)++;
+            local += frame_node(processes[pid].page_table[page].frame_number) == numa_home[pid];
+        }
+    }
+    return local;
+}
+
+// Node layout, where each process's pages live and the access counters
+void display_numa_stats() {
+    printf("\n==================== NUMA ====================\n");
+    printf("Node  Frames  Used\n");
+    printf("----  ------  ----\n");
+    for(int n = 0; n < numa_node_count; n++) {
+        int used = 0;
+        for(int i = 0; i < numa_nodes[n].frames; i++) {
+            used += !physical_memory[numa_nodes[n].first_frame + i].is_free;
+        }
+        printf("%4d  %2d-%-3d  %4d\n", n, numa_nodes[n].first_frame,
+               numa_nodes[n].first_frame + numa_nodes[n].frames - 1, used);
+    }
+
+    printf("\nPID  Home  Pages  Local\n");
+    printf("---  ----  -----  -----\n");
+    for(int pid = 0; pid < MAX_PROCESSES; pid++) {
+        if(processes[pid].pid == -1) {
+            continue;
+        }
+        int total;
+        int local = local_pages(pid, &total);
+        printf("%3d  %4d  %5d  %5d\n", pid, numa_home[pid], total, local);
+    }
+
+    printf("\nPolicy: %s, balancing %s\n", numa_policy_name(numa_policy),
+           numa_balancing ? "on" : "off");
+    printf("Accesses: %llu local, %llu remote (%.1f%% local), %.1f ns memory latency\n",
+           numa_stats.local_accesses, numa_stats.remote_accesses, local_share(), memory_latency());
+    printf("Hint faults: %llu, pages migrated: %llu, not migrated: %llu\n",
+           numa_stats.hint_faults, numa_stats.migrations, numa_stats.migrate_failed);
+    printf("==============================================\n");
+}
+
+// ==================== SIMULATION ====================
+
+#define NUMA_SIM_PROCESSES 2
+#define NUMA_SIM_PAGES 4        // Per process; 8 pages leave two frames free
+
+// Each process works on its own pages, mostly a hot half
+static int build_references(MemoryReference* refs, int count, uint64_t seed) {
+    Workload generator;
+    WorkloadPattern pattern = workload_pattern(PATTERN_HOT_COLD, 0, NUMA_SIM_PAGES);
+    pattern.hot_fraction = 0.5;
+
+    workload_init(&generator, seed);
+    for(int p = 0; p < NUMA_SIM_PROCESSES; p++) {
+        workload_add_process(&generator, p, 1);
+        workload_add_phase(&generator, p, &pattern);
+    }
+    int generated = workload_generate(&generator, refs, count);
+    workload_free(&generator);
+    return generated < 0 ? -1 : 0;
+}
+
+// Both processes start on node 0, where the second one first touches all its
+// pages; the scheduler then moves it to node 1 and the references run
+static void replay(const MemoryReference* refs, int count) {
+    int pids[NUMA_SIM_PROCESSES];
+
+    init_memory_system();
+    for(int p = 0; p < NUMA_SIM_PROCESSES; p++) {
+        pids[p] = create_process("numa");
+        numa_set_home(pids[p], 0);
+    }
+    for(int p = NUMA_SIM_PROCESSES - 1; p >= 0; p--) {
+        for(int page = 0; page < NUMA_SIM_PAGES; page++) {
+            access_memory_ex(pids[p], page * PAGE_SIZE, true);
+        }
+    }
+    numa_set_home(pids[1], 1);
+
+    memset(&numa_stats, 0, sizeof(numa_stats));
+    for(int i = 0; i < count; i++) {
+        access_memory_ex(pids[refs[i].pid], (int)refs[i].address, refs[i].is_write);
+    }
+}
+
+// Each placement policy with balancing off and on, on a two-socket host
+void run_numa_simulation(int refs, uint64_t seed) {
+    NumaNode saved_nodes[MAX_NUMA_NODES];
+    int saved_count = numa_node_count;
+    int saved_homes[MAX_PROCESSES];
+    NumaPolicy saved_policy = numa_policy;
+    int saved_preferred = numa_preferred_node;
+    bool saved_balancing = numa_balancing;
+    int saved_zero_page = zero_page_enabled;
+
+    if(refs <= 0) {
+        printf("Error: Reference count must be positive\n");
+        return;
+    }
+    MemoryReference* batch = (MemoryReference*)malloc(refs * sizeof(MemoryReference));
+    if(batch == NULL || build_references(batch, refs, seed) != 0) {
+        printf("Error: Memory allocation failed\n");
+        free(batch);
+        return;
+    }
+
+    memcpy(saved_nodes, numa_nodes, sizeof(saved_nodes));
+    memcpy(saved_homes, numa_home, sizeof(saved_homes));
+    verbose_mode = 0;
+    zero_page_enabled = 0;  // The zero frame is pinned to one node
+    numa_configure(2);
+    numa_preferred_node = 1;
+
+    printf("\n========================== NUMA PLACEMENT ==========================\n");
+    printf("2 nodes x %d frames, local %d ns, remote %d ns, hint fault %d ns\n",
+           MAX_FRAMES / 2, NUMA_LOCAL_LATENCY_NS, NUMA_REMOTE_LATENCY_NS, NUMA_HINT_FAULT_NS);
+    printf("%d processes x %d pages first touched on node 0, then process 1 moves to\n",
+           NUMA_SIM_PROCESSES, NUMA_SIM_PAGES);
+    printf("node 1; preferred node 1, %d references, seed %llu\n", refs, (unsigned long long)seed);
+
+    printf("\nPolicy       Balancing  Local pages  Local refs  Latency  Hints  Migrated\n");
+    printf("-----------  ---------  -----------  ----------  -------  -----  --------\n");
+
+    for(int policy = 0; policy < NUMA_POLICY_COUNT; policy++) {
+        for(int balancing = 0; balancing <= 1; balancing++) {
+            numa_policy = (NumaPolicy)policy;
+            numa_balancing = balancing;
+            replay(batch, refs);
+
+            int local = 0;
+            int total = 0;
+            for(int pid = 0; pid < NUMA_SIM_PROCESSES; pid++) {
+                int pages;
+                local += local_pages(pid, &pages);
+                total += pages;
+            }
+            printf("%-11s  %-9s  %5d of %-3d  %9.1f%%  %7.1f  %5llu  %8llu\n",
+                   numa_policy_name(numa_policy), balancing ? "On" : "Off", local, total,
+                   local_share(), memory_latency(), numa_stats.hint_faults, numa_stats.migrations);
+        }
+    }
+
+    printf("\nFirst touch strands memory on the node that initialised it; interleave\n");
+    printf("caps locality at one page in two. Balancing pulls pages after their users\n");
+    printf("as long as the target node has free frames.\n");
+    printf("====================================================================\n");
+
+    memcpy(numa_nodes, saved_nodes, sizeof(saved_nodes));
+    memcpy(numa_home, saved_homes, sizeof(saved_homes));
+    numa_node_count = saved_count;
+    numa_policy = saved_policy;
+    numa_preferred_node = saved_preferred;
+    numa_balancing = saved_balancing;
+    zero_page_enabled = saved_zero_page;
+    free(batch);
+}
@@ -0,0 +1,70 @@
+/**
+ * numa.h
+ * NUMA nodes, placement policies and automatic page balancing module header
+ */
+
+#ifndef NUMA_H
+#define NUMA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../../include/common_defs.h"
+
+#define MAX_NUMA_NODES 4
+#define NUMA_LOCAL_LATENCY_NS 80
+#define NUMA_REMOTE_LATENCY_NS 140     // One hop across the socket interconnect
+#define NUMA_HINT_FAULT_NS 500          // Cost of a hinting fault on top of the access
+#define NUMA_DEFAULT_SCAN_INTERVAL 50   // Shortest gap between hinting scans of a process
+#define NUMA_SCAN_BACKOFF_MAX 16        // Longest gap, in shortest gaps
+#define NUMA_DEFAULT_MIGRATE_LIMIT 2    // Pages migrated per scan interval
+
+typedef enum {
+    NUMA_FIRST_TOUCH,       // The node the faulting process runs on
+    NUMA_INTERLEAVE,        // Pages round-robin across the nodes
+    NUMA_PREFERRED,         // numa_preferred_node while it has free frames
+    NUMA_POLICY_COUNT
+} NumaPolicy;
+
+// A range of physical frames attached to one socket
+typedef struct {
+    int first_frame;
+    int frames;
+} NumaNode;
+
+typedef struct {
+    unsigned long long local_accesses;
+    unsigned long long remote_accesses;
+    unsigned long long hint_faults;
+    unsigned long long migrations;
+    unsigned long long migrate_failed;  // No free frame on the target node, or over the limit
+    unsigned long long scans;           // Processes armed
+} NumaStats;
+
+extern NumaNode numa_nodes[MAX_NUMA_NODES];
+extern int numa_node_count;
+extern NumaPolicy numa_policy;
+extern int numa_preferred_node;
+extern bool numa_balancing;
+extern int numa_scan_interval;
+extern int numa_migrate_limit;
+extern int numa_home[MAX_PROCESSES];
+extern NumaStats numa_stats;
+
+// Function Prototypes
+void reset_numa();
+int numa_configure(int nodes);
+const char* numa_policy_name(NumaPolicy policy);
+int frame_node(int frame_id);
+int numa_set_home(int pid, int node);
+void numa_on_create(int pid);
+void numa_set_context(int pid, int page_number);
+int numa_find_free_frame();
+void numa_tick();
+void numa_access(int pid, int page_number);
+void numa_forget_frame(int frame_id);
+void numa_migrate_frame(int from_frame, int to_frame);
+void numa_release_process(int pid);
+void display_numa_stats();
+void run_numa_simulation(int refs, uint64_t seed);
+
+#endif // NUMA_H
@@ -0,0 +1,327 @@
+/**
+ * overcommit.c
+ * Commit accounting, overcommit policies and the OOM killer
+ *
+ * A page costs commit when it first becomes private memory, i.e. on its
+ * first write; reads of untouched pages share the zero frame and cost
+ * nothing. vm_commit() stands in for an anonymous mmap: it reserves
+ * pages up front, and first writes draw on that reservation before
+ * asking for more. The policy decides whether a request is granted.
+ * When a granted promise cannot be kept because memory and swap are
+ * both full, the OOM killer ends the process with the largest footprint.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "overcommit.h"
+#include "memory_manager.h"
+#include "virtual_memory.h"
+#include "../trace/workload.h"
+
+OvercommitPolicy overcommit_policy = OVERCOMMIT_HEURISTIC;
+int overcommit_ratio = OVERCOMMIT_DEFAULT_RATIO;
+CommitAccount commit_accounts[MAX_PROCESSES];
+OvercommitStats overcommit_stats;
+
+static const char* policy_names[OVERCOMMIT_POLICY_COUNT] = {
+    "Heuristic", "Always", "Never"
+};
+
+// Clear every account and the counters; the policy itself is kept
+void reset_overcommit() {
+    memset(commit_accounts, 0, sizeof(commit_accounts));
+    memset(&overcommit_stats, 0, sizeof(overcommit_stats));
+}
+
+// Display name of a policy
+const char* overcommit_policy_name(OvercommitPolicy policy) {
+    return (policy >= 0 && policy < OVERCOMMIT_POLICY_COUNT) ? policy_names[policy] : "Unknown";
+}
+
+// Pages the never policy allows in total: swap plus a share of memory
+int commit_limit() {
+    return swap_slots + MAX_FRAMES * overcommit_ratio / 100;
+}
+
+// Pages committed by every process
+int committed_total() {
+    int total = 0;
+    for(int i = 0; i < MAX_PROCESSES; i++) {
+        total += commit_accounts[i].committed;
+    }
+    return total;
+}
+
+// ==================== COMMIT ACCOUNTING ====================
+
+// Reserve pages for a process, returns 0 or -1 if the policy refuses
+int vm_commit(int pid, int pages) {
+    if(pid < 0 || pid >= MAX_PROCESSES || processes[pid].pid == -1 || pages < 0) {
+        printf("Error: Invalid commit of %d pages for process %d\n", pages, pid);
+        return -1;
+    }
+
+    bool refuse = false;
+    switch(overcommit_policy) {
+        case OVERCOMMIT_ALWAYS:
+            break;
+        case OVERCOMMIT_NEVER:
+            refuse = committed_total() + pages > commit_limit();
+            break;
+        case OVERCOMMIT_HEURISTIC:
+        default:
+            // Only a request no amount of reclaim could back is obviously wrong
+            refuse = pages > MAX_FRAMES + swap_slots;
+            break;
+    }
+
+    if(refuse) {
+        commit_accounts[pid].refused++;
+        overcommit_stats.commit_refusals++;
+        VPRINTF("  ✗ Commit of %d pages refused for Process %d (%s policy, %d/%d committed)\n",
+                pages, pid, overcommit_policy_name(overcommit_policy),
+                committed_total(), commit_limit());
+        return -1;
+    }
+
+    commit_accounts[pid].committed += pages;
+    int total = committed_total();
+    if(total > overcommit_stats.peak_committed) {
+        overcommit_stats.peak_committed = total;
+    }
+    return 0;
+}
+
+// Give back reserved pages that no page has drawn on
+void vm_uncommit(int pid, int pages) {
+    if(pid < 0 || pid >= MAX_PROCESSES) {
+        return;
+    }
+    CommitAccount* account = &commit_accounts[pid];
+    int unused = account->committed - account->charged;
+    account->committed -= (pages < unused) ? pages : unused;
+}
+
+// Charge a page on its first write, returns 0 or -1 if no commit can be had
+int charge_page(int pid, int page_number) {
+    CommitAccount* account = &commit_accounts[pid];
+    if(account->page_charged[page_number]) {
+        return 0;
+    }
+    if(account->charged == account->committed && vm_commit(pid, 1) != 0) {
+        return -1;
+    }
+    account->page_charged[page_number] = true;
+    account->charged++;
+    return 0;
+}
+
+// Return a page's charge when it is unmapped
+void uncharge_page(int pid, int page_number) {
+    CommitAccount* account = &commit_accounts[pid];
+    if(!account->page_charged[page_number]) {
+        return;
+    }
+    account->page_charged[page_number] = false;
+    account->charged--;
+    account->committed--;
+}
+
+// A forked child owes the same private pages as its parent, returns 0 or -1
+int overcommit_fork(int parent, int child) {
+    if(vm_commit(child, commit_accounts[parent].committed) != 0) {
+        return -1;
+    }
+    commit_accounts[child].charged = commit_accounts[parent].charged;
+    memcpy(commit_accounts[child].page_charged, commit_accounts[parent].page_charged,
+           sizeof(commit_accounts[child].page_charged));
+    return 0;
+}
+
+// Drop a terminated process's commit
+void release_commit(int pid) {
+    memset(&commit_accounts[pid], 0, sizeof(CommitAccount));
+}
+
+// ==================== OOM KILLER ====================
+
+// Pages a process holds in memory and swap, the OOM killer's score
+int oom_badness(int pid) {
+    if(pid < 0 || pid >= MAX_PROCESSES || processes[pid].pid == -1) {
+        return -1;
+    }
+    return processes[pid].page_count + swap_pages(pid);
+}
+
+// Kill the process with the highest score, returns its pid or -1 if none is left
+int oom_kill() {
+    int victim = -1;
+    int worst = -1;
+    for(int i = 0; i < MAX_PROCESSES; i++) {
+        int score = oom_badness(i);
+        if(score > worst) {
+            victim = i;
+            worst = score;
+        }
+    }
+    if(victim == -1) {
+        return -1;
+    }
+
+    VPRINTF("  ✗ OUT OF MEMORY: Killed Process %d (%s), score %d\n",
+            victim, processes[victim].name, worst);
+    if(overcommit_stats.oom_kills < MAX_PROCESSES) {
+        overcommit_stats.victims[overcommit_stats.oom_kills] = victim;
+    }
+    overcommit_stats.oom_kills++;
+    terminate_process(victim);
+    return victim;
+}
+
+// ==================== REPORTS ====================
+
+// Commit per process against the policy's limit
+void display_commit_accounting() {
+    printf("\n==================== COMMIT ACCOUNTING ====================\n");
+    printf("Policy: %s, limit %d pages (swap %d + %d%% of %d frames)\n",
+           overcommit_policy_name(overcommit_policy), commit_limit(),
+           swap_slots, overcommit_ratio, MAX_FRAMES);
+    printf("\nPID  Committed  Charged  Resident  Swapped  Refused  Score\n");
+    printf("---  ---------  -------  --------  -------  -------  -----\n");
+    for(int i = 0; i < MAX_PROCESSES; i++) {
+        if(processes[i].pid == -1) {
+            continue;
+        }
+        printf("%3d  %9d  %7d  %8d  %7d  %7d  %5d\n",
+               i, commit_accounts[i].committed, commit_accounts[i].charged,
+               processes[i].page_count, swap_pages(i), commit_accounts[i].refused,
+               oom_badness(i));
+    }
+    printf("\nCommitted: %d pages (peak %d), zero frame mappings: %d\n",
+           committed_total(), overcommit_stats.peak_committed, zero_page_maps);
+    printf("Refusals: %d, OOM kills: %d\n",
+           overcommit_stats.commit_refusals, overcommit_stats.oom_kills);
+    printf("===========================================================\n");
+}
+
+// Sparse read-mostly processes: each reads across its whole address
+// space and writes only a few pages
+static void run_sparse_workload(int processes_count, int refs, uint64_t seed,
+                                int* peak_frames, int* faults) {
+    WorkloadRng rng;
+    int pids[MAX_PROCESSES];
+
+    init_memory_system();
+    workload_rng_seed(&rng, seed);
+    for(int p = 0; p < processes_count; p++) {
+        pids[p] = create_process("sparse");
+    }
+
+    *peak_frames = 0;
+    for(int i = 0; i < refs; i++) {
+        int pid = pids[i % processes_count];
+        bool is_write = workload_rng_double(&rng) < 0.05;
+        int page = is_write ? (int)workload_rng_bounded(&rng, 2) :
+                              (int)workload_rng_bounded(&rng, MAX_PAGES);
+        access_memory_ex(pid, page * PAGE_SIZE, is_write);
+
+        int used = 0;
+        for(int f = 0; f < MAX_FRAMES; f++) {
+            used += !physical_memory[f].is_free;
+        }
+        if(used > *peak_frames) {
+            *peak_frames = used;
+        }
+    }
+    *faults = stats.total_page_faults;
+}
+
+// Demand-zero savings, then each overcommit policy under memory pressure
+void run_overcommit_simulation(int swap_limit, uint64_t seed) {
+    const int workers = MAX_PROCESSES;
+    const int mapping = 8;                  // Pages each worker maps up front
+    const int greedy_mapping = 1000;        // One worker asks for far too much
+    const int refs = 400;
+    int saved_slots = swap_slots;
+    int saved_zero_page = zero_page_enabled;
+    OvercommitPolicy saved_policy = overcommit_policy;
+
+    if(swap_limit < 0 || swap_limit > SWAP_SPACE_SIZE) {
+        printf("Error: Swap limit must be 0-%d slots\n", SWAP_SPACE_SIZE);
+        return;
+    }
+
+    verbose_mode = 0;
+
+    printf("\n==================== DEMAND-ZERO PAGES ====================\n");
+    printf("%d processes, %d references, 95%% reads across %d pages, writes to 2\n",
+           workers - 1, refs, MAX_PAGES);
+    printf("\nZero page  Peak frames  Page faults  Zero mappings\n");
+    printf("---------  -----------  -----------  -------------\n");
+    for(int enabled = 0; enabled <= 1; enabled++) {
+        int peak;
+        int faults;
+        zero_page_enabled = enabled;
+        run_sparse_workload(workers - 1, refs, seed, &peak, &faults);
+        printf("%-9s  %11d  %11d  %13d\n", enabled ? "On" : "Off", peak, faults, zero_page_maps);
+    }
+    printf("===========================================================\n");
+
+    zero_page_enabled = saved_zero_page;
+    swap_slots = swap_limit;
+    printf("\n======================== OVERCOMMIT POLICIES ========================\n");
+    printf("%d workers map %d pages each, one also asks for %d; each then writes\n",
+           workers, mapping, greedy_mapping);
+    printf("%d random pages of %d; %d frames, %d swap slots, ratio %d%%\n",
+           refs / workers, MAX_PAGES, MAX_FRAMES, swap_slots, overcommit_ratio);
+    printf("\nPolicy      Limit  Peak commit  Refused  OOM kills  Writes done  Victims\n");
+    printf("----------  -----  -----------  -------  ---------  -----------  -------\n");
+
+    for(int policy = 0; policy < OVERCOMMIT_POLICY_COUNT; policy++) {
+        WorkloadRng rng;
+        int pids[MAX_PROCESSES];
+        int done = 0;
+
+        overcommit_policy = (OvercommitPolicy)policy;
+        init_memory_system();
+        workload_rng_seed(&rng, seed);
+
+        for(int w = 0; w < workers; w++) {
+            pids[w] = create_process(w == workers - 1 ? "greedy" : "worker");
+            vm_commit(pids[w], mapping);
+        }
+        vm_commit(pids[workers - 1], greedy_mapping);
+
+        for(int i = 0; i < refs; i++) {
+            int pid = pids[i % workers];
+            int page = (int)workload_rng_bounded(&rng, MAX_PAGES);
+            uint64_t word = workload_rng_next(&rng);
+            if(processes[pid].pid != -1 &&
+               write_memory(pid, page * PAGE_SIZE, &word, sizeof(word)) != -1) {
+                done++;
+            }
+        }
+
+        char victims[32] = "-";
+        int length = 0;
+        for(int k = 0; k < overcommit_stats.oom_kills && k < MAX_PROCESSES; k++) {
+            length += snprintf(victims + length, sizeof(victims) - length, "%s%d",
+                               k ? "," : "", overcommit_stats.victims[k]);
+        }
+        printf("%-10s  %5d  %11d  %7d  %9d  %11d  %s\n",
+               overcommit_policy_name(overcommit_policy), commit_limit(),
+               overcommit_stats.peak_committed, overcommit_stats.commit_refusals,
+               overcommit_stats.oom_kills, done, victims);
+    }
+
+    printf("\nNever refuses commits up front; Heuristic and Always promise more\n");
+    printf("than exists and fall back on the OOM killer when swap fills\n");
+    printf("=====================================================================\n");
+
+    display_commit_accounting();
+
+    swap_slots = saved_slots;
+    overcommit_policy = saved_policy;
+    zero_page_enabled = saved_zero_page;
+}
@@ -0,0 +1,59 @@
+/**
+ * overcommit.h
+ * Commit accounting, overcommit policies and the OOM killer
+ */
+
+#ifndef OVERCOMMIT_H
+#define OVERCOMMIT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../../include/common_defs.h"
+
+// Same meaning as vm.overcommit_memory 0, 1 and 2
+typedef enum {
+    OVERCOMMIT_HEURISTIC,   // Refuse only requests larger than memory plus swap
+    OVERCOMMIT_ALWAYS,      // Never refuse; running out is left to the OOM killer
+    OVERCOMMIT_NEVER,       // Refuse past swap + overcommit_ratio% of memory
+    OVERCOMMIT_POLICY_COUNT
+} OvercommitPolicy;
+
+#define OVERCOMMIT_DEFAULT_RATIO 50
+
+// Pages a process may make private; a page is charged on its first write
+typedef struct {
+    int committed;
+    int charged;
+    bool page_charged[MAX_PAGES];
+    int refused;            // Commit requests turned down
+} CommitAccount;
+
+typedef struct {
+    int commit_refusals;
+    int oom_kills;
+    int peak_committed;
+    int victims[MAX_PROCESSES];  // Killed processes in order
+} OvercommitStats;
+
+extern OvercommitPolicy overcommit_policy;
+extern int overcommit_ratio;
+extern CommitAccount commit_accounts[MAX_PROCESSES];
+extern OvercommitStats overcommit_stats;
+
+// Function Prototypes
+void reset_overcommit();
+const char* overcommit_policy_name(OvercommitPolicy policy);
+int commit_limit();
+int committed_total();
+int vm_commit(int pid, int pages);
+void vm_uncommit(int pid, int pages);
+int charge_page(int pid, int page_number);
+void uncharge_page(int pid, int page_number);
+int overcommit_fork(int parent, int child);
+void release_commit(int pid);
+int oom_badness(int pid);
+int oom_kill();
+void display_commit_accounting();
+void run_overcommit_simulation(int swap_limit, uint64_t seed);
+
+#endif // OVERCOMMIT_H
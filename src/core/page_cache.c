@@ -0,0 +1,456 @@
+/**
+ * page_cache.c
+ * File-backed mappings, shared page cache and readahead implementation
+ *
+ * Files are small in-memory images standing in for the disk. A process
+ * maps a range of a file into its address space as a file-backed region
+ * (see vma.c), which also carries the readahead state; a fault on such a page
+ * is served from the page cache, a global index from (file, page) to the
+ * frame holding it, so every process mapping the same file shares one
+ * frame per page. Cached frames stay resident after the last mapping is
+ * dropped and are reclaimed like any other frame, but need no swap: clean
+ * pages are simply dropped and dirty ones written back to the file.
+ * Private mappings are mapped copy-on-write, so a write copies the page
+ * out of the cache through cow_fault().
+ *
+ * Readahead follows the kernel's on-demand scheme. A miss right after the
+ * previous page starts a window; the page marked async_size from the end
+ * of the window reads the next, doubled window when it is hit, so a
+ * sequential reader stays ahead of its faults. A miss elsewhere reads
+ * just the page and resets the window.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "page_cache.h"
+#include "memory_manager.h"
+#include "latency.h"
+#include "../utils/address_table.h"
+#include "../trace/workload.h"
+
+// Key 0 is reserved by the address table, so file ids start at 1
+#define CACHE_KEY(file, offset) (((uint64_t)((file) + 1) << 32) | (uint32_t)(offset))
+
+// What a cached frame holds
+typedef struct {
+    bool cached;
+    int file_id;
+    int offset;
+    bool readahead;     // Read ahead and not faulted on yet
+    bool marker;        // Hitting it starts the next readahead window
+} CachePage;
+
+SimFile sim_files[MAX_FILES];
+PageCacheStats page_cache_stats;
+int readahead_max_pages = READAHEAD_DEFAULT_MAX_PAGES;
+
+static unsigned char file_contents[MAX_FILES][FILE_MAX_PAGES][PAGE_SIZE];
+static CachePage cache_pages[MAX_FRAMES];
+static AddressTable cache_index;
+
+// Drop every file and cached page along with the counters
+void reset_page_cache() {
+    address_table_free(&cache_index);
+    memset(sim_files, 0, sizeof(sim_files));
+    memset(cache_pages, 0, sizeof(cache_pages));
+    memset(&page_cache_stats, 0, sizeof(page_cache_stats));
+}
+
+// ==================== FILES AND MAPPINGS ====================
+
+// Create a file of pseudo-random contents, returns its id or -1
+int file_create(const char* name, int pages, uint64_t seed) {
+    if(pages < 1 || pages > FILE_MAX_PAGES) {
+        printf("Error: A file must have 1-%d pages\n", FILE_MAX_PAGES);
+        return -1;
+    }
+    for(int id = 0; id < MAX_FILES; id++) {
+        if(sim_files[id].valid) {
+            continue;
+        }
+
+        WorkloadRng rng;
+        workload_rng_seed(&rng, seed + id);
+        for(int page = 0; page < pages; page++) {
+            for(int i = 0; i < PAGE_SIZE; i += sizeof(uint64_t)) {
+                uint64_t word = workload_rng_next(&rng);
+                memcpy(&file_contents[id][page][i], &word, sizeof(word));
+            }
+        }
+        sim_files[id].valid = true;
+        snprintf(sim_files[id].name, sizeof(sim_files[id].name), "%s", name);
+        sim_files[id].pages = pages;
+        return id;
+    }
+    printf("Error: Maximum number of files reached (%d)\n", MAX_FILES);
+    return -1;
+}
+
+// Map file pages into a process, returns 0 or -1; the range must be untouched
+int mmap_file(int pid, int file_id, int file_offset, int start_page, int pages, bool shared) {
+    if(pid < 0 || pid >= MAX_PROCESSES || processes[pid].pid == -1) {
+        printf("Error: Invalid process ID %d\n", pid);
+        return -1;
+    }
+    if(file_id < 0 || file_id >= MAX_FILES || !sim_files[file_id].valid || pages < 1 ||
+       file_offset < 0 || file_offset + pages > sim_files[file_id].pages ||
+       start_page < 0 || start_page + pages > MAX_PAGES) {
+        printf("Error: Invalid mapping of %d pages of file %d at page %d\n",
+               pages, file_id, start_page);
+        return -1;
+    }
+    for(int page = start_page; page < start_page + pages; page++) {
+        if(processes[pid].page_table[page].valid || find_file_mapping(pid, page) != NULL) {
+            printf("Error: Page %d of Process %d is already in use\n", page, pid);
+            return -1;
+        }
+    }
+
+    if(mmap_region(pid, start_page, pages, VMA_READ | VMA_WRITE, shared ? VMA_SHARED : 0,
+                   file_id, file_offset) == -1) {
+        return -1;
+    }
+    
+    VPRINTF("✓ %s pages %d-%d mapped %s at pages %d-%d of Process %d\n",
+            sim_files[file_id].name, file_offset, file_offset + pages - 1,
+            shared ? "shared" : "private", start_page, start_page + pages - 1, pid);
+    return 0;
+}
+
+// File-backed region covering a page, NULL for anonymous memory
+Vma* find_file_mapping(int pid, int page_number) {
+    MmStruct* mm = process_mm(pid);
+    if(mm == NULL || page_number < 0) {
+        return NULL;
+    }
+    Vma* vma = vma_find(mm, (uint64_t)page_number);
+    return (vma != NULL && vma->file_id != -1) ? vma : NULL;
+}
+
+// ==================== PAGE CACHE ====================
+
+// Frame caching a file page, -1 if it is not cached
+int page_cache_lookup(int file_id, int offset) {
+    uint64_t frame_id;
+    if(address_table_get(&cache_index, CACHE_KEY(file_id, offset), &frame_id)) {
+        return (int)frame_id;
+    }
+    return -1;
+}
+
+// True if the frame belongs to the page cache
+bool page_cache_holds(int frame_id) {
+    return frame_id >= 0 && frame_id < MAX_FRAMES && cache_pages[frame_id].cached;
+}
+
+// Read one file page into a new cache frame, returns the frame or -1
+static int read_cache_page(int pid, int file_id, int offset, bool readahead) {
+    int frame_id = find_free_frame();
+    if(frame_id == -1) {
+        frame_id = reclaim_frame();
+    }
+    if(frame_id == -1 || processes[pid].pid == -1) {
+        return -1;
+    }
+
+    physical_memory[frame_id].load_time = current_time;
+    physical_memory[frame_id].last_access = current_time;
+    physical_memory[frame_id].reference_bit = 0;
+    physical_memory[frame_id].dirty = false;
+    memcpy(frame_data[frame_id], file_contents[file_id][offset], PAGE_SIZE);
+    mark_frame_used(frame_id);
+
+    CachePage* page = &cache_pages[frame_id];
+    page->cached = true;
+    page->file_id = file_id;
+    page->offset = offset;
+    page->readahead = readahead;
+    page->marker = false;
+    address_table_put(&cache_index, CACHE_KEY(file_id, offset), (uint64_t)frame_id);
+
+    page_cache_stats.pages_read++;
+    page_cache_stats.readahead_pages += readahead;
+    return frame_id;
+}
+
+static int next_window_size(int size) {
+    int next = size ? size * 2 : READAHEAD_INIT_PAGES;
+    return next < readahead_max_pages ? next : readahead_max_pages;
+}
+
+// Read the uncached pages of a window, except the one being faulted.
+// Works on a copy of the window: reclaim may kill the reader and free its region
+static void read_window(int pid, int file_id, ReadaheadState ra, int faulting_offset) {
+    int marker = ra.start + ra.size - ra.async_size;
+
+    for(int offset = ra.start;
+        offset < ra.start + ra.size && offset < sim_files[file_id].pages; offset++) {
+        if(offset == faulting_offset || page_cache_lookup(file_id, offset) != -1) {
+            continue;
+        }
+        int frame_id = read_cache_page(pid, file_id, offset, true);
+        if(frame_id == -1) {
+            return;
+        }
+        cache_pages[frame_id].marker = (ra.async_size > 0 && offset == marker);
+    }
+}
+
+// Map a file page from the cache, reading it and its readahead window on
+// a miss; returns the frame or -1
+int page_cache_fault(int pid, int page_number) {
+    Vma* mapping = find_file_mapping(pid, page_number);
+    if(mapping == NULL) {
+        return -1;
+    }
+
+    // The region is not touched once reading starts, as reclaim may free it
+    int file_id = mapping->file_id;
+    bool shared = (mapping->flags & VMA_SHARED) != 0;
+    ReadaheadState* ra = &mapping->ra;
+    int offset = (int)(mapping->file_offset + page_number - mapping->start);
+    int prev_offset = ra->prev_offset;
+    int frame_id = page_cache_lookup(file_id, offset);
+    ra->prev_offset = offset;
+
+    if(frame_id != -1) {
+        CachePage* page = &cache_pages[frame_id];
+        page_cache_stats.hits++;
+        latency_event(LAT_MINOR_FAULT);
+        page_cache_stats.readahead_used += page->readahead;
+        page->readahead = false;
+        VPRINTF("  ✓ PAGE CACHE HIT: %s page %d in Frame %d\n",
+                sim_files[file_id].name, offset, frame_id);
+
+        // The reader caught up with the window: read the next one ahead
+        if(page->marker && readahead_max_pages > 0) {
+            page->marker = false;
+            if(offset != ra->start + ra->size - ra->async_size) {
+                // Marked by another reader of the file
+                ra->start = offset;
+                ra->size = 1;
+            }
+            ra->start += ra->size;
+            ra->size = next_window_size(ra->size);
+            ra->async_size = ra->size;
+            page_cache_stats.async_readaheads++;
+            read_window(pid, file_id, *ra, -1);
+        }
+    } else {
+        page_cache_stats.misses++;
+        latency_event(LAT_MAJOR_FAULT);
+        VPRINTF("  ✗ PAGE CACHE MISS: Reading %s page %d\n", sim_files[file_id].name, offset);
+
+        ra->start = offset;
+        if(readahead_max_pages > 0 && offset == prev_offset + 1) {
+            ra->size = next_window_size(ra->size);
+            ra->async_size = ra->size / 2;
+            read_window(pid, file_id, *ra, offset);
+        } else {
+            ra->size = 0;
+            ra->async_size = 0;
+        }
+    }
+
+    if(processes[pid].pid == -1) {
+        return -1;  // Killed to make room for the window
+    }
+
+    // Reading the window may have reclaimed the page itself
+    frame_id = page_cache_lookup(file_id, offset);
+    if(frame_id == -1) {
+        frame_id = read_cache_page(pid, file_id, offset, false);
+        if(frame_id == -1) {
+            return -1;
+        }
+    }
+
+    map_page(pid, page_number, frame_id);
+    processes[pid].page_table[page_number].cow = !shared;
+    current_time++;
+    return frame_id;
+}
+
+// Take a frame out of the cache ahead of its eviction, writing it back if a
+// shared mapping dirtied it; returns true if it was cached
+bool page_cache_evict_frame(int frame_id) {
+    if(!page_cache_holds(frame_id)) {
+        return false;
+    }
+
+    CachePage* page = &cache_pages[frame_id];
+    if(physical_memory[frame_id].dirty) {
+        memcpy(file_contents[page->file_id][page->offset], frame_data[frame_id], PAGE_SIZE);
+        page_cache_stats.writebacks++;
+        latency_event(LAT_WRITEBACK);
+    }
+    page_cache_stats.readahead_wasted += page->readahead;
+    page_cache_stats.evictions++;
+
+    uint64_t unused;
+    address_table_take(&cache_index, CACHE_KEY(page->file_id, page->offset), &unused);
+    memset(page, 0, sizeof(CachePage));
+    return true;
+}
+
+// A cached page moved by migrate_page stays indexed
+void page_cache_migrate_frame(int from_frame, int to_frame) {
+    if(!page_cache_holds(from_frame)) {
+        return;
+    }
+    cache_pages[to_frame] = cache_pages[from_frame];
+    memset(&cache_pages[from_frame], 0, sizeof(CachePage));
+    address_table_put(&cache_index, CACHE_KEY(cache_pages[to_frame].file_id,
+                                              cache_pages[to_frame].offset), (uint64_t)to_frame);
+}
+
+// Frames held by the cache; mapped, if given, receives how many are mapped
+int page_cache_pages(int* mapped) {
+    int pages = 0;
+    int in_use = 0;
+    for(int i = 0; i < MAX_FRAMES; i++) {
+        if(cache_pages[i].cached) {
+            pages++;
+            in_use += (physical_memory[i].ref_count > 0);
+        }
+    }
+    if(mapped != NULL) {
+        *mapped = in_use;
+    }
+    return pages;
+}
+
+// ==================== REPORTS ====================
+
+// Hit ratio, readahead efficiency and what each file has cached
+void display_page_cache_stats() {
+    unsigned long long faults = page_cache_stats.hits + page_cache_stats.misses;
+    int mapped;
+    int cached = page_cache_pages(&mapped);
+    int used = 0;
+    for(int i = 0; i < MAX_FRAMES; i++) {
+        used += !physical_memory[i].is_free;
+    }
+
+    printf("\n==================== PAGE CACHE ====================\n");
+    printf("File            Pages  Cached  Mappings\n");
+    printf("--------------  -----  ------  --------\n");
+    for(int id = 0; id < MAX_FILES; id++) {
+        if(!sim_files[id].valid) {
+            continue;
+        }
+        int file_cached = 0;
+        int mappings = 0;
+        for(int i = 0; i < MAX_FRAMES; i++) {
+            file_cached += (cache_pages[i].cached && cache_pages[i].file_id == id);
+        }
+        for(int pid = 0; pid < MAX_PROCESSES; pid++) {
+            MmStruct* mm = process_mm(pid);
+            for(Vma* vma = vma_next(mm, 0); processes[pid].pid != -1 && vma != NULL;
+                vma = vma_next(mm, vma->end)) {
+                mappings += (vma->file_id == id);
+            }
+        }
+        printf("%-14s  %5d  %6d  %8d\n", sim_files[id].name, sim_files[id].pages,
+               file_cached, mappings);
+    }
+
+    printf("\nFile faults: %llu (%llu hits, %llu misses, %.1f%% hit ratio)\n",
+           faults, page_cache_stats.hits, page_cache_stats.misses,
+           faults ? page_cache_stats.hits * 100.0 / faults : 0.0);
+    printf("Pages read: %llu, by readahead: %llu (%llu used, %llu wasted, %.1f%% efficiency)\n",
+           page_cache_stats.pages_read, page_cache_stats.readahead_pages,
+           page_cache_stats.readahead_used, page_cache_stats.readahead_wasted,
+           page_cache_stats.readahead_pages ?
+           page_cache_stats.readahead_used * 100.0 / page_cache_stats.readahead_pages : 0.0);
+    printf("Async readaheads: %llu, evictions: %llu, writebacks: %llu\n",
+           page_cache_stats.async_readaheads, page_cache_stats.evictions,
+           page_cache_stats.writebacks);
+    printf("Page cache: %d of %d used frames (%d mapped, %d cached only)\n",
+           cached, used, mapped, cached - mapped);
+    printf("====================================================\n");
+}
+
+// Readers share a library and a data file; each streams or randomly reads
+// the data file, with and without readahead
+void run_page_cache_simulation(int readers, uint64_t seed) {
+    const int data_pages = 16;
+    const int lib_pages = 4;
+    const int lib_start = MAX_PAGES - lib_pages;
+    const int refs = 240;
+    static const char* patterns[] = {"Sequential", "Random"};
+    int saved_max = readahead_max_pages;
+
+    if(readers < 1 || readers > MAX_PROCESSES) {
+        printf("Error: Need 1-%d readers\n", MAX_PROCESSES);
+        return;
+    }
+
+    verbose_mode = 0;
+
+    printf("\n========================== PAGE CACHE AND READAHEAD ==========================\n");
+    printf("%d readers map data.bin (%d pages, shared) and libc.so (%d pages, private);\n",
+           readers, data_pages, lib_pages);
+    printf("%d references, every 4th to the library, 10%% of data references write\n", refs);
+    printf("\nPattern     Readahead  Hits  Misses  Read  Ahead  Used  Wasted  Efficiency\n");
+    printf("----------  ---------  ----  ------  ----  -----  ----  ------  ----------\n");
+
+    for(int pattern = 0; pattern < 2; pattern++) {
+        for(int ra = 0; ra <= 1; ra++) {
+            WorkloadRng rng;
+            int pids[MAX_PROCESSES];
+            int position[MAX_PROCESSES];
+
+            readahead_max_pages = ra ? READAHEAD_DEFAULT_MAX_PAGES : 0;
+            init_memory_system();
+            workload_rng_seed(&rng, seed);
+            int lib = file_create("libc.so", lib_pages, seed);
+            int data = file_create("data.bin", data_pages, seed);
+
+            for(int r = 0; r < readers; r++) {
+                pids[r] = create_process("reader");
+                mmap_file(pids[r], data, 0, 0, data_pages, true);
+                mmap_file(pids[r], lib, 0, lib_start, lib_pages, false);
+                position[r] = r * data_pages / readers;
+            }
+
+            for(int i = 0; i < refs; i++) {
+                int r = i % readers;
+                if(processes[pids[r]].pid == -1) {
+                    continue;
+                }
+                if(i % 4 == 3) {
+                    int page = lib_start + (int)workload_rng_bounded(&rng, lib_pages);
+                    access_memory_ex(pids[r], page * PAGE_SIZE, false);
+                    continue;
+                }
+
+                int page;
+                if(pattern == 0) {
+                    page = position[r];
+                    position[r] = (position[r] + 1) % data_pages;
+                } else {
+                    page = (int)workload_rng_bounded(&rng, data_pages);
+                }
+                bool is_write = workload_rng_bounded(&rng, 10) == 0;
+                access_memory_ex(pids[r], page * PAGE_SIZE, is_write);
+            }
+
+            printf("%-10s  %9s  %4llu  %6llu  %4llu  %5llu  %4llu  %6llu  %9.1f%%\n",
+                   patterns[pattern], ra ? "On" : "Off",
+                   page_cache_stats.hits, page_cache_stats.misses, page_cache_stats.pages_read,
+                   page_cache_stats.readahead_pages, page_cache_stats.readahead_used,
+                   page_cache_stats.readahead_wasted,
+                   page_cache_stats.readahead_pages ?
+                   page_cache_stats.readahead_used * 100.0 / page_cache_stats.readahead_pages : 0.0);
+        }
+    }
+
+    printf("\nMisses wait for the file; readahead turns a sequential reader's misses\n");
+    printf("into hits and stays out of the way of random reads\n");
+    printf("==============================================================================\n");
+
+    display_page_cache_stats();
+    readahead_max_pages = saved_max;
+}
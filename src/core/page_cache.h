@@ -0,0 +1,56 @@
+/**
+ * page_cache.h
+ * File-backed mappings, shared page cache and readahead module header
+ */
+
+#ifndef PAGE_CACHE_H
+#define PAGE_CACHE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../../include/common_defs.h"
+#include "vma.h"
+
+#define MAX_FILES 4
+#define FILE_MAX_PAGES 32
+
+#define READAHEAD_INIT_PAGES 2          // First window of a sequential stream
+#define READAHEAD_DEFAULT_MAX_PAGES 4   // Frames are scarce; 0 turns readahead off
+
+typedef struct {
+    bool valid;
+    char name[32];
+    int pages;
+} SimFile;
+
+typedef struct {
+    unsigned long long hits;            // Faults served from the cache
+    unsigned long long misses;          // Faults that waited for the file
+    unsigned long long pages_read;
+    unsigned long long readahead_pages; // Read before anyone asked for them
+    unsigned long long readahead_used;  // ... and faulted on later
+    unsigned long long readahead_wasted;// ... and evicted untouched
+    unsigned long long async_readaheads;
+    unsigned long long evictions;
+    unsigned long long writebacks;      // Dirty shared pages written to their file
+} PageCacheStats;
+
+extern SimFile sim_files[MAX_FILES];
+extern PageCacheStats page_cache_stats;
+extern int readahead_max_pages;
+
+// Function Prototypes
+void reset_page_cache();
+int file_create(const char* name, int pages, uint64_t seed);
+int mmap_file(int pid, int file_id, int file_offset, int start_page, int pages, bool shared);
+Vma* find_file_mapping(int pid, int page_number);
+int page_cache_fault(int pid, int page_number);
+int page_cache_lookup(int file_id, int offset);
+bool page_cache_holds(int frame_id);
+bool page_cache_evict_frame(int frame_id);
+void page_cache_migrate_frame(int from_frame, int to_frame);
+int page_cache_pages(int* mapped);
+void display_page_cache_stats();
+void run_page_cache_simulation(int readers, uint64_t seed);
+
+#endif // PAGE_CACHE_H
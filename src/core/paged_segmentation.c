@@ -0,0 +1,236 @@
+/**
+ * paged_segmentation.c
+ * Paged segmentation implementation
+ *
+ * In the combined mode a logical address is (segment, offset). The limit
+ * check uses the descriptor already loaded in a segment register, as on
+ * x86, so it costs nothing. The TLB caches the composite (segment, page)
+ * -> frame result; only on a miss are the segment table and then the
+ * segment's own page table read. Segment s owns entries
+ * SEGMENT_PAGE_TABLE(s) .. +SEGMENT_PAGES-1 of the process page table,
+ * which lets eviction, swapping and compaction treat its pages like any
+ * other. Pure paging and pure segmentation are costed the same way so the
+ * three schemes can be compared level by level.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "paged_segmentation.h"
+#include "memory_manager.h"
+#include "segmentation.h"
+#include "tlb.h"
+#include "../trace/workload.h"
+
+TranslationCost translation_costs[XLATE_MODE_COUNT];
+
+static const char* mode_names[XLATE_MODE_COUNT] = {
+    "Paging", "Segmentation", "Paged segmentation"
+};
+
+// Clear every scheme's counters
+void reset_translation_costs() {
+    memset(translation_costs, 0, sizeof(translation_costs));
+}
+
+// Access a page through the TLB, charging a hit or the given table walk cost
+static int costed_page_access(TranslationCost* cost, int pid, int address,
+                              bool is_write, int walk_levels) {
+    int hits_before = tlb_stats.hits;
+    int faults_before = processes[pid].page_faults;
+
+    int physical = access_memory_ex(pid, address, is_write);
+
+    cost->tlb_cost += XLATE_COST_TLB;
+    if(tlb_stats.hits != hits_before) {
+        cost->tlb_hits++;
+    } else {
+        if(walk_levels > 1) {
+            cost->segment_lookups++;
+            cost->segment_cost += XLATE_COST_TABLE;
+        }
+        cost->page_walks++;
+        cost->walk_cost += XLATE_COST_TABLE;
+    }
+    if(processes[pid].page_faults != faults_before) {
+        cost->page_faults++;
+        cost->fault_cost += XLATE_COST_FAULT;
+    }
+    return physical;
+}
+
+// Descriptor checks shared by both segmented schemes, 0 if the offset is inside the segment
+static int check_segment(TranslationCost* cost, int pid, int segment_num, int offset) {
+    cost->references++;
+    if(pid < 0 || pid >= MAX_PROCESSES || processes[pid].pid == -1 ||
+       segment_num < 0 || segment_num >= MAX_SEGMENTS ||
+       !processes[pid].segment_table[segment_num].valid ||
+       offset < 0 || offset >= processes[pid].segment_table[segment_num].limit) {
+        cost->segment_faults++;
+        return -1;
+    }
+    return 0;
+}
+
+// Translate (segment, offset) through the segment's page table, returns the physical address or -1
+int paged_segment_access(int pid, int segment_num, int offset, bool is_write) {
+    TranslationCost* cost = &translation_costs[XLATE_PAGED_SEGMENTATION];
+    if(check_segment(cost, pid, segment_num, offset) != 0) {
+        return -1;
+    }
+
+    int page = SEGMENT_PAGE_TABLE(segment_num) + offset / PAGE_SIZE;
+    return costed_page_access(cost, pid, page * PAGE_SIZE + offset % PAGE_SIZE, is_write, 2);
+}
+
+// Plain paging access with its translation cost recorded
+int costed_paging_access(int pid, int address, bool is_write) {
+    TranslationCost* cost = &translation_costs[XLATE_PAGING];
+    cost->references++;
+    return costed_page_access(cost, pid, address, is_write, 1);
+}
+
+// Plain segmentation: one segment table read per reference, no paging below
+int costed_segment_access(int pid, int segment_num, int offset) {
+    TranslationCost* cost = &translation_costs[XLATE_SEGMENTATION];
+    if(check_segment(cost, pid, segment_num, offset) != 0) {
+        return -1;
+    }
+    cost->segment_lookups++;
+    cost->segment_cost += XLATE_COST_TABLE;
+    return processes[pid].segment_table[segment_num].base_address + offset;
+}
+
+// Translate one address step by step for the menu
+void translate_paged_segment(int pid, int segment_num, int offset) {
+    if(pid < 0 || pid >= MAX_PROCESSES || processes[pid].pid == -1) {
+        printf("Error: Invalid process ID %d\n", pid);
+        return;
+    }
+
+    printf("\nAddress Translation (Paged Segmentation):\n");
+    printf("-----------------------------------------\n");
+    printf("Segment Number: %d\n", segment_num);
+    printf("Offset: %d\n", offset);
+
+    if(segment_num < 0 || segment_num >= MAX_SEGMENTS ||
+       !processes[pid].segment_table[segment_num].valid) {
+        printf("✗ SEGMENTATION FAULT: Segment %d not valid\n", segment_num);
+        translation_costs[XLATE_PAGED_SEGMENTATION].references++;
+        translation_costs[XLATE_PAGED_SEGMENTATION].segment_faults++;
+        return;
+    }
+    SegmentTableEntry* segment = &processes[pid].segment_table[segment_num];
+    if(offset < 0 || offset >= segment->limit) {
+        printf("✗ SEGMENTATION FAULT: Offset %d exceeds limit %d\n", offset, segment->limit);
+        translation_costs[XLATE_PAGED_SEGMENTATION].references++;
+        translation_costs[XLATE_PAGED_SEGMENTATION].segment_faults++;
+        return;
+    }
+
+    int page = offset / PAGE_SIZE;
+    printf("✓ Offset within limit %d\n", segment->limit);
+    printf("Segment page table: entries %d-%d, page %d -> entry %d\n",
+           SEGMENT_PAGE_TABLE(segment_num), SEGMENT_PAGE_TABLE(segment_num) + SEGMENT_PAGES - 1,
+           page, SEGMENT_PAGE_TABLE(segment_num) + page);
+
+    TranslationCost before = translation_costs[XLATE_PAGED_SEGMENTATION];
+    int physical = paged_segment_access(pid, segment_num, offset, false);
+    TranslationCost* after = &translation_costs[XLATE_PAGED_SEGMENTATION];
+    if(physical == -1) {
+        return;
+    }
+
+    printf("Frame Number: %d\n", physical / PAGE_SIZE);
+    printf("Physical Address: %d\n", physical);
+    printf("Levels: %s%s\n",
+           after->tlb_hits != before.tlb_hits ? "TLB hit" : "TLB miss, segment table, page table",
+           after->page_faults != before.page_faults ? ", page fault" : "");
+    printf("Cost: %llu time units\n",
+           (after->segment_cost + after->tlb_cost + after->walk_cost + after->fault_cost) -
+           (before.segment_cost + before.tlb_cost + before.walk_cost + before.fault_cost));
+}
+
+// ==================== REPORTS ====================
+
+// Per-level work and cost of each scheme
+void display_translation_costs() {
+    printf("\n============================= TRANSLATION COST BY LEVEL =============================\n");
+    printf("Costs: TLB %d, table read %d, page fault %d time units\n",
+           XLATE_COST_TLB, XLATE_COST_TABLE, XLATE_COST_FAULT);
+    printf("\nScheme                Refs  Seg.faults  Seg.reads  TLB hits  PT walks  Faults  Xlate/ref  Total/ref\n");
+    printf("------------------  ------  ----------  ---------  --------  --------  ------  ---------  ---------\n");
+
+    for(int mode = 0; mode < XLATE_MODE_COUNT; mode++) {
+        TranslationCost* c = &translation_costs[mode];
+        unsigned long long xlate = c->segment_cost + c->tlb_cost + c->walk_cost;
+        printf("%-18s  %6llu  %10llu  %9llu  %8llu  %8llu  %6llu  %9.2f  %9.2f\n",
+               mode_names[mode], c->references, c->segment_faults, c->segment_lookups,
+               c->tlb_hits, c->page_walks, c->page_faults,
+               c->references ? (double)xlate / c->references : 0.0,
+               c->references ? (double)(xlate + c->fault_cost) / c->references : 0.0);
+    }
+
+    printf("\nXlate/ref = segment table + TLB + page table cost; Total/ref adds page faults\n");
+    printf("=====================================================================================\n");
+}
+
+// Same (segment, offset) stream through all three schemes
+void run_translation_comparison(int refs_per_process, uint64_t seed) {
+    const int process_count = 2;
+
+    if(refs_per_process <= 0) {
+        printf("Error: Invalid reference count %d\n", refs_per_process);
+        return;
+    }
+
+    verbose_mode = 0;
+    reset_translation_costs();
+
+    for(int mode = 0; mode < XLATE_MODE_COUNT; mode++) {
+        WorkloadRng rng;
+        int pids[2];
+        int current[2] = {0, 0};
+
+        init_memory_system();
+        workload_rng_seed(&rng, seed);
+        for(int p = 0; p < process_count; p++) {
+            pids[p] = create_process(p == 0 ? "xlate-a" : "xlate-b");
+            for(int s = 0; s < MAX_SEGMENTS; s++) {
+                create_segment(pids[p], s, -1, 1 + (int)workload_rng_bounded(&rng, SEGMENT_SIZE));
+            }
+        }
+
+        // Each process mostly stays in one segment, sometimes moving to another
+        for(int i = 0; i < refs_per_process * process_count; i++) {
+            int p = i % process_count;
+            int pid = pids[p];
+            if(workload_rng_double(&rng) < 0.1) {
+                current[p] = (int)workload_rng_bounded(&rng, MAX_SEGMENTS);
+            }
+            int segment_num = current[p];
+            int offset = (int)workload_rng_bounded(&rng,
+                                                   (uint32_t)processes[pid].segment_table[segment_num].limit);
+            bool is_write = workload_rng_double(&rng) < 0.3;
+
+            switch(mode) {
+                case XLATE_PAGING: {
+                    int page = SEGMENT_PAGE_TABLE(segment_num) + offset / PAGE_SIZE;
+                    costed_paging_access(pid, page * PAGE_SIZE + offset % PAGE_SIZE, is_write);
+                    break;
+                }
+                case XLATE_SEGMENTATION:
+                    costed_segment_access(pid, segment_num, offset);
+                    break;
+                default:
+                    paged_segment_access(pid, segment_num, offset, is_write);
+                    break;
+            }
+        }
+    }
+
+    printf("\n%d processes x %d references, %d segments each, %d frames, seed %llu\n",
+           process_count, refs_per_process, MAX_SEGMENTS, MAX_FRAMES, (unsigned long long)seed);
+    printf("Segmentation keeps whole segments resident, so it never faults\n");
+    display_translation_costs();
+}
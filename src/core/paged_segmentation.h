@@ -0,0 +1,57 @@
+/**
+ * paged_segmentation.h
+ * Paged segmentation (segment -> page table -> frame) module header
+ */
+
+#ifndef PAGED_SEGMENTATION_H
+#define PAGED_SEGMENTATION_H
+
+#include <stdint.h>
+#include "../../include/common_defs.h"
+
+// Each segment owns SEGMENT_PAGES consecutive entries of its process's page table
+#define SEGMENT_PAGES (SEGMENT_SIZE / PAGE_SIZE)
+#define SEGMENT_PAGE_TABLE(segment) ((segment) * SEGMENT_PAGES)
+
+#if MAX_SEGMENTS * SEGMENT_PAGES > MAX_PAGES
+#error "Segment page tables do not fit in the process page table"
+#endif
+
+// Simulated cost of each translation level, in the load control time units
+#define XLATE_COST_TLB 1
+#define XLATE_COST_TABLE 10      // One memory read per table level
+#define XLATE_COST_FAULT 100     // Same as LC_FAULT_SERVICE_TIME
+
+typedef enum {
+    XLATE_PAGING,
+    XLATE_SEGMENTATION,
+    XLATE_PAGED_SEGMENTATION,
+    XLATE_MODE_COUNT
+} TranslationMode;
+
+// Work done per level by one translation scheme
+typedef struct {
+    unsigned long long references;
+    unsigned long long segment_faults;  // Invalid segment or offset past the limit
+    unsigned long long segment_lookups; // Segment table reads
+    unsigned long long tlb_hits;
+    unsigned long long page_walks;      // Page table reads after a TLB miss
+    unsigned long long page_faults;
+    unsigned long long segment_cost;
+    unsigned long long tlb_cost;
+    unsigned long long walk_cost;
+    unsigned long long fault_cost;
+} TranslationCost;
+
+extern TranslationCost translation_costs[XLATE_MODE_COUNT];
+
+// Function Prototypes
+int paged_segment_access(int pid, int segment_num, int offset, bool is_write);
+int costed_paging_access(int pid, int address, bool is_write);
+int costed_segment_access(int pid, int segment_num, int offset);
+void translate_paged_segment(int pid, int segment_num, int offset);
+void reset_translation_costs();
+void display_translation_costs();
+void run_translation_comparison(int refs_per_process, uint64_t seed);
+
+#endif // PAGED_SEGMENTATION_H
@@ -9,6 +9,7 @@
 #include "paging.h"
 #include "../../include/common_defs.h"
 #include "memory_manager.h"
+#include "../trace/workload.h"
 
 // Initialize paging system
 void init_paging_system(int total_pages, int page_size) {
@@ -152,17 +153,18 @@ int* generate_reference_string(int length) {
         return NULL;
     }
     
-    srand(time(NULL));
+    // Seeded generator: the same seed always gives the same string
+    WorkloadRng* rng = workload_global_rng();
     
     // Generate references with some locality
-    int current = rand() % MAX_PAGES;
+    int current = (int)workload_rng_bounded(rng, MAX_PAGES);
     for(int i = 0; i < length; i++) {
         // 70% chance to stay close to current page
-        if(rand() % 100 < 70) {
-            current = (current + (rand() % 5) - 2) % MAX_PAGES;
+        if(workload_rng_bounded(rng, 100) < 70) {
+            current = (current + (int)workload_rng_bounded(rng, 5) - 2) % MAX_PAGES;
             if(current < 0) current = 0;
         } else {
-            current = rand() % MAX_PAGES;
+            current = (int)workload_rng_bounded(rng, MAX_PAGES);
         }
         ref_string[i] = current;
     }
@@ -0,0 +1,368 @@
+/**
+ * prefetch.c
+ * Page-fault prefetcher implementation
+ *
+ * The prefetcher watches each process's faults, and its first touch of
+ * every page it prefetched, since those would have been faults. The
+ * stride policy keeps a small table of streams per process, like a
+ * hardware reference prediction table: a trigger continuing a stream's
+ * stride raises its confidence, a different jump lowers it and, once it
+ * is exhausted, retrains the stride. Confident streams issue the next
+ * prefetch_degree pages along the stride. Prefetches are queued and
+ * complete prefetch_latency references later through the normal fault
+ * path, into frames managed by reclaim like any other page, so a demand
+ * fault can still beat its prefetch (late) and a prefetch can evict a
+ * page that is then faulted on (pollution).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "prefetch.h"
+#include "memory_manager.h"
+#include "paging.h"
+#include "vma.h"
+#include "../trace/workload.h"
+
+typedef struct {
+    bool valid;
+    int pid;
+    int page_number;
+    unsigned long long ready_at;        // Lands before the reference after this count
+} PrefetchRequest;
+
+PrefetchPolicy prefetch_policy = PREFETCH_NONE;
+int prefetch_degree = PREFETCH_DEFAULT_DEGREE;
+int prefetch_latency = PREFETCH_DEFAULT_LATENCY;
+PrefetchStats prefetch_stats;
+
+static PrefetchStream streams[MAX_PROCESSES][PREFETCH_STREAMS];
+static PrefetchRequest queue[PREFETCH_QUEUE_SIZE];
+static bool prefetched[MAX_PROCESSES][MAX_PAGES];           // Loaded, not referenced yet
+static bool evicted_by_prefetch[MAX_PROCESSES][MAX_PAGES];
+static unsigned long long train_clock;
+
+static const char* policy_names[PREFETCH_POLICY_COUNT] = {
+    "Off", "Next-page", "Stride"
+};
+
+// Clear streams, queue and counters; the policy itself is kept
+void reset_prefetch() {
+    memset(streams, 0, sizeof(streams));
+    memset(queue, 0, sizeof(queue));
+    memset(prefetched, 0, sizeof(prefetched));
+    memset(evicted_by_prefetch, 0, sizeof(evicted_by_prefetch));
+    memset(&prefetch_stats, 0, sizeof(prefetch_stats));
+    train_clock = 0;
+}
+
+// Display name of a policy
+const char* prefetch_policy_name(PrefetchPolicy policy) {
+    return (policy >= 0 && policy < PREFETCH_POLICY_COUNT) ? policy_names[policy] : "Unknown";
+}
+
+// ==================== ASYNC QUEUE ====================
+
+static PrefetchRequest* find_request(int pid, int page_number) {
+    for(int i = 0; i < PREFETCH_QUEUE_SIZE; i++) {
+        if(queue[i].valid && queue[i].pid == pid && queue[i].page_number == page_number) {
+            return &queue[i];
+        }
+    }
+    return NULL;
+}
+
+// Queue one page unless it is resident or already on its way
+static void issue(int pid, int page_number) {
+    if(page_number < 0 || page_number >= MAX_PAGES ||
+       processes[pid].page_table[page_number].present || find_request(pid, page_number) != NULL) {
+        return;
+    }
+
+    prefetch_stats.issued++;
+    for(int i = 0; i < PREFETCH_QUEUE_SIZE; i++) {
+        if(!queue[i].valid) {
+            queue[i].valid = true;
+            queue[i].pid = pid;
+            queue[i].page_number = page_number;
+            queue[i].ready_at = stats.total_references + (prefetch_latency > 1 ? prefetch_latency - 1 : 0);
+            return;
+        }
+    }
+    prefetch_stats.dropped++;
+}
+
+// Bring one prefetched page in, noting the pages reclaim evicted for it
+static void complete(PrefetchRequest* request) {
+    int pid = request->pid;
+    int page_number = request->page_number;
+    request->valid = false;
+
+    // Pages outside any readable region are never brought in
+    Vma* vma = vma_find(process_mm(pid), (uint64_t)page_number);
+    if(processes[pid].pid == -1 || processes[pid].suspended ||
+       processes[pid].page_table[page_number].present ||
+       vma == NULL || !(vma->prot & VMA_READ)) {
+        prefetch_stats.dropped++;
+        return;
+    }
+
+    bool resident[MAX_PROCESSES][MAX_PAGES];
+    for(int p = 0; p < MAX_PROCESSES; p++) {
+        for(int g = 0; g < MAX_PAGES; g++) {
+            resident[p][g] = processes[p].pid != -1 && processes[p].page_table[g].present;
+        }
+    }
+
+    if(fault_in_page(pid, page_number, false) != 0) {
+        prefetch_stats.dropped++;
+        return;
+    }
+    prefetch_stats.loaded++;
+    prefetched[pid][page_number] = true;
+    physical_memory[processes[pid].page_table[page_number].frame_number].reference_bit = 0;
+
+    for(int p = 0; p < MAX_PROCESSES; p++) {
+        for(int g = 0; g < MAX_PAGES; g++) {
+            if(resident[p][g] && !processes[p].page_table[g].present) {
+                evicted_by_prefetch[p][g] = true;
+            }
+        }
+    }
+    VPRINTF("  ✓ PREFETCH: Page %d of Process %d loaded\n", page_number, pid);
+}
+
+// Complete every prefetch whose latency has passed
+void prefetch_tick() {
+    for(int i = 0; i < PREFETCH_QUEUE_SIZE; i++) {
+        if(queue[i].valid && queue[i].ready_at <= (unsigned long long)stats.total_references) {
+            complete(&queue[i]);
+        }
+    }
+}
+
+// ==================== STREAM DETECTION ====================
+
+// Match a trigger to the stream it continues or is nearest to, training it
+static PrefetchStream* train_stream(int pid, int page_number) {
+    PrefetchStream* table = streams[pid];
+    PrefetchStream* stream = NULL;
+    int nearest = PREFETCH_MAX_STRIDE + 1;
+
+    for(int i = 0; i < PREFETCH_STREAMS; i++) {
+        if(!table[i].valid) {
+            continue;
+        }
+        if(table[i].stride != 0 && page_number == table[i].last_page + table[i].stride) {
+            stream = &table[i];
+            break;
+        }
+        int distance = abs(page_number - table[i].last_page);
+        if(distance > 0 && distance < nearest) {
+            stream = &table[i];
+            nearest = distance;
+        }
+    }
+
+    if(stream == NULL) {
+        // Start a new stream in a free or the least recently trained slot
+        stream = &table[0];
+        for(int i = 0; i < PREFETCH_STREAMS; i++) {
+            if(!table[i].valid) {
+                stream = &table[i];
+                break;
+            }
+            if(table[i].last_used < stream->last_used) {
+                stream = &table[i];
+            }
+        }
+        stream->valid = true;
+        stream->stride = 0;
+        stream->confidence = 0;
+    } else if(stream->stride != 0 && page_number == stream->last_page + stream->stride) {
+        if(stream->confidence < PREFETCH_CONFIDENCE_MAX) {
+            stream->confidence++;
+        }
+    } else if(stream->confidence > 0) {
+        stream->confidence--;
+    } else {
+        stream->stride = page_number - stream->last_page;
+    }
+
+    stream->last_page = page_number;
+    stream->last_used = ++train_clock;
+    return stream;
+}
+
+// Feed one resolved access: faults and first touches of prefetched pages
+// train the active policy, which may issue prefetches
+void prefetch_observe(int pid, int page_number, bool fault) {
+    if(prefetch_policy == PREFETCH_NONE) {
+        return;
+    }
+
+    if(fault) {
+        prefetch_stats.demand_faults++;
+        PrefetchRequest* request = find_request(pid, page_number);
+        if(request != NULL) {
+            request->valid = false;
+            prefetch_stats.late++;
+        }
+        if(evicted_by_prefetch[pid][page_number]) {
+            evicted_by_prefetch[pid][page_number] = false;
+            prefetch_stats.pollution++;
+        }
+        prefetched[pid][page_number] = false;   // Evicted before it was used
+    } else if(prefetched[pid][page_number]) {
+        prefetched[pid][page_number] = false;
+        prefetch_stats.useful++;
+    } else {
+        return;
+    }
+
+    switch(prefetch_policy) {
+        case PREFETCH_NEXT_PAGE:
+            for(int k = 1; k <= prefetch_degree; k++) {
+                issue(pid, page_number + k);
+            }
+            break;
+        case PREFETCH_STRIDE: {
+            PrefetchStream* stream = train_stream(pid, page_number);
+            if(stream->stride != 0 && stream->confidence >= PREFETCH_CONFIDENCE_THRESHOLD) {
+                for(int k = 1; k <= prefetch_degree; k++) {
+                    issue(pid, page_number + k * stream->stride);
+                }
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+// Forget a terminated process's streams and pending prefetches
+void prefetch_release_process(int pid) {
+    memset(streams[pid], 0, sizeof(streams[pid]));
+    memset(prefetched[pid], 0, sizeof(prefetched[pid]));
+    memset(evicted_by_prefetch[pid], 0, sizeof(evicted_by_prefetch[pid]));
+    for(int i = 0; i < PREFETCH_QUEUE_SIZE; i++) {
+        if(queue[i].valid && queue[i].pid == pid) {
+            queue[i].valid = false;
+        }
+    }
+}
+
+// ==================== REPORTS ====================
+
+static double accuracy() {
+    return prefetch_stats.loaded ? prefetch_stats.useful * 100.0 / prefetch_stats.loaded : 0.0;
+}
+
+// Share of would-be faults that a prefetch removed
+static double coverage() {
+    unsigned long long would_fault = prefetch_stats.useful + prefetch_stats.demand_faults;
+    return would_fault ? prefetch_stats.useful * 100.0 / would_fault : 0.0;
+}
+
+// Prefetcher counters with accuracy, coverage and pollution
+void display_prefetch_stats() {
+    printf("\n==================== PREFETCHER ====================\n");
+    printf("Policy: %s, degree %d, latency %d references\n",
+           prefetch_policy_name(prefetch_policy), prefetch_degree, prefetch_latency);
+    printf("Issued: %llu, loaded: %llu, dropped: %llu\n",
+           prefetch_stats.issued, prefetch_stats.loaded, prefetch_stats.dropped);
+    printf("Useful: %llu (%.1f%% accuracy), late: %llu\n",
+           prefetch_stats.useful, accuracy(), prefetch_stats.late);
+    printf("Demand faults: %llu, coverage: %.1f%%\n", prefetch_stats.demand_faults, coverage());
+    printf("Pollution: %llu faults on pages a prefetch evicted\n", prefetch_stats.pollution);
+    printf("====================================================\n");
+}
+
+// Fill refs with one process's page stream for a workload
+static void build_stream(int workload, int* pages, bool* writes, int refs, uint64_t seed) {
+    if(workload == 0) {
+        // The generator the algorithm menus use
+        workload_set_seed(seed);
+        int* generated = generate_reference_string(refs);
+        for(int i = 0; i < refs; i++) {
+            pages[i] = generated ? generated[i] : 0;
+            writes[i] = (i % 4) == 0;
+        }
+        free(generated);
+        return;
+    }
+
+    static const PatternType patterns[] = {PATTERN_LOCALITY, PATTERN_SCAN, PATTERN_STRIDE, PATTERN_UNIFORM};
+    Workload generator;
+    MemoryReference* batch = (MemoryReference*)malloc(refs * sizeof(MemoryReference));
+    WorkloadPattern pattern = workload_pattern(patterns[workload], 0, MAX_PAGES);
+
+    workload_init(&generator, seed);
+    workload_add_process(&generator, 0, 1);
+    workload_add_phase(&generator, 0, &pattern);
+    if(batch == NULL || workload_generate(&generator, batch, refs) < 0) {
+        memset(pages, 0, refs * sizeof(int));
+        memset(writes, 0, refs * sizeof(bool));
+    } else {
+        for(int i = 0; i < refs; i++) {
+            pages[i] = (int)(batch[i].address / PAGE_SIZE % MAX_PAGES);
+            writes[i] = batch[i].is_write;
+        }
+    }
+    workload_free(&generator);
+    free(batch);
+}
+
+// Each prefetch policy over the menus' locality string and generated
+// scan, stride and uniform streams
+void run_prefetch_simulation(int refs, uint64_t seed) {
+    static const char* workloads[] = {"Locality", "Scan", "Stride", "Uniform"};
+    PrefetchPolicy saved_policy = prefetch_policy;
+
+    if(refs <= 0) {
+        printf("Error: Reference count must be positive\n");
+        return;
+    }
+
+    int* pages = (int*)malloc(refs * sizeof(int));
+    bool* writes = (bool*)malloc(refs * sizeof(bool));
+    if(pages == NULL || writes == NULL) {
+        printf("Error: Memory allocation failed\n");
+        free(pages);
+        free(writes);
+        return;
+    }
+
+    verbose_mode = 0;
+
+    printf("\n========================== FAULT-PATH PREFETCHING ==========================\n");
+    printf("One process, %d references over %d pages, %d frames; degree %d, latency %d\n",
+           refs, MAX_PAGES, MAX_FRAMES, prefetch_degree, prefetch_latency);
+    printf("\nWorkload  Prefetcher  Faults  Loaded  Useful  Late  Accuracy  Coverage  Pollution\n");
+    printf("--------  ----------  ------  ------  ------  ----  --------  --------  ---------\n");
+
+    for(int w = 0; w < 4; w++) {
+        build_stream(w, pages, writes, refs, seed);
+        for(int policy = 0; policy < PREFETCH_POLICY_COUNT; policy++) {
+            prefetch_policy = (PrefetchPolicy)policy;
+            init_memory_system();
+            int pid = create_process("stream");
+            for(int i = 0; i < refs; i++) {
+                access_memory_ex(pid, pages[i] * PAGE_SIZE, writes[i]);
+            }
+
+            printf("%-8s  %-10s  %6d  %6llu  %6llu  %4llu  %7.1f%%  %7.1f%%  %9llu\n",
+                   workloads[w], prefetch_policy_name(prefetch_policy), stats.total_page_faults,
+                   prefetch_stats.loaded, prefetch_stats.useful, prefetch_stats.late,
+                   accuracy(), coverage(), prefetch_stats.pollution);
+        }
+    }
+
+    printf("\nCoverage: share of would-be faults removed. Accuracy: share of loaded\n");
+    printf("pages used. Pollution: faults on pages a prefetch pushed out\n");
+    printf("============================================================================\n");
+
+    free(pages);
+    free(writes);
+    prefetch_policy = saved_policy;
+}
@@ -0,0 +1,61 @@
+/**
+ * prefetch.h
+ * Page-fault prefetcher module header
+ */
+
+#ifndef PREFETCH_H
+#define PREFETCH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../../include/common_defs.h"
+
+typedef enum {
+    PREFETCH_NONE,
+    PREFETCH_NEXT_PAGE,     // Always the pages after the faulting one
+    PREFETCH_STRIDE,        // Per-process stream table with confidence counters
+    PREFETCH_POLICY_COUNT
+} PrefetchPolicy;
+
+#define PREFETCH_STREAMS 4              // Streams tracked per process
+#define PREFETCH_MAX_STRIDE 4           // Larger jumps start a new stream
+#define PREFETCH_CONFIDENCE_MAX 3
+#define PREFETCH_CONFIDENCE_THRESHOLD 1 // Stride seen twice in a row
+#define PREFETCH_QUEUE_SIZE 8
+#define PREFETCH_DEFAULT_DEGREE 2       // Pages issued per trigger
+#define PREFETCH_DEFAULT_LATENCY 2      // References before a prefetch completes
+
+// One detected fault stream
+typedef struct {
+    bool valid;
+    int last_page;
+    int stride;
+    int confidence;
+    unsigned long long last_used;       // Least recently trained is replaced first
+} PrefetchStream;
+
+typedef struct {
+    unsigned long long issued;
+    unsigned long long loaded;          // Completed and brought into memory
+    unsigned long long useful;          // Loaded pages referenced afterwards
+    unsigned long long late;            // Demand faults on pages still in flight
+    unsigned long long dropped;         // Queue full, already resident, unmapped or process gone
+    unsigned long long pollution;       // Demand faults on pages a prefetch evicted
+    unsigned long long demand_faults;
+} PrefetchStats;
+
+extern PrefetchPolicy prefetch_policy;
+extern int prefetch_degree;
+extern int prefetch_latency;
+extern PrefetchStats prefetch_stats;
+
+// Function Prototypes
+void reset_prefetch();
+const char* prefetch_policy_name(PrefetchPolicy policy);
+void prefetch_tick();
+void prefetch_observe(int pid, int page_number, bool fault);
+void prefetch_release_process(int pid);
+void display_prefetch_stats();
+void run_prefetch_simulation(int refs, uint64_t seed);
+
+#endif // PREFETCH_H
@@ -0,0 +1,325 @@
+/**
+ * scheduler.c
+ * Multi-process interleaved execution scheduler implementation
+ *
+ * Each process contributes its own reference stream. The scheduler
+ * interleaves the streams on the shared frames according to the chosen
+ * policy and charges a cycle cost for every reference (TLB hit, page walk
+ * or page fault) and for every context switch, including the TLB refill
+ * penalty when switches flush the TLB instead of retaining ASID-tagged
+ * entries.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "scheduler.h"
+#include "../../include/common_defs.h"
+#include "memory_manager.h"
+#include "paging.h"
+#include "tlb.h"
+#include "load_control.h"
+
+// Stride scheduling constant: pass advance per slice is STRIDE_BASE / weight
+#define STRIDE_BASE 10000
+
+SchedulerStats scheduler_stats;
+
+static ReferenceStream streams[MAX_PROCESSES];
+static int stream_count = 0;
+
+// Default configuration: round robin, ASID-tagged TLB
+SchedulerConfig scheduler_default_config() {
+    SchedulerConfig config;
+    config.policy = SCHED_ROUND_ROBIN;
+    config.quantum = 4;
+    config.tlb_mode = TLB_ASID_RETAIN;
+    config.context_switch_cost = 500;
+    config.tlb_hit_cost = 1;
+    config.page_walk_cost = 30;
+    config.page_fault_cost = 10000;
+    return config;
+}
+
+// Name of a scheduling policy
+const char* scheduling_policy_name(SchedulingPolicy policy) {
+    switch(policy) {
+        case SCHED_ROUND_ROBIN:   return "Round robin";
+        case SCHED_WEIGHTED_FAIR: return "Weighted fair";
+        case SCHED_TIMESTAMP:     return "Timestamp";
+        default:                  return "Unknown";
+    }
+}
+
+// Remove all streams and clear the counters
+void scheduler_reset() {
+    stream_count = 0;
+    memset(&scheduler_stats, 0, sizeof(scheduler_stats));
+}
+
+// Register a process's reference stream (the stream is not copied)
+int scheduler_add_stream(int pid, const MemoryReference* refs, int count, int weight) {
+    if(pid < 0 || pid >= MAX_PROCESSES || processes[pid].pid == -1) {
+        printf("Error: Invalid process ID %d\n", pid);
+        return -1;
+    }
+
+    if(stream_count >= MAX_PROCESSES || refs == NULL || count <= 0) {
+        printf("Error: Cannot add reference stream for process %d\n", pid);
+        return -1;
+    }
+
+    ReferenceStream* stream = &streams[stream_count];
+    stream->pid = pid;
+    stream->refs = refs;
+    stream->count = count;
+    stream->position = 0;
+    stream->weight = weight > 0 ? weight : 1;
+    stream->pass = 0;
+    stream->slices = 0;
+    stream->faults = 0;
+    stream->tlb_misses = 0;
+    stream->cycles = 0;
+
+    return stream_count++;
+}
+
+// Stream still has references and its process may run
+static int stream_ready(int index) {
+    ReferenceStream* stream = &streams[index];
+    return stream->position < stream->count && is_process_runnable(stream->pid);
+}
+
+// Choose the stream to dispatch next, -1 when every stream is exhausted
+static int pick_next_stream(const SchedulerConfig* config, int current) {
+    int chosen = -1;
+
+    for(int n = 0; n < stream_count; n++) {
+        int index = (config->policy == SCHED_ROUND_ROBIN) ?
+                    (current + 1 + n) % stream_count : n;
+        if(!stream_ready(index)) {
+            continue;
+        }
+
+        if(chosen == -1) {
+            chosen = index;
+            if(config->policy == SCHED_ROUND_ROBIN) {
+                break;
+            }
+            continue;
+        }
+
+        if(config->policy == SCHED_WEIGHTED_FAIR &&
+           streams[index].pass < streams[chosen].pass) {
+            chosen = index;
+        } else if(config->policy == SCHED_TIMESTAMP &&
+                  streams[index].refs[streams[index].position].timestamp <
+                  streams[chosen].refs[streams[chosen].position].timestamp) {
+            chosen = index;
+        }
+    }
+
+    if(chosen != -1) {
+        return chosen;
+    }
+
+    // Only suspended processes have work left: load control must let one in
+    for(int index = 0; index < stream_count; index++) {
+        if(streams[index].position < streams[index].count) {
+            resume_process(streams[index].pid);
+            return index;
+        }
+    }
+
+    return -1;
+}
+
+// Issue one reference and charge its cost
+static void issue_reference(ReferenceStream* stream, const SchedulerConfig* config) {
+    const MemoryReference* ref = &stream->refs[stream->position++];
+    int misses_before = tlb_stats.misses;
+    int faults_before = processes[stream->pid].page_faults;
+
+    access_memory_ex(stream->pid, fold_virtual_address(ref->address), ref->is_write);
+
+    long long cost;
+    if(processes[stream->pid].page_faults != faults_before) {
+        cost = config->page_fault_cost;
+        stream->faults++;
+        scheduler_stats.faults++;
+    } else if(tlb_stats.misses != misses_before) {
+        cost = config->page_walk_cost;
+    } else {
+        cost = config->tlb_hit_cost;
+        scheduler_stats.tlb_hits++;
+    }
+
+    if(tlb_stats.misses != misses_before) {
+        stream->tlb_misses++;
+        scheduler_stats.tlb_misses++;
+    }
+
+    stream->cycles += cost;
+    scheduler_stats.total_cycles += cost;
+    scheduler_stats.references++;
+}
+
+// Interleave all registered streams until they are exhausted
+void scheduler_run(const SchedulerConfig* config) {
+    int current = -1;
+    int running_pid = -1;
+
+    memset(&scheduler_stats, 0, sizeof(scheduler_stats));
+
+    while(1) {
+        int next = pick_next_stream(config, current);
+        if(next == -1) {
+            break;
+        }
+
+        ReferenceStream* stream = &streams[next];
+
+        // Switching address spaces costs cycles and, without ASIDs,
+        // the whole TLB
+        if(running_pid != -1 && stream->pid != running_pid) {
+            scheduler_stats.context_switches++;
+            scheduler_stats.switch_cycles += config->context_switch_cost;
+            scheduler_stats.total_cycles += config->context_switch_cost;
+            if(config->tlb_mode == TLB_FLUSH_ON_SWITCH) {
+                tlb_flush_all();
+            }
+            VPRINTF("\n--- Context switch: Process %d -> Process %d ---\n",
+                    running_pid, stream->pid);
+        }
+        running_pid = stream->pid;
+        current = next;
+
+        // Timestamp order is decided reference by reference
+        int slice = (config->policy == SCHED_TIMESTAMP) ? 1 : config->quantum;
+        for(int i = 0; i < slice && stream->position < stream->count; i++) {
+            issue_reference(stream, config);
+            if(processes[stream->pid].suspended) {
+                break;
+            }
+        }
+
+        stream->slices++;
+        stream->pass += STRIDE_BASE / stream->weight;
+    }
+}
+
+// Display per-process and total accounting of the last run
+void display_scheduler_report(const SchedulerConfig* config) {
+    printf("\n================= SCHEDULER REPORT =================\n");
+    printf("Policy: %s, Quantum: %d refs, TLB on switch: %s\n",
+           scheduling_policy_name(config->policy), config->quantum,
+           config->tlb_mode == TLB_FLUSH_ON_SWITCH ? "flush" : "retain (ASID)");
+    printf("Costs: TLB hit %d, page walk %d, fault %d, switch %d cycles\n",
+           config->tlb_hit_cost, config->page_walk_cost,
+           config->page_fault_cost, config->context_switch_cost);
+
+    printf("\nPID  Name          Weight   Refs  Slices  TLB Miss  Faults      Cycles\n");
+    printf("---  ------------  ------  -----  ------  --------  ------  ----------\n");
+    for(int i = 0; i < stream_count; i++) {
+        ReferenceStream* stream = &streams[i];
+        printf("%3d  %-12s  %6d  %5d  %6d  %8d  %6d  %10lld\n",
+               stream->pid, processes[stream->pid].name, stream->weight,
+               stream->position, stream->slices, stream->tlb_misses,
+               stream->faults, stream->cycles);
+    }
+
+    int lookups = scheduler_stats.tlb_hits + scheduler_stats.tlb_misses;
+    printf("\nReferences: %d, Context switches: %d (%lld cycles)\n",
+           scheduler_stats.references, scheduler_stats.context_switches,
+           scheduler_stats.switch_cycles);
+    printf("TLB hit ratio: %.2f%%, Page faults: %d\n",
+           lookups > 0 ? (scheduler_stats.tlb_hits * 100.0) / lookups : 0.0,
+           scheduler_stats.faults);
+    printf("Total cycles: %lld (%.1f cycles/reference)\n",
+           scheduler_stats.total_cycles,
+           scheduler_stats.references > 0 ?
+           (double)scheduler_stats.total_cycles / scheduler_stats.references : 0.0);
+    printf("====================================================\n");
+}
+
+// ==================== POLICY COMPARISON ====================
+
+#define SCHED_DEMO_PROCESSES 3
+
+// Run every policy under both TLB modes over the same streams
+void run_scheduler_comparison(int refs_per_process) {
+    MemoryReference* refs[SCHED_DEMO_PROCESSES];
+    int saved_verbose = verbose_mode;
+
+    if(refs_per_process <= 0) {
+        printf("Error: Reference count must be positive\n");
+        return;
+    }
+
+    // Per-process streams with locality; timestamps advance at
+    // different rates so timestamp ordering interleaves unevenly
+    for(int p = 0; p < SCHED_DEMO_PROCESSES; p++) {
+        int* pages = generate_reference_string(refs_per_process);
+        refs[p] = (MemoryReference*)malloc(refs_per_process * sizeof(MemoryReference));
+        if(pages == NULL || refs[p] == NULL) {
+            printf("Error: Memory allocation failed\n");
+            free(pages);
+            for(int q = 0; q <= p; q++) {
+                free(refs[q]);
+            }
+            return;
+        }
+        for(int i = 0; i < refs_per_process; i++) {
+            refs[p][i].address = (unsigned long long)pages[i] * PAGE_SIZE;
+            refs[p][i].timestamp = (unsigned long long)i * (p + 1) * 10 + p;
+            refs[p][i].pid = p;
+            refs[p][i].is_write = (i % 4) == 0;
+        }
+        free(pages);
+    }
+
+    printf("\n============ SCHEDULER POLICY COMPARISON ============\n");
+    printf("%d processes x %d references, %d frames, %d TLB entries\n\n",
+           SCHED_DEMO_PROCESSES, refs_per_process, MAX_FRAMES, TLB_SIZE);
+    printf("Policy          TLB mode  Switches  TLB Hit%%  Faults       Cycles  Cyc/Ref\n");
+    printf("--------------  --------  --------  --------  ------  -----------  -------\n");
+
+    SchedulingPolicy policies[] = {SCHED_ROUND_ROBIN, SCHED_WEIGHTED_FAIR, SCHED_TIMESTAMP};
+    TLBSwitchMode modes[] = {TLB_FLUSH_ON_SWITCH, TLB_ASID_RETAIN};
+
+    verbose_mode = 0;
+    for(int p = 0; p < 3; p++) {
+        for(int m = 0; m < 2; m++) {
+            SchedulerConfig config = scheduler_default_config();
+            config.policy = policies[p];
+            config.tlb_mode = modes[m];
+
+            init_memory_system();
+            scheduler_reset();
+            for(int i = 0; i < SCHED_DEMO_PROCESSES; i++) {
+                char name[50];
+                snprintf(name, sizeof(name), "Tenant %d", i + 1);
+                int pid = create_process(name);
+                scheduler_add_stream(pid, refs[i], refs_per_process, i + 1);
+            }
+            scheduler_run(&config);
+
+            int lookups = scheduler_stats.tlb_hits + scheduler_stats.tlb_misses;
+            printf("%-14s  %-8s  %8d  %7.2f%%  %6d  %11lld  %7.1f\n",
+                   scheduling_policy_name(config.policy),
+                   config.tlb_mode == TLB_FLUSH_ON_SWITCH ? "flush" : "ASID",
+                   scheduler_stats.context_switches,
+                   lookups > 0 ? (scheduler_stats.tlb_hits * 100.0) / lookups : 0.0,
+                   scheduler_stats.faults,
+                   scheduler_stats.total_cycles,
+                   (double)scheduler_stats.total_cycles / scheduler_stats.references);
+        }
+    }
+    verbose_mode = saved_verbose;
+
+    printf("=====================================================\n");
+
+    for(int p = 0; p < SCHED_DEMO_PROCESSES; p++) {
+        free(refs[p]);
+    }
+}
@@ -0,0 +1,71 @@
+/**
+ * scheduler.h
+ * Multi-process interleaved execution scheduler module header
+ */
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include "../../include/common_defs.h"
+
+// How the next process to run is chosen
+typedef enum {
+    SCHED_ROUND_ROBIN,    // Fixed quantum, processes in turn
+    SCHED_WEIGHTED_FAIR,  // Stride scheduling, slices proportional to weight
+    SCHED_TIMESTAMP       // Merge streams by trace timestamp
+} SchedulingPolicy;
+
+// What a context switch does to the TLB
+typedef enum {
+    TLB_FLUSH_ON_SWITCH,  // No ASIDs: every switch empties the TLB
+    TLB_ASID_RETAIN       // Entries are tagged and survive switches
+} TLBSwitchMode;
+
+// Scheduler configuration and cost model (cycles)
+typedef struct {
+    SchedulingPolicy policy;
+    int quantum;              // References per slice
+    TLBSwitchMode tlb_mode;
+    int context_switch_cost;  // Register save/restore, kernel entry
+    int tlb_hit_cost;
+    int page_walk_cost;       // TLB miss on a resident page
+    int page_fault_cost;
+} SchedulerConfig;
+
+// One process's reference stream and its accounting
+typedef struct {
+    int pid;
+    const MemoryReference* refs;
+    int count;
+    int position;
+    int weight;
+    long long pass;           // Stride scheduling virtual time
+    int slices;
+    int faults;
+    int tlb_misses;
+    long long cycles;
+} ReferenceStream;
+
+// Whole-run totals
+typedef struct {
+    int references;
+    int context_switches;
+    long long switch_cycles;
+    long long total_cycles;
+    int tlb_hits;
+    int tlb_misses;
+    int faults;
+} SchedulerStats;
+
+extern SchedulerStats scheduler_stats;
+
+// Function Prototypes
+SchedulerConfig scheduler_default_config();
+void scheduler_reset();
+int scheduler_add_stream(int pid, const MemoryReference* refs, int count, int weight);
+void scheduler_run(const SchedulerConfig* config);
+void display_scheduler_report(const SchedulerConfig* config);
+void run_scheduler_comparison(int refs_per_process);
+const char* scheduling_policy_name(SchedulingPolicy policy);
+
+#endif // SCHEDULER_H
@@ -8,6 +8,23 @@
 #include "segmentation.h"
 #include "../../include/common_defs.h"
 #include "memory_manager.h"
+#include "../allocators/segment_alloc.h"
+
+// Placement of every process's segments in the physical range
+static SegmentAllocator segment_space;
+
+static SegmentAllocator* placement_engine(void) {
+    if(segment_space.space == 0) {
+        segment_alloc_init(&segment_space, SEGMENT_SPACE, FIT_FIRST);
+    }
+    return &segment_space;
+}
+
+// Forget every placed segment
+void reset_segment_space(void) {
+    segment_alloc_destroy(&segment_space);
+    segment_alloc_init(&segment_space, SEGMENT_SPACE, FIT_FIRST);
+}
 
 // Initialize segmentation system
 void init_segmentation_system(int total_segments) {
@@ -15,6 +32,8 @@ void init_segmentation_system(int total_segments) {
     printf("==================================\n");
     printf("Total segments: %d\n", total_segments);
     printf("Segment size: %d bytes\n", SEGMENT_SIZE);
+    printf("Physical space: %d bytes, %d used\n",
+           SEGMENT_SPACE, SEGMENT_SPACE - (int)placement_engine()->free_bytes);
     printf("✓ Segmentation system ready\n");
 }
 
@@ -80,31 +99,75 @@ void display_segment_table(int pid) {
     }
 }
 
-// Create a segment
-void create_segment(int pid, int segment_id, int base, int limit) {
+// Create a segment; base -1 lets the placement engine choose, returns the base or -1
+int create_segment(int pid, int segment_id, int base, int limit) {
     if(pid < 0 || pid >= MAX_PROCESSES || processes[pid].pid == -1) {
         printf("Error: Invalid process ID %d\n", pid);
-        return;
+        return -1;
     }
     
     if(segment_id < 0 || segment_id >= MAX_SEGMENTS) {
         printf("Error: Invalid segment ID %d\n", segment_id);
-        return;
+        return -1;
     }
     
     if(limit <= 0 || limit > SEGMENT_SIZE) {
         printf("Error: Limit must be between 1 and %d\n", SEGMENT_SIZE);
-        return;
+        return -1;
     }
     
-    processes[pid].segment_table[segment_id].segment_id = segment_id;
-    processes[pid].segment_table[segment_id].base_address = base;
-    processes[pid].segment_table[segment_id].limit = limit;
-    processes[pid].segment_table[segment_id].valid = true;
-    processes[pid].segment_table[segment_id].protection = 7;  // RWX
+    if(base < -1 || base >= SEGMENT_SPACE) {
+        printf("Error: Base must be between 0 and %d\n", SEGMENT_SPACE - 1);
+        return -1;
+    }
+    
+    SegmentAllocator* engine = placement_engine();
+    SegmentTableEntry* segment = &processes[pid].segment_table[segment_id];
+    uint64_t owner = SEGMENT_OWNER(pid, segment_id);
     
-    printf("✓ Segment %d created for Process %d\n", segment_id, pid);
-    printf("  Base: %d, Limit: %d\n", base, limit);
+    // Recreating a segment gives up its old extent, restored if the new one fails
+    if(segment->valid) {
+        segment_alloc_release(engine, (uint64_t)segment->base_address);
+    }
+    
+    int placed;
+    if(base == -1) {
+        int64_t chosen = segment_alloc_place(engine, owner, (uint64_t)limit);
+        placed = (int)chosen;
+        if(chosen == -1) {
+            printf("Error: No free extent of %d bytes for segment %d\n", limit, segment_id);
+        }
+    } else {
+        uint64_t other;
+        placed = base;
+        if(segment_alloc_overlap(engine, (uint64_t)base, (uint64_t)limit, &other)) {
+            printf("Error: Segment at %d..%d overlaps Process %d segment %d\n",
+                   base, base + limit - 1, SEGMENT_OWNER_PID(other), SEGMENT_OWNER_ID(other));
+            placed = -1;
+        } else if(segment_alloc_reserve(engine, owner, (uint64_t)base, (uint64_t)limit) != 0) {
+            printf("Error: Segment at %d..%d runs past the physical space\n",
+                   base, base + limit - 1);
+            placed = -1;
+        }
+    }
+    
+    if(placed == -1) {
+        if(segment->valid) {
+            segment_alloc_reserve(engine, owner, (uint64_t)segment->base_address,
+                                  (uint64_t)segment->limit);
+        }
+        return -1;
+    }
+    
+    segment->segment_id = segment_id;
+    segment->base_address = placed;
+    segment->limit = limit;
+    segment->valid = true;
+    segment->protection = 7;  // RWX
+    
+    VPRINTF("✓ Segment %d created for Process %d\n", segment_id, pid);
+    VPRINTF("  Base: %d, Limit: %d\n", placed, limit);
+    return placed;
 }
 
 // Delete a segment
@@ -114,6 +177,77 @@ void delete_segment(int pid, int segment_id) {
         return;
     }
     
-    processes[pid].segment_table[segment_id].valid = false;
-    printf("Segment %d deleted from Process %d\n", segment_id, pid);
+    if(segment_id < 0 || segment_id >= MAX_SEGMENTS) {
+        printf("Error: Invalid segment ID %d\n", segment_id);
+        return;
+    }
+    
+    SegmentTableEntry* segment = &processes[pid].segment_table[segment_id];
+    if(segment->valid) {
+        segment_alloc_release(placement_engine(), (uint64_t)segment->base_address);
+    }
+    segment->valid = false;
+    VPRINTF("Segment %d deleted from Process %d\n", segment_id, pid);
+}
+
+// Move a segment to a new base; the old extent is kept if the new one is taken
+int migrate_segment(int pid, int segment_id, int new_base) {
+    if(pid < 0 || pid >= MAX_PROCESSES || segment_id < 0 || segment_id >= MAX_SEGMENTS ||
+       !processes[pid].segment_table[segment_id].valid) {
+        return -1;
+    }
+    
+    SegmentAllocator* engine = placement_engine();
+    SegmentTableEntry* segment = &processes[pid].segment_table[segment_id];
+    uint64_t owner = SEGMENT_OWNER(pid, segment_id);
+    
+    // The new extent may overlap the old one when sliding down
+    segment_alloc_release(engine, (uint64_t)segment->base_address);
+    if(new_base < 0 ||
+       segment_alloc_reserve(engine, owner, (uint64_t)new_base, (uint64_t)segment->limit) != 0) {
+        segment_alloc_reserve(engine, owner, (uint64_t)segment->base_address,
+                              (uint64_t)segment->limit);
+        return -1;
+    }
+    
+    VPRINTF("Segment %d of Process %d migrated: Base %d -> %d\n",
+            segment_id, pid, segment->base_address, new_base);
+    segment->base_address = new_base;
+    return 0;
+}
+
+// Share of free segment space outside the largest free extent
+double segment_space_fragmentation(void) {
+    SegmentAllocator* engine = placement_engine();
+    if(engine->free_bytes == 0) {
+        return 0.0;
+    }
+    return 1.0 - (double)segment_alloc_largest_free(engine) / engine->free_bytes;
+}
+
+// Delete every segment of a process
+void release_process_segments(int pid) {
+    for(int i = 0; i < MAX_SEGMENTS; i++) {
+        if(processes[pid].segment_table[i].valid) {
+            delete_segment(pid, i);
+        }
+    }
+}
+
+// Find which segment a physical address belongs to
+void reverse_translate_address(int physical) {
+    uint64_t owner, base;
+    
+    printf("\nReverse Translation (Segmentation):\n");
+    printf("-----------------------------------\n");
+    printf("Physical Address: %d\n", physical);
+    
+    if(physical < 0 || !segment_alloc_lookup(placement_engine(), (uint64_t)physical, &owner, &base)) {
+        printf("✗ No segment covers physical address %d\n", physical);
+        return;
+    }
+    
+    printf("✓ Process %d, Segment %d\n", SEGMENT_OWNER_PID(owner), SEGMENT_OWNER_ID(owner));
+    printf("Base Address: %d\n", (int)base);
+    printf("Offset: %d\n", physical - (int)base);
 }
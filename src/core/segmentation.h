@@ -8,11 +8,19 @@
 
 #include "../../include/common_defs.h"
 
+// Physical range segments are placed in: every segment of every process at full size
+#define SEGMENT_SPACE (MAX_PROCESSES * MAX_SEGMENTS * SEGMENT_SIZE)
+
 // Function Prototypes
 void init_segmentation_system(int total_segments);
 void translate_segmented_address(int pid, int segment_num, int offset);
 void display_segment_table(int pid);
-void create_segment(int pid, int segment_id, int base, int limit);
+int create_segment(int pid, int segment_id, int base, int limit);
 void delete_segment(int pid, int segment_id);
+void release_process_segments(int pid);
+int migrate_segment(int pid, int segment_id, int new_base);
+double segment_space_fragmentation(void);
+void reverse_translate_address(int physical);
+void reset_segment_space(void);
 
 #endif // SEGMENTATION_H
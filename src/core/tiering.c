@@ -0,0 +1,479 @@
+/**
+ * tiering.c
+ * Memory tiers with hotness-based promotion and demotion
+ *
+ * Physical frames are split into tiers, fastest first: DRAM, then
+ * slower capacity such as CXL-attached or persistent memory. New pages
+ * go to the fastest tier with a free frame. Every scan interval the
+ * access bits of all frames are sampled into a decaying hotness count.
+ * With the access-bit policy the scan promotes slow-tier pages that
+ * stayed hot; with the fault-hint policy every few scans arm the
+ * slow-tier pages instead, and the next access to one takes a hinting
+ * fault that promotes it if it was also used in the interval before, as
+ * NUMA balancing and TPP do. Either way the scan then demotes a cold DRAM
+ * page when the tier has no free frame left, so new pages and
+ * promotions find room. Migrations per interval are capped to model
+ * the bandwidth spent copying pages between tiers.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "tiering.h"
+#include "memory_manager.h"
+#include "latency.h"
+#include "../trace/workload.h"
+
+// Sampling state of one frame
+typedef struct {
+    int hotness;
+    bool accessed;      // Access bit since the last scan
+    bool hint_armed;    // The next access takes a hinting fault
+} TierFrame;
+
+MemoryTier memory_tiers[MAX_TIERS] = {
+    { "DRAM", 0, MAX_FRAMES, TIER_DRAM_LATENCY_NS }
+};
+int tier_count = 1;
+TieringPolicy tiering_policy = TIERING_NONE;
+int tier_scan_interval = TIER_DEFAULT_SCAN_INTERVAL;
+int tier_migration_bandwidth = TIER_DEFAULT_BANDWIDTH;
+int tier_hot_threshold = TIER_DEFAULT_HOT_THRESHOLD;
+TieringStats tiering_stats;
+
+static TierFrame tier_frames[MAX_FRAMES];
+static unsigned long long next_scan;
+static int budget;      // Migrations left in this interval
+
+static const char* policy_names[TIERING_POLICY_COUNT] = {
+    "None", "Access bit", "Fault hint"
+};
+
+// Clear the sampling state and the counters; the tier layout and policy are kept
+void reset_tiering() {
+    memset(tier_frames, 0, sizeof(tier_frames));
+    memset(&tiering_stats, 0, sizeof(tiering_stats));
+    next_scan = 0;
+    budget = 0;
+}
+
+// Split the frames into tiers, fastest first; returns 0 or -1
+int tiering_configure(int count, const char* const* names, const int* frames,
+                      const int* latency_ns) {
+    if(count < 1 || count > MAX_TIERS) {
+        printf("Error: Between 1 and %d tiers are supported\n", MAX_TIERS);
+        return -1;
+    }
+
+    int total = 0;
+    for(int t = 0; t < count; t++) {
+        if(frames[t] < 1 || latency_ns[t] < 1 || (t > 0 && latency_ns[t] < latency_ns[t - 1])) {
+            printf("Error: Tier %d needs frames and a latency no lower than the tier above\n", t);
+            return -1;
+        }
+        total += frames[t];
+    }
+    if(total != MAX_FRAMES) {
+        printf("Error: Tiers hold %d frames, memory has %d\n", total, MAX_FRAMES);
+        return -1;
+    }
+
+    int first = 0;
+    for(int t = 0; t < count; t++) {
+        snprintf(memory_tiers[t].name, sizeof(memory_tiers[t].name), "%s", names[t]);
+        memory_tiers[t].first_frame = first;
+        memory_tiers[t].frames = frames[t];
+        memory_tiers[t].latency_ns = latency_ns[t];
+        first += frames[t];
+    }
+    tier_count = count;
+    return 0;
+}
+
+// Display name of a policy
+const char* tiering_policy_name(TieringPolicy policy) {
+    return (policy >= 0 && policy < TIERING_POLICY_COUNT) ? policy_names[policy] : "Unknown";
+}
+
+// Tier holding a frame
+int frame_tier(int frame_id) {
+    for(int t = 0; t < tier_count - 1; t++) {
+        if(frame_id < memory_tiers[t].first_frame + memory_tiers[t].frames) {
+            return t;
+        }
+    }
+    return tier_count - 1;
+}
+
+// Free frame in a tier, or in the fastest tier that has one when tier is -1
+int tier_find_free_frame(int tier) {
+    int first = tier == -1 ? 0 : tier;
+    int last = tier == -1 ? tier_count - 1 : tier;
+
+    for(int t = first; t <= last; t++) {
+        for(int i = 0; i < memory_tiers[t].frames; i++) {
+            int frame_id = memory_tiers[t].first_frame + i;
+            if(physical_memory[frame_id].is_free) {
+                return frame_id;
+            }
+        }
+    }
+    return -1;
+}
+
+// ==================== MIGRATION ====================
+
+static bool movable(int frame_id) {
+    return !physical_memory[frame_id].is_free && !is_frame_reserved(frame_id);
+}
+
+// Coldest movable page of a tier below a hotness, -1 if none
+static int coldest_frame(int tier, int below) {
+    int victim = -1;
+    for(int i = 0; i < memory_tiers[tier].frames; i++) {
+        int frame_id = memory_tiers[tier].first_frame + i;
+        if(!movable(frame_id) || tier_frames[frame_id].accessed ||
+           tier_frames[frame_id].hotness >= below) {
+            continue;
+        }
+        if(victim == -1 || tier_frames[frame_id].hotness < tier_frames[victim].hotness) {
+            victim = frame_id;
+        }
+    }
+    return victim;
+}
+
+// Move a page to the next slower tier with a free frame
+static bool demote(int frame_id) {
+    int target = -1;
+    for(int t = frame_tier(frame_id) + 1; t < tier_count && target == -1; t++) {
+        target = tier_find_free_frame(t);
+    }
+    if(target == -1) {
+        return false;
+    }
+    if(budget < 1) {
+        tiering_stats.throttled++;
+        return false;
+    }
+    if(migrate_page(frame_id, target) != 0) {
+        return false;
+    }
+
+    budget--;
+    tiering_stats.demotions++;
+    VPRINTF("  ↓ DEMOTED: Frame %d (%s) -> Frame %d (%s)\n", frame_id,
+            memory_tiers[frame_tier(frame_id)].name, target, memory_tiers[frame_tier(target)].name);
+    return true;
+}
+
+// Move a page to the fastest tier, demoting a colder page there if it is full
+static bool promote(int frame_id) {
+    int target = tier_find_free_frame(0);
+    if(target == -1) {
+        int victim = coldest_frame(0, tier_frames[frame_id].hotness);
+        if(victim == -1) {
+            return false;
+        }
+        if(budget < 2) {
+            tiering_stats.throttled++;
+            return false;
+        }
+        if(!demote(victim)) {
+            return false;
+        }
+        target = victim;
+    }
+    if(budget < 1) {
+        tiering_stats.throttled++;
+        return false;
+    }
+    if(migrate_page(frame_id, target) != 0) {
+        return false;
+    }
+
+    budget--;
+    tiering_stats.promotions++;
+    VPRINTF("  ↑ PROMOTED: Frame %d (%s) -> Frame %d (%s)\n", frame_id,
+            memory_tiers[frame_tier(frame_id)].name, target, memory_tiers[0].name);
+    return true;
+}
+
+// ==================== SAMPLING ====================
+
+// Sample access bits once per interval and migrate what the policy asks for
+void tiering_tick() {
+    if((unsigned long long)stats.total_references < next_scan) {
+        return;
+    }
+    next_scan = stats.total_references + (tier_scan_interval > 0 ? tier_scan_interval : 1);
+    budget = tier_migration_bandwidth;
+    tiering_stats.scans++;
+
+    // Hotness halves every interval; an access since the last scan adds to it
+    for(int f = 0; f < MAX_FRAMES; f++) {
+        TierFrame* state = &tier_frames[f];
+        state->hotness = (state->hotness >> 1) + (state->accessed ? TIER_HOT_WEIGHT : 0);
+        state->accessed = false;
+    }
+    if(tier_count < 2 || tiering_policy == TIERING_NONE) {
+        return;
+    }
+
+    for(int f = memory_tiers[1].first_frame; f < MAX_FRAMES; f++) {
+        if(!movable(f)) {
+            continue;
+        }
+        if(tiering_policy == TIERING_FAULT_HINT && tiering_stats.scans % TIER_HINT_SCAN_PERIOD == 0) {
+            tier_frames[f].hint_armed = true;
+        }
+    }
+
+    // Hottest slow-tier pages first
+    while(tiering_policy == TIERING_ACCESS_BIT && budget > 0) {
+        int hottest = -1;
+        for(int f = memory_tiers[1].first_frame; f < MAX_FRAMES; f++) {
+            if(movable(f) && tier_frames[f].hotness >= tier_hot_threshold &&
+               (hottest == -1 || tier_frames[f].hotness > tier_frames[hottest].hotness)) {
+                hottest = f;
+            }
+        }
+        if(hottest == -1 || !promote(hottest)) {
+            break;
+        }
+    }
+
+    // Keep a fast frame free for new pages and the next promotion
+    if(tier_find_free_frame(0) == -1) {
+        int victim = coldest_frame(0, TIER_HOT_WEIGHT);
+        if(victim != -1) {
+            demote(victim);
+        }
+    }
+}
+
+// Account a reference to a resident page; a hinting fault may promote it first.
+// Returns 1 if the page moved
+int tiering_access(int pid, int page_number) {
+    int frame_id = processes[pid].page_table[page_number].frame_number;
+    TierFrame* state = &tier_frames[frame_id];
+    int moved = 0;
+
+    state->accessed = true;
+    if(state->hint_armed) {
+        state->hint_armed = false;
+        tiering_stats.hint_faults++;
+        tiering_stats.latency_ns += TIER_HINT_FAULT_NS;
+        latency_charge(LAT_MINOR_FAULT, TIER_HINT_FAULT_NS);
+        VPRINTF("  ✗ HINT FAULT: Page %d of Process %d in %s\n", page_number, pid,
+                memory_tiers[frame_tier(frame_id)].name);
+
+        // This access counts towards the page's hotness
+        if(frame_tier(frame_id) > 0 && state->hotness + TIER_HOT_WEIGHT >= tier_hot_threshold &&
+           promote(frame_id)) {
+            frame_id = processes[pid].page_table[page_number].frame_number;
+            moved = 1;
+        }
+    }
+
+    int tier = frame_tier(frame_id);
+    tiering_stats.accesses[tier]++;
+    tiering_stats.latency_ns += memory_tiers[tier].latency_ns;
+    if(tier > 0) {
+        latency_charge(LAT_DRAM, memory_tiers[tier].latency_ns - memory_tiers[0].latency_ns);
+    }
+    return moved;
+}
+
+// A freed frame starts cold
+void tiering_forget_frame(int frame_id) {
+    memset(&tier_frames[frame_id], 0, sizeof(TierFrame));
+}
+
+// Sampling state follows a migrated page
+void tiering_migrate_frame(int from_frame, int to_frame) {
+    tier_frames[to_frame] = tier_frames[from_frame];
+    tiering_forget_frame(from_frame);
+}
+
+// ==================== REPORTING ====================
+
+static unsigned long long total_accesses() {
+    unsigned long long total = 0;
+    for(int t = 0; t < tier_count; t++) {
+        total += tiering_stats.accesses[t];
+    }
+    return total;
+}
+
+static double effective_latency() {
+    unsigned long long total = total_accesses();
+    return total ? (double)tiering_stats.latency_ns / total : 0.0;
+}
+
+// Accesses served per tier and the migration counters
+void display_tiering_stats() {
+    unsigned long long total = total_accesses();
+
+    printf("\n==================== MEMORY TIERS ====================\n");
+    printf("Tier      Frames  Latency  Accesses   Share\n");
+    printf("--------  ------  -------  --------  ------\n");
+    for(int t = 0; t < tier_count; t++) {
+        printf("%-8s  %6d  %4d ns  %8llu  %5.1f%%\n", memory_tiers[t].name,
+               memory_tiers[t].frames, memory_tiers[t].latency_ns, tiering_stats.accesses[t],
+               total ? tiering_stats.accesses[t] * 100.0 / total : 0.0);
+    }
+
+    printf("\nEffective latency: %.1f ns per access\n", effective_latency());
+    printf("Policy: %s, scan every %d references, %d pages per scan\n",
+           tiering_policy_name(tiering_policy), tier_scan_interval, tier_migration_bandwidth);
+    printf("Promotions: %llu, demotions: %llu (%llu KB copied), hint faults: %llu, held back: %llu\n",
+           tiering_stats.promotions, tiering_stats.demotions,
+           (tiering_stats.promotions + tiering_stats.demotions) * PAGE_SIZE / 1024,
+           tiering_stats.hint_faults, tiering_stats.throttled);
+    printf("======================================================\n");
+}
+
+// ==================== SIMULATION ====================
+
+#define TIER_SIM_PROCESSES 2
+#define TIER_SIM_PAGES 4        // Per process; 8 pages leave two frames free
+#define TIER_SIM_PHASES 8       // The hot half of each process moves every phase
+
+// Two processes with a hot half that moves every phase
+static int build_references(MemoryReference* refs, int count, uint64_t seed) {
+    Workload generator;
+    WorkloadPattern pattern = workload_pattern(PATTERN_HOT_COLD, 0, TIER_SIM_PAGES);
+    pattern.hot_fraction = 0.5;
+    pattern.hot_probability = 0.9;
+
+    workload_init(&generator, seed);
+    for(int p = 0; p < TIER_SIM_PROCESSES; p++) {
+        workload_add_process(&generator, p, 1);
+        workload_add_phase(&generator, p, &pattern);
+    }
+    int generated = workload_generate(&generator, refs, count);
+    workload_free(&generator);
+    if(generated < 0) {
+        return -1;
+    }
+
+    int phase_length = count / TIER_SIM_PHASES > 0 ? count / TIER_SIM_PHASES : 1;
+    for(int i = 0; i < count; i++) {
+        int shift = (i / phase_length) * (TIER_SIM_PAGES / 2);
+        int page = (int)(refs[i].address / PAGE_SIZE);
+        refs[i].address = (unsigned long long)((page + shift) % TIER_SIM_PAGES) * PAGE_SIZE;
+    }
+    return 0;
+}
+
+// Replay the references on a fresh memory system
+static void replay(const MemoryReference* refs, int count) {
+    int pids[TIER_SIM_PROCESSES];
+
+    init_memory_system();
+    for(int p = 0; p < TIER_SIM_PROCESSES; p++) {
+        pids[p] = create_process("tiered");
+    }
+    for(int i = 0; i < count; i++) {
+        access_memory_ex(pids[refs[i].pid], (int)refs[i].address, refs[i].is_write);
+    }
+}
+
+static double tier_share(int tier) {
+    unsigned long long total = total_accesses();
+    return total ? tiering_stats.accesses[tier] * 100.0 / total : 0.0;
+}
+
+// Each policy on a DRAM + CXL host against an all-DRAM one, then DRAM sizes
+void run_tiering_simulation(int refs, uint64_t seed) {
+    static const char* names[2] = { "DRAM", "CXL" };
+    static const int latencies[2] = { TIER_DRAM_LATENCY_NS, TIER_CXL_LATENCY_NS };
+    MemoryTier saved_tiers[MAX_TIERS];
+    int saved_count = tier_count;
+    TieringPolicy saved_policy = tiering_policy;
+    int saved_bandwidth = tier_migration_bandwidth;
+    int saved_zero_page = zero_page_enabled;
+
+    if(refs <= 0) {
+        printf("Error: Reference count must be positive\n");
+        return;
+    }
+    MemoryReference* batch = (MemoryReference*)malloc(refs * sizeof(MemoryReference));
+    if(batch == NULL || build_references(batch, refs, seed) != 0) {
+        printf("Error: Memory allocation failed\n");
+        free(batch);
+        return;
+    }
+
+    memcpy(saved_tiers, memory_tiers, sizeof(saved_tiers));
+    verbose_mode = 0;
+    zero_page_enabled = 0;  // The zero frame is pinned and would hold a DRAM frame
+
+    printf("\n=========================== MEMORY TIERING ===========================\n");
+    printf("%d processes x %d pages, %d references, hot half moves %d times; seed %llu\n",
+           TIER_SIM_PROCESSES, TIER_SIM_PAGES, refs, TIER_SIM_PHASES - 1,
+           (unsigned long long)seed);
+    printf("DRAM %d ns, CXL %d ns, hint fault %d ns; scan every %d references\n",
+           TIER_DRAM_LATENCY_NS, TIER_CXL_LATENCY_NS, TIER_HINT_FAULT_NS, tier_scan_interval);
+
+    printf("\nHost          Policy      BW  In DRAM  Latency  Slowdown  Promoted  Demoted  Hints  Held\n");
+    printf("------------  ----------  --  -------  -------  --------  --------  -------  -----  ----\n");
+
+    // All-DRAM baseline
+    int all_frames[1] = { MAX_FRAMES };
+    tiering_configure(1, names, all_frames, latencies);
+    tiering_policy = TIERING_NONE;
+    replay(batch, refs);
+    double baseline = effective_latency();
+    printf("%-12s  %-10s  %2s  %6.1f%%  %7.1f  %7.2fx  %8s  %7s  %5s  %4s\n",
+           "10 DRAM", "-", "-", tier_share(0), baseline, 1.0, "-", "-", "-", "-");
+
+    int frames[2] = { 4, MAX_FRAMES - 4 };
+    tiering_configure(2, names, frames, latencies);
+    for(int policy = 0; policy < TIERING_POLICY_COUNT; policy++) {
+        for(int bandwidth = 1; bandwidth <= 4; bandwidth *= 4) {
+            if(policy == TIERING_NONE && bandwidth > 1) {
+                continue;
+            }
+            tiering_policy = (TieringPolicy)policy;
+            tier_migration_bandwidth = bandwidth;
+            replay(batch, refs);
+
+            char bw[12];
+            snprintf(bw, sizeof(bw), "%d", bandwidth);
+            printf("%-12s  %-10s  %2s  %6.1f%%  %7.1f  %7.2fx  %8llu  %7llu  %5llu  %4llu\n",
+                   "4+6 CXL", tiering_policy_name(tiering_policy),
+                   policy == TIERING_NONE ? "-" : bw, tier_share(0), effective_latency(),
+                   baseline > 0 ? effective_latency() / baseline : 0.0,
+                   tiering_stats.promotions, tiering_stats.demotions,
+                   tiering_stats.hint_faults, tiering_stats.throttled);
+        }
+    }
+
+    // How much DRAM the hot set needs
+    printf("\nDRAM frames  In DRAM  Latency  Slowdown   (access bit, %d pages per scan)\n",
+           TIER_DEFAULT_BANDWIDTH);
+    printf("-----------  -------  -------  --------\n");
+    tiering_policy = TIERING_ACCESS_BIT;
+    tier_migration_bandwidth = TIER_DEFAULT_BANDWIDTH;
+    for(int dram = 2; dram < MAX_FRAMES; dram += 2) {
+        int sized[2] = { dram, MAX_FRAMES - dram };
+        tiering_configure(2, names, sized, latencies);
+        replay(batch, refs);
+        printf("%11d  %6.1f%%  %7.1f  %7.2fx\n", dram, tier_share(0), effective_latency(),
+               baseline > 0 ? effective_latency() / baseline : 0.0);
+    }
+
+    printf("\nFirst-touch placement strands the hot set in CXL once it moves; sampling\n");
+    printf("access bits brings it back for a few migrations; hinting faults react\n");
+    printf("later and add their own cost to the accesses that take them.\n");
+    printf("======================================================================\n");
+
+    memcpy(memory_tiers, saved_tiers, sizeof(saved_tiers));
+    tier_count = saved_count;
+    tiering_policy = saved_policy;
+    tier_migration_bandwidth = saved_bandwidth;
+    zero_page_enabled = saved_zero_page;
+    free(batch);
+}
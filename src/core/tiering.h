@@ -0,0 +1,70 @@
+/**
+ * tiering.h
+ * Memory tiers with hotness-based promotion and demotion module header
+ */
+
+#ifndef TIERING_H
+#define TIERING_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../../include/common_defs.h"
+
+#define MAX_TIERS 3
+#define TIER_DRAM_LATENCY_NS 80
+#define TIER_CXL_LATENCY_NS 250
+#define TIER_DEFAULT_SCAN_INTERVAL 20   // References between access-bit scans
+#define TIER_DEFAULT_BANDWIDTH 2        // Pages migrated per scan interval
+#define TIER_HOT_WEIGHT 4               // Hotness added by an access seen in a scan
+#define TIER_DEFAULT_HOT_THRESHOLD 6    // Accessed in two intervals running
+#define TIER_HINT_FAULT_NS 500          // Cost of a hinting fault on top of the access
+#define TIER_HINT_SCAN_PERIOD 4         // Scans between arming the slow-tier pages
+
+typedef enum {
+    TIERING_NONE,           // Pages stay where they were first placed
+    TIERING_ACCESS_BIT,     // Scans promote slow-tier pages whose access bits stay set
+    TIERING_FAULT_HINT,     // Slow-tier pages are armed to fault; a hot one is promoted on its fault
+    TIERING_POLICY_COUNT
+} TieringPolicy;
+
+// A range of physical frames with one access latency, fastest tier first
+typedef struct {
+    char name[16];
+    int first_frame;
+    int frames;
+    int latency_ns;
+} MemoryTier;
+
+typedef struct {
+    unsigned long long accesses[MAX_TIERS];
+    unsigned long long latency_ns;      // Summed over accesses, hinting faults included
+    unsigned long long promotions;
+    unsigned long long demotions;
+    unsigned long long hint_faults;
+    unsigned long long throttled;       // Migrations held back by the bandwidth limit
+    unsigned long long scans;
+} TieringStats;
+
+extern MemoryTier memory_tiers[MAX_TIERS];
+extern int tier_count;
+extern TieringPolicy tiering_policy;
+extern int tier_scan_interval;
+extern int tier_migration_bandwidth;
+extern int tier_hot_threshold;
+extern TieringStats tiering_stats;
+
+// Function Prototypes
+void reset_tiering();
+int tiering_configure(int count, const char* const* names, const int* frames,
+                      const int* latency_ns);
+const char* tiering_policy_name(TieringPolicy policy);
+int frame_tier(int frame_id);
+int tier_find_free_frame(int tier);
+void tiering_tick();
+int tiering_access(int pid, int page_number);
+void tiering_forget_frame(int frame_id);
+void tiering_migrate_frame(int from_frame, int to_frame);
+void display_tiering_stats();
+void run_tiering_simulation(int refs, uint64_t seed);
+
+#endif // TIERING_H
@@ -0,0 +1,190 @@
+/**
+ * timeline.c
+ * Fixed-interval statistics windows
+ *
+ * Lifetime totals average a program's phases together: a trace that is
+ * all hits for a while and then thrashes reports one middling hit ratio.
+ * Every reference is therefore also counted into the current window of
+ * timeline_interval references, and finished windows stay in a ring of
+ * TIMELINE_WINDOWS, so the recent history of hit ratio, fault rate and
+ * latency can be shown as a time series. Only raw counts are kept; the
+ * ratios are worked out when the ring is displayed. A window whose hit
+ * ratio moves away from the average of the few before it is flagged as a
+ * phase change.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "timeline.h"
+#include "memory_manager.h"
+#include "../trace/workload.h"
+
+int timeline_interval = TIMELINE_DEFAULT_INTERVAL;
+
+static StatsWindow ring[TIMELINE_WINDOWS];
+static unsigned long long closed;       // Windows finished since the reset
+static unsigned long long observed;     // References counted since the reset
+
+// Drop every window
+void reset_timeline() {
+    memset(ring, 0, sizeof(ring));
+    closed = 0;
+    observed = 0;
+}
+
+// Count a finished reference into the current window
+void timeline_observe(bool was_fault, unsigned long long latency_ns) {
+    StatsWindow* window = &ring[closed % TIMELINE_WINDOWS];
+    if(window->references == 0) {
+        window->first_reference = observed;
+    }
+
+    window->references++;
+    window->faults += was_fault;
+    window->latency_ns += latency_ns;
+    if(latency_ns > window->max_ns) {
+        window->max_ns = latency_ns;
+    }
+    observed++;
+
+    if(window->references >= (unsigned long long)(timeline_interval > 0 ? timeline_interval : 1)) {
+        closed++;
+        memset(&ring[closed % TIMELINE_WINDOWS], 0, sizeof(StatsWindow));
+    }
+}
+
+// Copy the kept windows oldest first, the unfinished one last; returns how many
+int timeline_windows(StatsWindow* windows, int max) {
+    unsigned long long first = closed >= TIMELINE_WINDOWS ? closed - TIMELINE_WINDOWS + 1 : 0;
+    int count = 0;
+
+    for(unsigned long long w = first; w <= closed && count < max; w++) {
+        const StatsWindow* window = &ring[w % TIMELINE_WINDOWS];
+        if(window->references > 0) {
+            windows[count++] = *window;
+        }
+    }
+    return count;
+}
+
+static double hit_ratio(const StatsWindow* window) {
+    return window->references ?
+           (window->references - window->faults) * 100.0 / window->references : 0.0;
+}
+
+// Flag the windows whose hit ratio left the average of the windows before
+// them; the comparison restarts at each change so a new phase is flagged once
+void timeline_phase_changes(const StatsWindow* windows, int count, bool* changes) {
+    int phase_start = 0;
+    for(int i = 0; i < count; i++) {
+        int first = i - TIMELINE_SHIFT_HISTORY > phase_start ? i - TIMELINE_SHIFT_HISTORY : phase_start;
+        changes[i] = false;
+        if(first == i) {
+            continue;
+        }
+
+        double average = 0.0;
+        for(int w = first; w < i; w++) {
+            average += hit_ratio(&windows[w]);
+        }
+        average /= i - first;
+
+        double delta = hit_ratio(&windows[i]) - average;
+        if(delta >= TIMELINE_SHIFT_POINTS || delta <= -TIMELINE_SHIFT_POINTS) {
+            changes[i] = true;
+            phase_start = i;
+        }
+    }
+}
+
+// Time series of the kept windows, one line each
+void display_timeline() {
+    StatsWindow windows[TIMELINE_WINDOWS];
+    bool changes[TIMELINE_WINDOWS];
+    int count = timeline_windows(windows, TIMELINE_WINDOWS);
+    timeline_phase_changes(windows, count, changes);
+
+    printf("\n==================== TIMELINE ====================\n");
+    printf("Windows of %d references, last %d kept\n", timeline_interval, TIMELINE_WINDOWS);
+    if(count == 0) {
+        printf("No references yet\n");
+        printf("==================================================\n");
+        return;
+    }
+
+    printf("  First ref   Hit %%  Fault %%  Mean (ns)   Max (ns)  Hit ratio\n");
+    printf("-----------  ------  -------  ---------  ---------  --------------------\n");
+    for(int i = 0; i < count; i++) {
+        const StatsWindow* window = &windows[i];
+        double hits = hit_ratio(window);
+        char bar[21];
+        int filled = (int)(hits / 5.0 + 0.5);
+        memset(bar, '#', filled);
+        memset(bar + filled, '.', 20 - filled);
+        bar[20] = '\0';
+
+        printf("%11llu  %6.1f  %7.1f  %9.0f  %9llu  %s%s\n", window->first_reference, hits,
+               100.0 - hits, (double)window->latency_ns / window->references, window->max_ns, bar,
+               changes[i] ? "  <- phase change" : "");
+    }
+    printf("==================================================\n");
+}
+
+// ==================== SIMULATION ====================
+
+#define TIMELINE_SIM_INTERVAL 500
+#define TIMELINE_SIM_PHASE 3000         // References per phase
+
+// One process alternates between a hot set that fits in memory and a
+// sequential scan over more pages than there are frames
+void run_timeline_simulation(int refs, uint64_t seed) {
+    int saved_interval = timeline_interval;
+
+    if(refs <= 0) {
+        printf("Error: Reference count must be positive\n");
+        return;
+    }
+    MemoryReference* batch = (MemoryReference*)malloc(refs * sizeof(MemoryReference));
+    if(batch == NULL) {
+        printf("Error: Memory allocation failed\n");
+        return;
+    }
+
+    Workload generator;
+    WorkloadPattern resident = workload_pattern(PATTERN_HOT_COLD, 0, MAX_FRAMES - 2);
+    WorkloadPattern scan = workload_pattern(PATTERN_SCAN, 0, MAX_FRAMES + 6);
+    resident.length = TIMELINE_SIM_PHASE;
+    scan.length = TIMELINE_SIM_PHASE;
+
+    workload_init(&generator, seed);
+    workload_add_process(&generator, 0, 1);
+    workload_add_phase(&generator, 0, &resident);
+    workload_add_phase(&generator, 0, &scan);
+    int generated = workload_generate(&generator, batch, refs);
+    workload_free(&generator);
+    if(generated < 0) {
+        printf("Error: Memory allocation failed\n");
+        free(batch);
+        return;
+    }
+
+    verbose_mode = 0;
+    timeline_interval = TIMELINE_SIM_INTERVAL;
+    init_memory_system();
+    int pid = create_process("phased");
+    for(int i = 0; i < refs; i++) {
+        access_memory_ex(pid, (int)batch[i].address, batch[i].is_write);
+    }
+
+    printf("\n%d references alternating every %d between %d resident pages and a\n",
+           refs, TIMELINE_SIM_PHASE, MAX_FRAMES - 2);
+    printf("scan over %d pages on %d frames; seed %llu\n", MAX_FRAMES + 6, MAX_FRAMES,
+           (unsigned long long)seed);
+    display_timeline();
+    update_statistics();
+    printf("Lifetime hit ratio %.1f%% averages both phases together\n", stats.hit_ratio);
+
+    timeline_interval = saved_interval;
+    free(batch);
+}
@@ -0,0 +1,37 @@
+/**
+ * timeline.h
+ * Fixed-interval statistics windows module header
+ */
+
+#ifndef TIMELINE_H
+#define TIMELINE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../../include/common_defs.h"
+
+#define TIMELINE_WINDOWS 64             // Windows kept; the oldest is overwritten
+#define TIMELINE_DEFAULT_INTERVAL 1000  // References per window
+#define TIMELINE_SHIFT_POINTS 15.0      // Hit ratio move, in points, that marks a phase change
+#define TIMELINE_SHIFT_HISTORY 3        // Windows averaged to compare against
+
+// Counters of one window; ratios are derived when displayed
+typedef struct {
+    unsigned long long first_reference;
+    unsigned long long references;
+    unsigned long long faults;
+    unsigned long long latency_ns;
+    unsigned long long max_ns;
+} StatsWindow;
+
+extern int timeline_interval;
+
+// Function Prototypes
+void reset_timeline();
+void timeline_observe(bool was_fault, unsigned long long latency_ns);
+int timeline_windows(StatsWindow* windows, int max);
+void timeline_phase_changes(const StatsWindow* windows, int count, bool* changes);
+void display_timeline();
+void run_timeline_simulation(int refs, uint64_t seed);
+
+#endif // TIMELINE_H
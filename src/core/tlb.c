@@ -0,0 +1,133 @@
+/**
+ * tlb.c
+ * Translation Lookaside Buffer implementation
+ *
+ * A small fully associative TLB with LRU replacement. Entries carry an
+ * address space identifier so translations of several processes can stay
+ * cached across context switches (ASID retention) or be dropped on every
+ * switch (flush mode).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "tlb.h"
+#include "../../include/common_defs.h"
+
+TLBEntry tlb[TLB_SIZE];
+TLBStats tlb_stats;
+
+// Monotonic counter for LRU ordering of entries
+static int tlb_clock = 0;
+
+// Initialize the TLB
+void init_tlb() {
+    for(int i = 0; i < TLB_SIZE; i++) {
+        tlb[i].valid = false;
+        tlb[i].asid = -1;
+        tlb[i].page_number = -1;
+        tlb[i].frame_number = -1;
+        tlb[i].last_use = 0;
+    }
+    tlb_clock = 0;
+    reset_tlb_statistics();
+}
+
+// Look up a translation, returns the frame number or -1 on a miss
+int tlb_lookup(int asid, int page_number) {
+    for(int i = 0; i < TLB_SIZE; i++) {
+        if(tlb[i].valid && tlb[i].asid == asid && tlb[i].page_number == page_number) {
+            tlb[i].last_use = ++tlb_clock;
+            tlb_stats.hits++;
+            return tlb[i].frame_number;
+        }
+    }
+
+    tlb_stats.misses++;
+    return -1;
+}
+
+// Cache a translation, replacing the least recently used entry
+void tlb_insert(int asid, int page_number, int frame_number) {
+    int slot = 0;
+
+    for(int i = 0; i < TLB_SIZE; i++) {
+        if(tlb[i].valid && tlb[i].asid == asid && tlb[i].page_number == page_number) {
+            slot = i;
+            break;
+        }
+        if(!tlb[i].valid) {
+            slot = i;
+            break;
+        }
+        if(tlb[i].last_use < tlb[slot].last_use) {
+            slot = i;
+        }
+    }
+
+    tlb[slot].valid = true;
+    tlb[slot].asid = asid;
+    tlb[slot].page_number = page_number;
+    tlb[slot].frame_number = frame_number;
+    tlb[slot].last_use = ++tlb_clock;
+}
+
+// Drop a single translation (page evicted or unmapped)
+void tlb_invalidate(int asid, int page_number) {
+    for(int i = 0; i < TLB_SIZE; i++) {
+        if(tlb[i].valid && tlb[i].asid == asid && tlb[i].page_number == page_number) {
+            tlb[i].valid = false;
+            tlb_stats.invalidations++;
+        }
+    }
+}
+
+// Drop every translation (context switch without ASIDs)
+void tlb_flush_all() {
+    for(int i = 0; i < TLB_SIZE; i++) {
+        tlb[i].valid = false;
+    }
+    tlb_stats.flushes++;
+}
+
+// Drop the translations of one address space
+void tlb_flush_asid(int asid) {
+    for(int i = 0; i < TLB_SIZE; i++) {
+        if(tlb[i].valid && tlb[i].asid == asid) {
+            tlb[i].valid = false;
+        }
+    }
+    tlb_stats.flushes++;
+}
+
+// Reset TLB counters
+void reset_tlb_statistics() {
+    tlb_stats.hits = 0;
+    tlb_stats.misses = 0;
+    tlb_stats.flushes = 0;
+    tlb_stats.invalidations = 0;
+}
+
+// Display TLB contents
+void display_tlb() {
+    printf("\nTLB Contents (%d entries):\n", TLB_SIZE);
+    printf("==========================\n");
+    printf("Slot  ASID  Page  Frame  Last Use\n");
+    printf("----  ----  ----  -----  --------\n");
+
+    for(int i = 0; i < TLB_SIZE; i++) {
+        if(tlb[i].valid) {
+            printf("%4d  %4d  %4d  %5d  %8d\n",
+                   i, tlb[i].asid, tlb[i].page_number,
+                   tlb[i].frame_number, tlb[i].last_use);
+        } else {
+            printf("%4d  %4s  %4s  %5s  %8s\n", i, "--", "--", "--", "--");
+        }
+    }
+
+    int lookups = tlb_stats.hits + tlb_stats.misses;
+    printf("\nHits: %d, Misses: %d, Hit Ratio: %.2f%%\n",
+           tlb_stats.hits, tlb_stats.misses,
+           lookups > 0 ? (tlb_stats.hits * 100.0) / lookups : 0.0);
+    printf("Flushes: %d, Invalidations: %d\n",
+           tlb_stats.flushes, tlb_stats.invalidations);
+}
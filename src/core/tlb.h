@@ -0,0 +1,43 @@
+/**
+ * tlb.h
+ * Translation Lookaside Buffer module header
+ */
+
+#ifndef TLB_H
+#define TLB_H
+
+#include "../../include/common_defs.h"
+
+#define TLB_SIZE 8
+
+// One cached translation, tagged with the owning address space (ASID)
+typedef struct {
+    bool valid;
+    int asid;
+    int page_number;
+    int frame_number;
+    int last_use;
+} TLBEntry;
+
+// TLB counters
+typedef struct {
+    int hits;
+    int misses;
+    int flushes;
+    int invalidations;
+} TLBStats;
+
+extern TLBEntry tlb[TLB_SIZE];
+extern TLBStats tlb_stats;
+
+// Function Prototypes
+void init_tlb();
+int tlb_lookup(int asid, int page_number);
+void tlb_insert(int asid, int page_number, int frame_number);
+void tlb_invalidate(int asid, int page_number);
+void tlb_flush_all();
+void tlb_flush_asid(int asid);
+void reset_tlb_statistics();
+void display_tlb();
+
+#endif // TLB_H
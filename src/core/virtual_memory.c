@@ -5,12 +5,15 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "virtual_memory.h"
 #include "../../include/common_defs.h"
 #include "memory_manager.h"
+#include "tlb.h"
+#include "page_cache.h"
+#include "latency.h"
 
 // Swap space simulation
-#define SWAP_SPACE_SIZE 100
 typedef struct {
     int pid;
     int page_number;
@@ -18,6 +21,10 @@ typedef struct {
 } SwapEntry;
 
 SwapEntry swap_space[SWAP_SPACE_SIZE];
+static unsigned char swap_data[SWAP_SPACE_SIZE][PAGE_SIZE];
+
+// Usable slots; batch runs lower it to create memory pressure
+int swap_slots = SWAP_SPACE_SIZE;
 
 // Initialize virtual memory
 void init_virtual_memory(int virtual_pages, int physical_frames) {
@@ -28,11 +35,7 @@ void init_virtual_memory(int virtual_pages, int physical_frames) {
     printf("Swap space: %d pages\n", SWAP_SPACE_SIZE);
     
     // Initialize swap space
-    for(int i = 0; i < SWAP_SPACE_SIZE; i++) {
-        swap_space[i].pid = -1;
-        swap_space[i].page_number = -1;
-        swap_space[i].in_swap = 0;
-    }
+    reset_swap_space();
     
     printf("✓ Virtual memory system ready\n");
     printf("✓ Demand paging enabled\n");
@@ -64,23 +67,17 @@ void simulate_virtual_memory_access(int pid, int address) {
         printf("Checking swap space...\n");
         
         // Check if page is in swap space
-        int in_swap = 0;
-        for(int i = 0; i < SWAP_SPACE_SIZE; i++) {
-            if(swap_space[i].pid == pid && 
-               swap_space[i].page_number == page_number &&
-               swap_space[i].in_swap) {
-                in_swap = 1;
-                break;
-            }
-        }
-        
-        if(in_swap) {
+        if(swap_lookup(pid, page_number) != -1) {
             printf("Page found in swap space\n");
             printf("Swapping in page from disk...\n");
             swap_in(pid, page_number);
+        } else if(find_file_mapping(pid, page_number) != NULL) {
+            printf("Page is file-backed\n");
+            printf("Loading page through the page cache...\n");
+            page_cache_fault(pid, page_number);
         } else {
             printf("Page not found anywhere (First access)\n");
-            printf("Loading page from executable file...\n");
+            printf("Allocating anonymous page...\n");
             
             // Allocate page
             allocate_page(pid, page_number);
@@ -129,115 +126,112 @@ void display_virtual_memory_state() {
 
 // Swap in a page from disk
 void swap_in(int pid, int page_number) {
-    printf("\nSwap In Operation:\n");
-    printf("------------------\n");
+    VPRINTF("\nSwap In Operation:\n");
+    VPRINTF("------------------\n");
     
     // Find the page in swap space
-    int swap_index = -1;
-    for(int i = 0; i < SWAP_SPACE_SIZE; i++) {
-        if(swap_space[i].pid == pid && 
-           swap_space[i].page_number == page_number &&
-           swap_space[i].in_swap) {
-            swap_index = i;
-            break;
-        }
-    }
+    int swap_index = swap_lookup(pid, page_number);
     
     if(swap_index == -1) {
         printf("Error: Page not found in swap space\n");
         return;
     }
     
-    printf("1. Locate page in swap space (slot %d)\n", swap_index);
-    printf("2. Find free frame in physical memory\n");
+    VPRINTF("1. Locate page in swap space (slot %d)\n", swap_index);
+    VPRINTF("2. Find free frame in physical memory\n");
     
     int frame_id = find_free_frame();
     
     if(frame_id == -1) {
-        printf("3. No free frames - need to swap out a page\n");
-        // In real implementation, select victim and swap out
-        printf("4. Select victim page\n");
-        printf("5. Swap out victim page\n");
-        
-        // For demo, we'll just allocate
-        frame_id = 0;  // Use frame 0 for demo
+        VPRINTF("3. No free frames - need to swap out a page\n");
+        VPRINTF("4. Select victim page\n");
+        frame_id = reclaim_frame();
+        VPRINTF("5. Victim evicted from frame %d\n", frame_id);
     } else {
-        printf("3. Free frame found: %d\n", frame_id);
+        VPRINTF("3. Free frame found: %d\n", frame_id);
     }
     
-    printf("4. Read page from swap space into frame %d\n", frame_id);
-    printf("5. Update page table\n");
-    printf("6. Clear swap space entry\n");
+    if(frame_id == -1) {
+        printf("Error: No frame available for swap in\n");
+        return;
+    }
+    if(processes[pid].pid == -1) {
+        return;  // Killed to free memory while its page was being brought in
+    }
     
-    // Update physical memory
+    VPRINTF("4. Read page from swap space into frame %d\n", frame_id);
+    VPRINTF("5. Update page table\n");
+    VPRINTF("6. Clear swap space entry\n");
+    
+    // Update physical memory and page table
     physical_memory[frame_id].frame_id = frame_id;
-    physical_memory[frame_id].page_number = page_number;
-    physical_memory[frame_id].process_id = pid;
     physical_memory[frame_id].load_time = current_time;
     physical_memory[frame_id].last_access = current_time;
-    physical_memory[frame_id].is_free = false;
-    
-    // Update page table
-    processes[pid].page_table[page_number].frame_number = frame_id;
-    processes[pid].page_table[page_number].present = true;
-    processes[pid].page_table[page_number].valid = true;
+    physical_memory[frame_id].dirty = false;
+    memcpy(frame_data[frame_id], swap_data[swap_index], PAGE_SIZE);
+    mark_frame_used(frame_id);
+    map_page(pid, page_number, frame_id);
     
     // Clear swap space
     swap_space[swap_index].in_swap = 0;
+    swap_space[swap_index].pid = -1;
+    swap_space[swap_index].page_number = -1;
     
-    printf("✓ Page %d swapped in successfully\n", page_number);
+    VPRINTF("✓ Page %d swapped in successfully\n", page_number);
     current_time++;
 }
 
 // Swap out a page to disk
-void swap_out(int pid, int page_number) {
-    printf("\nSwap Out Operation:\n");
-    printf("-------------------\n");
+int swap_out(int pid, int page_number) {
+    VPRINTF("\nSwap Out Operation:\n");
+    VPRINTF("-------------------\n");
+    
+    if(pid < 0 || pid >= MAX_PROCESSES || page_number < 0 || page_number >= MAX_PAGES ||
+       !processes[pid].page_table[page_number].present) {
+        printf("Error: Page %d of process %d is not resident\n", page_number, pid);
+        return -1;
+    }
     
-    // Find free slot in swap space
-    int swap_index = -1;
-    for(int i = 0; i < SWAP_SPACE_SIZE; i++) {
-        if(!swap_space[i].in_swap) {
-            swap_index = i;
-            break;
-        }
+    // A page cache frame is backed by its file: only the mapping is dropped
+    int cached_frame = processes[pid].page_table[page_number].frame_number;
+    if(page_cache_holds(cached_frame)) {
+        unmap_page(pid, page_number);
+        VPRINTF("✓ Page %d is file-backed, mapping dropped and Frame %d left in the page cache\n",
+                page_number, cached_frame);
+        return 0;
     }
     
+    // Record the page in a free swap slot
+    int swap_index = swap_store(pid, page_number);
+    
     if(swap_index == -1) {
         printf("Error: No free space in swap area\n");
-        return;
+        return -1;
     }
     
-    printf("1. Select victim page: Process %d, Page %d\n", pid, page_number);
+    VPRINTF("1. Select victim page: Process %d, Page %d\n", pid, page_number);
     
     int frame_id = processes[pid].page_table[page_number].frame_number;
     
-    printf("2. Check if page is dirty (modified)\n");
+    VPRINTF("2. Check if page is dirty (modified)\n");
     
     if(physical_memory[frame_id].dirty) {
-        printf("3. Page is dirty - write to swap space\n");
+        VPRINTF("3. Page is dirty - write to swap space\n");
+        latency_swap_out();
     } else {
-        printf("3. Page is clean - no need to write\n");
+        VPRINTF("3. Page is clean - no need to write\n");
     }
     
-    printf("4. Free frame %d\n", frame_id);
-    
-    // Update swap space
-    swap_space[swap_index].pid = pid;
-    swap_space[swap_index].page_number = page_number;
-    swap_space[swap_index].in_swap = 1;
-    
-    // Update physical memory
-    physical_memory[frame_id].is_free = true;
-    physical_memory[frame_id].page_number = -1;
-    physical_memory[frame_id].process_id = -1;
-    
-    // Update page table
-    processes[pid].page_table[page_number].present = false;
-    processes[pid].page_table[page_number].frame_number = -1;
+    // The frame stays resident while other processes still share it
+    if(unmap_page(pid, page_number) == 0) {
+        VPRINTF("4. Free frame %d\n", frame_id);
+    } else {
+        VPRINTF("4. Frame %d still shared, only the mapping is dropped\n", frame_id);
+    }
     
-    printf("5. Update swap space (slot %d)\n", swap_index);
-    printf("✓ Page %d swapped out successfully\n", page_number);
+    VPRINTF("5. Update swap space (slot %d)\n", swap_index);
+    VPRINTF("✓ Page %d swapped out successfully\n", page_number);
+    return 0;
 }
 
 // Display swap space
@@ -264,3 +258,101 @@ void display_swap_space() {
     
     printf("\nTotal: %d/%d slots used\n", used_slots, SWAP_SPACE_SIZE);
 }
+
+// Find the swap slot holding a page, -1 if it is not swapped out
+int swap_lookup(int pid, int page_number) {
+    for(int i = 0; i < SWAP_SPACE_SIZE; i++) {
+        if(swap_space[i].in_swap &&
+           swap_space[i].pid == pid &&
+           swap_space[i].page_number == page_number) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Write a page to a free swap slot, returns the slot or -1 if swap is full
+int swap_store(int pid, int page_number) {
+    int slot = swap_lookup(pid, page_number);
+    
+    for(int i = 0; slot == -1 && i < swap_slots; i++) {
+        if(!swap_space[i].in_swap) {
+            swap_space[i].pid = pid;
+            swap_space[i].page_number = page_number;
+            swap_space[i].in_swap = 1;
+            slot = i;
+        }
+    }
+    
+    // A resident page's contents go with it
+    if(slot != -1 && processes[pid].page_table[page_number].present) {
+        memcpy(swap_data[slot], frame_data[processes[pid].page_table[page_number].frame_number],
+               PAGE_SIZE);
+    }
+    return slot;
+}
+
+// Give another process its own swap copy of a swapped-out page, returns the slot or -1
+int swap_duplicate(int pid, int page_number, int to_pid) {
+    int from = swap_lookup(pid, page_number);
+    if(from == -1) {
+        return -1;
+    }
+    
+    int slot = swap_store(to_pid, page_number);
+    if(slot != -1) {
+        memcpy(swap_data[slot], swap_data[from], PAGE_SIZE);
+    }
+    return slot;
+}
+
+// Usable slots not holding a page
+int swap_free_slots() {
+    int used = 0;
+    for(int i = 0; i < SWAP_SPACE_SIZE; i++) {
+        used += swap_space[i].in_swap;
+    }
+    return swap_slots > used ? swap_slots - used : 0;
+}
+
+// Pages of one process held in swap
+int swap_pages(int pid) {
+    int count = 0;
+    for(int i = 0; i < SWAP_SPACE_SIZE; i++) {
+        count += (swap_space[i].in_swap && swap_space[i].pid == pid);
+    }
+    return count;
+}
+
+// Free the swap slot of one page, returns 0 or -1 if it was not swapped out
+int swap_discard(int pid, int page_number) {
+    int slot = swap_lookup(pid, page_number);
+    if(slot == -1) {
+        return -1;
+    }
+    
+    swap_space[slot].pid = -1;
+    swap_space[slot].page_number = -1;
+    swap_space[slot].in_swap = 0;
+    return 0;
+}
+
+// Drop every swap slot owned by a terminating process
+void swap_release_process(int pid) {
+    for(int i = 0; i < SWAP_SPACE_SIZE; i++) {
+        if(swap_space[i].in_swap && swap_space[i].pid == pid) {
+            swap_space[i].pid = -1;
+            swap_space[i].page_number = -1;
+            swap_space[i].in_swap = 0;
+        }
+    }
+}
+
+// Mark every swap slot free
+void reset_swap_space() {
+    for(int i = 0; i < SWAP_SPACE_SIZE; i++) {
+        swap_space[i].pid = -1;
+        swap_space[i].page_number = -1;
+        swap_space[i].in_swap = 0;
+    }
+}
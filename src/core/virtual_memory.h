@@ -8,12 +8,24 @@
 
 #include "../../include/common_defs.h"
 
+#define SWAP_SPACE_SIZE 100
+
+extern int swap_slots;
+
 // Function Prototypes
 void init_virtual_memory(int virtual_pages, int physical_frames);
 void simulate_virtual_memory_access(int pid, int address);
 void display_virtual_memory_state();
 void swap_in(int pid, int page_number);
-void swap_out(int pid, int page_number);
+int swap_out(int pid, int page_number);
 void display_swap_space();
+int swap_lookup(int pid, int page_number);
+int swap_store(int pid, int page_number);
+int swap_duplicate(int pid, int page_number, int to_pid);
+int swap_free_slots();
+int swap_pages(int pid);
+int swap_discard(int pid, int page_number);
+void swap_release_process(int pid);
+void reset_swap_space();
 
 #endif // VIRTUAL_MEMORY_H
@@ -0,0 +1,706 @@
+/**
+ * vma.c
+ * Virtual memory areas: per-process address-space regions
+ *
+ * Every process owns an address space made of regions (heap, stack,
+ * anonymous and file mappings), each with its own protection and
+ * backing. Regions live in a balanced tree keyed by start page, so
+ * finding the one holding an address costs O(log n) however many there
+ * are; the free gaps between them sit in a second tree that answers
+ * "lowest hole of n pages" for unplaced mappings. munmap and mprotect
+ * split regions at the range boundaries and neighbours that end up
+ * identical are merged again. A small cache of the last regions found,
+ * indexed by page, short-cuts the repeated lookups of a fault-heavy
+ * loop, like the kernel's per-thread vmacache.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "vma.h"
+#include "memory_manager.h"
+#include "virtual_memory.h"
+#include "overcommit.h"
+#include "page_cache.h"
+#include "../trace/workload.h"
+
+#define VMA_OF(node) ((Vma*)(uintptr_t)(node)->tie)
+
+VmaStats vma_stats;
+
+static MmStruct process_mms[MAX_PROCESSES];
+
+// ==================== ADDRESS SPACE ====================
+
+// Empty address space of the given size, one gap covering all of it
+void mm_init(MmStruct* mm, uint64_t pages) {
+    memset(mm, 0, sizeof(MmStruct));
+    extent_tree_init(&mm->vmas);
+    extent_tree_init(&mm->gaps);
+    mm->pages = pages;
+    if(pages > 0) {
+        extent_tree_insert(&mm->gaps, 0, 0, pages);
+    }
+}
+
+// Free every region and both trees
+void mm_destroy(MmStruct* mm) {
+    ExtentNode* node;
+    while((node = extent_tree_min(&mm->vmas)) != NULL) {
+        Vma* vma = VMA_OF(node);
+        extent_tree_remove(&mm->vmas, node->key, node->tie);
+        free(vma);
+    }
+    extent_tree_free(&mm->vmas);
+    extent_tree_free(&mm->gaps);
+    memset(mm, 0, sizeof(MmStruct));
+}
+
+static void cache_clear(MmStruct* mm) {
+    memset(mm->cache, 0, sizeof(mm->cache));
+}
+
+static int insert_vma(MmStruct* mm, Vma* vma) {
+    if(extent_tree_insert(&mm->vmas, vma->start, (uint64_t)(uintptr_t)vma, 0) != 0) {
+        return -1;
+    }
+    mm->count++;
+    return 0;
+}
+
+static void erase_vma(MmStruct* mm, Vma* vma) {
+    extent_tree_remove(&mm->vmas, vma->start, (uint64_t)(uintptr_t)vma);
+    mm->count--;
+    free(vma);
+}
+
+// Region holding a page, without touching the cache or the counters
+static Vma* vma_at(MmStruct* mm, uint64_t page) {
+    ExtentNode* node = extent_tree_floor(&mm->vmas, page);
+    if(node == NULL || VMA_OF(node)->end <= page) {
+        return NULL;
+    }
+    return VMA_OF(node);
+}
+
+// Region holding a page, NULL if the page is not mapped
+Vma* vma_find(MmStruct* mm, uint64_t page) {
+    vma_stats.lookups++;
+
+    for(int i = 0; i < VMA_CACHE_SIZE; i++) {
+        Vma* vma = mm->cache[i];
+        if(vma != NULL && page >= vma->start && page < vma->end) {
+            vma_stats.cache_hits++;
+            return vma;
+        }
+    }
+
+    Vma* vma = vma_at(mm, page);
+    if(vma != NULL) {
+        mm->cache[page % VMA_CACHE_SIZE] = vma;
+    }
+    return vma;
+}
+
+// First region ending after a page, for walks in address order
+Vma* vma_next(MmStruct* mm, uint64_t page) {
+    Vma* vma = vma_at(mm, page);
+    if(vma != NULL) {
+        return vma;
+    }
+    ExtentNode* node = extent_tree_lower_bound(&mm->vmas, page, 0);
+    return node != NULL ? VMA_OF(node) : NULL;
+}
+
+// ==================== GAPS ====================
+
+// True if no region touches [start, end)
+static bool range_free(MmStruct* mm, uint64_t start, uint64_t end) {
+    ExtentNode* gap = extent_tree_floor(&mm->gaps, start);
+    return gap != NULL && gap->key + gap->length >= end;
+}
+
+// Take a free range out of the gap holding it
+static void gap_take(MmStruct* mm, uint64_t start, uint64_t end) {
+    ExtentNode* gap = extent_tree_floor(&mm->gaps, start);
+    uint64_t gap_start = gap->key;
+    uint64_t gap_end = gap->key + gap->length;
+
+    extent_tree_remove(&mm->gaps, gap_start, 0);
+    if(gap_start < start) {
+        extent_tree_insert(&mm->gaps, gap_start, 0, start - gap_start);
+    }
+    if(end < gap_end) {
+        extent_tree_insert(&mm->gaps, end, 0, gap_end - end);
+    }
+}
+
+// Return a range to the gaps, joining the gaps on either side
+static void gap_release(MmStruct* mm, uint64_t start, uint64_t end) {
+    ExtentNode* before = start > 0 ? extent_tree_floor(&mm->gaps, start - 1) : NULL;
+    if(before != NULL && before->key + before->length == start) {
+        uint64_t key = before->key;
+        extent_tree_remove(&mm->gaps, key, 0);
+        start = key;
+    }
+
+    ExtentNode* after = extent_tree_find(&mm->gaps, end, 0);
+    if(after != NULL) {
+        uint64_t after_end = after->key + after->length;
+        extent_tree_remove(&mm->gaps, end, 0);
+        end = after_end;
+    }
+
+    extent_tree_insert(&mm->gaps, start, 0, end - start);
+}
+
+// ==================== SPLIT AND MERGE ====================
+
+// Adjacent regions that one region could describe
+static bool can_merge(const Vma* low, const Vma* high) {
+    return low->end == high->start &&
+           low->prot == high->prot &&
+           low->flags == high->flags &&
+           low->file_id == high->file_id &&
+           (low->file_id == -1 || low->file_offset + (low->end - low->start) == high->file_offset);
+}
+
+// Cut a region in two at a page, returns the upper part or NULL
+static Vma* split_vma(MmStruct* mm, Vma* vma, uint64_t at) {
+    Vma* upper = (Vma*)malloc(sizeof(Vma));
+    if(upper == NULL) {
+        return NULL;
+    }
+
+    *upper = *vma;
+    upper->start = at;
+    if(vma->file_id != -1) {
+        upper->file_offset += at - vma->start;
+    }
+    vma->end = at;
+    if(insert_vma(mm, upper) != 0) {
+        vma->end = upper->end;
+        free(upper);
+        return NULL;
+    }
+
+    vma_stats.splits++;
+    cache_clear(mm);
+    return upper;
+}
+
+// Merge matching neighbours among the regions touching [start, end]
+static void merge_range(MmStruct* mm, uint64_t start, uint64_t end) {
+    Vma* vma = vma_next(mm, start > 0 ? start - 1 : 0);
+
+    while(vma != NULL && vma->start <= end) {
+        ExtentNode* node = extent_tree_lower_bound(&mm->vmas, vma->end, 0);
+        Vma* next = node != NULL ? VMA_OF(node) : NULL;
+
+        if(next != NULL && can_merge(vma, next)) {
+            vma->end = next->end;
+            erase_vma(mm, next);
+            vma_stats.merges++;
+        } else {
+            vma = next;
+        }
+    }
+    cache_clear(mm);
+}
+
+// ==================== MAP, UNMAP, PROTECT ====================
+
+// Map a region over free pages, VMA_ANY for the lowest hole that fits.
+// Returns the region now holding it (merged with matching neighbours) or NULL
+Vma* vma_map(MmStruct* mm, uint64_t start, uint64_t pages, int prot, int flags,
+             int file_id, uint64_t file_offset) {
+    if(pages == 0) {
+        return NULL;
+    }
+
+    if(start == VMA_ANY) {
+        ExtentNode* gap = extent_tree_first_fit(&mm->gaps, pages);
+        if(gap == NULL) {
+            return NULL;
+        }
+        start = gap->key;
+    } else if(start >= mm->pages || pages > mm->pages - start ||
+              !range_free(mm, start, start + pages)) {
+        return NULL;
+    }
+
+    Vma* vma = (Vma*)malloc(sizeof(Vma));
+    if(vma == NULL) {
+        return NULL;
+    }
+    vma->start = start;
+    vma->end = start + pages;
+    vma->prot = prot;
+    vma->flags = flags;
+    vma->file_id = file_id;
+    vma->file_offset = file_offset;
+    memset(&vma->ra, 0, sizeof(vma->ra));
+    vma->ra.prev_offset = -1;
+
+    if(insert_vma(mm, vma) != 0) {
+        free(vma);
+        return NULL;
+    }
+    gap_take(mm, start, start + pages);
+    merge_range(mm, start, start + pages);
+    return vma_at(mm, start);
+}
+
+// Remove every region inside a range, splitting those that straddle its ends
+int vma_unmap(MmStruct* mm, uint64_t start, uint64_t pages) {
+    if(pages == 0 || start >= mm->pages || pages > mm->pages - start) {
+        return -1;
+    }
+    uint64_t end = start + pages;
+
+    Vma* first = vma_at(mm, start);
+    if(first != NULL && first->start < start && split_vma(mm, first, start) == NULL) {
+        return -1;
+    }
+
+    ExtentNode* node;
+    while((node = extent_tree_lower_bound(&mm->vmas, start, 0)) != NULL && node->key < end) {
+        Vma* vma = VMA_OF(node);
+        if(vma->end > end && split_vma(mm, vma, end) == NULL) {
+            return -1;
+        }
+
+        uint64_t vma_start = vma->start;
+        uint64_t vma_end = vma->end;
+        erase_vma(mm, vma);
+        gap_release(mm, vma_start, vma_end);
+    }
+
+    cache_clear(mm);
+    return 0;
+}
+
+// Change the protection of a fully mapped range
+int vma_protect(MmStruct* mm, uint64_t start, uint64_t pages, int prot) {
+    if(pages == 0 || start >= mm->pages || pages > mm->pages - start) {
+        return -1;
+    }
+    uint64_t end = start + pages;
+
+    // Regions must cover the range without holes
+    for(uint64_t page = start; page < end; ) {
+        Vma* vma = vma_at(mm, page);
+        if(vma == NULL) {
+            return -1;
+        }
+        page = vma->end;
+    }
+
+    Vma* vma = vma_at(mm, start);
+    if(vma->start < start && (vma = split_vma(mm, vma, start)) == NULL) {
+        return -1;
+    }
+    while(vma != NULL && vma->start < end) {
+        if(vma->end > end && split_vma(mm, vma, end) == NULL) {
+            return -1;
+        }
+        vma->prot = prot;
+        vma = vma_at(mm, vma->end);
+    }
+
+    merge_range(mm, start, end);
+    return 0;
+}
+
+// Copy every region of one address space into another; readahead starts over
+int mm_copy(MmStruct* dst, MmStruct* src) {
+    mm_destroy(dst);
+    mm_init(dst, src->pages);
+
+    for(Vma* vma = vma_next(src, 0); vma != NULL; vma = vma_next(src, vma->end)) {
+        if(vma_map(dst, vma->start, vma->end - vma->start, vma->prot, vma->flags,
+                   vma->file_id, vma->file_offset) == NULL) {
+            return -1;
+        }
+    }
+    dst->start_brk = src->start_brk;
+    dst->brk = src->brk;
+    return 0;
+}
+
+// ==================== PROCESS ADDRESS SPACES ====================
+
+// Free every address space and clear the counters
+void reset_vma() {
+    for(int pid = 0; pid < MAX_PROCESSES; pid++) {
+        mm_destroy(&process_mms[pid]);
+    }
+    memset(&vma_stats, 0, sizeof(vma_stats));
+}
+
+// Address space of a process slot
+MmStruct* process_mm(int pid) {
+    return (pid >= 0 && pid < MAX_PROCESSES) ? &process_mms[pid] : NULL;
+}
+
+// Layout of a new process: heap over the lower half, stack over the upper half
+void vma_default_layout(int pid) {
+    MmStruct* mm = &process_mms[pid];
+
+    mm_destroy(mm);
+    mm_init(mm, MAX_PAGES);
+    vma_map(mm, 0, MAX_PAGES / 2, VMA_READ | VMA_WRITE, VMA_GROWSUP, -1, 0);
+    vma_map(mm, MAX_PAGES / 2, MAX_PAGES - MAX_PAGES / 2, VMA_READ | VMA_WRITE,
+            VMA_GROWSDOWN, -1, 0);
+    mm->start_brk = 0;
+    mm->brk = MAX_PAGES / 2;
+}
+
+static bool valid_process(int pid) {
+    if(pid < 0 || pid >= MAX_PROCESSES || processes[pid].pid == -1) {
+        printf("Error: Invalid process %d\n", pid);
+        return false;
+    }
+    return true;
+}
+
+// Drop the pages of a range from memory and swap, uncharging them
+static void release_pages(int pid, uint64_t start, uint64_t end) {
+    for(uint64_t page = start; page < end && page < MAX_PAGES; page++) {
+        PageTableEntry* entry = &processes[pid].page_table[page];
+        if(entry->present) {
+            deallocate_page(pid, (int)page);
+        }
+        swap_discard(pid, (int)page);
+        uncharge_page(pid, (int)page);
+        entry->valid = false;
+        entry->modified = false;
+        entry->referenced = false;
+    }
+}
+
+// Unmap a range: its pages are freed and any region inside it is removed
+int munmap_region(int pid, uint64_t start, uint64_t pages) {
+    if(!valid_process(pid)) {
+        return -1;
+    }
+    MmStruct* mm = &process_mms[pid];
+    if(pages == 0 || start >= mm->pages || pages > mm->pages - start) {
+        printf("Error: Range %llu+%llu outside the address space\n",
+               (unsigned long long)start, (unsigned long long)pages);
+        return -1;
+    }
+
+    release_pages(pid, start, start + pages);
+    return vma_unmap(mm, start, pages);
+}
+
+// Map a region, replacing whatever was mapped there before (MAP_FIXED);
+// VMA_ANY picks the lowest hole. Returns the start page or -1
+int64_t mmap_region(int pid, uint64_t start, uint64_t pages, int prot, int flags,
+                    int file_id, uint64_t file_offset) {
+    if(!valid_process(pid)) {
+        return -1;
+    }
+    MmStruct* mm = &process_mms[pid];
+
+    if(start == VMA_ANY) {
+        ExtentNode* gap = extent_tree_first_fit(&mm->gaps, pages);
+        if(gap == NULL) {
+            printf("Error: No hole of %llu pages in Process %d\n", (unsigned long long)pages, pid);
+            return -1;
+        }
+        start = gap->key;
+    } else if(munmap_region(pid, start, pages) != 0) {
+        return -1;
+    }
+
+    if(vma_map(mm, start, pages, prot, flags, file_id, file_offset) == NULL) {
+        printf("Error: Cannot map %llu pages at %llu\n",
+               (unsigned long long)pages, (unsigned long long)start);
+        return -1;
+    }
+    return (int64_t)start;
+}
+
+// Change the protection of a mapped range
+int mprotect_region(int pid, uint64_t start, uint64_t pages, int prot) {
+    if(!valid_process(pid)) {
+        return -1;
+    }
+    if(vma_protect(&process_mms[pid], start, pages, prot) != 0) {
+        printf("Error: Range %llu+%llu is not fully mapped\n",
+               (unsigned long long)start, (unsigned long long)pages);
+        return -1;
+    }
+    return 0;
+}
+
+// Move the end of the heap; growing merges into the heap region, shrinking unmaps
+int process_brk(int pid, uint64_t new_brk) {
+    if(!valid_process(pid)) {
+        return -1;
+    }
+    MmStruct* mm = &process_mms[pid];
+    if(new_brk < mm->start_brk || new_brk > mm->pages) {
+        printf("Error: Break %llu outside the heap\n", (unsigned long long)new_brk);
+        return -1;
+    }
+
+    if(new_brk > mm->brk) {
+        if(vma_map(mm, mm->brk, new_brk - mm->brk, VMA_READ | VMA_WRITE, VMA_GROWSUP,
+                   -1, 0) == NULL) {
+            printf("Error: Heap cannot grow to %llu, the range is in use\n",
+                   (unsigned long long)new_brk);
+            return -1;
+        }
+    } else if(new_brk < mm->brk && munmap_region(pid, new_brk, mm->brk - new_brk) != 0) {
+        return -1;
+    }
+
+    mm->brk = new_brk;
+    return 0;
+}
+
+// A fault just below a stack extends it down, returns the stack or NULL
+static Vma* expand_stack(MmStruct* mm, uint64_t page) {
+    ExtentNode* node = extent_tree_lower_bound(&mm->vmas, page, 0);
+    if(node == NULL) {
+        return NULL;
+    }
+
+    Vma* stack = VMA_OF(node);
+    if(!(stack->flags & VMA_GROWSDOWN) || stack->start - page > VMA_STACK_GROWTH_LIMIT) {
+        return NULL;
+    }
+
+    // Nothing is mapped in between, or page would have been found
+    gap_take(mm, page, stack->start);
+    extent_tree_remove(&mm->vmas, stack->start, (uint64_t)(uintptr_t)stack);
+    stack->start = page;
+    extent_tree_insert(&mm->vmas, stack->start, (uint64_t)(uintptr_t)stack, 0);
+
+    // It may now touch the rest of a stack that was split by munmap
+    vma_stats.stack_expansions++;
+    merge_range(mm, page, page);
+    return vma_at(mm, page);
+}
+
+// Check a reference against the regions of its process, returns 0 or -1 on a fault
+int vma_check_access(int pid, int page_number, bool is_write) {
+    MmStruct* mm = &process_mms[pid];
+    Vma* vma = vma_find(mm, (uint64_t)page_number);
+
+    if(vma == NULL) {
+        vma = expand_stack(mm, (uint64_t)page_number);
+        if(vma != NULL) {
+            VPRINTF("  Stack of Process %d grown down to page %d\n", pid, page_number);
+        }
+    }
+    if(vma == NULL) {
+        vma_stats.segfaults++;
+        VPRINTF("  ✗ SEGMENTATION FAULT: Page %d of Process %d is not mapped\n", page_number, pid);
+        return -1;
+    }
+
+    if(!(vma->prot & (is_write ? VMA_WRITE : VMA_READ))) {
+        vma_stats.protection_faults++;
+        VPRINTF("  ✗ PROTECTION FAULT: %s of page %d of Process %d\n",
+                is_write ? "Write" : "Read", page_number, pid);
+        return -1;
+    }
+    return 0;
+}
+
+// The child of a fork starts with a copy of its parent's regions
+void vma_fork(int parent, int child) {
+    if(mm_copy(&process_mms[child], &process_mms[parent]) != 0) {
+        printf("Error: Out of memory copying the regions of Process %d\n", parent);
+    }
+}
+
+// Free the regions of a terminating process
+void vma_release_process(int pid) {
+    if(pid >= 0 && pid < MAX_PROCESSES) {
+        mm_destroy(&process_mms[pid]);
+    }
+}
+
+// List the regions of a process, as /proc/pid/maps
+void display_vmas(int pid) {
+    MmStruct* mm = process_mm(pid);
+    if(mm == NULL) {
+        return;
+    }
+
+    printf("\nAddress Space (%d regions, brk at page %llu):\n", mm->count,
+           (unsigned long long)mm->brk);
+    printf("Start    End  Perm  Pages  Mapping\n");
+    printf("-----  -----  ----  -----  -------\n");
+
+    for(Vma* vma = vma_next(mm, 0); vma != NULL; vma = vma_next(mm, vma->end)) {
+        char mapping[48];
+        if(vma->file_id >= 0 && vma->file_id < MAX_FILES) {
+            snprintf(mapping, sizeof(mapping), "%s +%llu", sim_files[vma->file_id].name,
+                     (unsigned long long)vma->file_offset);
+        } else {
+            snprintf(mapping, sizeof(mapping), "%s",
+                     (vma->flags & VMA_GROWSUP) ? "[heap]" :
+                     (vma->flags & VMA_GROWSDOWN) ? "[stack]" : "[anon]");
+        }
+
+        printf("%5llu  %5llu  %c%c%c%c  %5llu  %s\n",
+               (unsigned long long)vma->start, (unsigned long long)vma->end,
+               (vma->prot & VMA_READ) ? 'r' : '-',
+               (vma->prot & VMA_WRITE) ? 'w' : '-',
+               (vma->prot & VMA_EXEC) ? 'x' : '-',
+               (vma->flags & VMA_SHARED) ? 's' : 'p',
+               (unsigned long long)(vma->end - vma->start), mapping);
+    }
+}
+
+// ==================== BENCHMARK ====================
+
+static double elapsed_ns(struct timespec* begin, struct timespec* end) {
+    return (end->tv_sec - begin->tv_sec) * 1e9 + (end->tv_nsec - begin->tv_nsec);
+}
+
+// Region holding a page by scanning every region in address order
+static Vma* linear_find(Vma** regions, int count, uint64_t page, unsigned long long* visits) {
+    for(int i = 0; i < count; i++) {
+        (*visits)++;
+        if(regions[i]->end > page) {
+            return regions[i]->start <= page ? regions[i] : NULL;
+        }
+    }
+    return NULL;
+}
+
+// Next page to look up: uniform, or mostly a few pages on from the last one
+static uint64_t next_lookup(WorkloadRng* rng, uint64_t span, bool local, uint64_t last) {
+    if(!local || workload_rng_bounded(rng, 8) == 0) {
+        return workload_rng_next(rng) % span;
+    }
+    return (last + workload_rng_bounded(rng, 3)) % span;
+}
+
+// Lookup and split/merge cost with many regions
+void run_vma_benchmark(int mappings, uint64_t seed) {
+    const int lookups = 20000;
+    const int churn = 5000;
+    const char* pattern_names[2] = { "Random", "Local" };
+
+    if(mappings < 1) {
+        printf("Error: Mappings must be positive\n");
+        return;
+    }
+
+    MmStruct mm;
+    mm_init(&mm, 1ULL << 36);
+    WorkloadRng rng;
+    workload_rng_seed(&rng, seed);
+
+    // Regions of 1-16 pages with a hole after each, so none merge
+    uint64_t cursor = 0;
+    for(int i = 0; i < mappings; i++) {
+        uint64_t pages = 1 + workload_rng_bounded(&rng, 16);
+        int prot = (i % 3 == 0) ? VMA_READ : VMA_READ | VMA_WRITE;
+        if(vma_map(&mm, cursor, pages, prot, 0, -1, 0) == NULL) {
+            printf("Error: Out of memory building %d regions\n", mappings);
+            mm_destroy(&mm);
+            return;
+        }
+        cursor += pages + 1 + workload_rng_bounded(&rng, 4);
+    }
+
+    Vma** regions = (Vma**)malloc(mappings * sizeof(Vma*));
+    uint64_t* pages = (uint64_t*)malloc(lookups * sizeof(uint64_t));
+    if(regions == NULL || pages == NULL) {
+        printf("Error: Out of memory\n");
+        free(regions);
+        free(pages);
+        mm_destroy(&mm);
+        return;
+    }
+    int count = 0;
+    for(Vma* vma = vma_next(&mm, 0); vma != NULL; vma = vma_next(&mm, vma->end)) {
+        regions[count++] = vma;
+    }
+
+    printf("\n========== VMA TREE BENCHMARK ==========\n");
+    printf("Regions: %d over %llu pages, %d lookups per run, seed %llu\n",
+           count, (unsigned long long)cursor, lookups, (unsigned long long)seed);
+
+    printf("\nLookup         Pattern  ns/lookup  Nodes/lookup  Cache hits  Found\n");
+    printf("------------   -------  ---------  ------------  ----------  -----\n");
+
+    VmaStats saved_stats = vma_stats;
+    for(int local = 0; local <= 1; local++) {
+        uint64_t last = 0;
+        for(int i = 0; i < lookups; i++) {
+            last = next_lookup(&rng, cursor, local != 0, last);
+            pages[i] = last;
+        }
+
+        for(int method = 0; method < 3; method++) {
+            struct timespec begin, end;
+            unsigned long long visits = 0;
+            int found = 0;
+
+            memset(&vma_stats, 0, sizeof(vma_stats));
+            cache_clear(&mm);
+            mm.vmas.visits = 0;
+
+            clock_gettime(CLOCK_MONOTONIC, &begin);
+            for(int i = 0; i < lookups; i++) {
+                Vma* vma = method == 0 ? linear_find(regions, count, pages[i], &visits) :
+                           method == 1 ? vma_at(&mm, pages[i]) : vma_find(&mm, pages[i]);
+                found += (vma != NULL);
+            }
+            clock_gettime(CLOCK_MONOTONIC, &end);
+            if(method > 0) {
+                visits = mm.vmas.visits;
+            }
+
+            printf("%-12s   %-7s  %9.1f  %12.1f  %9.1f%%  %5d\n",
+                   method == 0 ? "Linear scan" : method == 1 ? "Tree" : "Tree + cache",
+                   pattern_names[local], elapsed_ns(&begin, &end) / lookups,
+                   (double)visits / lookups,
+                   method == 2 ? 100.0 * vma_stats.cache_hits / lookups : 0.0, found);
+        }
+    }
+
+    // mprotect the middle of a region (two splits), then back (two merges)
+    memset(&vma_stats, 0, sizeof(vma_stats));
+    int protected_ops = 0;
+    struct timespec begin, end;
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    for(int i = 0; i < churn; i++) {
+        Vma* vma = vma_at(&mm, regions[workload_rng_bounded(&rng, count)]->start);
+        uint64_t size = vma->end - vma->start;
+        if(size < 3) {
+            continue;
+        }
+        uint64_t start = vma->start + 1;
+        int prot = vma->prot;
+        vma_protect(&mm, start, size - 2, prot | VMA_EXEC);
+        vma_protect(&mm, start, size - 2, prot);
+        protected_ops += 2;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    printf("\nmprotect churn: %d calls, %llu splits, %llu merges, %.1f ns/call\n",
+           protected_ops, vma_stats.splits, vma_stats.merges,
+           protected_ops > 0 ? elapsed_ns(&begin, &end) / protected_ops : 0.0);
+    printf("Regions afterwards: %d (was %d)\n", mm.count, count);
+
+    printf("\nThe tree visits about log2(n) nodes where the scan visits n/2 regions;\n");
+    printf("the last-hit cache answers most lookups of a local pattern without either.\n");
+    printf("========================================\n");
+
+    vma_stats = saved_stats;
+    free(regions);
+    free(pages);
+    mm_destroy(&mm);
+}
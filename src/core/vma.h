@@ -0,0 +1,95 @@
+/**
+ * vma.h
+ * Virtual memory areas: per-process address-space regions module header
+ */
+
+#ifndef VMA_H
+#define VMA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../../include/common_defs.h"
+#include "../utils/extent_tree.h"
+
+// Protection bits
+#define VMA_READ 1
+#define VMA_WRITE 2
+#define VMA_EXEC 4
+
+// Region flags
+#define VMA_SHARED 1        // Writes to a file mapping reach the file
+#define VMA_GROWSUP 2       // Heap, moved by brk
+#define VMA_GROWSDOWN 4     // Stack, extended by faults just below it
+
+#define VMA_ANY UINT64_MAX              // Let the layer pick the address
+#define VMA_CACHE_SIZE 4                // Last-hit slots per address space
+#define VMA_STACK_GROWTH_LIMIT 4        // Pages below a stack a fault may extend it by
+
+// Readahead state of a file region, as struct file_ra_state
+typedef struct {
+    int start;          // First page of the current window
+    int size;           // Pages in the window, 0 after a random miss
+    int async_size;     // Trailing pages; hitting the first starts the next window
+    int prev_offset;    // Last page faulted, -1 before the first
+} ReadaheadState;
+
+// One region of an address space, in pages
+typedef struct {
+    uint64_t start;
+    uint64_t end;           // Exclusive
+    int prot;
+    int flags;
+    int file_id;            // -1 for anonymous memory
+    uint64_t file_offset;   // File page mapped at start
+    ReadaheadState ra;
+} Vma;
+
+// An address space: regions and the gaps between them, both ordered by address
+typedef struct {
+    ExtentTree vmas;        // Keyed by start, tie holds the Vma
+    ExtentTree gaps;        // Keyed by start, length in pages
+    uint64_t pages;         // Size of the address space
+    uint64_t start_brk;
+    uint64_t brk;
+    int count;
+    Vma* cache[VMA_CACHE_SIZE];     // Indexed by page, cleared when regions change
+} MmStruct;
+
+typedef struct {
+    unsigned long long lookups;
+    unsigned long long cache_hits;
+    unsigned long long splits;
+    unsigned long long merges;
+    unsigned long long stack_expansions;
+    unsigned long long segfaults;
+    unsigned long long protection_faults;
+} VmaStats;
+
+extern VmaStats vma_stats;
+
+// Function Prototypes
+void mm_init(MmStruct* mm, uint64_t pages);
+void mm_destroy(MmStruct* mm);
+int mm_copy(MmStruct* dst, MmStruct* src);
+Vma* vma_find(MmStruct* mm, uint64_t page);
+Vma* vma_next(MmStruct* mm, uint64_t page);
+Vma* vma_map(MmStruct* mm, uint64_t start, uint64_t pages, int prot, int flags,
+             int file_id, uint64_t file_offset);
+int vma_unmap(MmStruct* mm, uint64_t start, uint64_t pages);
+int vma_protect(MmStruct* mm, uint64_t start, uint64_t pages, int prot);
+
+void reset_vma();
+MmStruct* process_mm(int pid);
+void vma_default_layout(int pid);
+int64_t mmap_region(int pid, uint64_t start, uint64_t pages, int prot, int flags,
+                    int file_id, uint64_t file_offset);
+int munmap_region(int pid, uint64_t start, uint64_t pages);
+int mprotect_region(int pid, uint64_t start, uint64_t pages, int prot);
+int process_brk(int pid, uint64_t new_brk);
+int vma_check_access(int pid, int page_number, bool is_write);
+void vma_fork(int parent, int child);
+void vma_release_process(int pid);
+void display_vmas(int pid);
+void run_vma_benchmark(int mappings, uint64_t seed);
+
+#endif // VMA_H
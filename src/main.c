@@ -12,11 +12,37 @@
 #include "core/paging.h"
 #include "core/segmentation.h"
 #include "core/virtual_memory.h"
+#include "core/load_control.h"
+#include "core/scheduler.h"
+#include "core/compaction.h"
+#include "core/paged_segmentation.h"
+#include "core/cow.h"
+#include "core/ksm.h"
+#include "core/overcommit.h"
+#include "core/page_cache.h"
+#include "core/prefetch.h"
+#include "core/vma.h"
+#include "core/tiering.h"
+#include "core/numa.h"
+#include "core/latency.h"
+#include "core/timeline.h"
 #include "algorithms/fifo.h"
 #include "algorithms/lru.h"
 #include "algorithms/optimal.h"
 #include "visualization/console_gui.h"
 #include "visualization/memory_display.h"
+#include "trace/trace_reader.h"
+#include "trace/trace_binary.h"
+#include "trace/trace_mmap.h"
+#include "trace/replay.h"
+#include "trace/locality.h"
+#include "trace/workload.h"
+#include "trace/proc_sampler.h"
+#include "trace/heap_events.h"
+#include "allocators/heap_sim.h"
+#include "allocators/buddy.h"
+#include "allocators/slab.h"
+#include "allocators/segment_alloc.h"
 #include "utils/helpers.h"
 #include "utils/logger.h"
 
@@ -28,7 +54,390 @@ int current_time = 0;
 int algorithm_type = 0;  // Default: FIFO
 int simulation_running = 0;
 
-int main() {
+// Print command-line usage for the batch tools
+static void print_usage(const char* program) {
+    printf("Usage: %s                         Interactive menu\n", program);
+    printf("       %s --thrashing-report [N]  Load control throughput comparison\n", program);
+    printf("       %s --scheduler-report [N]  Scheduling policy / TLB mode comparison\n", program);
+    printf("       %s --replay <lackey|pin|perf> <trace|-> [pid]\n", program);
+    printf("                                  Replay a recorded memory trace\n");
+    printf("       %s --convert <lackey|pin|perf> <trace|-> <out.dmvt> [pid]\n", program);
+    printf("                                  Convert a text trace to the binary format\n");
+    printf("       %s --replay-bin <trace.dmvt> [threads]\n", program);
+    printf("                                  Replay a binary trace via mmap and parallel decoders\n");
+    printf("       %s --trace-info <trace.dmvt> Show binary trace header and blocks\n", program);
+    printf("       %s --decode-bench <trace.dmvt> [threads]\n", program);
+    printf("                                  Measure serial and pipelined decode rate\n");
+    printf("       %s --workload <name> [N] [seed]  Replay a synthetic workload\n", program);
+    printf("       %s --workload-trace <name> <N> <out.dmvt> [seed]\n", program);
+    printf("                                  Write a synthetic workload as a binary trace\n");
+    printf("       %s --workload-bench <name> [N] [seed]\n", program);
+    printf("                                  Measure workload generation rate\n");
+    printf("       Workloads: uniform zipf scan loop stride hotcold locality phased mix\n");
+    printf("       %s --sample <pid> [intervals] [ms] [method] [out.dmvt]\n", program);
+    printf("                                  Sample page accesses of a live process\n");
+    printf("                                  (method: auto idle softdirty residency)\n");
+    printf("       %s --heap-events <events.bin|unix:path>\n", program);
+    printf("                                  Replay heap events recorded by libheapshim.so\n");
+    printf("       %s --heap-sim [N|events.bin] [seed]\n", program);
+    printf("                                  Compare heap placement strategies on a trace\n");
+    printf("       %s --buddy-report [frames] [N] [seed]\n", program);
+    printf("                                  Buddy allocator churn and fragmentation per order\n");
+    printf("       %s --slab-sim [N|events.bin] [cpus] [seed]\n", program);
+    printf("                                  Slab caches with per-CPU magazines vs. none\n");
+    printf("       %s --segment-bench [segments] [N] [seed]\n", program);
+    printf("                                  Segment placement churn under each fit strategy\n");
+    printf("       %s --translation-report [refs] [seed]\n", program);
+    printf("                                  Per-level cost of paging, segmentation and paged segmentation\n");
+    printf("       %s --compact [budget] [seed]\n", program);
+    printf("                                  Fragment frames and segments, then compact in budgeted steps\n");
+    printf("       %s --fork-sim [workers] [refs] [write%%] [seed]\n", program);
+    printf("                                  Fork pre-warmed workers and track copy-on-write RSS growth\n");
+    printf("       %s --ksm-sim [vms] [pages/tick] [ticks] [seed]\n", program);
+    printf("                                  Merge identical pages across near-identical VMs\n");
+    printf("       %s --overcommit-sim [swap slots] [seed]\n", program);
+    printf("                                  Demand-zero savings and OOM behaviour of each overcommit policy\n");
+    printf("       %s --page-cache-sim [readers] [seed]\n", program);
+    printf("                                  Page cache hits and readahead efficiency for shared file mappings\n");
+    printf("       %s --prefetch-sim [refs] [seed]\n", program);
+    printf("                                  Accuracy, coverage and pollution of each fault-path prefetcher\n");
+    printf("       %s --vma-bench [mappings] [seed]\n", program);
+    printf("                                  Region lookup, split and merge cost with many mappings\n");
+    printf("       %s --tier-sim [refs] [seed]\n", program);
+    printf("                                  Accesses per tier and effective latency of each tiering policy\n");
+    printf("       %s --numa-sim [refs] [seed]\n", program);
+    printf("                                  Local share and memory latency of each NUMA placement policy\n");
+    printf("       %s --latency-sim [refs] [seed] [name=ns ...]\n", program);
+    printf("                                  Latency components and percentiles with disk and compressed swap\n");
+    printf("       %s --timeline-sim [refs] [seed]\n", program);
+    printf("                                  Hit ratio per window across alternating program phases\n");
+    printf("       %s --locality <lackey|pin|perf> <trace|-> [pid]\n", program);
+    printf("                                  Replay a trace with per-process reuse distances and phases\n");
+    printf("       %s --locality-sim [refs] [seed]\n", program);
+    printf("                                  Reuse distances and per-phase working sets of a phased workload\n");
+}
+
+// Batch tools that run without the interactive menu
+static int run_command_line(int argc, char* argv[]) {
+    if(strcmp(argv[1], "--thrashing-report") == 0) {
+        int refs = (argc > 2) ? atoi(argv[2]) : 200;
+        run_load_control_comparison(refs);
+        return 0;
+    }
+    
+    if(strcmp(argv[1], "--scheduler-report") == 0) {
+        int refs = (argc > 2) ? atoi(argv[2]) : 200;
+        run_scheduler_comparison(refs);
+        return 0;
+    }
+    
+    if(strcmp(argv[1], "--replay") == 0 && argc > 3) {
+        TraceFormat format = trace_format_from_name(argv[2]);
+        int default_pid = (argc > 4) ? atoi(argv[4]) : -1;
+        
+        verbose_mode = 0;
+        init_memory_system();
+        replay_reset();
+        if(replay_trace_file(argv[3], format, default_pid) != 0) {
+            return 1;
+        }
+        display_replay_report();
+        display_statistics();
+        display_timeline();
+        display_memory_map();
+        return 0;
+    }
+    
+    if(strcmp(argv[1], "--convert") == 0 && argc > 4) {
+        TraceFormat format = trace_format_from_name(argv[2]);
+        int default_pid = (argc > 5) ? atoi(argv[5]) : -1;
+        
+        if(trace_convert_text(argv[3], format, default_pid, argv[4]) != 0) {
+            return 1;
+        }
+        display_trace_binary_info(argv[4]);
+        return 0;
+    }
+    
+    if(strcmp(argv[1], "--replay-bin") == 0 && argc > 2) {
+        verbose_mode = 0;
+        init_memory_system();
+        replay_reset();
+        int threads = (argc > 3) ? atoi(argv[3]) : 0;
+        if(replay_mapped_trace(argv[2], threads) != 0) {
+            return 1;
+        }
+        display_replay_report();
+        display_statistics();
+        display_timeline();
+        display_memory_map();
+        return 0;
+    }
+    
+    if(strcmp(argv[1], "--trace-info") == 0 && argc > 2) {
+        display_trace_binary_info(argv[2]);
+        return 0;
+    }
+    
+    if(strcmp(argv[1], "--decode-bench") == 0 && argc > 2) {
+        int threads = (argc > 3) ? atoi(argv[3]) : 0;
+        if(benchmark_trace_decode(argv[2]) != 0) {
+            return 1;
+        }
+        return benchmark_mapped_decode(argv[2], threads) == 0 ? 0 : 1;
+    }
+    
+    if(strncmp(argv[1], "--workload", 10) == 0 && argc > 2) {
+        int writes_trace = strcmp(argv[1], "--workload-trace") == 0;
+        int seed_arg = writes_trace ? 5 : 4;
+        unsigned long long count = (argc > 3) ? strtoull(argv[3], NULL, 10) : 10000;
+        uint64_t seed = (argc > seed_arg) ? strtoull(argv[seed_arg], NULL, 10) : WORKLOAD_DEFAULT_SEED;
+        Workload workload;
+        int status = -1;
+        
+        workload_init(&workload, seed);
+        if(workload_preset(&workload, argv[2], MAX_PAGES) == 0) {
+            if(writes_trace && argc > 4) {
+                status = workload_write_trace(&workload, count, argv[4]);
+                if(status == 0) {
+                    display_trace_binary_info(argv[4]);
+                }
+            } else if(strcmp(argv[1], "--workload-bench") == 0) {
+                workload_benchmark(&workload, count);
+                status = 0;
+            } else if(strcmp(argv[1], "--workload") == 0) {
+                verbose_mode = 0;
+                init_memory_system();
+                replay_reset();
+                status = workload_replay(&workload, count);
+                if(status == 0) {
+                    display_replay_report();
+                    display_statistics();
+                }
+            } else {
+                print_usage(argv[0]);
+            }
+        }
+        workload_free(&workload);
+        return status == 0 ? 0 : 1;
+    }
+    
+    if(strcmp(argv[1], "--sample") == 0 && argc > 2) {
+        int intervals = (argc > 3) ? atoi(argv[3]) : 10;
+        int interval_ms = (argc > 4) ? atoi(argv[4]) : 100;
+        SampleMethod method = (argc > 5) ? sample_method_from_name(argv[5]) : SAMPLE_AUTO;
+        
+        verbose_mode = 0;
+        init_memory_system();
+        replay_reset();
+        if(run_proc_sampler(atoi(argv[2]), intervals, interval_ms, method,
+                            (argc > 6) ? argv[6] : NULL) != 0) {
+            return 1;
+        }
+        display_replay_report();
+        display_memory_map();
+        return 0;
+    }
+    
+    if(strcmp(argv[1], "--heap-events") == 0 && argc > 2) {
+        int status;
+        
+        verbose_mode = 0;
+        init_memory_system();
+        replay_reset();
+        if(strncmp(argv[2], "unix:", 5) == 0) {
+            status = heap_events_listen(argv[2] + 5);
+        } else {
+            status = heap_events_consume_file(argv[2]);
+        }
+        if(status != 0) {
+            return 1;
+        }
+        display_heap_event_report();
+        display_segment_table(heap_event_stats.pid);
+        display_memory_map();
+        return 0;
+    }
+    
+    if(strcmp(argv[1], "--heap-sim") == 0) {
+        HeapTrace trace;
+        char* end = NULL;
+        unsigned long long operations = (argc > 2) ? strtoull(argv[2], &end, 10) : 1000000;
+        int status;
+        
+        // A number asks for a synthetic trace, anything else is an event file
+        if(argc > 2 && (end == argv[2] || *end != '\0')) {
+            status = heap_trace_from_events(&trace, argv[2]);
+        } else {
+            uint64_t seed = (argc > 3) ? strtoull(argv[3], NULL, 10) : WORKLOAD_DEFAULT_SEED;
+            status = heap_trace_synthetic(&trace, operations, seed);
+        }
+        if(status != 0) {
+            return 1;
+        }
+        status = run_heap_sim_comparison(&trace);
+        heap_trace_free(&trace);
+        return status == 0 ? 0 : 1;
+    }
+    
+    if(strcmp(argv[1], "--buddy-report") == 0) {
+        int frames = (argc > 2) ? atoi(argv[2]) : 65536;
+        unsigned long long operations = (argc > 3) ? strtoull(argv[3], NULL, 10) : 1000000;
+        uint64_t seed = (argc > 4) ? strtoull(argv[4], NULL, 10) : WORKLOAD_DEFAULT_SEED;
+        run_buddy_benchmark(frames, operations, seed);
+        return 0;
+    }
+    
+    if(strcmp(argv[1], "--slab-sim") == 0) {
+        HeapTrace trace;
+        char* end = NULL;
+        unsigned long long operations = (argc > 2) ? strtoull(argv[2], &end, 10) : 1000000;
+        int cpus = (argc > 3) ? atoi(argv[3]) : 4;
+        int status;
+        
+        if(argc > 2 && (end == argv[2] || *end != '\0')) {
+            status = heap_trace_from_events(&trace, argv[2]);
+        } else {
+            uint64_t seed = (argc > 4) ? strtoull(argv[4], NULL, 10) : WORKLOAD_DEFAULT_SEED;
+            status = slab_trace_synthetic(&trace, operations, cpus, seed);
+        }
+        if(status != 0) {
+            return 1;
+        }
+        status = run_slab_comparison(&trace, cpus);
+        heap_trace_free(&trace);
+        return status == 0 ? 0 : 1;
+    }
+    
+    if(strcmp(argv[1], "--segment-bench") == 0) {
+        int segments = (argc > 2) ? atoi(argv[2]) : 4096;
+        unsigned long long operations = (argc > 3) ? strtoull(argv[3], NULL, 10) : 1000000;
+        uint64_t seed = (argc > 4) ? strtoull(argv[4], NULL, 10) : WORKLOAD_DEFAULT_SEED;
+        run_segment_benchmark(segments, operations, seed);
+        return 0;
+    }
+    
+    if(strcmp(argv[1], "--translation-report") == 0) {
+        int refs = (argc > 2) ? atoi(argv[2]) : 5000;
+        uint64_t seed = (argc > 3) ? strtoull(argv[3], NULL, 10) : WORKLOAD_DEFAULT_SEED;
+        run_translation_comparison(refs, seed);
+        return 0;
+    }
+    
+    if(strcmp(argv[1], "--compact") == 0) {
+        int budget = (argc > 2) ? atoi(argv[2]) : COMPACTION_STEP_BUDGET;
+        uint64_t seed = (argc > 3) ? strtoull(argv[3], NULL, 10) : WORKLOAD_DEFAULT_SEED;
+        run_compaction_demo(budget, seed);
+        return 0;
+    }
+    
+    if(strcmp(argv[1], "--fork-sim") == 0) {
+        int workers = (argc > 2) ? atoi(argv[2]) : MAX_PROCESSES - 1;
+        int refs = (argc > 3) ? atoi(argv[3]) : 200;
+        int write_percent = (argc > 4) ? atoi(argv[4]) : 20;
+        uint64_t seed = (argc > 5) ? strtoull(argv[5], NULL, 10) : WORKLOAD_DEFAULT_SEED;
+        run_fork_simulation(workers, refs, write_percent, seed);
+        return 0;
+    }
+    
+    if(strcmp(argv[1], "--ksm-sim") == 0) {
+        int vms = (argc > 2) ? atoi(argv[2]) : 4;
+        int pages_per_tick = (argc > 3) ? atoi(argv[3]) : KSM_DEFAULT_PAGES_PER_TICK;
+        int ticks = (argc > 4) ? atoi(argv[4]) : 100;
+        uint64_t seed = (argc > 5) ? strtoull(argv[5], NULL, 10) : WORKLOAD_DEFAULT_SEED;
+        run_ksm_simulation(vms, pages_per_tick, ticks, seed);
+        return 0;
+    }
+    
+    if(strcmp(argv[1], "--overcommit-sim") == 0) {
+        int slots = (argc > 2) ? atoi(argv[2]) : 20;
+        uint64_t seed = (argc > 3) ? strtoull(argv[3], NULL, 10) : WORKLOAD_DEFAULT_SEED;
+        run_overcommit_simulation(slots, seed);
+        return 0;
+    }
+    
+    if(strcmp(argv[1], "--page-cache-sim") == 0) {
+        int readers = (argc > 2) ? atoi(argv[2]) : 2;
+        uint64_t seed = (argc > 3) ? strtoull(argv[3], NULL, 10) : WORKLOAD_DEFAULT_SEED;
+        run_page_cache_simulation(readers, seed);
+        return 0;
+    }
+    
+    if(strcmp(argv[1], "--prefetch-sim") == 0) {
+        int refs = (argc > 2) ? atoi(argv[2]) : 2000;
+        uint64_t seed = (argc > 3) ? strtoull(argv[3], NULL, 10) : WORKLOAD_DEFAULT_SEED;
+        run_prefetch_simulation(refs, seed);
+        return 0;
+    }
+    
+    if(strcmp(argv[1], "--vma-bench") == 0) {
+        int mappings = (argc > 2) ? atoi(argv[2]) : 20000;
+        uint64_t seed = (argc > 3) ? strtoull(argv[3], NULL, 10) : WORKLOAD_DEFAULT_SEED;
+        run_vma_benchmark(mappings, seed);
+        return 0;
+    }
+    
+    if(strcmp(argv[1], "--tier-sim") == 0) {
+        int refs = (argc > 2) ? atoi(argv[2]) : 4000;
+        uint64_t seed = (argc > 3) ? strtoull(argv[3], NULL, 10) : WORKLOAD_DEFAULT_SEED;
+        run_tiering_simulation(refs, seed);
+        return 0;
+    }
+    
+    if(strcmp(argv[1], "--numa-sim") == 0) {
+        int refs = (argc > 2) ? atoi(argv[2]) : 4000;
+        uint64_t seed = (argc > 3) ? strtoull(argv[3], NULL, 10) : WORKLOAD_DEFAULT_SEED;
+        run_numa_simulation(refs, seed);
+        return 0;
+    }
+    
+    if(strcmp(argv[1], "--latency-sim") == 0) {
+        int refs = (argc > 2) ? atoi(argv[2]) : 20000;
+        uint64_t seed = (argc > 3) ? strtoull(argv[3], NULL, 10) : WORKLOAD_DEFAULT_SEED;
+        for(int i = 4; i < argc; i++) {
+            if(latency_config_set(argv[i]) != 0) {
+                return 1;
+            }
+        }
+        run_latency_simulation(refs, seed);
+        return 0;
+    }
+    
+    if(strcmp(argv[1], "--timeline-sim") == 0) {
+        int refs = (argc > 2) ? atoi(argv[2]) : 12000;
+        uint64_t seed = (argc > 3) ? strtoull(argv[3], NULL, 10) : WORKLOAD_DEFAULT_SEED;
+        run_timeline_simulation(refs, seed);
+        return 0;
+    }
+    
+    if(strcmp(argv[1], "--locality") == 0 && argc > 3) {
+        TraceFormat format = trace_format_from_name(argv[2]);
+        int default_pid = (argc > 4) ? atoi(argv[4]) : -1;
+        
+        verbose_mode = 0;
+        init_memory_system();
+        replay_reset();
+        locality_enabled = true;
+        if(replay_trace_file(argv[3], format, default_pid) != 0) {
+            return 1;
+        }
+        display_replay_report();
+        display_locality_report();
+        return 0;
+    }
+    
+    if(strcmp(argv[1], "--locality-sim") == 0) {
+        int refs = (argc > 2) ? atoi(argv[2]) : 24000;
+        uint64_t seed = (argc > 3) ? strtoull(argv[3], NULL, 10) : WORKLOAD_DEFAULT_SEED;
+        run_locality_simulation(refs, seed);
+        return 0;
+    }
+    
+    print_usage(argv[0]);
+    return 1;
+}
+
+int main(int argc, char* argv[]) {
     int choice;
     int pid, page_num, address;
     char process_name[50];
@@ -36,6 +445,10 @@ int main() {
     // Seed random number generator
     srand(time(NULL));
     
+    if(argc > 1) {
+        return run_command_line(argc, argv);
+    }
+    
     printf("\n");
     printf("╔════════════════════════════════════════════════════════════╗\n");
     printf("║          DYNAMIC MEMORY MANAGEMENT VISUALIZER             ║\n");
@@ -122,7 +535,7 @@ int main() {
                 
             case 5: // Paging System
                 display_paging_menu();
-                int paging_choice = get_integer_input("Enter choice: ", 1, 5);
+                int paging_choice = get_integer_input("Enter choice: ", 1, 9);
                 
                 switch(paging_choice) {
                     case 1: // Initialize Paging
@@ -143,7 +556,27 @@ int main() {
                         page_num = get_integer_input("Page number: ", 0, MAX_PAGES-1);
                         simulate_paging_fault(pid, page_num);
                         break;
-                    case 5: // Back
+                    case 5: // Compaction
+                        compact_memory();
+                        break;
+                    case 6: // Fork
+                        pid = get_integer_input("Process ID: ", 0, MAX_PROCESSES-1);
+                        if(fork_process(pid) != -1) {
+                            display_cow_stats();
+                        }
+                        break;
+                    case 7: // Same-page merging
+                        // Two passes: the first only records checksums
+                        ksm_scan(2 * MAX_PROCESSES * MAX_PAGES);
+                        display_ksm_stats();
+                        break;
+                    case 8: // Overcommit policy
+                        overcommit_policy = (OvercommitPolicy)get_integer_input(
+                            "Policy (0=Heuristic, 1=Always, 2=Never): ", 0, OVERCOMMIT_POLICY_COUNT - 1);
+                        overcommit_ratio = get_integer_input("Overcommit ratio (%): ", 0, 100);
+                        display_commit_accounting();
+                        break;
+                    case 9: // Back
                         break;
                 }
                 wait_for_enter();
@@ -151,7 +584,7 @@ int main() {
                 
             case 6: // Segmentation System
                 display_segmentation_menu();
-                int seg_choice = get_integer_input("Enter choice: ", 1, 5);
+                int seg_choice = get_integer_input("Enter choice: ", 1, 7);
                 
                 switch(seg_choice) {
                     case 1:
@@ -170,10 +603,19 @@ int main() {
                     case 4:
                         pid = get_integer_input("Process ID: ", 0, MAX_PROCESSES-1);
                         seg_num = get_integer_input("Segment number: ", 0, MAX_SEGMENTS-1);
-                        int base = get_integer_input("Base address: ", 0, 99999);
+                        int base = get_integer_input("Base address (-1 = auto): ", -1, SEGMENT_SPACE-1);
                         int limit = get_integer_input("Limit: ", 1, SEGMENT_SIZE);
                         create_segment(pid, seg_num, base, limit);
                         break;
+                    case 5:
+                        reverse_translate_address(get_integer_input("Physical address: ", 0, SEGMENT_SPACE-1));
+                        break;
+                    case 6:
+                        pid = get_integer_input("Process ID: ", 0, MAX_PROCESSES-1);
+                        seg_num = get_integer_input("Segment number: ", 0, MAX_SEGMENTS-1);
+                        offset = get_integer_input("Offset: ", 0, SEGMENT_SIZE-1);
+                        translate_paged_segment(pid, seg_num, offset);
+                        break;
                 }
                 wait_for_enter();
                 break;
@@ -238,15 +680,29 @@ int main() {
                 allocate_page(p2, 3);
                 allocate_page(p2, 4);
                 
-                // Access memory to generate page faults
-                printf("\nSimulating memory accesses...\n");
-                for(int i = 0; i < 10; i++) {
-                    int addr = random_int(0, MAX_PAGES * PAGE_SIZE - 1);
-                    access_memory(p1, addr);
-                    delay(500);  // Half second delay
+                // Give each process its own reference stream and let the
+                // scheduler interleave them on the shared frames
+                printf("\nSimulating interleaved memory accesses...\n");
+                MemoryReference demo_refs[2][5];
+                int demo_pids[2] = {p1, p2};
+                for(int p = 0; p < 2; p++) {
+                    for(int i = 0; i < 5; i++) {
+                        demo_refs[p][i].address = random_int(0, MAX_PAGES * PAGE_SIZE - 1);
+                        demo_refs[p][i].timestamp = i;
+                        demo_refs[p][i].pid = demo_pids[p];
+                        demo_refs[p][i].is_write = random_int(0, 3) == 0;
+                    }
                 }
                 
+                SchedulerConfig demo_config = scheduler_default_config();
+                demo_config.quantum = 2;
+                scheduler_reset();
+                scheduler_add_stream(p1, demo_refs[0], 5, 1);
+                scheduler_add_stream(p2, demo_refs[1], 5, 1);
+                scheduler_run(&demo_config);
+                
                 // Show results
+                display_scheduler_report(&demo_config);
                 display_statistics();
                 display_memory_map();
                 
@@ -0,0 +1,518 @@
+/**
+ * heap_shim.c
+ * LD_PRELOAD malloc/free/mmap interception shim
+ *
+ * Build:  make shim   (produces libheapshim.so)
+ * Use:    DMV_HEAP_TRACE=events.bin LD_PRELOAD=./libheapshim.so ./program
+ *
+ * Every intercepted call appends a HeapEvent to a ring owned by the
+ * calling thread: a single-producer/single-consumer ring, so recording is
+ * a few plain stores, one atomic sequence increment and one release
+ * store, with no locks and no system calls besides the vDSO clock. A
+ * background thread drains all rings about every millisecond, orders each
+ * batch by sequence number and writes it to the output file or socket.
+ * A thread that finds its ring full takes the drain lock and drains every
+ * ring itself, so bursts stall the thread instead of losing events. Only
+ * events that cannot be stored at all (no ring, or recording is shutting
+ * down) are dropped; they are counted and written into the stream as
+ * HEAP_EVENT_DROPPED records so the consumer knows its view is partial.
+ */
+
+#define _GNU_SOURCE
+#include <dlfcn.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/un.h>
+#include "heap_shim.h"
+
+#define SHIM_RING_EVENTS 32768          // Per thread, power of two
+#define SHIM_BOOTSTRAP_BYTES (64 * 1024)
+#define SHIM_DRAIN_INTERVAL_NS 1000000
+
+// Per-thread event ring
+typedef struct ShimRing {
+    _Atomic uint64_t head;              // Next slot the owner writes
+    _Atomic uint64_t tail;              // Next slot the drain thread reads
+    _Atomic uint64_t dropped;
+    uint64_t reported;                  // Drops already written, under drain_lock
+    _Atomic int owned;                  // Cleared when the owner thread exits
+    struct ShimRing* next;
+    HeapEvent events[SHIM_RING_EVENTS];
+} ShimRing;
+
+static void* (*real_malloc)(size_t);
+static void* (*real_calloc)(size_t, size_t);
+static void* (*real_realloc)(void*, size_t);
+static void (*real_free)(void*);
+static void* (*real_mmap)(void*, size_t, int, int, int, off_t);
+static int (*real_munmap)(void*, size_t);
+static int (*real_posix_memalign)(void**, size_t, size_t);
+static void* (*real_aligned_alloc)(size_t, size_t);
+static void* (*real_memalign)(size_t, size_t);
+
+// dlsym itself may allocate before the real allocator is known
+static char bootstrap[SHIM_BOOTSTRAP_BYTES];
+static size_t bootstrap_used = 0;
+static int resolving = 0;
+
+static _Atomic(ShimRing*) ring_list = NULL;
+static __thread ShimRing* thread_ring = NULL;
+static __thread int in_shim = 0;       // Ignore calls made by the shim itself
+static __thread uint32_t thread_id = 0;
+
+static _Atomic uint64_t sequence = 0;
+static _Atomic uint64_t lost = 0;       // Dropped before a ring was available
+static uint64_t lost_reported = 0;
+
+// Rings have a single consumer at a time: the drain thread, or a thread
+// whose ring is full
+static pthread_mutex_t drain_lock = PTHREAD_MUTEX_INITIALIZER;
+static HeapEvent* drain_batch = NULL;
+static size_t drain_capacity = 0;
+
+static _Atomic int shim_active = 0;
+static _Atomic int drain_running = 0;
+static pthread_t drain_thread;
+static pthread_key_t ring_key;
+static int output_fd = -1;
+static int output_is_socket = 0;
+
+// ==================== SYMBOL RESOLUTION ====================
+
+static void* bootstrap_alloc(size_t size) {
+    size = (size + 15) & ~(size_t)15;
+    if(bootstrap_used + size > SHIM_BOOTSTRAP_BYTES) {
+        return NULL;
+    }
+    void* block = bootstrap + bootstrap_used;
+    bootstrap_used += size;
+    return block;
+}
+
+static int is_bootstrap(const void* p) {
+    return (const char*)p >= bootstrap && (const char*)p < bootstrap + SHIM_BOOTSTRAP_BYTES;
+}
+
+static void resolve_symbols() {
+    if(real_malloc != NULL || resolving) {
+        return;
+    }
+    resolving = 1;
+    real_malloc = (void* (*)(size_t))dlsym(RTLD_NEXT, "malloc");
+    real_calloc = (void* (*)(size_t, size_t))dlsym(RTLD_NEXT, "calloc");
+    real_realloc = (void* (*)(void*, size_t))dlsym(RTLD_NEXT, "realloc");
+    real_free = (void (*)(void*))dlsym(RTLD_NEXT, "free");
+    real_mmap = (void* (*)(void*, size_t, int, int, int, off_t))dlsym(RTLD_NEXT, "mmap");
+    real_munmap = (int (*)(void*, size_t))dlsym(RTLD_NEXT, "munmap");
+    real_posix_memalign = (int (*)(void**, size_t, size_t))dlsym(RTLD_NEXT, "posix_memalign");
+    real_aligned_alloc = (void* (*)(size_t, size_t))dlsym(RTLD_NEXT, "aligned_alloc");
+    real_memalign = (void* (*)(size_t, size_t))dlsym(RTLD_NEXT, "memalign");
+    resolving = 0;
+}
+
+// ==================== RECORDING ====================
+
+// Reuse the ring of an exited thread, or map a new one
+static ShimRing* ring_acquire() {
+    for(ShimRing* ring = atomic_load(&ring_list); ring != NULL; ring = ring->next) {
+        int expected = 0;
+        if(atomic_compare_exchange_strong(&ring->owned, &expected, 1)) {
+            return ring;
+        }
+    }
+
+    void* memory = real_mmap(NULL, sizeof(ShimRing), PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(memory == MAP_FAILED) {
+        return NULL;
+    }
+
+    ShimRing* ring = (ShimRing*)memory;
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    atomic_init(&ring->dropped, 0);
+    ring->reported = 0;
+    atomic_init(&ring->owned, 1);
+
+    ShimRing* first = atomic_load(&ring_list);
+    do {
+        ring->next = first;
+    } while(!atomic_compare_exchange_weak(&ring_list, &first, ring));
+    return ring;
+}
+
+// Thread exit: the drain thread still empties the ring, then it is reused
+static void ring_release(void* ring) {
+    atomic_store(&((ShimRing*)ring)->owned, 0);
+}
+
+static size_t drain_now();
+
+static void record(uint32_t type, const void* address, size_t size, const void* old_address) {
+    if(in_shim || !atomic_load_explicit(&shim_active, memory_order_relaxed)) {
+        return;
+    }
+
+    ShimRing* ring = thread_ring;
+    if(ring == NULL) {
+        in_shim = 1;
+        ring = ring_acquire();
+        if(ring != NULL) {
+            pthread_setspecific(ring_key, ring);
+        }
+        thread_id = (uint32_t)syscall(SYS_gettid);
+        in_shim = 0;
+        if(ring == NULL) {
+            atomic_fetch_add_explicit(&lost, 1, memory_order_relaxed);
+            return;
+        }
+        thread_ring = ring;
+    }
+
+    // Full ring: drain on the spot rather than overwrite or drop
+    uint64_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    while(head - atomic_load_explicit(&ring->tail, memory_order_acquire) >= SHIM_RING_EVENTS) {
+        if(!atomic_load(&drain_running)) {
+            atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+            return;
+        }
+        in_shim = 1;
+        drain_now();
+        in_shim = 0;
+    }
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    HeapEvent* event = &ring->events[head & (SHIM_RING_EVENTS - 1)];
+    event->sequence = atomic_fetch_add_explicit(&sequence, 1, memory_order_relaxed);
+    event->timestamp_ns = (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+    event->address = (uint64_t)(uintptr_t)address;
+    event->size = size;
+    event->old_address = (uint64_t)(uintptr_t)old_address;
+    event->thread = thread_id;
+    event->type = type;
+
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+// ==================== INTERPOSED CALLS ====================
+
+void* malloc(size_t size) {
+    if(real_malloc == NULL) {
+        if(resolving) return bootstrap_alloc(size);
+        resolve_symbols();
+    }
+    void* p = real_malloc(size);
+    record(HEAP_EVENT_MALLOC, p, size, NULL);
+    return p;
+}
+
+void* calloc(size_t count, size_t size) {
+    if(real_calloc == NULL) {
+        // Bootstrap memory is static, hence already zero
+        if(resolving) return bootstrap_alloc(count * size);
+        resolve_symbols();
+    }
+    void* p = real_calloc(count, size);
+    record(HEAP_EVENT_CALLOC, p, count * size, NULL);
+    return p;
+}
+
+void* realloc(void* old, size_t size) {
+    if(real_realloc == NULL) {
+        if(resolving) return bootstrap_alloc(size);
+        resolve_symbols();
+    }
+    if(is_bootstrap(old)) {
+        void* p = real_malloc(size);
+        if(p != NULL) {
+            size_t available = SHIM_BOOTSTRAP_BYTES - (size_t)((char*)old - bootstrap);
+            memcpy(p, old, size < available ? size : available);
+        }
+        return p;
+    }
+    void* p = real_realloc(old, size);
+    record(HEAP_EVENT_REALLOC, p, size, old);
+    return p;
+}
+
+void free(void* p) {
+    if(p == NULL || is_bootstrap(p)) {
+        return;
+    }
+    if(real_free == NULL) {
+        resolve_symbols();
+    }
+    // Recorded first: once freed, another thread may be handed the address
+    record(HEAP_EVENT_FREE, p, 0, NULL);
+    real_free(p);
+}
+
+int posix_memalign(void** result, size_t alignment, size_t size) {
+    if(real_posix_memalign == NULL) {
+        if(resolving) return ENOMEM;
+        resolve_symbols();
+    }
+    int status = real_posix_memalign(result, alignment, size);
+    if(status == 0) {
+        record(HEAP_EVENT_MEMALIGN, *result, size, NULL);
+    }
+    return status;
+}
+
+void* aligned_alloc(size_t alignment, size_t size) {
+    if(real_aligned_alloc == NULL) {
+        if(resolving) return NULL;
+        resolve_symbols();
+    }
+    void* p = real_aligned_alloc(alignment, size);
+    record(HEAP_EVENT_MEMALIGN, p, size, NULL);
+    return p;
+}
+
+void* memalign(size_t alignment, size_t size) {
+    if(real_memalign == NULL) {
+        if(resolving) return NULL;
+        resolve_symbols();
+    }
+    void* p = real_memalign(alignment, size);
+    record(HEAP_EVENT_MEMALIGN, p, size, NULL);
+    return p;
+}
+
+void* mmap(void* address, size_t length, int prot, int flags, int fd, off_t offset) {
+    if(real_mmap == NULL) {
+        resolve_symbols();
+    }
+    void* p = real_mmap(address, length, prot, flags, fd, offset);
+    if(p != MAP_FAILED) {
+        record(HEAP_EVENT_MMAP, p, length, NULL);
+    }
+    return p;
+}
+
+int munmap(void* address, size_t length) {
+    if(real_munmap == NULL) {
+        resolve_symbols();
+    }
+    record(HEAP_EVENT_MUNMAP, address, length, NULL);
+    return real_munmap(address, length);
+}
+
+// ==================== DRAINING ====================
+
+static int compare_events(const void* a, const void* b) {
+    uint64_t sa = ((const HeapEvent*)a)->sequence;
+    uint64_t sb = ((const HeapEvent*)b)->sequence;
+    return (sa > sb) - (sa < sb);
+}
+
+static void write_all(const void* data, size_t length) {
+    const char* p = (const char*)data;
+    while(length > 0 && output_fd >= 0) {
+        ssize_t written = output_is_socket ? send(output_fd, p, length, MSG_NOSIGNAL)
+                                           : write(output_fd, p, length);
+        if(written < 0) {
+            if(errno == EINTR) continue;
+            close(output_fd);
+            output_fd = -1;
+            return;
+        }
+        p += written;
+        length -= (size_t)written;
+    }
+}
+
+// Room for more events in the drain batch
+static int batch_reserve(size_t count, size_t more) {
+    if(count + more <= drain_capacity) {
+        return 0;
+    }
+    size_t grown = (count + more) * 2;
+    HeapEvent* larger = (HeapEvent*)real_realloc(drain_batch, grown * sizeof(HeapEvent));
+    if(larger == NULL) {
+        return -1;
+    }
+    drain_batch = larger;
+    drain_capacity = grown;
+    return 0;
+}
+
+// Record of events lost since the last one written
+static void append_dropped(size_t* count, uint64_t dropped) {
+    HeapEvent* marker = &drain_batch[(*count)++];
+    memset(marker, 0, sizeof(HeapEvent));
+    marker->sequence = atomic_fetch_add(&sequence, 1);
+    marker->size = dropped;
+    marker->type = HEAP_EVENT_DROPPED;
+}
+
+// Move every pending event and drop count into the batch, returns the
+// count; the caller holds drain_lock
+static size_t collect() {
+    size_t count = 0;
+
+    uint64_t unringed = atomic_load(&lost);
+    if(unringed != lost_reported && batch_reserve(count, 1) == 0) {
+        append_dropped(&count, unringed - lost_reported);
+        lost_reported = unringed;
+    }
+
+    for(ShimRing* ring = atomic_load(&ring_list); ring != NULL; ring = ring->next) {
+        uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+        uint64_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+        uint64_t dropped = atomic_load(&ring->dropped);
+        if(batch_reserve(count, (head - tail) + 1) != 0) {
+            break;
+        }
+
+        if(dropped != ring->reported) {
+            append_dropped(&count, dropped - ring->reported);
+            ring->reported = dropped;
+        }
+        for(; tail != head; tail++) {
+            drain_batch[count++] = ring->events[tail & (SHIM_RING_EVENTS - 1)];
+        }
+        atomic_store_explicit(&ring->tail, tail, memory_order_release);
+    }
+
+    return count;
+}
+
+// Empty every ring into the output, returns the events written
+static size_t drain_now() {
+    pthread_mutex_lock(&drain_lock);
+    size_t count = collect();
+    if(count > 0) {
+        // Rings drain one after another; sequence numbers restore the interleaving
+        qsort(drain_batch, count, sizeof(HeapEvent), compare_events);
+        write_all(drain_batch, count * sizeof(HeapEvent));
+    }
+    pthread_mutex_unlock(&drain_lock);
+    return count;
+}
+
+static void* drain_main(void* argument) {
+    (void)argument;
+    in_shim = 1;
+
+    struct timespec pause = {0, SHIM_DRAIN_INTERVAL_NS};
+
+    while(1) {
+        int running = atomic_load(&drain_running);
+        if(drain_now() > 0) {
+            continue;
+        }
+        if(!running) {
+            break;
+        }
+        nanosleep(&pause, NULL);
+    }
+    return NULL;
+}
+
+// ==================== LIFECYCLE ====================
+
+static int open_output() {
+    const char* target = getenv(HEAP_SHIM_ENV);
+    char path[256];
+
+    if(target != NULL && strncmp(target, "unix:", 5) == 0) {
+        struct sockaddr_un address;
+        memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        snprintf(address.sun_path, sizeof(address.sun_path), "%s", target + 5);
+
+        output_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if(output_fd >= 0 && connect(output_fd, (struct sockaddr*)&address, sizeof(address)) != 0) {
+            close(output_fd);
+            output_fd = -1;
+        }
+        output_is_socket = 1;
+    } else {
+        if(target == NULL || target[0] == '\0') {
+            snprintf(path, sizeof(path), "heap_events.%d.bin", (int)getpid());
+            target = path;
+        }
+        output_fd = open(target, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    }
+
+    if(output_fd < 0) {
+        fprintf(stderr, "heap_shim: cannot open %s (%s), not recording\n",
+                target, strerror(errno));
+        return -1;
+    }
+
+    HeapEventHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, HEAP_EVENT_MAGIC, 4);
+    header.version = HEAP_EVENT_VERSION;
+    header.pid = (uint32_t)getpid();
+    header.event_size = sizeof(HeapEvent);
+    write_all(&header, sizeof(header));
+    return output_fd >= 0 ? 0 : -1;
+}
+
+// A forked child has no drain thread: stop recording there
+static void after_fork_child() {
+    atomic_store(&shim_active, 0);
+    output_fd = -1;
+}
+
+__attribute__((constructor))
+static void shim_start() {
+    in_shim = 1;
+    resolve_symbols();
+
+    if(pthread_key_create(&ring_key, ring_release) == 0 && open_output() == 0) {
+        atomic_store(&drain_running, 1);
+        if(pthread_create(&drain_thread, NULL, drain_main, NULL) == 0) {
+            pthread_atfork(NULL, NULL, after_fork_child);
+            atomic_store(&shim_active, 1);
+        } else {
+            atomic_store(&drain_running, 0);
+        }
+    }
+
+    in_shim = 0;
+}
+
+__attribute__((destructor))
+static void shim_stop() {
+    if(!atomic_load(&shim_active)) {
+        return;
+    }
+
+    in_shim = 1;
+    atomic_store(&shim_active, 0);
+    atomic_store(&drain_running, 0);
+    pthread_join(drain_thread, NULL);
+
+    // Drops counted after the last drain still reach the stream
+    drain_now();
+    uint64_t dropped = atomic_load(&lost);
+    for(ShimRing* ring = atomic_load(&ring_list); ring != NULL; ring = ring->next) {
+        dropped += atomic_load(&ring->dropped);
+    }
+    if(dropped > 0) {
+        fprintf(stderr, "heap_shim: %llu events dropped (marked in the stream)\n",
+                (unsigned long long)dropped);
+    }
+
+    if(output_fd >= 0) {
+        close(output_fd);
+        output_fd = -1;
+    }
+}
@@ -0,0 +1,52 @@
+/**
+ * heap_shim.h
+ * Heap event stream format shared by the LD_PRELOAD shim and the simulator
+ *
+ * Stream layout: one HeapEventHeader, then HeapEvent records until EOF.
+ * Records are written in batches and are only ordered within a batch;
+ * the sequence number orders them across batches and threads.
+ * The shim writes to the file named by DMV_HEAP_TRACE (default
+ * heap_events.<pid>.bin) or, for "unix:<path>", to a Unix stream socket.
+ */
+
+#ifndef HEAP_SHIM_H
+#define HEAP_SHIM_H
+
+#include <stdint.h>
+
+#define HEAP_EVENT_MAGIC "DMVH"
+#define HEAP_EVENT_VERSION 2
+#define HEAP_SHIM_ENV "DMV_HEAP_TRACE"
+
+// Intercepted calls
+typedef enum {
+    HEAP_EVENT_MALLOC = 1,
+    HEAP_EVENT_CALLOC,
+    HEAP_EVENT_REALLOC,
+    HEAP_EVENT_FREE,
+    HEAP_EVENT_MMAP,
+    HEAP_EVENT_MUNMAP,
+    HEAP_EVENT_MEMALIGN,        // posix_memalign, aligned_alloc, memalign
+    HEAP_EVENT_DROPPED          // size: events lost before this point
+} HeapEventType;
+
+// Stream header
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t pid;
+    uint32_t event_size;        // sizeof(HeapEvent) of the writer
+} HeapEventHeader;
+
+// One intercepted call
+typedef struct {
+    uint64_t sequence;          // Global order of the calls, from 0
+    uint64_t timestamp_ns;      // CLOCK_MONOTONIC
+    uint64_t address;           // Result (free/munmap: the argument)
+    uint64_t size;
+    uint64_t old_address;       // realloc: block being resized
+    uint32_t thread;            // Kernel thread id
+    uint32_t type;              // HeapEventType
+} HeapEvent;
+
+#endif // HEAP_SHIM_H
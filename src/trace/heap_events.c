@@ -0,0 +1,433 @@
+/**
+ * heap_events.c
+ * Heap event stream consumer implementation
+ *
+ * Replays the malloc/free/mmap events of a real program against the
+ * simulator: allocations touch (write) the pages they cover, frees touch
+ * the block's first page, mmap regions become segments of the process
+ * and the span of the malloc heap becomes segment 0. Live blocks are kept
+ * in an open-addressing table so live and peak heap size are exact.
+ *
+ * The shim writes events in batches that are only sorted internally, so a
+ * free on one thread can arrive a batch ahead of the malloc on another
+ * thread that it releases. Events therefore pass through a min-heap on
+ * their sequence number and are applied strictly in sequence order. The
+ * same ordered reader feeds the heap allocator simulator's traces.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "heap_events.h"
+#include "replay.h"
+#include "../../include/common_defs.h"
+#include "../core/memory_manager.h"
+#include "../core/segmentation.h"
+#include "../utils/address_table.h"
+
+#define HEAP_READ_BATCH 4096
+#define HEAP_HEAP_SEGMENT 0
+
+HeapEventStats heap_event_stats;
+
+// mmap regions currently shown as segments
+typedef struct {
+    uint64_t address;
+    uint64_t size;
+    bool used;
+} MappedRegion;
+
+static AddressTable live_blocks;      // address -> size
+static AddressTable seen_threads;
+static MappedRegion regions[MAX_SEGMENTS];
+
+// Events held back until every lower sequence number has been seen
+typedef struct {
+    HeapEvent* pending;                 // Min-heap on sequence number
+    size_t count;
+    size_t capacity;
+    uint64_t next_sequence;
+    HeapEventSink sink;
+    void* context;
+    int status;                         // First sink failure
+} HeapEventOrder;
+static int next_region_slot = 1;
+static uint64_t heap_low;
+static uint64_t heap_high;
+
+// ==================== EVENT APPLICATION ====================
+
+static void reset_heap_events(int source_pid) {
+    address_table_free(&live_blocks);
+    address_table_free(&seen_threads);
+    memset(regions, 0, sizeof(regions));
+    memset(&heap_event_stats, 0, sizeof(heap_event_stats));
+    next_region_slot = 1;
+    heap_low = UINT64_MAX;
+    heap_high = 0;
+    heap_event_stats.source_pid = source_pid;
+    heap_event_stats.pid = replay_map_pid(source_pid);
+}
+
+// Simulated accesses to the pages of [address, address + size)
+static void touch_range(uint64_t address, uint64_t size, bool is_write) {
+    int pid = heap_event_stats.pid;
+    uint64_t first = address / PAGE_SIZE;
+    uint64_t last = (address + (size ? size : 1) - 1) / PAGE_SIZE;
+
+    if(last - first >= HEAP_TOUCH_PAGES) {
+        last = first + HEAP_TOUCH_PAGES - 1;
+    }
+    for(uint64_t page = first; page <= last; page++) {
+        access_memory_ex(pid, fold_virtual_address(page * PAGE_SIZE), is_write);
+    }
+}
+
+static void block_allocated(uint64_t address, uint64_t size) {
+    if(address == 0) {
+        return;
+    }
+    address_table_put(&live_blocks, address, size);
+    heap_event_stats.live_bytes += size;
+    if(heap_event_stats.live_bytes > heap_event_stats.peak_bytes) {
+        heap_event_stats.peak_bytes = heap_event_stats.live_bytes;
+    }
+
+    int size_class = 0;
+    while(size_class < HEAP_SIZE_CLASSES - 1 && (1ULL << (size_class + 1)) <= size) {
+        size_class++;
+    }
+    heap_event_stats.size_classes[size_class]++;
+
+    if(address < heap_low) heap_low = address;
+    if(address + size > heap_high) heap_high = address + size;
+    touch_range(address, size, true);
+}
+
+static void block_freed(uint64_t address) {
+    uint64_t size;
+    if(address == 0) {
+        return;
+    }
+    if(!address_table_take(&live_blocks, address, &size)) {
+        heap_event_stats.unknown_frees++;
+        return;
+    }
+    heap_event_stats.live_bytes -= size;
+    touch_range(address, 1, false);
+}
+
+// Segment for a region, placed by the segment allocator so regions never overlap
+static void show_segment(int slot, uint64_t size) {
+    int limit = size > SEGMENT_SIZE ? SEGMENT_SIZE : (int)(size ? size : 1);
+    create_segment(heap_event_stats.pid, slot, -1, limit);
+}
+
+static void region_mapped(uint64_t address, uint64_t size) {
+    int slot = next_region_slot;
+    next_region_slot = (next_region_slot % (MAX_SEGMENTS - 1)) + 1;
+
+    regions[slot].address = address;
+    regions[slot].size = size;
+    regions[slot].used = true;
+    show_segment(slot, size);
+    touch_range(address, size, false);
+}
+
+static void region_unmapped(uint64_t address) {
+    for(int slot = 1; slot < MAX_SEGMENTS; slot++) {
+        if(regions[slot].used && regions[slot].address == address) {
+            regions[slot].used = false;
+            delete_segment(heap_event_stats.pid, slot);
+            return;
+        }
+    }
+}
+
+static void apply_event(const HeapEvent* event) {
+    if(event->type > HEAP_EVENT_DROPPED || event->type == 0) {
+        return;
+    }
+    if(event->type == HEAP_EVENT_DROPPED) {
+        heap_event_stats.dropped += event->size;
+        heap_event_stats.by_type[event->type]++;
+        return;
+    }
+
+    heap_event_stats.events++;
+    heap_event_stats.by_type[event->type]++;
+    if(heap_event_stats.first_ns == 0) {
+        heap_event_stats.first_ns = event->timestamp_ns;
+    }
+    heap_event_stats.last_ns = event->timestamp_ns;
+    if(address_table_put(&seen_threads, (uint64_t)event->thread + 1, 0) == 1) {
+        heap_event_stats.threads++;
+    }
+
+    switch(event->type) {
+        case HEAP_EVENT_MALLOC:
+        case HEAP_EVENT_CALLOC:
+        case HEAP_EVENT_MEMALIGN:
+            block_allocated(event->address, event->size);
+            break;
+        case HEAP_EVENT_REALLOC:
+            if(event->address != 0) {
+                block_freed(event->old_address);
+                block_allocated(event->address, event->size);
+            }
+            break;
+        case HEAP_EVENT_FREE:
+            block_freed(event->address);
+            break;
+        case HEAP_EVENT_MMAP:
+            region_mapped(event->address, event->size);
+            break;
+        case HEAP_EVENT_MUNMAP:
+            region_unmapped(event->address);
+            break;
+    }
+}
+
+// Replay events into the simulator, as a heap_events_read sink
+static int apply_sink(const HeapEvent* event, void* context) {
+    (void)context;
+    apply_event(event);
+    return 0;
+}
+
+// Read a whole event stream from a descriptor and apply it
+static int consume_stream(int fd, const char* name) {
+    HeapEventHeader header;
+    if(heap_events_read_header(fd, name, &header) != 0) {
+        return -1;
+    }
+
+    int saved_verbose = verbose_mode;
+    verbose_mode = 0;
+    reset_heap_events((int)header.pid);
+
+    int status = heap_events_read(fd, apply_sink, NULL);
+
+    if(heap_high > heap_low) {
+        show_segment(HEAP_HEAP_SEGMENT, heap_high - heap_low);
+    }
+    heap_event_stats.live_blocks = live_blocks.count;
+    verbose_mode = saved_verbose;
+
+    address_table_free(&live_blocks);
+    address_table_free(&seen_threads);
+    return status;
+}
+
+// ==================== ORDERED READER ====================
+
+static void pending_swap(HeapEventOrder* order, size_t a, size_t b) {
+    HeapEvent held = order->pending[a];
+    order->pending[a] = order->pending[b];
+    order->pending[b] = held;
+}
+
+static int pending_push(HeapEventOrder* order, const HeapEvent* event) {
+    if(order->count == order->capacity) {
+        size_t grown = order->capacity ? order->capacity * 2 : HEAP_READ_BATCH;
+        HeapEvent* larger = (HeapEvent*)realloc(order->pending, grown * sizeof(HeapEvent));
+        if(larger == NULL) {
+            return -1;
+        }
+        order->pending = larger;
+        order->capacity = grown;
+    }
+
+    HeapEvent* heap = order->pending;
+    size_t i = order->count++;
+    heap[i] = *event;
+    while(i > 0 && heap[(i - 1) / 2].sequence > heap[i].sequence) {
+        pending_swap(order, i, (i - 1) / 2);
+        i = (i - 1) / 2;
+    }
+    return 0;
+}
+
+static HeapEvent pending_pop(HeapEventOrder* order) {
+    HeapEvent* heap = order->pending;
+    HeapEvent first = heap[0];
+    heap[0] = heap[--order->count];
+    for(size_t i = 0;;) {
+        size_t smallest = i;
+        size_t left = 2 * i + 1;
+        if(left < order->count && heap[left].sequence < heap[smallest].sequence) {
+            smallest = left;
+        }
+        if(left + 1 < order->count && heap[left + 1].sequence < heap[smallest].sequence) {
+            smallest = left + 1;
+        }
+        if(smallest == i) {
+            break;
+        }
+        pending_swap(order, i, smallest);
+        i = smallest;
+    }
+    return first;
+}
+
+static void deliver(HeapEventOrder* order, const HeapEvent* event) {
+    if(event->sequence >= order->next_sequence) {
+        order->next_sequence = event->sequence + 1;
+    }
+    if(order->status == 0) {
+        order->status = order->sink(event, order->context);
+    }
+}
+
+// Hand on held events that are next in sequence; with drain set, hand on
+// all of them, skipping over gaps (end of stream or too many held back)
+static void apply_pending(HeapEventOrder* order, bool drain) {
+    while(order->count > 0) {
+        if(order->pending[0].sequence != order->next_sequence && !drain &&
+           order->count < HEAP_REORDER_LIMIT) {
+            return;
+        }
+        HeapEvent event = pending_pop(order);
+        deliver(order, &event);
+    }
+}
+
+// Read and check the stream header
+int heap_events_read_header(int fd, const char* name, HeapEventHeader* header) {
+    if(read(fd, header, sizeof(HeapEventHeader)) != sizeof(HeapEventHeader) ||
+       memcmp(header->magic, HEAP_EVENT_MAGIC, 4) != 0 ||
+       header->version != HEAP_EVENT_VERSION || header->event_size != sizeof(HeapEvent)) {
+        printf("Error: '%s' is not a heap event stream\n", name);
+        return -1;
+    }
+    return 0;
+}
+
+// Pass every event after the header to the sink in sequence order.
+// Returns 0, or -1 if memory ran out or the sink failed
+int heap_events_read(int fd, HeapEventSink sink, void* context) {
+    HeapEventOrder order;
+    memset(&order, 0, sizeof(order));
+    order.sink = sink;
+    order.context = context;
+
+    HeapEvent* batch = (HeapEvent*)malloc(HEAP_READ_BATCH * sizeof(HeapEvent));
+    if(batch == NULL) {
+        printf("Error: Memory allocation failed\n");
+        return -1;
+    }
+
+    // Events may straddle reads on a socket: keep the partial tail
+    size_t buffered = 0;
+    ssize_t got;
+    while(order.status == 0 &&
+          (got = read(fd, (char*)batch + buffered,
+                      HEAP_READ_BATCH * sizeof(HeapEvent) - buffered)) > 0) {
+        buffered += (size_t)got;
+        size_t complete = buffered / sizeof(HeapEvent);
+        for(size_t i = 0; i < complete; i++) {
+            if(pending_push(&order, &batch[i]) != 0) {
+                apply_pending(&order, true);    // Out of memory: hand on what is held, in order
+                deliver(&order, &batch[i]);
+            }
+        }
+        apply_pending(&order, false);
+        buffered -= complete * sizeof(HeapEvent);
+        memmove(batch, (char*)batch + complete * sizeof(HeapEvent), buffered);
+    }
+    apply_pending(&order, true);
+
+    free(order.pending);
+    free(batch);
+    return order.status;
+}
+
+// Apply an event file written by the shim
+int heap_events_consume_file(const char* path) {
+    FILE* file = fopen(path, "rb");
+    if(file == NULL) {
+        printf("Error: Could not open heap events '%s'\n", path);
+        return -1;
+    }
+    int status = consume_stream(fileno(file), path);
+    fclose(file);
+    return status;
+}
+
+// Wait for one shim connection on a Unix socket and apply its stream
+int heap_events_listen(const char* socket_path) {
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    snprintf(address.sun_path, sizeof(address.sun_path), "%s", socket_path);
+
+    int server = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(socket_path);
+    if(server < 0 || bind(server, (struct sockaddr*)&address, sizeof(address)) != 0 ||
+       listen(server, 1) != 0) {
+        printf("Error: Cannot listen on '%s'\n", socket_path);
+        if(server >= 0) close(server);
+        return -1;
+    }
+
+    printf("Waiting for heap events on %s (run the program with %s=unix:%s)\n",
+           socket_path, HEAP_SHIM_ENV, socket_path);
+    int client = accept(server, NULL, NULL);
+    int status = -1;
+    if(client >= 0) {
+        status = consume_stream(client, socket_path);
+        close(client);
+    }
+
+    close(server);
+    unlink(socket_path);
+    return status;
+}
+
+// Display what the stream did
+void display_heap_event_report() {
+    static const char* type_names[] = {"", "malloc", "calloc", "realloc", "free", "mmap", "munmap",
+                                       "memalign"};
+
+    printf("\n=================== HEAP EVENTS ===================\n");
+    printf("Source pid: %d -> Process %d, Threads: %llu\n",
+           heap_event_stats.source_pid, heap_event_stats.pid, heap_event_stats.threads);
+    printf("Events: %llu over %.3f ms\n", heap_event_stats.events,
+           (heap_event_stats.last_ns - heap_event_stats.first_ns) / 1e6);
+    for(int type = HEAP_EVENT_MALLOC; type <= HEAP_EVENT_MEMALIGN; type++) {
+        printf("  %-8s %llu\n", type_names[type], heap_event_stats.by_type[type]);
+    }
+
+    // Missing events leave blocks live forever or make frees look unknown
+    if(heap_event_stats.dropped > 0) {
+        printf("Dropped by the shim: %llu events; the live and unknown free counts\n",
+               heap_event_stats.dropped);
+        printf("below are only bounds\n");
+        printf("Live at end: at most %llu blocks, %llu bytes (peak %llu bytes)\n",
+               heap_event_stats.live_blocks, heap_event_stats.live_bytes,
+               heap_event_stats.peak_bytes);
+        printf("Frees not matched to a recorded allocation: %llu\n",
+               heap_event_stats.unknown_frees);
+    } else {
+        printf("Live at end: %llu blocks, %llu bytes (peak %llu bytes)\n",
+               heap_event_stats.live_blocks, heap_event_stats.live_bytes,
+               heap_event_stats.peak_bytes);
+    }
+    if(heap_event_stats.dropped == 0 && heap_event_stats.unknown_frees > 0) {
+        printf("Frees of blocks allocated before recording: %llu\n",
+               heap_event_stats.unknown_frees);
+    }
+
+    printf("\nSize class        Allocations\n");
+    printf("----------------  -----------\n");
+    for(int c = 0; c < HEAP_SIZE_CLASSES; c++) {
+        if(heap_event_stats.size_classes[c] > 0) {
+            printf("%7llu-%-8llu  %11llu\n", 1ULL << c, (2ULL << c) - 1,
+                   heap_event_stats.size_classes[c]);
+        }
+    }
+    printf("===================================================\n");
+}
@@ -0,0 +1,46 @@
+/**
+ * heap_events.h
+ * Heap event stream consumer (events recorded by the LD_PRELOAD shim)
+ */
+
+#ifndef HEAP_EVENTS_H
+#define HEAP_EVENTS_H
+
+#include <stdint.h>
+#include "../../include/common_defs.h"
+#include "../shim/heap_shim.h"
+
+#define HEAP_SIZE_CLASSES 24            // Power-of-two size buckets
+#define HEAP_TOUCH_PAGES MAX_PAGES      // Pages touched per allocation at most
+#define HEAP_REORDER_LIMIT (1 << 20)    // Events held back waiting for a missing sequence number
+
+// Totals over a consumed stream
+typedef struct {
+    int source_pid;
+    int pid;                            // Simulator process the events drive
+    unsigned long long events;
+    unsigned long long by_type[HEAP_EVENT_DROPPED + 1];
+    unsigned long long dropped;         // Lost by the shim; live and unknown counts are then partial
+    unsigned long long unknown_frees;   // Frees of blocks allocated before the shim
+    unsigned long long live_blocks;
+    unsigned long long live_bytes;
+    unsigned long long peak_bytes;
+    unsigned long long size_classes[HEAP_SIZE_CLASSES];
+    unsigned long long threads;
+    uint64_t first_ns;
+    uint64_t last_ns;
+} HeapEventStats;
+
+// Receives events in sequence order; nonzero stops the read
+typedef int (*HeapEventSink)(const HeapEvent* event, void* context);
+
+extern HeapEventStats heap_event_stats;
+
+// Function Prototypes
+int heap_events_read_header(int fd, const char* name, HeapEventHeader* header);
+int heap_events_read(int fd, HeapEventSink sink, void* context);
+int heap_events_consume_file(const char* path);
+int heap_events_listen(const char* socket_path);
+void display_heap_event_report();
+
+#endif // HEAP_EVENTS_H
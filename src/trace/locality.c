@@ -0,0 +1,442 @@
+/**
+ * locality.c
+ * Reuse distance and phase analysis of reference streams
+ *
+ * Runs beside trace replay on the source addresses, before they are
+ * folded into the simulated address space. For every reference the
+ * reuse distance is the number of distinct pages touched since the
+ * previous reference to the same page: exactly the LRU stack depth, so
+ * an LRU memory of n frames hits every reference whose distance is below
+ * n. Each process keeps a Fenwick tree over access times with a mark at
+ * the last access of every page, which turns the distance into one
+ * prefix sum. When the times run out the live marks are renumbered in
+ * order, so the tree stays proportional to the pages, not the trace.
+ *
+ * Phases are found from signatures of fixed windows of references, in
+ * the style of basic block vectors: each window counts its references
+ * into a few page hash buckets, and a window whose normalised counts are
+ * far from those of the current phase starts a new one. New phases that
+ * look like an earlier one share its label. Every phase reports its
+ * working set and the LRU frames it needs for a given hit ratio, which
+ * is what a per-phase frame allocation works from.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "locality.h"
+#include "replay.h"
+#include "workload.h"
+#include "../core/memory_manager.h"
+
+#define STAMP_SHIFT 40                  // Last-access value: window stamp above, time below
+#define TIME_MASK ((1ULL << STAMP_SHIFT) - 1)
+#define STAMP_LIMIT ((1ULL << (64 - STAMP_SHIFT)) - 1)
+
+bool locality_enabled = false;
+int locality_window = LOCALITY_DEFAULT_WINDOW;
+LocalityProcess locality_processes[MAX_PROCESSES];
+
+// Free every stream and start over
+void reset_locality() {
+    for(int pid = 0; pid < MAX_PROCESSES; pid++) {
+        LocalityProcess* stream = &locality_processes[pid];
+        address_table_free(&stream->last_access);
+        address_table_free(&stream->phase_stamp);
+        free(stream->tree);
+        free(stream->window_pages);
+        free(stream->phases);
+        memset(stream, 0, sizeof(LocalityProcess));
+    }
+}
+
+// ==================== REUSE DISTANCE ====================
+
+static void tree_add(LocalityProcess* stream, uint64_t time, int64_t delta) {
+    for(uint64_t i = time + 1; i <= stream->capacity; i += i & (~i + 1)) {
+        stream->tree[i] += (uint64_t)delta;
+    }
+}
+
+// Marks at times up to and including the given one
+static uint64_t tree_prefix(const LocalityProcess* stream, uint64_t time) {
+    uint64_t sum = 0;
+    for(uint64_t i = time + 1; i > 0; i -= i & (~i + 1)) {
+        sum += stream->tree[i];
+    }
+    return sum;
+}
+
+typedef struct {
+    uint64_t time;
+    uint64_t slot;
+} TimedSlot;
+
+static int by_time(const void* a, const void* b) {
+    uint64_t x = ((const TimedSlot*)a)->time;
+    uint64_t y = ((const TimedSlot*)b)->time;
+    return (x > y) - (x < y);
+}
+
+// Renumber the live marks 0..n-1 in time order, growing the tree so at
+// least half of it is free afterwards; returns 0 or -1
+static int compact(LocalityProcess* stream) {
+    AddressTable* table = &stream->last_access;
+    uint64_t live = table->count;
+    uint64_t capacity = stream->capacity ? stream->capacity : LOCALITY_MIN_CAPACITY;
+    while(capacity < live * 2) {
+        capacity *= 2;
+    }
+
+    TimedSlot* order = (TimedSlot*)malloc((live ? live : 1) * sizeof(TimedSlot));
+    uint64_t* tree = (uint64_t*)calloc(capacity + 1, sizeof(uint64_t));
+    if(order == NULL || tree == NULL) {
+        free(order);
+        free(tree);
+        return -1;
+    }
+
+    uint64_t n = 0;
+    for(uint64_t slot = 0; slot < table->capacity; slot++) {
+        if(table->keys[slot] != 0) {
+            order[n].time = table->values[slot] & TIME_MASK;
+            order[n].slot = slot;
+            n++;
+        }
+    }
+    qsort(order, n, sizeof(TimedSlot), by_time);
+
+    free(stream->tree);
+    stream->tree = tree;
+    stream->capacity = capacity;
+    for(uint64_t rank = 0; rank < n; rank++) {
+        uint64_t* value = &table->values[order[rank].slot];
+        *value = (*value & ~TIME_MASK) | rank;
+        tree_add(stream, rank, 1);
+    }
+    stream->now = n;
+    free(order);
+    return 0;
+}
+
+static void stream_failed(LocalityProcess* stream, int pid) {
+    printf("Error: Memory allocation failed, locality analysis of process %d stopped\n", pid);
+    stream->failed = true;
+}
+
+// ==================== PHASES ====================
+
+static uint64_t page_key(uint64_t address) {
+    return address / PAGE_SIZE + 1;     // Key 0 is reserved by the table
+}
+
+static int signature_dim(uint64_t key) {
+    return (int)((key * 0x9E3779B97F4A7C15ULL) >> (64 - 5));
+}
+
+// Manhattan distance of two signatures after scaling each to sum 1, 0 to 2
+static double signature_distance(const uint64_t* a, const uint64_t* b) {
+    uint64_t total_a = 0;
+    uint64_t total_b = 0;
+    for(int d = 0; d < LOCALITY_SIGNATURE_DIMS; d++) {
+        total_a += a[d];
+        total_b += b[d];
+    }
+    if(total_a == 0 || total_b == 0) {
+        return 2.0;
+    }
+
+    double distance = 0.0;
+    for(int d = 0; d < LOCALITY_SIGNATURE_DIMS; d++) {
+        double delta = (double)a[d] / total_a - (double)b[d] / total_b;
+        distance += delta < 0 ? -delta : delta;
+    }
+    return distance;
+}
+
+// Label of the closest earlier phase within the threshold, or a new one
+static int match_label(LocalityProcess* stream, const uint64_t* signature) {
+    int label = -1;
+    double best = LOCALITY_PHASE_THRESHOLD;
+    for(int p = 0; p < stream->phase_count; p++) {
+        double distance = signature_distance(signature, stream->phases[p].signature);
+        if(distance <= best) {
+            best = distance;
+            label = stream->phases[p].label;
+        }
+    }
+    return label != -1 ? label : stream->labels++;
+}
+
+// Fold the finished window into the current phase, or start a new phase with it
+static int close_window(LocalityProcess* stream) {
+    if(stream->window_references == 0) {
+        return 0;
+    }
+
+    LocalityPhase* phase = stream->phase_count ? &stream->phases[stream->phase_count - 1] : NULL;
+    bool boundary = phase == NULL ||
+                    signature_distance(stream->window_counts, phase->signature) > LOCALITY_PHASE_THRESHOLD;
+    if(boundary && phase != NULL) {
+        stream->phase_changes++;
+    }
+    if(boundary && stream->phase_count < LOCALITY_MAX_PHASES) {
+        LocalityPhase* phases = (LocalityPhase*)realloc(stream->phases,
+                                                        (stream->phase_count + 1) * sizeof(LocalityPhase));
+        if(phases == NULL) {
+            return -1;
+        }
+        stream->phases = phases;
+        int label = match_label(stream, stream->window_counts);
+        phase = &phases[stream->phase_count++];
+        memset(phase, 0, sizeof(LocalityPhase));
+        phase->first_reference = stream->references - stream->window_references;
+        phase->label = label;
+    }
+
+    phase->references += stream->window_references;
+    phase->windows++;
+    phase->cold += stream->window_cold;
+    for(int d = 0; d < LOCALITY_SIGNATURE_DIMS; d++) {
+        phase->signature[d] += stream->window_counts[d];
+    }
+    hdr_merge(&phase->reuse, &stream->window_reuse);
+
+    // Pages of this window not yet counted in the phase's working set
+    uint64_t stamp = (uint64_t)(phase - stream->phases) + 1;
+    for(uint64_t i = 0; i < stream->window_page_count; i++) {
+        uint64_t seen;
+        if(!address_table_get(&stream->phase_stamp, stream->window_pages[i], &seen) || seen != stamp) {
+            if(address_table_put(&stream->phase_stamp, stream->window_pages[i], stamp) < 0) {
+                return -1;
+            }
+            phase->pages++;
+        }
+    }
+
+    memset(stream->window_counts, 0, sizeof(stream->window_counts));
+    stream->window_references = 0;
+    stream->window_cold = 0;
+    stream->window_page_count = 0;
+    hdr_reset(&stream->window_reuse);
+    stream->window_seq++;
+    return 0;
+}
+
+// ==================== STREAM ====================
+
+// Account one reference of a process at its source address
+void locality_observe(int pid, uint64_t address) {
+    if(pid < 0 || pid >= MAX_PROCESSES || locality_processes[pid].failed) {
+        return;
+    }
+    LocalityProcess* stream = &locality_processes[pid];
+    uint64_t window = locality_window > 0 ? (uint64_t)locality_window : 1;
+
+    if(stream->window_page_capacity < window) {
+        uint64_t* pages = (uint64_t*)realloc(stream->window_pages, window * sizeof(uint64_t));
+        if(pages == NULL) {
+            stream_failed(stream, pid);
+            return;
+        }
+        stream->window_pages = pages;
+        stream->window_page_capacity = window;
+    }
+    if(stream->now == stream->capacity && compact(stream) != 0) {
+        stream_failed(stream, pid);
+        return;
+    }
+
+    uint64_t key = page_key(address);
+    uint64_t stamp = stream->window_seq % STAMP_LIMIT + 1;
+    uint64_t value;
+    bool seen = address_table_get(&stream->last_access, key, &value);
+    if(seen) {
+        uint64_t previous = value & TIME_MASK;
+        uint64_t distance = stream->last_access.count - tree_prefix(stream, previous);
+        tree_add(stream, previous, -1);
+        hdr_record(&stream->reuse, distance);
+        hdr_record(&stream->window_reuse, distance);
+    } else {
+        stream->cold++;
+        stream->window_cold++;
+    }
+    if(!seen || (value >> STAMP_SHIFT) != stamp) {
+        stream->window_pages[stream->window_page_count++] = key;
+    }
+
+    if(address_table_put(&stream->last_access, key, (stamp << STAMP_SHIFT) | stream->now) < 0) {
+        stream_failed(stream, pid);
+        return;
+    }
+    tree_add(stream, stream->now, 1);
+    stream->now++;
+
+    stream->window_counts[signature_dim(key)]++;
+    stream->window_references++;
+    stream->references++;
+    if(stream->window_references >= window && close_window(stream) != 0) {
+        stream_failed(stream, pid);
+    }
+}
+
+// Close every partly filled window so the phases cover the whole stream
+void locality_flush() {
+    for(int pid = 0; pid < MAX_PROCESSES; pid++) {
+        LocalityProcess* stream = &locality_processes[pid];
+        if(!stream->failed && close_window(stream) != 0) {
+            stream_failed(stream, pid);
+        }
+    }
+}
+
+// LRU frames that would serve the given share of references as hits, or
+// 0 if first touches alone miss more than that
+uint64_t locality_frames_for(const HdrHistogram* reuse, uint64_t references, double hit_percent) {
+    uint64_t target = (uint64_t)(hit_percent / 100.0 * references + 0.999999);
+    if(target == 0) {
+        return 0;
+    }
+    if(target > reuse->samples) {
+        return 0;
+    }
+    return hdr_value_at_rank(reuse, target) + 1;
+}
+
+// ==================== REPORTING ====================
+
+static void print_frames(const HdrHistogram* reuse, uint64_t references, double hit_percent) {
+    uint64_t frames = locality_frames_for(reuse, references, hit_percent);
+    if(frames) {
+        printf("%10llu", (unsigned long long)frames);
+    } else {
+        printf("%10s", "-");
+    }
+}
+
+static void display_stream(int pid, const LocalityProcess* stream) {
+    printf("\nProcess %d: %llu references, %llu pages, %llu phase changes\n", pid,
+           (unsigned long long)stream->references, (unsigned long long)stream->last_access.count,
+           (unsigned long long)stream->phase_changes);
+
+    printf("Reuse distance  References   Share\n");
+    printf("--------------  ----------  ------\n");
+    uint64_t low = 0;
+    uint64_t high = 1;
+    while(stream->reuse.samples > 0 && low <= stream->reuse.max) {
+        uint64_t count = hdr_count_below(&stream->reuse, high) - hdr_count_below(&stream->reuse, low);
+        char range[32];
+        if(high - low == 1) {
+            snprintf(range, sizeof(range), "%llu", (unsigned long long)low);
+        } else {
+            snprintf(range, sizeof(range), "%llu-%llu", (unsigned long long)low,
+                     (unsigned long long)(high - 1));
+        }
+        printf("%-14s  %10llu  %5.1f%%\n", range, (unsigned long long)count,
+               count * 100.0 / stream->references);
+        low = high;
+        high *= 2;
+    }
+    printf("%-14s  %10llu  %5.1f%%\n", "First touch", (unsigned long long)stream->cold,
+           stream->cold * 100.0 / stream->references);
+
+    printf("LRU frames for 90%% / 95%% / 99%% hits:");
+    print_frames(&stream->reuse, stream->references, 90.0);
+    print_frames(&stream->reuse, stream->references, 95.0);
+    print_frames(&stream->reuse, stream->references, 99.0);
+    printf("\n");
+
+    printf("\n  #  Label  First ref  References  Working set  Frames 90%%  Frames 99%%\n");
+    printf("---  -----  ---------  ----------  -----------  ----------  ----------\n");
+    for(int p = 0; p < stream->phase_count; p++) {
+        const LocalityPhase* phase = &stream->phases[p];
+        printf("%3d  %5c  %9llu  %10llu  %11llu", p + 1, 'A' + phase->label % 26,
+               (unsigned long long)phase->first_reference, (unsigned long long)phase->references,
+               (unsigned long long)phase->pages);
+        printf("  ");
+        print_frames(&phase->reuse, phase->references, 90.0);
+        printf("  ");
+        print_frames(&phase->reuse, phase->references, 99.0);
+        printf("\n");
+    }
+    if(stream->phase_changes + 1 > (uint64_t)stream->phase_count) {
+        printf("Later phase changes were folded into phase %d\n", stream->phase_count);
+    }
+}
+
+// Reuse distances and phases of every analysed process
+void display_locality_report() {
+    locality_flush();
+
+    printf("\n==================== LOCALITY ====================\n");
+    printf("Windows of %d references; a window more than %.2f from its phase's\n",
+           locality_window, LOCALITY_PHASE_THRESHOLD);
+    printf("page signature starts a new phase. Frames are LRU frames, '-' when\n");
+    printf("first touches alone miss more than the target allows.\n");
+    for(int pid = 0; pid < MAX_PROCESSES; pid++) {
+        if(locality_processes[pid].references > 0) {
+            display_stream(pid, &locality_processes[pid]);
+        }
+    }
+    printf("==================================================\n");
+}
+
+// ==================== SIMULATION ====================
+
+#define LOCALITY_SIM_PHASE 4000         // References per phase of the phased process
+
+// A phased process alternating between a skewed working set and a scan,
+// beside a steady one, replayed through the paging module
+void run_locality_simulation(int refs, uint64_t seed) {
+    bool saved_enabled = locality_enabled;
+
+    if(refs <= 0) {
+        printf("Error: Reference count must be positive\n");
+        return;
+    }
+    MemoryReference* batch = (MemoryReference*)malloc(refs * sizeof(MemoryReference));
+    if(batch == NULL) {
+        printf("Error: Memory allocation failed\n");
+        return;
+    }
+
+    Workload generator;
+    WorkloadPattern skewed = workload_pattern(PATTERN_ZIPF, 0, 256);
+    WorkloadPattern scan = workload_pattern(PATTERN_SCAN, 4096, 48);
+    WorkloadPattern steady = workload_pattern(PATTERN_HOT_COLD, 0, 64);
+    skewed.length = LOCALITY_SIM_PHASE;
+    scan.length = LOCALITY_SIM_PHASE;
+
+    workload_init(&generator, seed);
+    workload_add_process(&generator, 0, 1);
+    workload_add_phase(&generator, 0, &skewed);
+    workload_add_phase(&generator, 0, &scan);
+    workload_add_process(&generator, 1, 1);
+    workload_add_phase(&generator, 1, &steady);
+    int generated = workload_generate(&generator, batch, refs);
+    workload_free(&generator);
+    if(generated < 0) {
+        printf("Error: Memory allocation failed\n");
+        free(batch);
+        return;
+    }
+
+    verbose_mode = 0;
+    init_memory_system();
+    replay_reset();
+    replay_map_pid(0);                  // Keep the simulator pids equal to the generated ones
+    replay_map_pid(1);
+    locality_enabled = true;
+    for(int i = 0; i < refs; i += REPLAY_BATCH_SIZE) {
+        replay_references(&batch[i], refs - i < REPLAY_BATCH_SIZE ? refs - i : REPLAY_BATCH_SIZE);
+    }
+
+    printf("\n%d references: process 0 alternates every %d between a Zipf working\n",
+           refs, LOCALITY_SIM_PHASE);
+    printf("set of 256 pages and a scan over 48, process 1 stays on a hot/cold set\n");
+    printf("of 64 pages; seed %llu\n", (unsigned long long)seed);
+    display_locality_report();
+
+    locality_enabled = saved_enabled;
+    free(batch);
+}
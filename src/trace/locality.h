@@ -0,0 +1,75 @@
+/**
+ * locality.h
+ * Reuse distance and phase analysis of reference streams module header
+ */
+
+#ifndef LOCALITY_H
+#define LOCALITY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../../include/common_defs.h"
+#include "../utils/address_table.h"
+#include "../utils/hdr_histogram.h"
+
+#define LOCALITY_DEFAULT_WINDOW 1000    // References per signature window
+#define LOCALITY_SIGNATURE_DIMS 32      // Page hash buckets per signature
+#define LOCALITY_PHASE_THRESHOLD 0.5    // Manhattan distance (0-2) that starts a new phase
+#define LOCALITY_MAX_PHASES 64          // Per process; later changes extend the last phase
+#define LOCALITY_MIN_CAPACITY 1024      // Fenwick tree slots before the first compaction
+
+// A run of windows with similar signatures
+typedef struct {
+    uint64_t first_reference;
+    uint64_t references;
+    uint64_t windows;
+    uint64_t pages;                     // Working set: distinct pages touched in the phase
+    uint64_t cold;                      // First touches in the whole stream
+    int label;                          // Phases with the same label look alike
+    uint64_t signature[LOCALITY_SIGNATURE_DIMS];
+    HdrHistogram reuse;
+} LocalityPhase;
+
+// One process's stream: a Fenwick tree over access times holds a mark at
+// the last access of every page, so the distinct pages since a page's
+// previous access are a prefix-sum difference
+typedef struct {
+    AddressTable last_access;           // Page -> window stamp and time of its last access
+    AddressTable phase_stamp;           // Page -> last phase it was counted in, plus one
+    uint64_t* tree;
+    uint64_t capacity;
+    uint64_t now;
+    uint64_t references;
+    uint64_t cold;
+    HdrHistogram reuse;
+
+    // The window being filled
+    uint64_t window_seq;
+    uint64_t window_counts[LOCALITY_SIGNATURE_DIMS];
+    uint64_t window_references;
+    uint64_t window_cold;
+    uint64_t* window_pages;             // Distinct pages of the window
+    uint64_t window_page_count;
+    uint64_t window_page_capacity;
+    HdrHistogram window_reuse;
+
+    LocalityPhase* phases;
+    int phase_count;
+    int labels;
+    uint64_t phase_changes;
+    bool failed;                        // Out of memory; the stream is no longer analysed
+} LocalityProcess;
+
+extern bool locality_enabled;
+extern int locality_window;
+extern LocalityProcess locality_processes[MAX_PROCESSES];
+
+// Function Prototypes
+void reset_locality();
+void locality_observe(int pid, uint64_t address);
+void locality_flush();
+uint64_t locality_frames_for(const HdrHistogram* reuse, uint64_t references, double hit_percent);
+void display_locality_report();
+void run_locality_simulation(int refs, uint64_t seed);
+
+#endif // LOCALITY_H
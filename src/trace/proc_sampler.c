@@ -0,0 +1,568 @@
+/**
+ * proc_sampler.c
+ * Live process page access sampling implementation
+ *
+ * Each interval is armed and then scanned. Arming clears the soft-dirty
+ * and referenced bits through /proc/<pid>/clear_refs and, with idle page
+ * tracking, marks every resident page frame idle. Scanning walks
+ * /proc/<pid>/pagemap in PROC_PAGEMAP_BATCH-entry preads and reports a
+ * page as accessed when its frame lost the idle flag, or, without idle
+ * tracking, when it became soft-dirty. Kernels built without soft-dirty
+ * support only reveal first touches: pages that became present during
+ * the interval, which are reported as new resident pages rather than as
+ * accesses. The smaps Referenced total, cleared at arming, still gives the
+ * interval's access volume in every mode. Accessed pages are emitted as
+ * references stamped with the interval number, so the result is a
+ * time-sliced trace of the live process.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "proc_sampler.h"
+#include "replay.h"
+#include "trace_binary.h"
+#include "../../include/common_defs.h"
+#include "../core/memory_manager.h"
+
+// pagemap entry layout (Documentation/admin-guide/mm/pagemap.rst)
+#define PM_PRESENT     (1ULL << 63)
+#define PM_SOFT_DIRTY  (1ULL << 55)
+#define PM_PFN_MASK    ((1ULL << 55) - 1)
+
+#define PAGE_IDLE_BITMAP "/sys/kernel/mm/page_idle/bitmap"
+#define PROC_EMIT_BATCH 1024
+
+// Pending references of a scan, flushed to the consumer in batches
+typedef struct {
+    MemoryReference refs[PROC_EMIT_BATCH];
+    int count;
+    TraceBlockConsumer consumer;
+    void* context;
+} EmitBuffer;
+
+// One 64-frame word of the idle bitmap, cached so neighbouring frames
+// cost a single pread/pwrite
+typedef struct {
+    uint64_t index;
+    uint64_t bits;
+    int valid;
+} IdleWord;
+
+// Parse a method name given on the command line
+SampleMethod sample_method_from_name(const char* name) {
+    if(strcmp(name, "idle") == 0) return SAMPLE_PAGE_IDLE;
+    if(strcmp(name, "softdirty") == 0) return SAMPLE_SOFT_DIRTY;
+    if(strcmp(name, "residency") == 0) return SAMPLE_RESIDENCY;
+    return SAMPLE_AUTO;
+}
+
+// Display name of a method
+const char* sample_method_name(SampleMethod method) {
+    switch(method) {
+        case SAMPLE_PAGE_IDLE:  return "idle page tracking";
+        case SAMPLE_SOFT_DIRTY: return "soft-dirty";
+        case SAMPLE_RESIDENCY:  return "residency (new resident pages only)";
+        default:                return "auto";
+    }
+}
+
+// Kernel tracks soft-dirty bits (CONFIG_MEM_SOFT_DIRTY): probe on a
+// private page of our own
+static int soft_dirty_supported() {
+    static int supported = -1;
+    if(supported != -1) {
+        return supported;
+    }
+
+    supported = 0;
+    long page_size = sysconf(_SC_PAGESIZE);
+    volatile char* page = (volatile char*)mmap(NULL, page_size, PROT_READ | PROT_WRITE,
+                                               MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    int clear_fd = open("/proc/self/clear_refs", O_WRONLY);
+    int pagemap_fd = open("/proc/self/pagemap", O_RDONLY);
+
+    if(page != MAP_FAILED && clear_fd >= 0 && pagemap_fd >= 0) {
+        uint64_t entry = 0;
+        page[0] = 1;
+        if(write(clear_fd, "4", 1) == 1) {
+            page[0] = 2;
+            if(pread(pagemap_fd, &entry, sizeof(entry),
+                     ((uintptr_t)page / page_size) * sizeof(entry)) == sizeof(entry)) {
+                supported = (entry & PM_SOFT_DIRTY) != 0;
+            }
+        }
+    }
+
+    if(page != MAP_FAILED) munmap((void*)page, page_size);
+    if(clear_fd >= 0) close(clear_fd);
+    if(pagemap_fd >= 0) close(pagemap_fd);
+    return supported;
+}
+
+// Best method that needs no page frame numbers
+static SampleMethod unprivileged_method() {
+    return soft_dirty_supported() ? SAMPLE_SOFT_DIRTY : SAMPLE_RESIDENCY;
+}
+
+// Attach to a running process
+ProcSampler* proc_sampler_open(int pid, SampleMethod method) {
+    char path[64];
+
+    ProcSampler* sampler = (ProcSampler*)calloc(1, sizeof(ProcSampler));
+    if(sampler == NULL) {
+        printf("Error: Memory allocation failed\n");
+        return NULL;
+    }
+    sampler->pid = pid;
+    sampler->method = method;
+    sampler->idle_fd = -1;
+    sampler->pagemap_batch = (uint64_t*)malloc(PROC_PAGEMAP_BATCH * sizeof(uint64_t));
+
+    snprintf(path, sizeof(path), "/proc/%d/pagemap", pid);
+    sampler->pagemap_fd = open(path, O_RDONLY);
+    snprintf(path, sizeof(path), "/proc/%d/clear_refs", pid);
+    sampler->clear_refs_fd = open(path, O_WRONLY);
+
+    if(sampler->pagemap_batch == NULL || sampler->pagemap_fd < 0 || sampler->clear_refs_fd < 0) {
+        printf("Error: Cannot attach to process %d (%s)\n", pid, strerror(errno));
+        proc_sampler_close(sampler);
+        return NULL;
+    }
+
+    if(method == SAMPLE_AUTO || method == SAMPLE_PAGE_IDLE) {
+        sampler->idle_fd = open(PAGE_IDLE_BITMAP, O_RDWR);
+        if(sampler->idle_fd < 0) {
+            if(method == SAMPLE_PAGE_IDLE) {
+                printf("Error: %s unavailable (%s)\n", PAGE_IDLE_BITMAP, strerror(errno));
+                proc_sampler_close(sampler);
+                return NULL;
+            }
+            sampler->method = unprivileged_method();
+        } else {
+            sampler->method = SAMPLE_PAGE_IDLE;
+        }
+    } else if(method == SAMPLE_SOFT_DIRTY && !soft_dirty_supported()) {
+        printf("Error: Kernel does not track soft-dirty pages\n");
+        proc_sampler_close(sampler);
+        return NULL;
+    }
+
+    return sampler;
+}
+
+// Detach and close every descriptor
+void proc_sampler_close(ProcSampler* sampler) {
+    if(sampler == NULL) {
+        return;
+    }
+    if(sampler->pagemap_fd >= 0) close(sampler->pagemap_fd);
+    if(sampler->clear_refs_fd >= 0) close(sampler->clear_refs_fd);
+    if(sampler->idle_fd >= 0) close(sampler->idle_fd);
+    free(sampler->pagemap_batch);
+    free(sampler->resident);
+    free(sampler);
+}
+
+// Reload the target's mappings from /proc/<pid>/maps
+static int read_maps(ProcSampler* sampler) {
+    char path[64];
+    char line[512];
+
+    snprintf(path, sizeof(path), "/proc/%d/maps", sampler->pid);
+    FILE* maps = fopen(path, "r");
+    if(maps == NULL) {
+        printf("Error: Process %d is gone\n", sampler->pid);
+        return -1;
+    }
+
+    sampler->vma_count = 0;
+    while(fgets(line, sizeof(line), maps) != NULL && sampler->vma_count < PROC_MAX_VMAS) {
+        ProcVma* vma = &sampler->vmas[sampler->vma_count];
+        int name_offset = 0;
+
+        memset(vma, 0, sizeof(ProcVma));
+        if(sscanf(line, "%llx-%llx %4s %*s %*s %*s %n",
+                  &vma->start, &vma->end, vma->perms, &name_offset) < 3) {
+            continue;
+        }
+
+        // Unreadable guard regions and the legacy vsyscall page never hold data
+        if(vma->perms[0] != 'r' || strstr(line, "[vsyscall]") != NULL) {
+            continue;
+        }
+
+        if(name_offset > 0) {
+            line[strcspn(line, "\n")] = '\0';
+            snprintf(vma->name, sizeof(vma->name), "%s", line + name_offset);
+        }
+        sampler->vma_count++;
+    }
+
+    fclose(maps);
+    return 0;
+}
+
+// Fill per-mapping Rss and Referenced from /proc/<pid>/smaps
+static void read_smaps(ProcSampler* sampler) {
+    char path[64];
+    char line[512];
+    ProcVma* current = NULL;
+
+    snprintf(path, sizeof(path), "/proc/%d/smaps", sampler->pid);
+    FILE* smaps = fopen(path, "r");
+    if(smaps == NULL) {
+        return;
+    }
+
+    while(fgets(line, sizeof(line), smaps) != NULL) {
+        unsigned long long start, end, kb;
+
+        if(sscanf(line, "%llx-%llx ", &start, &end) == 2) {
+            current = NULL;
+            for(int i = 0; i < sampler->vma_count; i++) {
+                if(sampler->vmas[i].start == start) {
+                    current = &sampler->vmas[i];
+                    break;
+                }
+            }
+        } else if(current != NULL && sscanf(line, "Rss: %llu kB", &kb) == 1) {
+            current->rss_kb = kb;
+        } else if(current != NULL && sscanf(line, "Referenced: %llu kB", &kb) == 1) {
+            current->referenced_kb = kb;
+        }
+    }
+
+    fclose(smaps);
+}
+
+// Write a command to clear_refs
+static int clear_refs(ProcSampler* sampler, const char* command) {
+    if(write(sampler->clear_refs_fd, command, strlen(command)) < 0) {
+        printf("Error: clear_refs '%s' failed for process %d (%s)\n",
+               command, sampler->pid, strerror(errno));
+        return -1;
+    }
+    return 0;
+}
+
+// Hand buffered references to the consumer
+static void emit_flush(EmitBuffer* emit) {
+    if(emit->count > 0 && emit->consumer != NULL) {
+        emit->consumer(emit->refs, emit->count, emit->context);
+    }
+    emit->count = 0;
+}
+
+// Write back a word of idle bits being assembled for arming
+static void idle_write(ProcSampler* sampler, IdleWord* word) {
+    if(word->valid && word->bits != 0 && sampler->idle_errno == 0 &&
+       pwrite(sampler->idle_fd, &word->bits, sizeof(uint64_t),
+              word->index * sizeof(uint64_t)) != sizeof(uint64_t)) {
+        // Nothing marked idle would make every frame look accessed
+        sampler->idle_errno = errno ? errno : EIO;
+    }
+    word->valid = 0;
+    word->bits = 0;
+}
+
+// Frame is still idle since arming
+static int idle_check(ProcSampler* sampler, IdleWord* word, uint64_t pfn) {
+    if(!word->valid || word->index != pfn / 64) {
+        word->index = pfn / 64;
+        word->valid = pread(sampler->idle_fd, &word->bits, sizeof(uint64_t),
+                            word->index * sizeof(uint64_t)) == sizeof(uint64_t);
+        if(!word->valid) {
+            word->bits = 0;
+        }
+    }
+    return (word->bits >> (pfn % 64)) & 1;
+}
+
+// Size and clear the residency bitmap for the current mappings
+static int reset_resident_bits(ProcSampler* sampler, uint64_t page_size) {
+    uint64_t pages = 0;
+    for(int v = 0; v < sampler->vma_count; v++) {
+        pages += (sampler->vmas[v].end - sampler->vmas[v].start) / page_size;
+    }
+
+    uint64_t words = pages / 64 + 1;
+    if(words > sampler->resident_words) {
+        uint64_t* bits = (uint64_t*)realloc(sampler->resident, words * sizeof(uint64_t));
+        if(bits == NULL) {
+            printf("Error: Memory allocation failed\n");
+            return -1;
+        }
+        sampler->resident = bits;
+        sampler->resident_words = words;
+    }
+    memset(sampler->resident, 0, sampler->resident_words * sizeof(uint64_t));
+    return 0;
+}
+
+// Walk pagemap for every mapping. When arming, resident frames are marked
+// idle (or recorded as resident); otherwise accessed pages are emitted.
+// Returns the frames seen
+static unsigned long long scan_pagemap(ProcSampler* sampler, int arming, EmitBuffer* emit) {
+    unsigned long long frames = 0;
+    uint64_t page_size = (uint64_t)sysconf(_SC_PAGESIZE);
+    uint64_t position = 0;
+    IdleWord word = {0, 0, 0};
+    int use_idle = (sampler->method == SAMPLE_PAGE_IDLE);
+    int use_residency = (sampler->method == SAMPLE_RESIDENCY);
+
+    if(arming && use_residency && reset_resident_bits(sampler, page_size) != 0) {
+        return 0;
+    }
+
+    for(int v = 0; v < sampler->vma_count; v++) {
+        ProcVma* vma = &sampler->vmas[v];
+        uint64_t first = vma->start / page_size;
+        uint64_t last = vma->end / page_size;
+
+        for(uint64_t page = first; page < last; page += PROC_PAGEMAP_BATCH) {
+            uint64_t count = last - page < PROC_PAGEMAP_BATCH ? last - page : PROC_PAGEMAP_BATCH;
+            ssize_t got = pread(sampler->pagemap_fd, sampler->pagemap_batch,
+                                count * sizeof(uint64_t), page * sizeof(uint64_t));
+            sampler->pagemap_reads++;
+            if(got <= 0) {
+                position += last - page;    // Keep later mappings on their own bits
+                break;
+            }
+
+            uint64_t returned = (uint64_t)got / sizeof(uint64_t);
+            for(uint64_t i = 0; i < returned; i++) {
+                uint64_t entry = sampler->pagemap_batch[i];
+                uint64_t slot = position + i;
+                if(!(entry & PM_PRESENT)) {
+                    continue;
+                }
+
+                uint64_t pfn = entry & PM_PFN_MASK;
+                if(pfn != 0) {
+                    frames++;
+                }
+
+                if(arming) {
+                    if(use_residency) {
+                        sampler->resident[slot / 64] |= 1ULL << (slot % 64);
+                    } else if(use_idle && pfn != 0) {
+                        if(word.valid && word.index != pfn / 64) {
+                            idle_write(sampler, &word);
+                        }
+                        word.index = pfn / 64;
+                        word.valid = 1;
+                        word.bits |= 1ULL << (pfn % 64);
+                    }
+                    continue;
+                }
+
+                sampler->present_pages++;
+                int written = (entry & PM_SOFT_DIRTY) != 0;
+                int accessed;
+                if(use_idle) {
+                    accessed = pfn != 0 && !idle_check(sampler, &word, pfn);
+                } else if(use_residency) {
+                    accessed = !((sampler->resident[slot / 64] >> (slot % 64)) & 1);
+                } else {
+                    accessed = written;
+                }
+                if(!accessed) {
+                    continue;
+                }
+
+                vma->accessed_pages++;
+                sampler->accessed_pages++;
+                if(written) {
+                    sampler->written_pages++;
+                }
+
+                MemoryReference* ref = &emit->refs[emit->count++];
+                ref->address = (page + i) * page_size;
+                ref->timestamp = sampler->intervals;
+                ref->pid = sampler->pid;
+                ref->is_write = written;
+                if(emit->count == PROC_EMIT_BATCH) {
+                    emit_flush(emit);
+                }
+            }
+            sampler->pages_scanned += returned;
+            position += count;
+        }
+    }
+
+    if(arming && use_idle) {
+        idle_write(sampler, &word);
+    }
+    return frames;
+}
+
+// Reset access state so the next scan sees only what happens from now on
+int proc_sampler_begin_interval(ProcSampler* sampler) {
+    if(read_maps(sampler) != 0) {
+        return -1;
+    }
+
+    // 4: soft-dirty bits (write detection), 1: referenced bits (smaps)
+    if(clear_refs(sampler, "4") != 0 || clear_refs(sampler, "1") != 0) {
+        return -1;
+    }
+
+    if(sampler->method == SAMPLE_PAGE_IDLE) {
+        // Frame numbers read back as zero without CAP_SYS_ADMIN
+        if(scan_pagemap(sampler, 1, NULL) == 0) {
+            sampler->method = unprivileged_method();
+            printf("Note: page frame numbers hidden, falling back to %s sampling\n",
+                   sample_method_name(sampler->method));
+        } else if(sampler->idle_errno != 0) {
+            sampler->method = unprivileged_method();
+            printf("Note: cannot mark pages idle (%s), falling back to %s sampling\n",
+                   strerror(sampler->idle_errno), sample_method_name(sampler->method));
+        }
+        if(sampler->method != SAMPLE_PAGE_IDLE) {
+            close(sampler->idle_fd);
+            sampler->idle_fd = -1;
+        }
+    }
+    if(sampler->method == SAMPLE_RESIDENCY) {
+        scan_pagemap(sampler, 1, NULL);
+    }
+    return 0;
+}
+
+// Scan the interval just ended and emit its accessed pages
+int proc_sampler_end_interval(ProcSampler* sampler, TraceBlockConsumer consumer, void* context) {
+    EmitBuffer* emit = (EmitBuffer*)malloc(sizeof(EmitBuffer));
+    if(emit == NULL) {
+        printf("Error: Memory allocation failed\n");
+        return -1;
+    }
+    emit->count = 0;
+    emit->consumer = consumer;
+    emit->context = context;
+
+    scan_pagemap(sampler, 0, emit);
+    emit_flush(emit);
+    free(emit);
+
+    read_smaps(sampler);
+    sampler->intervals++;
+    return 0;
+}
+
+// Referenced KB of every mapping in the last interval, from smaps
+static unsigned long long referenced_kb(const ProcSampler* sampler) {
+    unsigned long long total = 0;
+    for(int i = 0; i < sampler->vma_count; i++) {
+        total += sampler->vmas[i].referenced_kb;
+    }
+    return total;
+}
+
+// Sampled pages go to the simulator and optionally to a binary trace
+static void sample_consumer(const MemoryReference* refs, int count, void* context) {
+    TraceWriter* writer = (TraceWriter*)context;
+
+    replay_references(refs, count);
+    for(int i = 0; writer != NULL && i < count; i++) {
+        trace_writer_append(writer, &refs[i]);
+    }
+}
+
+// Sample a live process for a number of intervals and replay what it touched
+int run_proc_sampler(int pid, int intervals, int interval_ms, SampleMethod method,
+                     const char* trace_path) {
+    ProcSampler* sampler = proc_sampler_open(pid, method);
+    if(sampler == NULL) {
+        return -1;
+    }
+
+    TraceWriter* writer = NULL;
+    if(trace_path != NULL) {
+        writer = trace_writer_open(trace_path, PAGE_SIZE, TRACE_DEFAULT_BLOCK_RECORDS);
+        if(writer == NULL) {
+            proc_sampler_close(sampler);
+            return -1;
+        }
+    }
+
+    printf("Sampling process %d: %d intervals of %d ms using %s\n",
+           pid, intervals, interval_ms, sample_method_name(sampler->method));
+    printf("\nInterval  Present  %8s  Written   Ref KB\n",
+           sampler->method == SAMPLE_RESIDENCY ? "New" : "Accessed");
+    printf("--------  -------  --------  -------  -------\n");
+
+    struct timespec pause;
+    pause.tv_sec = interval_ms / 1000;
+    pause.tv_nsec = (interval_ms % 1000) * 1000000L;
+
+    int status = 0;
+    for(int i = 0; i < intervals && status == 0; i++) {
+        unsigned long long present = sampler->present_pages;
+        unsigned long long accessed = sampler->accessed_pages;
+        unsigned long long written = sampler->written_pages;
+
+        if(proc_sampler_begin_interval(sampler) != 0) {
+            status = -1;
+            break;
+        }
+        nanosleep(&pause, NULL);
+        if(kill(pid, 0) != 0 && errno == ESRCH) {
+            printf("Process %d exited\n", pid);
+            break;
+        }
+        status = proc_sampler_end_interval(sampler, sample_consumer, writer);
+
+        printf("%8d  %7llu  %8llu  %7llu  %7llu\n", i + 1,
+               sampler->present_pages - present,
+               sampler->accessed_pages - accessed,
+               sampler->written_pages - written,
+               referenced_kb(sampler));
+    }
+
+    if(writer != NULL && trace_writer_close(writer) != 0) {
+        status = -1;
+    }
+
+    display_proc_sampler_report(sampler);
+    proc_sampler_close(sampler);
+    return status;
+}
+
+// Display sampling totals and the busiest mappings of the last interval
+void display_proc_sampler_report(const ProcSampler* sampler) {
+    printf("\n================ LIVE PROCESS SAMPLE ================\n");
+    printf("Process: %d, Method: %s, Intervals: %llu\n",
+           sampler->pid, sample_method_name(sampler->method), sampler->intervals);
+    printf("Pages scanned: %llu in %llu pagemap reads\n",
+           sampler->pages_scanned, sampler->pagemap_reads);
+    if(sampler->method == SAMPLE_RESIDENCY) {
+        printf("New resident pages: %llu (%llu written); accesses to resident pages\n",
+               sampler->accessed_pages, sampler->written_pages);
+        printf("are not visible in this mode, see Ref KB for the access volume\n");
+    } else {
+        printf("Accessed pages: %llu (%llu written)\n",
+               sampler->accessed_pages, sampler->written_pages);
+    }
+
+    printf("\nLast interval by mapping:\n");
+    printf("Start             End               Perm   Rss KB   Ref KB  %8s  Name\n",
+           sampler->method == SAMPLE_RESIDENCY ? "New" : "Accessed");
+    printf("----------------  ----------------  ----  -------  -------  --------  ----\n");
+    for(int i = 0; i < sampler->vma_count; i++) {
+        const ProcVma* vma = &sampler->vmas[i];
+        if(vma->rss_kb == 0 && vma->accessed_pages == 0) {
+            continue;
+        }
+        printf("%016llx  %016llx  %-4s  %7llu  %7llu  %8llu  %s\n",
+               vma->start, vma->end, vma->perms, vma->rss_kb,
+               vma->referenced_kb, vma->accessed_pages, vma->name);
+    }
+    printf("=====================================================\n");
+}
@@ -0,0 +1,67 @@
+/**
+ * proc_sampler.h
+ * Live process page access sampling through /proc (Linux)
+ */
+
+#ifndef PROC_SAMPLER_H
+#define PROC_SAMPLER_H
+
+#include <stdint.h>
+#include "../../include/common_defs.h"
+#include "trace_mmap.h"
+
+#define PROC_MAX_VMAS 512
+#define PROC_PAGEMAP_BATCH 4096     // pagemap entries per pread (32 KB)
+
+// How accesses are detected between two samples
+typedef enum {
+    SAMPLE_AUTO,        // Best method the kernel and privileges allow
+    SAMPLE_PAGE_IDLE,   // /sys/kernel/mm/page_idle: reads and writes, needs root
+    SAMPLE_SOFT_DIRTY,  // clear_refs + pagemap soft-dirty bit: writes and first touches
+    SAMPLE_RESIDENCY    // pagemap present bit only: new resident pages, not accesses
+} SampleMethod;
+
+// One mapping of the target, with smaps counters from the last interval
+typedef struct {
+    unsigned long long start;
+    unsigned long long end;
+    char perms[5];
+    char name[64];
+    unsigned long long rss_kb;
+    unsigned long long referenced_kb;
+    unsigned long long accessed_pages;
+} ProcVma;
+
+// Sampler attached to one process
+typedef struct {
+    int pid;
+    SampleMethod method;
+    int pagemap_fd;
+    int clear_refs_fd;
+    int idle_fd;
+    int idle_errno;             // Arming the idle bitmap failed; idle tracking is abandoned
+    ProcVma vmas[PROC_MAX_VMAS];
+    int vma_count;
+    uint64_t* pagemap_batch;
+    uint64_t* resident;         // Present bits at arming, one per scanned page
+    uint64_t resident_words;
+    unsigned long long intervals;
+    unsigned long long pages_scanned;
+    unsigned long long present_pages;
+    unsigned long long accessed_pages;
+    unsigned long long written_pages;
+    unsigned long long pagemap_reads;
+} ProcSampler;
+
+// Function Prototypes
+ProcSampler* proc_sampler_open(int pid, SampleMethod method);
+int proc_sampler_begin_interval(ProcSampler* sampler);
+int proc_sampler_end_interval(ProcSampler* sampler, TraceBlockConsumer consumer, void* context);
+void proc_sampler_close(ProcSampler* sampler);
+int run_proc_sampler(int pid, int intervals, int interval_ms, SampleMethod method,
+                     const char* trace_path);
+void display_proc_sampler_report(const ProcSampler* sampler);
+SampleMethod sample_method_from_name(const char* name);
+const char* sample_method_name(SampleMethod method);
+
+#endif // PROC_SAMPLER_H
@@ -0,0 +1,205 @@
+/**
+ * replay.c
+ * Batch trace replay implementation
+ *
+ * Feeds batches of references from any workload source into the memory
+ * manager with per-access tracing switched off. Source pids are mapped
+ * onto simulator process slots on first sight, and source addresses are
+ * folded into the simulated virtual address space.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "replay.h"
+#include "trace_binary.h"
+#include "locality.h"
+#include "../../include/common_defs.h"
+#include "../core/memory_manager.h"
+
+ReplayStats replay_stats;
+
+// Source pid -> simulator pid
+static int pid_map_source[MAX_PROCESSES];
+static int pid_map_slot[MAX_PROCESSES];
+static int pid_map_count = 0;
+
+// Forget the pid mapping and clear the counters
+void replay_reset() {
+    pid_map_count = 0;
+    replay_stats.references = 0;
+    replay_stats.writes = 0;
+    replay_stats.faults = 0;
+    replay_stats.batches = 0;
+    replay_stats.source_pids = 0;
+    replay_stats.folded_references = 0;
+    replay_stats.seconds = 0.0;
+    reset_locality();
+}
+
+// Simulator process for a source pid, created on first reference
+int replay_map_pid(int source_pid) {
+    for(int i = 0; i < pid_map_count; i++) {
+        if(pid_map_source[i] == source_pid) {
+            return pid_map_slot[i];
+        }
+    }
+
+    int slot = -1;
+    if(pid_map_count < MAX_PROCESSES) {
+        char name[50];
+        snprintf(name, sizeof(name), "pid %d", source_pid);
+        slot = create_process(name);
+    }
+
+    // No free process slot: share one with an already mapped pid
+    if(slot == -1) {
+        if(pid_map_count == 0) {
+            return -1;
+        }
+        replay_stats.folded_references++;
+        return pid_map_slot[(unsigned)source_pid % pid_map_count];
+    }
+
+    pid_map_source[pid_map_count] = source_pid;
+    pid_map_slot[pid_map_count] = slot;
+    pid_map_count++;
+    replay_stats.source_pids++;
+    return slot;
+}
+
+// Replay a batch of references, returns how many were applied
+int replay_references(const MemoryReference* refs, int count) {
+    int saved_verbose = verbose_mode;
+    int applied = 0;
+
+    verbose_mode = 0;
+    for(int i = 0; i < count; i++) {
+        int pid = replay_map_pid(refs[i].pid);
+        if(pid == -1) {
+            continue;
+        }
+
+        if(locality_enabled) {
+            locality_observe(pid, refs[i].address);
+        }
+
+        int faults_before = processes[pid].page_faults;
+        if(access_memory_ex(pid, fold_virtual_address(refs[i].address), refs[i].is_write) < 0) {
+            continue;
+        }
+
+        applied++;
+        replay_stats.references++;
+        if(refs[i].is_write) {
+            replay_stats.writes++;
+        }
+        if(processes[pid].page_faults != faults_before) {
+            replay_stats.faults++;
+        }
+    }
+    verbose_mode = saved_verbose;
+
+    replay_stats.batches++;
+    return applied;
+}
+
+// Stream a text trace through the simulator in fixed-size batches
+int replay_trace_file(const char* path, TraceFormat format, int default_pid) {
+    TraceReader* reader = trace_reader_open(path, format, default_pid);
+    if(reader == NULL) {
+        return -1;
+    }
+
+    MemoryReference* batch = (MemoryReference*)malloc(REPLAY_BATCH_SIZE * sizeof(MemoryReference));
+    if(batch == NULL) {
+        printf("Error: Memory allocation failed\n");
+        trace_reader_close(reader);
+        return -1;
+    }
+
+    struct timespec begin, end;
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+
+    int count;
+    while((count = trace_reader_read_batch(reader, batch, REPLAY_BATCH_SIZE)) > 0) {
+        replay_references(batch, count);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    replay_stats.seconds += (end.tv_sec - begin.tv_sec) + (end.tv_nsec - begin.tv_nsec) / 1e9;
+
+    printf("Trace '%s' (%s): %llu lines, %llu references, %llu skipped\n",
+           path, trace_format_name(format),
+           reader->lines, reader->records, reader->skipped);
+
+    free(batch);
+    trace_reader_close(reader);
+    return 0;
+}
+
+// Replay a binary trace block by block
+int replay_binary_trace(const char* path) {
+    TraceBinaryReader* reader = trace_binary_open(path);
+    if(reader == NULL) {
+        return -1;
+    }
+
+    MemoryReference* block = (MemoryReference*)malloc(reader->header.block_records *
+                                                      sizeof(MemoryReference));
+    if(block == NULL) {
+        printf("Error: Memory allocation failed\n");
+        trace_binary_close(reader);
+        return -1;
+    }
+
+    struct timespec begin, end;
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+
+    int status = 0;
+    for(uint64_t b = 0; b < reader->header.block_count; b++) {
+        int count = trace_binary_read_block(reader, b, block);
+        if(count < 0) {
+            printf("Error: Block %llu of '%s' is corrupt\n", (unsigned long long)b, path);
+            status = -1;
+            break;
+        }
+        for(int offset = 0; offset < count; offset += REPLAY_BATCH_SIZE) {
+            int batch = count - offset;
+            replay_references(block + offset, batch < REPLAY_BATCH_SIZE ? batch : REPLAY_BATCH_SIZE);
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    replay_stats.seconds += (end.tv_sec - begin.tv_sec) + (end.tv_nsec - begin.tv_nsec) / 1e9;
+
+    printf("Binary trace '%s': %llu references in %llu blocks\n", path,
+           (unsigned long long)reader->header.record_count,
+           (unsigned long long)reader->header.block_count);
+
+    free(block);
+    trace_binary_close(reader);
+    return status;
+}
+
+// Display replay counters
+void display_replay_report() {
+    printf("\n=================== TRACE REPLAY ===================\n");
+    printf("References replayed: %llu (%llu writes)\n",
+           replay_stats.references, replay_stats.writes);
+    printf("Page faults: %llu (%.2f%%)\n", replay_stats.faults,
+           replay_stats.references > 0 ?
+           (replay_stats.faults * 100.0) / replay_stats.references : 0.0);
+    printf("Batches: %llu of up to %d references\n",
+           replay_stats.batches, REPLAY_BATCH_SIZE);
+    printf("Source processes: %d\n", replay_stats.source_pids);
+    if(replay_stats.folded_references > 0) {
+        printf("References folded onto shared slots: %llu\n",
+               replay_stats.folded_references);
+    }
+    if(replay_stats.seconds > 0) {
+        printf("Replay rate: %.0f references/second\n",
+               replay_stats.references / replay_stats.seconds);
+    }
+    printf("====================================================\n");
+}
@@ -0,0 +1,36 @@
+/**
+ * replay.h
+ * Batch trace replay module header
+ */
+
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "../../include/common_defs.h"
+#include "trace_reader.h"
+
+// References handed to the simulator per batch
+#define REPLAY_BATCH_SIZE 4096
+
+// Replay counters
+typedef struct {
+    unsigned long long references;
+    unsigned long long writes;
+    unsigned long long faults;
+    unsigned long long batches;
+    int source_pids;        // Distinct pids seen in the trace
+    unsigned long long folded_references;  // From pids sharing a slot (table full)
+    double seconds;
+} ReplayStats;
+
+extern ReplayStats replay_stats;
+
+// Function Prototypes
+void replay_reset();
+int replay_map_pid(int source_pid);
+int replay_references(const MemoryReference* refs, int count);
+int replay_trace_file(const char* path, TraceFormat format, int default_pid);
+int replay_binary_trace(const char* path);
+void display_replay_report();
+
+#endif // REPLAY_H
@@ -0,0 +1,584 @@
+/**
+ * trace_binary.c
+ * Compact binary trace format implementation
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "trace_binary.h"
+#include "../../include/common_defs.h"
+
+// ==================== BYTE ORDER HELPERS ====================
+
+static void put_u16(uint8_t* p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void put_u32(uint8_t* p, uint32_t v) {
+    for(int i = 0; i < 4; i++) {
+        p[i] = (uint8_t)(v >> (8 * i));
+    }
+}
+
+static void put_u64(uint8_t* p, uint64_t v) {
+    for(int i = 0; i < 8; i++) {
+        p[i] = (uint8_t)(v >> (8 * i));
+    }
+}
+
+static uint16_t get_u16(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get_u32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+           ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint64_t get_u64(const uint8_t* p) {
+    return (uint64_t)get_u32(p) | ((uint64_t)get_u32(p + 4) << 32);
+}
+
+// Append an unsigned LEB128 varint, returns bytes written
+static size_t put_varint(uint8_t* p, uint64_t v) {
+    size_t n = 0;
+    while(v >= 0x80) {
+        p[n++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    p[n++] = (uint8_t)v;
+    return n;
+}
+
+// Read a varint, returns the next input position or NULL if truncated
+static const uint8_t* get_varint(const uint8_t* p, const uint8_t* end, uint64_t* value) {
+    uint64_t v = 0;
+    int shift = 0;
+
+    while(p < end && shift < 64) {
+        uint8_t byte = *p++;
+        v |= (uint64_t)(byte & 0x7f) << shift;
+        if(byte < 0x80) {
+            *value = v;
+            return p;
+        }
+        shift += 7;
+    }
+    return NULL;
+}
+
+// ==================== HEADER AND INDEX ====================
+
+static void encode_header(const TraceBinaryHeader* header, uint8_t* data) {
+    memset(data, 0, TRACE_HEADER_SIZE);
+    memcpy(data, TRACE_MAGIC, 4);
+    put_u16(data + 4, header->version);
+    put_u32(data + 8, header->page_size);
+    put_u32(data + 12, header->block_records);
+    put_u32(data + 16, header->pid_count);
+    put_u64(data + 24, header->record_count);
+    put_u64(data + 32, header->block_count);
+    put_u64(data + 40, header->index_offset);
+    put_u64(data + 48, header->pid_table_offset);
+}
+
+// Decode and validate a header, returns 0 on success
+int trace_binary_parse_header(const uint8_t* data, size_t size, TraceBinaryHeader* header) {
+    if(size < TRACE_HEADER_SIZE || memcmp(data, TRACE_MAGIC, 4) != 0) {
+        return -1;
+    }
+
+    header->version = get_u16(data + 4);
+    header->page_size = get_u32(data + 8);
+    header->block_records = get_u32(data + 12);
+    header->pid_count = get_u32(data + 16);
+    header->record_count = get_u64(data + 24);
+    header->block_count = get_u64(data + 32);
+    header->index_offset = get_u64(data + 40);
+    header->pid_table_offset = get_u64(data + 48);
+
+    if(header->version != TRACE_VERSION || header->page_size == 0 ||
+       header->block_records == 0) {
+        return -1;
+    }
+    return 0;
+}
+
+// Decode one index entry
+void trace_binary_parse_index_entry(const uint8_t* data, TraceBlockIndex* entry) {
+    entry->offset = get_u64(data);
+    entry->length = get_u32(data + 8);
+    entry->record_count = get_u32(data + 12);
+    entry->first_record = get_u64(data + 16);
+}
+
+// ==================== ENCODER ====================
+
+// Create a binary trace; block_records of 0 selects the default
+TraceWriter* trace_writer_open(const char* path, uint32_t page_size, uint32_t block_records) {
+    if(page_size == 0) {
+        printf("Error: Page size must be positive\n");
+        return NULL;
+    }
+
+    TraceWriter* writer = (TraceWriter*)calloc(1, sizeof(TraceWriter));
+    if(writer == NULL) {
+        printf("Error: Memory allocation failed\n");
+        return NULL;
+    }
+
+    writer->header.version = TRACE_VERSION;
+    writer->header.page_size = page_size;
+    writer->header.block_records = block_records ? block_records : TRACE_DEFAULT_BLOCK_RECORDS;
+    writer->block = (uint8_t*)malloc((size_t)writer->header.block_records * TRACE_MAX_RECORD_BYTES);
+    writer->file = fopen(path, "wb");
+
+    if(writer->block == NULL || writer->file == NULL) {
+        printf("Error: Could not create binary trace '%s'\n", path);
+        if(writer->file != NULL) {
+            fclose(writer->file);
+        }
+        free(writer->block);
+        free(writer);
+        return NULL;
+    }
+
+    // Header is rewritten with the final counts on close
+    uint8_t header[TRACE_HEADER_SIZE];
+    encode_header(&writer->header, header);
+    fwrite(header, 1, TRACE_HEADER_SIZE, writer->file);
+
+    writer->offset = TRACE_HEADER_SIZE;
+    writer->previous_pid_index = -1;
+    writer->last_pid = -1;
+    return writer;
+}
+
+// Pid table index for a pid, adding it on first sight
+static int64_t writer_pid_index(TraceWriter* writer, int pid) {
+    if(pid == writer->last_pid && writer->header.pid_count > 0) {
+        return writer->last_pid_index;
+    }
+
+    uint32_t index = 0;
+    while(index < writer->header.pid_count && writer->pids[index] != pid) {
+        index++;
+    }
+
+    if(index == writer->header.pid_count) {
+        if(writer->header.pid_count == writer->pid_capacity) {
+            uint32_t capacity = writer->pid_capacity ? writer->pid_capacity * 2 : 16;
+            int32_t* pids = (int32_t*)realloc(writer->pids, capacity * sizeof(int32_t));
+            if(pids == NULL) {
+                return -1;
+            }
+            writer->pids = pids;
+            writer->pid_capacity = capacity;
+        }
+        writer->pids[writer->header.pid_count++] = pid;
+    }
+
+    writer->last_pid = pid;
+    writer->last_pid_index = index;
+    return index;
+}
+
+// Write out the open block and record it in the index
+static int flush_block(TraceWriter* writer) {
+    if(writer->block_fill == 0) {
+        return 0;
+    }
+
+    if(writer->header.block_count == writer->index_capacity) {
+        uint64_t capacity = writer->index_capacity ? writer->index_capacity * 2 : 64;
+        TraceBlockIndex* index = (TraceBlockIndex*)realloc(writer->index,
+                                                           capacity * sizeof(TraceBlockIndex));
+        if(index == NULL) {
+            return -1;
+        }
+        writer->index = index;
+        writer->index_capacity = capacity;
+    }
+
+    if(fwrite(writer->block, 1, writer->block_length, writer->file) != writer->block_length) {
+        return -1;
+    }
+
+    TraceBlockIndex* entry = &writer->index[writer->header.block_count++];
+    entry->offset = writer->offset;
+    entry->length = (uint32_t)writer->block_length;
+    entry->record_count = writer->block_fill;
+    entry->first_record = writer->header.record_count - writer->block_fill;
+
+    writer->offset += writer->block_length;
+    writer->block_length = 0;
+    writer->block_fill = 0;
+    writer->previous_page = 0;
+    writer->previous_pid_index = -1;
+    return 0;
+}
+
+// Encode one reference
+int trace_writer_append(TraceWriter* writer, const MemoryReference* ref) {
+    int64_t pid_index = writer_pid_index(writer, ref->pid);
+    if(pid_index < 0) {
+        return -1;
+    }
+
+    uint64_t page = ref->address / writer->header.page_size;
+    int64_t delta = (int64_t)(page - writer->previous_page);
+    uint64_t zigzag = ((uint64_t)delta << 1) ^ (uint64_t)(delta >> 63);
+    int pid_changed = (pid_index != writer->previous_pid_index);
+
+    uint64_t tag = (zigzag << 2) | ((uint64_t)pid_changed << 1) | (ref->is_write ? 1 : 0);
+    writer->block_length += put_varint(writer->block + writer->block_length, tag);
+    if(pid_changed) {
+        writer->block_length += put_varint(writer->block + writer->block_length,
+                                           (uint64_t)pid_index);
+    }
+
+    writer->previous_page = page;
+    writer->previous_pid_index = pid_index;
+    writer->block_fill++;
+    writer->header.record_count++;
+
+    if(writer->block_fill == writer->header.block_records) {
+        return flush_block(writer);
+    }
+    return 0;
+}
+
+// Flush, write the index and pid table, finalize the header
+int trace_writer_close(TraceWriter* writer) {
+    if(writer == NULL) {
+        return -1;
+    }
+
+    int status = flush_block(writer);
+
+    uint8_t entry[TRACE_INDEX_ENTRY_SIZE];
+    writer->header.index_offset = writer->offset;
+    for(uint64_t i = 0; i < writer->header.block_count && status == 0; i++) {
+        put_u64(entry, writer->index[i].offset);
+        put_u32(entry + 8, writer->index[i].length);
+        put_u32(entry + 12, writer->index[i].record_count);
+        put_u64(entry + 16, writer->index[i].first_record);
+        if(fwrite(entry, 1, TRACE_INDEX_ENTRY_SIZE, writer->file) != TRACE_INDEX_ENTRY_SIZE) {
+            status = -1;
+        }
+    }
+    writer->offset += writer->header.block_count * TRACE_INDEX_ENTRY_SIZE;
+
+    writer->header.pid_table_offset = writer->offset;
+    for(uint32_t i = 0; i < writer->header.pid_count && status == 0; i++) {
+        put_u32(entry, (uint32_t)writer->pids[i]);
+        if(fwrite(entry, 1, 4, writer->file) != 4) {
+            status = -1;
+        }
+    }
+
+    uint8_t header[TRACE_HEADER_SIZE];
+    encode_header(&writer->header, header);
+    if(status == 0 && (fseek(writer->file, 0, SEEK_SET) != 0 ||
+       fwrite(header, 1, TRACE_HEADER_SIZE, writer->file) != TRACE_HEADER_SIZE)) {
+        status = -1;
+    }
+
+    if(fclose(writer->file) != 0) {
+        status = -1;
+    }
+    free(writer->block);
+    free(writer->index);
+    free(writer->pids);
+    free(writer);
+
+    if(status != 0) {
+        printf("Error: Failed to write binary trace\n");
+    }
+    return status;
+}
+
+// ==================== DECODER ====================
+
+// Decode one block into refs, returns the record count or -1 if corrupt
+int trace_binary_decode_block(const uint8_t* data, size_t size, uint32_t count,
+                              const TraceBinaryHeader* header, const int32_t* pids,
+                              uint64_t first_record, MemoryReference* refs) {
+    const uint8_t* p = data;
+    const uint8_t* end = data + size;
+    const uint64_t page_size = header->page_size;
+    const uint32_t pid_count = header->pid_count;
+    uint64_t page = 0;
+    int pid = 0;
+
+    for(uint32_t i = 0; i < count; i++) {
+        uint64_t tag;
+
+        // Most records are a small delta without a pid change: one byte
+        if(p < end && *p < 0x80) {
+            tag = *p++;
+        } else if((p = get_varint(p, end, &tag)) == NULL) {
+            return -1;
+        }
+
+        if(tag & 2) {
+            uint64_t index;
+            if((p = get_varint(p, end, &index)) == NULL || index >= pid_count) {
+                return -1;
+            }
+            pid = pids[index];
+        }
+
+        uint64_t zigzag = tag >> 2;
+        page += (zigzag >> 1) ^ (0 - (zigzag & 1));
+
+        refs[i].address = page * page_size;
+        refs[i].timestamp = first_record + i;
+        refs[i].pid = pid;
+        refs[i].is_write = (tag & 1) != 0;
+    }
+
+    return (int)count;
+}
+
+// Open a binary trace for block-at-a-time reading
+TraceBinaryReader* trace_binary_open(const char* path) {
+    TraceBinaryReader* reader = (TraceBinaryReader*)calloc(1, sizeof(TraceBinaryReader));
+    if(reader == NULL) {
+        printf("Error: Memory allocation failed\n");
+        return NULL;
+    }
+
+    uint8_t header[TRACE_HEADER_SIZE];
+    reader->file = fopen(path, "rb");
+    if(reader->file == NULL ||
+       fread(header, 1, TRACE_HEADER_SIZE, reader->file) != TRACE_HEADER_SIZE ||
+       trace_binary_parse_header(header, TRACE_HEADER_SIZE, &reader->header) != 0) {
+        printf("Error: '%s' is not a binary trace\n", path);
+        trace_binary_close(reader);
+        return NULL;
+    }
+
+    // Both tables must lie inside the file before anything is read from them
+    uint64_t size = 0;
+    if(fseek(reader->file, 0, SEEK_END) == 0 && ftell(reader->file) > 0) {
+        size = (uint64_t)ftell(reader->file);
+    }
+    uint64_t blocks = reader->header.block_count;
+    if(reader->header.index_offset + blocks * TRACE_INDEX_ENTRY_SIZE > size ||
+       reader->header.pid_table_offset + (uint64_t)reader->header.pid_count * 4 > size) {
+        printf("Error: Binary trace '%s' is truncated\n", path);
+        trace_binary_close(reader);
+        return NULL;
+    }
+
+    reader->index = (TraceBlockIndex*)malloc((blocks ? blocks : 1) * sizeof(TraceBlockIndex));
+    reader->pids = (int32_t*)malloc((reader->header.pid_count ? reader->header.pid_count : 1) *
+                                    sizeof(int32_t));
+    if(reader->index == NULL || reader->pids == NULL) {
+        printf("Error: Memory allocation failed\n");
+        trace_binary_close(reader);
+        return NULL;
+    }
+
+    uint8_t entry[TRACE_INDEX_ENTRY_SIZE];
+    int status = fseek(reader->file, (long)reader->header.index_offset, SEEK_SET);
+    for(uint64_t i = 0; i < blocks && status == 0; i++) {
+        if(fread(entry, 1, TRACE_INDEX_ENTRY_SIZE, reader->file) != TRACE_INDEX_ENTRY_SIZE) {
+            status = -1;
+            break;
+        }
+        trace_binary_parse_index_entry(entry, &reader->index[i]);
+        if(reader->index[i].offset + reader->index[i].length > size ||
+           reader->index[i].record_count > reader->header.block_records) {
+            printf("Error: Block %llu of '%s' lies outside the file\n",
+                   (unsigned long long)i, path);
+            trace_binary_close(reader);
+            return NULL;
+        }
+        if(reader->index[i].length > reader->block_buffer_size) {
+            reader->block_buffer_size = reader->index[i].length;
+        }
+    }
+
+    if(status == 0) {
+        status = fseek(reader->file, (long)reader->header.pid_table_offset, SEEK_SET);
+    }
+    for(uint32_t i = 0; i < reader->header.pid_count && status == 0; i++) {
+        if(fread(entry, 1, 4, reader->file) != 4) {
+            status = -1;
+            break;
+        }
+        reader->pids[i] = (int32_t)get_u32(entry);
+    }
+
+    reader->block_buffer = (uint8_t*)malloc(reader->block_buffer_size ? reader->block_buffer_size : 1);
+    if(status != 0 || reader->block_buffer == NULL) {
+        printf("Error: Binary trace '%s' is truncated\n", path);
+        trace_binary_close(reader);
+        return NULL;
+    }
+
+    return reader;
+}
+
+// Read and decode one block, returns the record count or -1 on error
+int trace_binary_read_block(TraceBinaryReader* reader, uint64_t block, MemoryReference* refs) {
+    if(block >= reader->header.block_count) {
+        return -1;
+    }
+
+    TraceBlockIndex* entry = &reader->index[block];
+    if(fseek(reader->file, (long)entry->offset, SEEK_SET) != 0 ||
+       fread(reader->block_buffer, 1, entry->length, reader->file) != entry->length) {
+        return -1;
+    }
+
+    return trace_binary_decode_block(reader->block_buffer, entry->length, entry->record_count,
+                                     &reader->header, reader->pids, entry->first_record, refs);
+}
+
+// Close a binary trace
+void trace_binary_close(TraceBinaryReader* reader) {
+    if(reader == NULL) {
+        return;
+    }
+    if(reader->file != NULL) {
+        fclose(reader->file);
+    }
+    free(reader->index);
+    free(reader->pids);
+    free(reader->block_buffer);
+    free(reader);
+}
+
+// ==================== CONVERSION ====================
+
+// Convert a text trace (Lackey, Pin, perf mem) into the binary format
+int trace_convert_text(const char* input, TraceFormat format, int default_pid,
+                       const char* output) {
+    TraceReader* reader = trace_reader_open(input, format, default_pid);
+    if(reader == NULL) {
+        return -1;
+    }
+
+    TraceWriter* writer = trace_writer_open(output, PAGE_SIZE, TRACE_DEFAULT_BLOCK_RECORDS);
+    if(writer == NULL) {
+        trace_reader_close(reader);
+        return -1;
+    }
+
+    MemoryReference ref;
+    int status = 0;
+    while(status == 0 && trace_reader_next(reader, &ref)) {
+        status = trace_writer_append(writer, &ref);
+    }
+
+    printf("Converted %llu references from '%s' (%s), %llu lines skipped\n",
+           reader->records, input, trace_format_name(format), reader->skipped);
+
+    trace_reader_close(reader);
+    if(trace_writer_close(writer) != 0) {
+        status = -1;
+    }
+    return status;
+}
+
+// Display header and block statistics of a binary trace
+void display_trace_binary_info(const char* path) {
+    TraceBinaryReader* reader = trace_binary_open(path);
+    if(reader == NULL) {
+        return;
+    }
+
+    uint64_t payload = 0;
+    for(uint64_t i = 0; i < reader->header.block_count; i++) {
+        payload += reader->index[i].length;
+    }
+
+    printf("\n================== BINARY TRACE ==================\n");
+    printf("File: %s (format v%u)\n", path, reader->header.version);
+    printf("Page size: %u bytes\n", reader->header.page_size);
+    printf("Records: %llu in %llu blocks (up to %u per block)\n",
+           (unsigned long long)reader->header.record_count,
+           (unsigned long long)reader->header.block_count,
+           reader->header.block_records);
+    printf("Encoded payload: %llu bytes (%.2f bytes/record)\n",
+           (unsigned long long)payload,
+           reader->header.record_count ? (double)payload / reader->header.record_count : 0.0);
+    printf("Processes: %u [", reader->header.pid_count);
+    for(uint32_t i = 0; i < reader->header.pid_count && i < 8; i++) {
+        printf("%s%d", i ? ", " : "", reader->pids[i]);
+    }
+    printf("%s]\n", reader->header.pid_count > 8 ? ", ..." : "");
+    printf("==================================================\n");
+
+    trace_binary_close(reader);
+}
+
+// Measure raw decode throughput: the file is loaded first so only
+// decoding is timed
+int benchmark_trace_decode(const char* path) {
+    TraceBinaryReader* reader = trace_binary_open(path);
+    if(reader == NULL) {
+        return -1;
+    }
+
+    uint64_t blocks = reader->header.block_count;
+    uint8_t** data = (uint8_t**)calloc(blocks ? blocks : 1, sizeof(uint8_t*));
+    MemoryReference* refs = (MemoryReference*)malloc(reader->header.block_records *
+                                                     sizeof(MemoryReference));
+    int status = (data != NULL && refs != NULL) ? 0 : -1;
+
+    for(uint64_t b = 0; b < blocks && status == 0; b++) {
+        data[b] = (uint8_t*)malloc(reader->index[b].length ? reader->index[b].length : 1);
+        if(data[b] == NULL ||
+           fseek(reader->file, (long)reader->index[b].offset, SEEK_SET) != 0 ||
+           fread(data[b], 1, reader->index[b].length, reader->file) != reader->index[b].length) {
+            status = -1;
+        }
+    }
+
+    if(status != 0) {
+        printf("Error: Could not load '%s' for decoding\n", path);
+    } else {
+        struct timespec begin, end;
+        unsigned long long decoded = 0;
+        volatile int sink = 0;
+
+        clock_gettime(CLOCK_MONOTONIC, &begin);
+        for(uint64_t b = 0; b < blocks; b++) {
+            TraceBlockIndex* entry = &reader->index[b];
+            int count = trace_binary_decode_block(data[b], entry->length, entry->record_count,
+                                                  &reader->header, reader->pids,
+                                                  entry->first_record, refs);
+            if(count < 0) {
+                printf("Error: Block %llu is corrupt\n", (unsigned long long)b);
+                status = -1;
+                break;
+            }
+            decoded += count;
+            // Touch the output so the decode cannot be optimized away
+            if(count > 0) {
+                sink += refs[count - 1].pid;
+            }
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        double seconds = (end.tv_sec - begin.tv_sec) + (end.tv_nsec - begin.tv_nsec) / 1e9;
+        (void)sink;
+        printf("Decoded %llu references in %.3f s (%.1f M references/second)\n",
+               decoded, seconds, seconds > 0 ? decoded / seconds / 1e6 : 0.0);
+    }
+
+    for(uint64_t b = 0; data != NULL && b < blocks; b++) {
+        free(data[b]);
+    }
+    free(data);
+    free(refs);
+    trace_binary_close(reader);
+    return status;
+}
@@ -0,0 +1,100 @@
+/**
+ * trace_binary.h
+ * Compact binary trace format (delta + varint encoded blocks)
+ *
+ * Layout (all integers little-endian):
+ *   header      TRACE_HEADER_SIZE bytes, see TraceBinaryHeader
+ *   blocks      independently decodable runs of records
+ *   index       one TRACE_INDEX_ENTRY_SIZE entry per block
+ *   pid table   pid_count 32-bit pids
+ *
+ * Each record is a varint tag = zigzag(page delta) << 2 | pid_changed << 1
+ * | is_write, followed by a varint pid table index when pid_changed is set.
+ * Delta and pid state restart at every block boundary.
+ */
+
+#ifndef TRACE_BINARY_H
+#define TRACE_BINARY_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include "../../include/common_defs.h"
+#include "trace_reader.h"
+
+#define TRACE_MAGIC "DMVT"
+#define TRACE_VERSION 1
+#define TRACE_HEADER_SIZE 64
+#define TRACE_INDEX_ENTRY_SIZE 24
+#define TRACE_DEFAULT_BLOCK_RECORDS 65536
+#define TRACE_MAX_RECORD_BYTES 15  // 10-byte tag + 5-byte pid index
+
+// File header
+typedef struct {
+    uint16_t version;
+    uint32_t page_size;
+    uint32_t block_records;     // Maximum records per block
+    uint32_t pid_count;
+    uint64_t record_count;
+    uint64_t block_count;
+    uint64_t index_offset;
+    uint64_t pid_table_offset;
+} TraceBinaryHeader;
+
+// Where a block lives and which records it holds
+typedef struct {
+    uint64_t offset;
+    uint32_t length;
+    uint32_t record_count;
+    uint64_t first_record;
+} TraceBlockIndex;
+
+// Encoder state
+typedef struct {
+    FILE* file;
+    TraceBinaryHeader header;
+    uint8_t* block;             // Encoded bytes of the open block
+    size_t block_length;
+    uint32_t block_fill;        // Records in the open block
+    uint64_t previous_page;
+    int64_t previous_pid_index;
+    TraceBlockIndex* index;
+    uint64_t index_capacity;
+    int32_t* pids;
+    uint32_t pid_capacity;
+    int last_pid;               // Cache for the common "same pid" case
+    uint32_t last_pid_index;
+    uint64_t offset;
+} TraceWriter;
+
+// Decoder state for stdio-based access
+typedef struct {
+    FILE* file;
+    TraceBinaryHeader header;
+    TraceBlockIndex* index;
+    int32_t* pids;
+    uint8_t* block_buffer;
+    size_t block_buffer_size;
+} TraceBinaryReader;
+
+// Function Prototypes
+TraceWriter* trace_writer_open(const char* path, uint32_t page_size, uint32_t block_records);
+int trace_writer_append(TraceWriter* writer, const MemoryReference* ref);
+int trace_writer_close(TraceWriter* writer);
+
+TraceBinaryReader* trace_binary_open(const char* path);
+int trace_binary_read_block(TraceBinaryReader* reader, uint64_t block, MemoryReference* refs);
+void trace_binary_close(TraceBinaryReader* reader);
+
+int trace_binary_parse_header(const uint8_t* data, size_t size, TraceBinaryHeader* header);
+void trace_binary_parse_index_entry(const uint8_t* data, TraceBlockIndex* entry);
+int trace_binary_decode_block(const uint8_t* data, size_t size, uint32_t count,
+                              const TraceBinaryHeader* header, const int32_t* pids,
+                              uint64_t first_record, MemoryReference* refs);
+
+int trace_convert_text(const char* input, TraceFormat format, int default_pid,
+                       const char* output);
+void display_trace_binary_info(const char* path);
+int benchmark_trace_decode(const char* path);
+
+#endif // TRACE_BINARY_H
@@ -0,0 +1,361 @@
+/**
+ * trace_mmap.c
+ * Zero-copy memory-mapped binary traces with parallel block decoding
+ *
+ * The trace file is mapped read-only and blocks are decoded straight out
+ * of the mapping; nothing is copied into a heap buffer. Decoder threads
+ * claim blocks in file order and publish them into a bounded ring of
+ * slots. Each slot carries a sequence number that says whose turn it is:
+ * for block b in slot b % R, sequence == b means the slot is free for
+ * the decoder, b + 1 means the block is ready for the consumer, and the
+ * consumer hands the slot on by storing b + R. The single consumer thus
+ * sees blocks in order while decoders run up to R blocks ahead, without
+ * any locks.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sched.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "trace_mmap.h"
+#include "replay.h"
+#include "../../include/common_defs.h"
+
+MappedDecodeStats mapped_decode_stats;
+
+// One ring slot: a decoded block and the turn marker
+typedef struct {
+    _Atomic uint64_t sequence;
+    int count;
+    MemoryReference* refs;
+} DecodeSlot;
+
+// Shared state of one decode run
+typedef struct {
+    MappedTrace* trace;
+    DecodeSlot* slots;
+    uint64_t ring_size;
+    _Atomic uint64_t next_block;
+    _Atomic int failed;
+    _Atomic unsigned long long producer_waits;
+} DecodePipeline;
+
+// Map a binary trace and load its index and pid table
+MappedTrace* trace_mmap_open(const char* path) {
+    MappedTrace* trace = (MappedTrace*)calloc(1, sizeof(MappedTrace));
+    if(trace == NULL) {
+        printf("Error: Memory allocation failed\n");
+        return NULL;
+    }
+
+    struct stat info;
+    trace->fd = open(path, O_RDONLY);
+    if(trace->fd < 0 || fstat(trace->fd, &info) != 0) {
+        printf("Error: Could not open binary trace '%s'\n", path);
+        trace_mmap_close(trace);
+        return NULL;
+    }
+
+    trace->size = (size_t)info.st_size;
+    if(trace->size >= TRACE_HEADER_SIZE) {
+        void* base = mmap(NULL, trace->size, PROT_READ, MAP_PRIVATE, trace->fd, 0);
+        trace->base = (base == MAP_FAILED) ? NULL : (const uint8_t*)base;
+    }
+
+    if(trace->base == NULL ||
+       trace_binary_parse_header(trace->base, trace->size, &trace->header) != 0) {
+        printf("Error: '%s' is not a binary trace\n", path);
+        trace_mmap_close(trace);
+        return NULL;
+    }
+
+    // Both tables must lie inside the file before anything is read from them
+    uint64_t blocks = trace->header.block_count;
+    uint64_t pid_count = trace->header.pid_count;
+    if(trace->header.index_offset + blocks * TRACE_INDEX_ENTRY_SIZE > trace->size ||
+       trace->header.pid_table_offset + pid_count * 4 > trace->size) {
+        printf("Error: Binary trace '%s' is truncated\n", path);
+        trace_mmap_close(trace);
+        return NULL;
+    }
+
+    trace->index = (TraceBlockIndex*)malloc((blocks ? blocks : 1) * sizeof(TraceBlockIndex));
+    trace->pids = (int32_t*)malloc((pid_count ? pid_count : 1) * sizeof(int32_t));
+    if(trace->index == NULL || trace->pids == NULL) {
+        printf("Error: Memory allocation failed\n");
+        trace_mmap_close(trace);
+        return NULL;
+    }
+
+    for(uint64_t i = 0; i < blocks; i++) {
+        trace_binary_parse_index_entry(trace->base + trace->header.index_offset +
+                                       i * TRACE_INDEX_ENTRY_SIZE, &trace->index[i]);
+        if(trace->index[i].offset + trace->index[i].length > trace->size ||
+           trace->index[i].record_count > trace->header.block_records) {
+            printf("Error: Block %llu of '%s' lies outside the file\n",
+                   (unsigned long long)i, path);
+            trace_mmap_close(trace);
+            return NULL;
+        }
+    }
+
+    for(uint64_t i = 0; i < pid_count; i++) {
+        const uint8_t* p = trace->base + trace->header.pid_table_offset + i * 4;
+        trace->pids[i] = (int32_t)((uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+                                   ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24));
+    }
+
+    // Blocks are read front to back exactly once
+    madvise((void*)trace->base, trace->size, MADV_SEQUENTIAL);
+    return trace;
+}
+
+// Unmap a trace
+void trace_mmap_close(MappedTrace* trace) {
+    if(trace == NULL) {
+        return;
+    }
+    if(trace->base != NULL) {
+        munmap((void*)trace->base, trace->size);
+    }
+    if(trace->fd >= 0) {
+        close(trace->fd);
+    }
+    free(trace->index);
+    free(trace->pids);
+    free(trace);
+}
+
+// Drop a decoded block's pages from the mapping so a trace larger than
+// RAM never pins more than the blocks in flight
+static void release_block_pages(const MappedTrace* trace, const TraceBlockIndex* entry) {
+    uintptr_t page = (uintptr_t)sysconf(_SC_PAGESIZE);
+    uintptr_t begin = ((uintptr_t)(trace->base + entry->offset) + page - 1) & ~(page - 1);
+    uintptr_t end = (uintptr_t)(trace->base + entry->offset + entry->length) & ~(page - 1);
+
+    if(end > begin) {
+        madvise((void*)begin, end - begin, MADV_DONTNEED);
+    }
+}
+
+// Decoder thread: claim the next block, wait for its slot, decode, publish
+static void* decode_worker(void* argument) {
+    DecodePipeline* pipeline = (DecodePipeline*)argument;
+    MappedTrace* trace = pipeline->trace;
+
+    while(!atomic_load_explicit(&pipeline->failed, memory_order_relaxed)) {
+        uint64_t block = atomic_fetch_add_explicit(&pipeline->next_block, 1,
+                                                   memory_order_relaxed);
+        if(block >= trace->header.block_count) {
+            break;
+        }
+
+        DecodeSlot* slot = &pipeline->slots[block % pipeline->ring_size];
+        while(atomic_load_explicit(&slot->sequence, memory_order_acquire) != block) {
+            if(atomic_load_explicit(&pipeline->failed, memory_order_relaxed)) {
+                return NULL;
+            }
+            atomic_fetch_add_explicit(&pipeline->producer_waits, 1, memory_order_relaxed);
+            sched_yield();
+        }
+
+        const TraceBlockIndex* entry = &trace->index[block];
+        slot->count = trace_binary_decode_block(trace->base + entry->offset, entry->length,
+                                                entry->record_count, &trace->header,
+                                                trace->pids, entry->first_record, slot->refs);
+        if(slot->count < 0) {
+            atomic_store_explicit(&pipeline->failed, 1, memory_order_relaxed);
+        }
+        release_block_pages(trace, entry);
+
+        atomic_store_explicit(&slot->sequence, block + 1, memory_order_release);
+    }
+
+    return NULL;
+}
+
+// Decode every block on worker threads and hand them to the consumer in
+// order on the calling thread; returns 0, or -1 on a corrupt block
+int trace_mmap_decode(MappedTrace* trace, int threads,
+                      TraceBlockConsumer consumer, void* context) {
+    if(threads < 1) {
+        threads = 1;
+    }
+    if(threads > TRACE_MAX_DECODE_THREADS) {
+        threads = TRACE_MAX_DECODE_THREADS;
+    }
+
+    DecodePipeline pipeline;
+    pipeline.trace = trace;
+    pipeline.ring_size = (uint64_t)threads * 2;
+    atomic_init(&pipeline.next_block, 0);
+    atomic_init(&pipeline.failed, 0);
+    atomic_init(&pipeline.producer_waits, 0);
+
+    pipeline.slots = (DecodeSlot*)calloc(pipeline.ring_size, sizeof(DecodeSlot));
+    if(pipeline.slots == NULL) {
+        printf("Error: Memory allocation failed\n");
+        return -1;
+    }
+
+    int status = 0;
+    for(uint64_t i = 0; i < pipeline.ring_size; i++) {
+        atomic_init(&pipeline.slots[i].sequence, i);
+        pipeline.slots[i].refs = (MemoryReference*)malloc(trace->header.block_records *
+                                                          sizeof(MemoryReference));
+        if(pipeline.slots[i].refs == NULL) {
+            status = -1;
+        }
+    }
+
+    pthread_t workers[TRACE_MAX_DECODE_THREADS];
+    int started = 0;
+    if(status == 0) {
+        for(; started < threads; started++) {
+            if(pthread_create(&workers[started], NULL, decode_worker, &pipeline) != 0) {
+                break;
+            }
+        }
+        if(started == 0) {
+            status = -1;
+        }
+    }
+    if(status != 0) {
+        printf("Error: Could not start trace decoders\n");
+    }
+
+    memset(&mapped_decode_stats, 0, sizeof(mapped_decode_stats));
+    mapped_decode_stats.threads = started;
+    mapped_decode_stats.ring_slots = (int)pipeline.ring_size;
+
+    struct timespec begin, end;
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+
+    for(uint64_t block = 0; status == 0 && block < trace->header.block_count; block++) {
+        DecodeSlot* slot = &pipeline.slots[block % pipeline.ring_size];
+
+        while(atomic_load_explicit(&slot->sequence, memory_order_acquire) != block + 1) {
+            if(atomic_load_explicit(&pipeline.failed, memory_order_relaxed)) {
+                break;
+            }
+            mapped_decode_stats.consumer_waits++;
+            sched_yield();
+        }
+        if(atomic_load_explicit(&slot->sequence, memory_order_acquire) != block + 1 ||
+           slot->count < 0) {
+            printf("Error: Block %llu of the trace is corrupt\n", (unsigned long long)block);
+            status = -1;
+            break;
+        }
+
+        consumer(slot->refs, slot->count, context);
+        mapped_decode_stats.blocks++;
+        mapped_decode_stats.references += slot->count;
+
+        atomic_store_explicit(&slot->sequence, block + pipeline.ring_size,
+                              memory_order_release);
+    }
+
+    // Decoders waiting on slots the consumer will never free must give up
+    if(status != 0) {
+        atomic_store_explicit(&pipeline.failed, 1, memory_order_relaxed);
+    }
+    for(int i = 0; i < started; i++) {
+        pthread_join(workers[i], NULL);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    mapped_decode_stats.seconds = (end.tv_sec - begin.tv_sec) +
+                                  (end.tv_nsec - begin.tv_nsec) / 1e9;
+    mapped_decode_stats.producer_waits = atomic_load(&pipeline.producer_waits);
+
+    for(uint64_t i = 0; i < pipeline.ring_size; i++) {
+        free(pipeline.slots[i].refs);
+    }
+    free(pipeline.slots);
+    return status;
+}
+
+// Default decoder count: every core but the consumer's
+static int default_decode_threads() {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    return cores > 1 ? (int)cores - 1 : 1;
+}
+
+// Consumer that feeds the simulator in replay-sized batches
+static void replay_block(const MemoryReference* refs, int count, void* context) {
+    (void)context;
+    for(int offset = 0; offset < count; offset += REPLAY_BATCH_SIZE) {
+        int batch = count - offset;
+        replay_references(refs + offset, batch < REPLAY_BATCH_SIZE ? batch : REPLAY_BATCH_SIZE);
+    }
+}
+
+// Replay a binary trace through the mapped, parallel decoder
+int replay_mapped_trace(const char* path, int threads) {
+    MappedTrace* trace = trace_mmap_open(path);
+    if(trace == NULL) {
+        return -1;
+    }
+
+    int status = trace_mmap_decode(trace, threads > 0 ? threads : default_decode_threads(),
+                                   replay_block, NULL);
+    replay_stats.seconds += mapped_decode_stats.seconds;
+
+    printf("Mapped trace '%s': %llu references in %llu blocks\n", path,
+           (unsigned long long)trace->header.record_count,
+           (unsigned long long)trace->header.block_count);
+
+    trace_mmap_close(trace);
+    return status;
+}
+
+// Consumer that only looks at each block
+static void count_block(const MemoryReference* refs, int count, void* context) {
+    unsigned long long* checksum = (unsigned long long*)context;
+    if(count > 0) {
+        *checksum += refs[count - 1].address;
+    }
+}
+
+// Measure decode throughput of the mapped pipeline without simulation
+int benchmark_mapped_decode(const char* path, int threads) {
+    MappedTrace* trace = trace_mmap_open(path);
+    if(trace == NULL) {
+        return -1;
+    }
+
+    unsigned long long checksum = 0;
+    int status = trace_mmap_decode(trace, threads > 0 ? threads : default_decode_threads(),
+                                   count_block, &checksum);
+    if(status == 0) {
+        display_mapped_decode_stats();
+    }
+
+    trace_mmap_close(trace);
+    return status;
+}
+
+// Display pipeline counters of the last decode
+void display_mapped_decode_stats() {
+    double rate = mapped_decode_stats.seconds > 0 ?
+                  mapped_decode_stats.references / mapped_decode_stats.seconds : 0.0;
+
+    printf("\n================= MAPPED DECODE =================\n");
+    printf("Decoder threads: %d, Ring slots: %d\n",
+           mapped_decode_stats.threads, mapped_decode_stats.ring_slots);
+    printf("Blocks: %llu, References: %llu\n",
+           mapped_decode_stats.blocks, mapped_decode_stats.references);
+    printf("Consumer waits: %llu, Decoder waits: %llu\n",
+           mapped_decode_stats.consumer_waits, mapped_decode_stats.producer_waits);
+    printf("Time: %.3f s (%.1f M references/second)\n",
+           mapped_decode_stats.seconds, rate / 1e6);
+    printf("=================================================\n");
+}
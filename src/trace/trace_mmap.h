@@ -0,0 +1,51 @@
+/**
+ * trace_mmap.h
+ * Zero-copy memory-mapped binary traces with parallel block decoding
+ */
+
+#ifndef TRACE_MMAP_H
+#define TRACE_MMAP_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "../../include/common_defs.h"
+#include "trace_binary.h"
+
+#define TRACE_MAX_DECODE_THREADS 16
+
+// A binary trace mapped read-only into the address space
+typedef struct {
+    int fd;
+    const uint8_t* base;
+    size_t size;
+    TraceBinaryHeader header;
+    TraceBlockIndex* index;
+    int32_t* pids;
+} MappedTrace;
+
+// Receives decoded blocks strictly in file order, on the calling thread
+typedef void (*TraceBlockConsumer)(const MemoryReference* refs, int count, void* context);
+
+// Pipeline counters of the last run
+typedef struct {
+    int threads;
+    int ring_slots;
+    unsigned long long blocks;
+    unsigned long long references;
+    unsigned long long consumer_waits;  // Consumer found the next block not ready
+    unsigned long long producer_waits;  // A decoder found its slot still in use
+    double seconds;
+} MappedDecodeStats;
+
+extern MappedDecodeStats mapped_decode_stats;
+
+// Function Prototypes
+MappedTrace* trace_mmap_open(const char* path);
+void trace_mmap_close(MappedTrace* trace);
+int trace_mmap_decode(MappedTrace* trace, int threads,
+                      TraceBlockConsumer consumer, void* context);
+int replay_mapped_trace(const char* path, int threads);
+int benchmark_mapped_decode(const char* path, int threads);
+void display_mapped_decode_stats();
+
+#endif // TRACE_MMAP_H
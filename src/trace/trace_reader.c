@@ -0,0 +1,314 @@
+/**
+ * trace_reader.c
+ * Streaming memory trace parsers implementation
+ *
+ * Traces are read through a single fixed-size chunk buffer: lines are
+ * parsed in place and the buffer is refilled when a line straddles the
+ * end of the chunk, so memory use stays bounded however large the trace.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "trace_reader.h"
+#include "../../include/common_defs.h"
+
+// perf_mem_data_src.mem_op bits
+#define PERF_MEM_OP_STORE 0x04
+#define PERF_MEM_OP_MASK 0x1f
+
+// Open a trace for streaming ("-" reads standard input)
+TraceReader* trace_reader_open(const char* path, TraceFormat format, int default_pid) {
+    if(format == TRACE_FORMAT_UNKNOWN) {
+        printf("Error: Unknown trace format\n");
+        return NULL;
+    }
+
+    TraceReader* reader = (TraceReader*)calloc(1, sizeof(TraceReader));
+    if(reader == NULL) {
+        printf("Error: Memory allocation failed\n");
+        return NULL;
+    }
+
+    reader->buffer = (char*)malloc(TRACE_CHUNK_SIZE + 1);
+    if(reader->buffer == NULL) {
+        printf("Error: Memory allocation failed\n");
+        free(reader);
+        return NULL;
+    }
+
+    if(strcmp(path, "-") == 0) {
+        reader->file = stdin;
+    } else {
+        reader->file = fopen(path, "r");
+    }
+    if(reader->file == NULL) {
+        printf("Error: Could not open trace '%s'\n", path);
+        free(reader->buffer);
+        free(reader);
+        return NULL;
+    }
+
+    reader->format = format;
+    reader->default_pid = default_pid;
+    reader->include_fetches = 1;
+    return reader;
+}
+
+// Close a trace and release its buffer
+void trace_reader_close(TraceReader* reader) {
+    if(reader == NULL) {
+        return;
+    }
+    if(reader->file != NULL && reader->file != stdin) {
+        fclose(reader->file);
+    }
+    free(reader->buffer);
+    free(reader);
+}
+
+// Move the unconsumed tail to the front of the buffer and read another chunk
+static void refill(TraceReader* reader) {
+    size_t pending = reader->end - reader->start;
+
+    memmove(reader->buffer, reader->buffer + reader->start, pending);
+    reader->start = 0;
+    reader->end = pending;
+
+    size_t got = fread(reader->buffer + reader->end, 1,
+                       TRACE_CHUNK_SIZE - reader->end, reader->file);
+    reader->end += got;
+    if(got == 0) {
+        reader->eof = 1;
+    }
+}
+
+// Next line, NUL-terminated in place; NULL at end of trace
+static char* next_line(TraceReader* reader) {
+    while(1) {
+        char* begin = reader->buffer + reader->start;
+        char* newline = (char*)memchr(begin, '\n', reader->end - reader->start);
+
+        if(newline != NULL) {
+            *newline = '\0';
+            reader->start = (size_t)(newline - reader->buffer) + 1;
+            reader->lines++;
+            return begin;
+        }
+
+        if(reader->eof) {
+            if(reader->start == reader->end) {
+                return NULL;
+            }
+            reader->buffer[reader->end] = '\0';
+            reader->start = reader->end;
+            reader->lines++;
+            return begin;
+        }
+
+        // A line longer than a whole chunk cannot be a trace record:
+        // drop what we have and let the parser reject the remainder
+        if(reader->start == 0 && reader->end == TRACE_CHUNK_SIZE) {
+            reader->start = reader->end;
+            reader->skipped++;
+        }
+
+        refill(reader);
+    }
+}
+
+// Parse a hexadecimal field, returns the character after it or NULL
+static char* parse_hex(char* p, unsigned long long* value) {
+    char* end;
+    *value = strtoull(p, &end, 16);
+    return (end == p) ? NULL : end;
+}
+
+// Valgrind Lackey: "I  04001f7e,3", " S 7ff000b28,8", " L ...", " M ..."
+static int parse_lackey(TraceReader* reader, char* line, MemoryReference* ref) {
+    // Tool chatter such as "==1234== ..." carries the traced pid
+    if(line[0] == '=' && line[1] == '=') {
+        if(reader->default_pid < 0) {
+            reader->default_pid = atoi(line + 2);
+        }
+        return 0;
+    }
+
+    char* p = line;
+    while(*p == ' ') {
+        p++;
+    }
+
+    char op = *p;
+    if((op != 'I' && op != 'L' && op != 'S' && op != 'M') || p[1] != ' ') {
+        return 0;
+    }
+    if(op == 'I' && !reader->include_fetches) {
+        return 0;
+    }
+
+    unsigned long long address;
+    char* end = parse_hex(p + 1, &address);
+    if(end == NULL || *end != ',') {
+        return 0;
+    }
+
+    // A modify is a load and a store to the same address; the store is
+    // what matters to the page tables
+    ref->address = address;
+    ref->pid = reader->default_pid >= 0 ? reader->default_pid : 0;
+    ref->is_write = (op == 'S' || op == 'M');
+    return 1;
+}
+
+// Pin-style: "[pid] 0x401234: W 0x7ffe1234 [size]"
+static int parse_pin(TraceReader* reader, char* line, MemoryReference* ref) {
+    char* p = line;
+    while(*p == ' ' || *p == '\t') {
+        p++;
+    }
+    if(*p == '#' || *p == '\0') {
+        return 0;
+    }
+
+    char* end;
+    unsigned long long first = strtoull(p, &end, 0);
+    if(end == p) {
+        return 0;
+    }
+
+    int pid = reader->default_pid >= 0 ? reader->default_pid : 0;
+    if(*end != ':') {
+        // Leading pid column, then the instruction pointer
+        pid = (int)first;
+        p = end;
+        strtoull(p, &end, 0);
+        if(end == p || *end != ':') {
+            return 0;
+        }
+    }
+
+    p = end + 1;
+    while(*p == ' ' || *p == '\t') {
+        p++;
+    }
+
+    char op = *p;
+    if(op != 'R' && op != 'W') {
+        return 0;
+    }
+
+    unsigned long long address;
+    if(parse_hex(p + 1, &address) == NULL) {
+        return 0;
+    }
+
+    ref->address = address;
+    ref->pid = pid;
+    ref->is_write = (op == 'W');
+    return 1;
+}
+
+// perf mem address column; some perf releases print "0x016<hex>" because
+// of a broken format string, so strip that prefix when the width is off
+static int parse_perf_address(char* token, unsigned long long* value) {
+    if(strncmp(token, "0x016", 5) == 0 && strlen(token) != 18) {
+        token += 5;
+    }
+    return parse_hex(token, value) != NULL;
+}
+
+// perf mem report -D: "PID TID IP ADDR [PHYS] WEIGHT DSRC SYMBOL"
+static int parse_perf_mem(TraceReader* reader, char* line, MemoryReference* ref) {
+    char* tokens[8];
+    int count = 0;
+    char* save = NULL;
+
+    if(line[0] == '#') {
+        if(strstr(line, "PHYS") != NULL) {
+            reader->perf_has_phys = 1;
+        }
+        return 0;
+    }
+
+    for(char* token = strtok_r(line, " \t,", &save);
+        token != NULL && count < 8;
+        token = strtok_r(NULL, " \t,", &save)) {
+        tokens[count++] = token;
+    }
+
+    int dsrc_index = reader->perf_has_phys ? 6 : 5;
+    if(count <= dsrc_index) {
+        return 0;
+    }
+
+    unsigned long long address, data_source;
+    char* end;
+    long pid = strtol(tokens[0], &end, 10);
+    if(end == tokens[0] || !parse_perf_address(tokens[3], &address) ||
+       parse_hex(tokens[dsrc_index], &data_source) == NULL || address == 0) {
+        return 0;
+    }
+
+    ref->address = address;
+    ref->pid = (int)pid;
+    ref->is_write = ((data_source & PERF_MEM_OP_MASK) & PERF_MEM_OP_STORE) != 0;
+    return 1;
+}
+
+// Read the next reference, returns 1 on success and 0 at end of trace
+int trace_reader_next(TraceReader* reader, MemoryReference* ref) {
+    char* line;
+
+    while((line = next_line(reader)) != NULL) {
+        int parsed = 0;
+        switch(reader->format) {
+            case TRACE_FORMAT_LACKEY:
+                parsed = parse_lackey(reader, line, ref);
+                break;
+            case TRACE_FORMAT_PIN:
+                parsed = parse_pin(reader, line, ref);
+                break;
+            case TRACE_FORMAT_PERF_MEM:
+                parsed = parse_perf_mem(reader, line, ref);
+                break;
+            default:
+                break;
+        }
+
+        if(parsed) {
+            ref->timestamp = reader->records++;
+            return 1;
+        }
+        reader->skipped++;
+    }
+
+    return 0;
+}
+
+// Fill up to max_refs references, returns how many were read
+int trace_reader_read_batch(TraceReader* reader, MemoryReference* refs, int max_refs) {
+    int count = 0;
+    while(count < max_refs && trace_reader_next(reader, &refs[count])) {
+        count++;
+    }
+    return count;
+}
+
+// Parse a format name given on the command line
+TraceFormat trace_format_from_name(const char* name) {
+    if(strcmp(name, "lackey") == 0) return TRACE_FORMAT_LACKEY;
+    if(strcmp(name, "pin") == 0) return TRACE_FORMAT_PIN;
+    if(strcmp(name, "perf") == 0 || strcmp(name, "perf-mem") == 0) return TRACE_FORMAT_PERF_MEM;
+    return TRACE_FORMAT_UNKNOWN;
+}
+
+// Display name of a format
+const char* trace_format_name(TraceFormat format) {
+    switch(format) {
+        case TRACE_FORMAT_LACKEY:   return "Valgrind Lackey";
+        case TRACE_FORMAT_PIN:      return "Pin";
+        case TRACE_FORMAT_PERF_MEM: return "perf mem";
+        default:                    return "unknown";
+    }
+}
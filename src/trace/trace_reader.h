@@ -0,0 +1,47 @@
+/**
+ * trace_reader.h
+ * Streaming memory trace parsers (Valgrind Lackey, Pin, perf mem)
+ */
+
+#ifndef TRACE_READER_H
+#define TRACE_READER_H
+
+#include <stdio.h>
+#include "../../include/common_defs.h"
+
+// Bytes read from the file per refill; the reader never holds more
+#define TRACE_CHUNK_SIZE (64 * 1024)
+
+// Supported text trace formats
+typedef enum {
+    TRACE_FORMAT_LACKEY,    // valgrind --tool=lackey --trace-mem=yes
+    TRACE_FORMAT_PIN,       // pinatrace-style "ip: R|W addr"
+    TRACE_FORMAT_PERF_MEM,  // perf mem report -D
+    TRACE_FORMAT_UNKNOWN
+} TraceFormat;
+
+// Streaming reader over a text trace
+typedef struct {
+    FILE* file;
+    TraceFormat format;
+    int default_pid;           // Used when the format carries no pid
+    int include_fetches;       // Lackey: keep instruction fetches
+    int perf_has_phys;         // perf mem: dump has a PHYS ADDR column
+    char* buffer;              // One chunk plus the line being assembled
+    size_t start;              // First unconsumed byte
+    size_t end;                // One past the last buffered byte
+    int eof;
+    unsigned long long lines;
+    unsigned long long records;
+    unsigned long long skipped;  // Comments, tool chatter, malformed lines
+} TraceReader;
+
+// Function Prototypes
+TraceReader* trace_reader_open(const char* path, TraceFormat format, int default_pid);
+int trace_reader_next(TraceReader* reader, MemoryReference* ref);
+int trace_reader_read_batch(TraceReader* reader, MemoryReference* refs, int max_refs);
+void trace_reader_close(TraceReader* reader);
+TraceFormat trace_format_from_name(const char* name);
+const char* trace_format_name(TraceFormat format);
+
+#endif // TRACE_READER_H
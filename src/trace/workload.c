@@ -0,0 +1,534 @@
+/**
+ * workload.c
+ * Deterministic synthetic workload generator implementation
+ *
+ * All randomness comes from xoshiro256** seeded through splitmix64, so a
+ * workload is a pure function of its seed and configuration. Every
+ * process stream owns its own generator; interleaving uses a separate
+ * one, so adding a process does not perturb the others' page sequences.
+ * Bounded draws use Lemire's multiply-shift with rejection (no modulo
+ * bias) and Zipf ranks come from a precomputed alias table, so every
+ * pattern costs O(1) per reference.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "workload.h"
+#include "replay.h"
+#include "trace_binary.h"
+#include "../../include/common_defs.h"
+
+static WorkloadRng global_rng;
+static int global_rng_seeded = 0;
+
+// ==================== RANDOM NUMBERS ====================
+
+static uint64_t splitmix64(uint64_t* state) {
+    uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+static inline uint64_t rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+// Expand a 64-bit seed into a full generator state
+void workload_rng_seed(WorkloadRng* rng, uint64_t seed) {
+    for(int i = 0; i < 4; i++) {
+        rng->s[i] = splitmix64(&seed);
+    }
+}
+
+// Next 64 random bits (xoshiro256**)
+uint64_t workload_rng_next(WorkloadRng* rng) {
+    uint64_t* s = rng->s;
+    uint64_t result = rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+
+    return result;
+}
+
+// Unbiased integer in [0, range)
+uint32_t workload_rng_bounded(WorkloadRng* rng, uint32_t range) {
+    uint64_t product = (workload_rng_next(rng) >> 32) * range;
+    uint32_t low = (uint32_t)product;
+
+    if(low < range) {
+        uint32_t threshold = (0u - range) % range;
+        while(low < threshold) {
+            product = (workload_rng_next(rng) >> 32) * range;
+            low = (uint32_t)product;
+        }
+    }
+    return (uint32_t)(product >> 32);
+}
+
+// Uniform double in [0, 1)
+double workload_rng_double(WorkloadRng* rng) {
+    return (workload_rng_next(rng) >> 11) * 0x1.0p-53;
+}
+
+// Reseed the generator shared by the simulator's built-in reference strings
+void workload_set_seed(uint64_t seed) {
+    workload_rng_seed(&global_rng, seed);
+    global_rng_seeded = 1;
+}
+
+// Shared generator, seeded with WORKLOAD_DEFAULT_SEED on first use
+WorkloadRng* workload_global_rng() {
+    if(!global_rng_seeded) {
+        workload_set_seed(WORKLOAD_DEFAULT_SEED);
+    }
+    return &global_rng;
+}
+
+// ==================== ALIAS TABLE ====================
+
+// Build a Walker/Vose alias table over non-negative weights
+int alias_table_build(AliasTable* table, const double* weights, uint32_t size) {
+    table->size = size;
+    table->threshold = (uint32_t*)malloc(size * sizeof(uint32_t));
+    table->alias = (uint32_t*)malloc(size * sizeof(uint32_t));
+    double* scaled = (double*)malloc(size * sizeof(double));
+    uint32_t* small = (uint32_t*)malloc(size * sizeof(uint32_t));
+    uint32_t* large = (uint32_t*)malloc(size * sizeof(uint32_t));
+
+    double total = 0.0;
+    for(uint32_t i = 0; i < size; i++) {
+        total += weights[i];
+    }
+
+    if(table->threshold == NULL || table->alias == NULL || scaled == NULL ||
+       small == NULL || large == NULL || size == 0 || total <= 0.0) {
+        printf("Error: Cannot build alias table\n");
+        free(scaled);
+        free(small);
+        free(large);
+        alias_table_free(table);
+        return -1;
+    }
+
+    uint32_t small_count = 0, large_count = 0;
+    for(uint32_t i = 0; i < size; i++) {
+        scaled[i] = weights[i] * size / total;
+        table->alias[i] = i;
+        if(scaled[i] < 1.0) {
+            small[small_count++] = i;
+        } else {
+            large[large_count++] = i;
+        }
+    }
+
+    // Pair each under-full column with an over-full one
+    while(small_count > 0 && large_count > 0) {
+        uint32_t under = small[--small_count];
+        uint32_t over = large[large_count - 1];
+
+        table->threshold[under] = (uint32_t)(scaled[under] * 4294967296.0);
+        table->alias[under] = over;
+        scaled[over] -= 1.0 - scaled[under];
+        if(scaled[over] < 1.0) {
+            large_count--;
+            small[small_count++] = over;
+        }
+    }
+
+    // Whatever is left is full up to rounding error
+    while(large_count > 0) {
+        table->threshold[large[--large_count]] = UINT32_MAX;
+    }
+    while(small_count > 0) {
+        table->threshold[small[--small_count]] = UINT32_MAX;
+    }
+
+    free(scaled);
+    free(small);
+    free(large);
+    return 0;
+}
+
+// Draw an index in O(1)
+uint32_t alias_table_sample(const AliasTable* table, WorkloadRng* rng) {
+    uint32_t column = workload_rng_bounded(rng, table->size);
+    return ((uint32_t)workload_rng_next(rng) < table->threshold[column]) ?
+           column : table->alias[column];
+}
+
+// Release an alias table
+void alias_table_free(AliasTable* table) {
+    free(table->threshold);
+    free(table->alias);
+    table->threshold = NULL;
+    table->alias = NULL;
+    table->size = 0;
+}
+
+// ==================== PATTERNS ====================
+
+// Pattern with sensible defaults for the given region
+WorkloadPattern workload_pattern(PatternType type, uint64_t base_page, uint32_t pages) {
+    WorkloadPattern pattern;
+    memset(&pattern, 0, sizeof(pattern));
+    pattern.type = type;
+    pattern.base_page = base_page;
+    pattern.pages = pages > 0 ? pages : 1;
+    pattern.skew = 0.99;
+    pattern.hot_fraction = 0.2;
+    pattern.hot_probability = 0.8;
+    pattern.write_ratio = 0.25;
+
+    switch(type) {
+        case PATTERN_LOOP:     pattern.stride = pattern.pages > 1 ? pattern.pages / 2 : 1; break;
+        case PATTERN_STRIDE:   pattern.stride = 3; break;
+        case PATTERN_LOCALITY: pattern.stride = 2; break;
+        default:               pattern.stride = 1; break;
+    }
+    return pattern;
+}
+
+// Parse a pattern name
+PatternType pattern_type_from_name(const char* name) {
+    if(strcmp(name, "uniform") == 0) return PATTERN_UNIFORM;
+    if(strcmp(name, "zipf") == 0) return PATTERN_ZIPF;
+    if(strcmp(name, "scan") == 0) return PATTERN_SCAN;
+    if(strcmp(name, "loop") == 0) return PATTERN_LOOP;
+    if(strcmp(name, "stride") == 0) return PATTERN_STRIDE;
+    if(strcmp(name, "hotcold") == 0) return PATTERN_HOT_COLD;
+    if(strcmp(name, "locality") == 0) return PATTERN_LOCALITY;
+    return PATTERN_UNKNOWN;
+}
+
+// Display name of a pattern
+const char* pattern_type_name(PatternType type) {
+    switch(type) {
+        case PATTERN_UNIFORM:  return "uniform";
+        case PATTERN_ZIPF:     return "zipf";
+        case PATTERN_SCAN:     return "scan";
+        case PATTERN_LOOP:     return "loop";
+        case PATTERN_STRIDE:   return "stride";
+        case PATTERN_HOT_COLD: return "hotcold";
+        case PATTERN_LOCALITY: return "locality";
+        default:               return "unknown";
+    }
+}
+
+// ==================== WORKLOADS ====================
+
+// Empty workload; nothing is generated until processes are added
+void workload_init(Workload* workload, uint64_t seed) {
+    memset(workload, 0, sizeof(Workload));
+    workload->seed = seed;
+    workload_rng_seed(&workload->rng, seed);
+}
+
+// Add a process stream with an interleaving weight, returns its index
+int workload_add_process(Workload* workload, int pid, int weight) {
+    if(workload->stream_count >= MAX_PROCESSES) {
+        printf("Error: Workload already has %d processes\n", MAX_PROCESSES);
+        return -1;
+    }
+
+    int index = workload->stream_count++;
+    WorkloadStream* stream = &workload->streams[index];
+    memset(stream, 0, sizeof(WorkloadStream));
+    stream->pid = pid;
+    stream->weight = weight > 0 ? weight : 1;
+    workload_rng_seed(&stream->rng, workload->seed ^ (0x9e3779b97f4a7c15ULL * (index + 1)));
+    workload->total_weight += stream->weight;
+    return index;
+}
+
+// Append a phase to a process stream
+int workload_add_phase(Workload* workload, int stream, const WorkloadPattern* pattern) {
+    if(stream < 0 || stream >= workload->stream_count) {
+        printf("Error: Invalid workload stream %d\n", stream);
+        return -1;
+    }
+
+    WorkloadStream* s = &workload->streams[stream];
+    if(s->phase_count >= WORKLOAD_MAX_PHASES || pattern->type == PATTERN_UNKNOWN ||
+       pattern->pages == 0) {
+        printf("Error: Cannot add phase to workload stream %d\n", stream);
+        return -1;
+    }
+
+    int phase = s->phase_count;
+    s->phases[phase] = *pattern;
+    if(s->phases[phase].stride == 0) {
+        s->phases[phase].stride = 1;
+    }
+
+    if(pattern->type == PATTERN_ZIPF) {
+        double* weights = (double*)malloc(pattern->pages * sizeof(double));
+        if(weights == NULL) {
+            printf("Error: Memory allocation failed\n");
+            return -1;
+        }
+        for(uint32_t rank = 0; rank < pattern->pages; rank++) {
+            weights[rank] = 1.0 / pow(rank + 1.0, pattern->skew);
+        }
+        int status = alias_table_build(&s->zipf[phase], weights, pattern->pages);
+        free(weights);
+        if(status != 0) {
+            return -1;
+        }
+    }
+
+    s->phase_count++;
+    return phase;
+}
+
+// Next page of a stream under its current phase
+static uint64_t next_page(WorkloadStream* stream, const WorkloadPattern* pattern) {
+    WorkloadRng* rng = &stream->rng;
+    uint32_t pages = pattern->pages;
+    uint64_t offset;
+
+    switch(pattern->type) {
+        case PATTERN_ZIPF:
+            offset = alias_table_sample(&stream->zipf[stream->phase], rng);
+            break;
+        case PATTERN_SCAN:
+            offset = stream->cursor++ % pages;
+            break;
+        case PATTERN_LOOP:
+            offset = stream->cursor++ % (pattern->stride < pages ? pattern->stride : pages);
+            break;
+        case PATTERN_STRIDE:
+            offset = (stream->cursor++ * pattern->stride) % pages;
+            break;
+        case PATTERN_HOT_COLD: {
+            uint32_t hot = (uint32_t)(pages * pattern->hot_fraction);
+            if(hot == 0) hot = 1;
+            if(hot >= pages || workload_rng_double(rng) < pattern->hot_probability) {
+                offset = workload_rng_bounded(rng, hot < pages ? hot : pages);
+            } else {
+                offset = hot + workload_rng_bounded(rng, pages - hot);
+            }
+            break;
+        }
+        case PATTERN_LOCALITY:
+            // Mostly a short walk around the last page, sometimes a jump
+            if(workload_rng_bounded(rng, 100) < 70) {
+                uint32_t radius = pattern->stride;
+                stream->cursor = (stream->cursor + pages * (uint64_t)(radius + 1) +
+                                  workload_rng_bounded(rng, 2 * radius + 1) - radius) % pages;
+            } else {
+                stream->cursor = workload_rng_bounded(rng, pages);
+            }
+            offset = stream->cursor;
+            break;
+        default:
+            offset = workload_rng_bounded(rng, pages);
+            break;
+    }
+
+    return pattern->base_page + offset;
+}
+
+// Fill refs with the next count references, returns count or -1
+int workload_generate(Workload* workload, MemoryReference* refs, int count) {
+    if(workload->stream_count == 0) {
+        printf("Error: Workload has no processes\n");
+        return -1;
+    }
+    for(int s = 0; s < workload->stream_count; s++) {
+        if(workload->streams[s].phase_count == 0) {
+            printf("Error: Workload stream %d has no phases\n", s);
+            return -1;
+        }
+    }
+
+    for(int i = 0; i < count; i++) {
+        int s = 0;
+        if(workload->stream_count > 1) {
+            int pick = (int)workload_rng_bounded(&workload->rng, workload->total_weight);
+            while(pick >= workload->streams[s].weight) {
+                pick -= workload->streams[s].weight;
+                s++;
+            }
+        }
+
+        WorkloadStream* stream = &workload->streams[s];
+        const WorkloadPattern* pattern = &stream->phases[stream->phase];
+
+        refs[i].address = next_page(stream, pattern) * PAGE_SIZE;
+        refs[i].timestamp = workload->generated++;
+        refs[i].pid = stream->pid;
+        refs[i].is_write = workload_rng_double(&stream->rng) < pattern->write_ratio;
+
+        if(pattern->length > 0 && ++stream->phase_position >= pattern->length) {
+            stream->phase = (stream->phase + 1) % stream->phase_count;
+            stream->phase_position = 0;
+            stream->cursor = 0;
+        }
+    }
+
+    return count;
+}
+
+// Release alias tables
+void workload_free(Workload* workload) {
+    for(int s = 0; s < workload->stream_count; s++) {
+        for(int p = 0; p < workload->streams[s].phase_count; p++) {
+            alias_table_free(&workload->streams[s].zipf[p]);
+        }
+    }
+    workload->stream_count = 0;
+    workload->total_weight = 0;
+}
+
+// Configure a named workload over a region of pages: any pattern name,
+// "phased" (one process cycling through four patterns) or "mix" (four
+// processes with different patterns and weights)
+int workload_preset(Workload* workload, const char* name, uint32_t pages) {
+    PatternType type = pattern_type_from_name(name);
+
+    if(type != PATTERN_UNKNOWN) {
+        WorkloadPattern pattern = workload_pattern(type, 0, pages);
+        int stream = workload_add_process(workload, 0, 1);
+        return workload_add_phase(workload, stream, &pattern) < 0 ? -1 : 0;
+    }
+
+    if(strcmp(name, "phased") == 0) {
+        PatternType phases[] = {PATTERN_ZIPF, PATTERN_SCAN, PATTERN_HOT_COLD, PATTERN_LOOP};
+        int stream = workload_add_process(workload, 0, 1);
+        for(int p = 0; p < 4; p++) {
+            // Each phase moves to a different half of the region
+            WorkloadPattern pattern = workload_pattern(phases[p], (p % 2) * (pages / 2),
+                                                       pages / 2 > 0 ? pages / 2 : 1);
+            pattern.length = 1000;
+            if(workload_add_phase(workload, stream, &pattern) < 0) {
+                return -1;
+            }
+        }
+        return 0;
+    }
+
+    if(strcmp(name, "mix") == 0) {
+        PatternType types[] = {PATTERN_ZIPF, PATTERN_SCAN, PATTERN_LOOP, PATTERN_HOT_COLD};
+        int weights[] = {4, 1, 2, 3};
+        for(int p = 0; p < 4; p++) {
+            WorkloadPattern pattern = workload_pattern(types[p], 0, pages);
+            int stream = workload_add_process(workload, p, weights[p]);
+            if(stream < 0 || workload_add_phase(workload, stream, &pattern) < 0) {
+                return -1;
+            }
+        }
+        return 0;
+    }
+
+    printf("Error: Unknown workload '%s'\n", name);
+    return -1;
+}
+
+// ==================== OUTPUTS ====================
+
+// Stream generated references straight into the replay engine
+int workload_replay(Workload* workload, uint64_t references) {
+    MemoryReference* batch = (MemoryReference*)malloc(REPLAY_BATCH_SIZE * sizeof(MemoryReference));
+    if(batch == NULL) {
+        printf("Error: Memory allocation failed\n");
+        return -1;
+    }
+
+    struct timespec begin, end;
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+
+    int status = 0;
+    while(references > 0 && status == 0) {
+        int count = references < REPLAY_BATCH_SIZE ? (int)references : REPLAY_BATCH_SIZE;
+        if(workload_generate(workload, batch, count) < 0) {
+            status = -1;
+            break;
+        }
+        replay_references(batch, count);
+        references -= count;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    replay_stats.seconds += (end.tv_sec - begin.tv_sec) + (end.tv_nsec - begin.tv_nsec) / 1e9;
+
+    free(batch);
+    return status;
+}
+
+// Write generated references as a binary trace
+int workload_write_trace(Workload* workload, uint64_t references, const char* path) {
+    TraceWriter* writer = trace_writer_open(path, PAGE_SIZE, TRACE_DEFAULT_BLOCK_RECORDS);
+    MemoryReference* batch = (MemoryReference*)malloc(REPLAY_BATCH_SIZE * sizeof(MemoryReference));
+    int status = (writer != NULL && batch != NULL) ? 0 : -1;
+
+    while(references > 0 && status == 0) {
+        int count = references < REPLAY_BATCH_SIZE ? (int)references : REPLAY_BATCH_SIZE;
+        if(workload_generate(workload, batch, count) < 0) {
+            status = -1;
+            break;
+        }
+        for(int i = 0; i < count && status == 0; i++) {
+            status = trace_writer_append(writer, &batch[i]);
+        }
+        references -= count;
+    }
+
+    if(writer != NULL && trace_writer_close(writer) != 0) {
+        status = -1;
+    }
+    free(batch);
+    return status;
+}
+
+// Measure generation speed alone
+void workload_benchmark(Workload* workload, uint64_t references) {
+    MemoryReference batch[1024];
+    unsigned long long checksum = 0;
+    uint64_t remaining = references;
+
+    struct timespec begin, end;
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+
+    while(remaining > 0) {
+        int count = remaining < 1024 ? (int)remaining : 1024;
+        if(workload_generate(workload, batch, count) < 0) {
+            return;
+        }
+        checksum += batch[count - 1].address;
+        remaining -= count;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double seconds = (end.tv_sec - begin.tv_sec) + (end.tv_nsec - begin.tv_nsec) / 1e9;
+
+    printf("\n================ WORKLOAD GENERATOR ================\n");
+    printf("Seed: %llu, Processes: %d\n",
+           (unsigned long long)workload->seed, workload->stream_count);
+    for(int s = 0; s < workload->stream_count; s++) {
+        WorkloadStream* stream = &workload->streams[s];
+        printf("  pid %d (weight %d):", stream->pid, stream->weight);
+        for(int p = 0; p < stream->phase_count; p++) {
+            printf(" %s[%u pages]", pattern_type_name(stream->phases[p].type),
+                   stream->phases[p].pages);
+        }
+        printf("\n");
+    }
+    printf("Generated %llu references in %.3f s\n",
+           (unsigned long long)references, seconds);
+    if(seconds > 0) {
+        printf("Rate: %.1f M references/second (%.2f billion/minute)\n",
+               references / seconds / 1e6, references / seconds * 60 / 1e9);
+    }
+    printf("Checksum: %016llx\n", checksum);
+    printf("====================================================\n");
+}
@@ -0,0 +1,102 @@
+/**
+ * workload.h
+ * Deterministic synthetic workload generator
+ */
+
+#ifndef WORKLOAD_H
+#define WORKLOAD_H
+
+#include <stdint.h>
+#include "../../include/common_defs.h"
+
+#define WORKLOAD_MAX_PHASES 8
+#define WORKLOAD_DEFAULT_SEED 42
+
+// xoshiro256** generator state
+typedef struct {
+    uint64_t s[4];
+} WorkloadRng;
+
+// Access pattern of one phase
+typedef enum {
+    PATTERN_UNIFORM,
+    PATTERN_ZIPF,       // Rank r drawn with probability ~ 1 / r^skew
+    PATTERN_SCAN,       // Sequential sweep, wraps at the end of the region
+    PATTERN_LOOP,       // Sequential over a loop_pages window, repeated
+    PATTERN_STRIDE,     // Every stride-th page
+    PATTERN_HOT_COLD,   // hot_probability of references hit the hot set
+    PATTERN_LOCALITY,   // Small random walk with occasional jumps
+    PATTERN_UNKNOWN
+} PatternType;
+
+// One phase of a process's reference stream
+typedef struct {
+    PatternType type;
+    uint64_t base_page;         // First page of the region
+    uint32_t pages;             // Region size in pages
+    uint32_t stride;            // STRIDE: step; LOOP: window; LOCALITY: walk radius
+    double skew;                // ZIPF exponent
+    double hot_fraction;        // HOT_COLD: share of pages that are hot
+    double hot_probability;     // HOT_COLD: share of references to the hot set
+    double write_ratio;
+    uint64_t length;            // References before the next phase, 0 = no change
+} WorkloadPattern;
+
+// Walker's alias table for O(1) sampling of a discrete distribution
+typedef struct {
+    uint32_t size;
+    uint32_t* threshold;        // Keep column i when a 32-bit draw is below this
+    uint32_t* alias;
+} AliasTable;
+
+// Phased reference stream of one process
+typedef struct {
+    int pid;
+    int weight;
+    WorkloadRng rng;
+    WorkloadPattern phases[WORKLOAD_MAX_PHASES];
+    AliasTable zipf[WORKLOAD_MAX_PHASES];
+    int phase_count;
+    int phase;
+    uint64_t phase_position;
+    uint64_t cursor;            // Scan/loop/stride/locality position
+} WorkloadStream;
+
+// A set of process streams interleaved by weight
+typedef struct {
+    uint64_t seed;
+    WorkloadRng rng;
+    WorkloadStream streams[MAX_PROCESSES];
+    int stream_count;
+    int total_weight;
+    uint64_t generated;
+} Workload;
+
+// Function Prototypes
+void workload_rng_seed(WorkloadRng* rng, uint64_t seed);
+uint64_t workload_rng_next(WorkloadRng* rng);
+uint32_t workload_rng_bounded(WorkloadRng* rng, uint32_t range);
+double workload_rng_double(WorkloadRng* rng);
+void workload_set_seed(uint64_t seed);
+WorkloadRng* workload_global_rng();
+
+int alias_table_build(AliasTable* table, const double* weights, uint32_t size);
+uint32_t alias_table_sample(const AliasTable* table, WorkloadRng* rng);
+void alias_table_free(AliasTable* table);
+
+WorkloadPattern workload_pattern(PatternType type, uint64_t base_page, uint32_t pages);
+PatternType pattern_type_from_name(const char* name);
+const char* pattern_type_name(PatternType type);
+
+void workload_init(Workload* workload, uint64_t seed);
+int workload_add_process(Workload* workload, int pid, int weight);
+int workload_add_phase(Workload* workload, int stream, const WorkloadPattern* pattern);
+int workload_generate(Workload* workload, MemoryReference* refs, int count);
+void workload_free(Workload* workload);
+int workload_preset(Workload* workload, const char* name, uint32_t pages);
+
+int workload_replay(Workload* workload, uint64_t references);
+int workload_write_trace(Workload* workload, uint64_t references, const char* path);
+void workload_benchmark(Workload* workload, uint64_t references);
+
+#endif // WORKLOAD_H
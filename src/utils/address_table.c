@@ -0,0 +1,118 @@
+/**
+ * address_table.c
+ * Open-addressing hash map implementation
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "address_table.h"
+
+static uint64_t hash_address(uint64_t key) {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    return key;
+}
+
+// Empty table; storage is allocated on first insert
+void address_table_init(AddressTable* table) {
+    memset(table, 0, sizeof(AddressTable));
+}
+
+// Release storage and leave the table empty
+void address_table_free(AddressTable* table) {
+    free(table->keys);
+    free(table->values);
+    memset(table, 0, sizeof(AddressTable));
+}
+
+static int address_table_grow(AddressTable* table) {
+    AddressTable larger;
+    larger.capacity = table->capacity ? table->capacity * 2 : 1024;
+    larger.count = 0;
+    larger.keys = (uint64_t*)calloc(larger.capacity, sizeof(uint64_t));
+    larger.values = (uint64_t*)calloc(larger.capacity, sizeof(uint64_t));
+    if(larger.keys == NULL || larger.values == NULL) {
+        free(larger.keys);
+        free(larger.values);
+        return -1;
+    }
+
+    for(uint64_t i = 0; i < table->capacity; i++) {
+        if(table->keys[i] != 0) {
+            address_table_put(&larger, table->keys[i], table->values[i]);
+        }
+    }
+    address_table_free(table);
+    *table = larger;
+    return 0;
+}
+
+// Insert or overwrite; returns 1 if the key was new, 0 if replaced, -1 on failure
+int address_table_put(AddressTable* table, uint64_t key, uint64_t value) {
+    if((table->count + 1) * 4 > table->capacity * 3 && address_table_grow(table) != 0) {
+        return -1;
+    }
+
+    uint64_t mask = table->capacity - 1;
+    uint64_t slot = hash_address(key) & mask;
+    while(table->keys[slot] != 0 && table->keys[slot] != key) {
+        slot = (slot + 1) & mask;
+    }
+
+    int added = (table->keys[slot] == 0);
+    table->keys[slot] = key;
+    table->values[slot] = value;
+    table->count += added;
+    return added;
+}
+
+// Look up a key, returns 1 and its value if present
+int address_table_get(const AddressTable* table, uint64_t key, uint64_t* value) {
+    if(table->capacity == 0) {
+        return 0;
+    }
+
+    uint64_t mask = table->capacity - 1;
+    for(uint64_t slot = hash_address(key) & mask; table->keys[slot] != 0;
+        slot = (slot + 1) & mask) {
+        if(table->keys[slot] == key) {
+            *value = table->values[slot];
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Remove a key, returns 1 and its value if it was present
+int address_table_take(AddressTable* table, uint64_t key, uint64_t* value) {
+    if(table->capacity == 0) {
+        return 0;
+    }
+
+    uint64_t mask = table->capacity - 1;
+    uint64_t slot = hash_address(key) & mask;
+    while(table->keys[slot] != key) {
+        if(table->keys[slot] == 0) {
+            return 0;
+        }
+        slot = (slot + 1) & mask;
+    }
+    if(value != NULL) {
+        *value = table->values[slot];
+    }
+
+    // Pull later members of the probe run back over the hole
+    uint64_t hole = slot;
+    for(uint64_t next = (hole + 1) & mask; table->keys[next] != 0; next = (next + 1) & mask) {
+        uint64_t home = hash_address(table->keys[next]) & mask;
+        if(((next - home) & mask) >= ((next - hole) & mask)) {
+            table->keys[hole] = table->keys[next];
+            table->values[hole] = table->values[next];
+            hole = next;
+        }
+    }
+    table->keys[hole] = 0;
+    table->count--;
+    return 1;
+}
@@ -0,0 +1,26 @@
+/**
+ * address_table.h
+ * Open-addressing hash map from 64-bit addresses to 64-bit values
+ */
+
+#ifndef ADDRESS_TABLE_H
+#define ADDRESS_TABLE_H
+
+#include <stdint.h>
+
+// Linear probing with backward-shift deletion; key 0 is reserved
+typedef struct {
+    uint64_t* keys;
+    uint64_t* values;
+    uint64_t capacity;          // Power of two
+    uint64_t count;
+} AddressTable;
+
+// Function Prototypes
+void address_table_init(AddressTable* table);
+void address_table_free(AddressTable* table);
+int address_table_put(AddressTable* table, uint64_t key, uint64_t value);
+int address_table_get(const AddressTable* table, uint64_t key, uint64_t* value);
+int address_table_take(AddressTable* table, uint64_t key, uint64_t* value);
+
+#endif // ADDRESS_TABLE_H
@@ -0,0 +1,323 @@
+/**
+ * extent_tree.c
+ * Balanced ordered map of extents implementation
+ *
+ * A treap keyed by (key, tie) where every node also carries the largest
+ * length found in its subtree. Ordered by address it answers "lowest
+ * extent of at least n bytes" in O(log n); ordered by (length, address)
+ * it answers best fit with a plain lower bound.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "extent_tree.h"
+
+#define EXTENT_CHUNK_NODES 4096
+
+typedef struct ExtentChunk {
+    struct ExtentChunk* next;
+    ExtentNode nodes[EXTENT_CHUNK_NODES];
+} ExtentChunk;
+
+// ==================== NODE POOL ====================
+
+static uint32_t next_priority(ExtentTree* tree) {
+    uint32_t x = tree->seed;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    tree->seed = x;
+    return x;
+}
+
+static ExtentNode* acquire_node(ExtentTree* tree) {
+    if(tree->spare == NULL) {
+        ExtentChunk* chunk = (ExtentChunk*)malloc(sizeof(ExtentChunk));
+        if(chunk == NULL) {
+            return NULL;
+        }
+        chunk->next = (ExtentChunk*)tree->chunks;
+        tree->chunks = chunk;
+        for(int i = 0; i < EXTENT_CHUNK_NODES; i++) {
+            chunk->nodes[i].left = tree->spare;
+            tree->spare = &chunk->nodes[i];
+        }
+    }
+
+    ExtentNode* node = tree->spare;
+    tree->spare = node->left;
+    return node;
+}
+
+static void release_node(ExtentTree* tree, ExtentNode* node) {
+    node->left = tree->spare;
+    tree->spare = node;
+}
+
+// Empty tree
+void extent_tree_init(ExtentTree* tree) {
+    memset(tree, 0, sizeof(ExtentTree));
+    tree->seed = 2463534242u;
+}
+
+// Release every node and pool chunk
+void extent_tree_free(ExtentTree* tree) {
+    ExtentChunk* chunk = (ExtentChunk*)tree->chunks;
+    while(chunk != NULL) {
+        ExtentChunk* next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    extent_tree_init(tree);
+}
+
+// ==================== TREAP OPERATIONS ====================
+
+static int compare_node(const ExtentNode* node, uint64_t key, uint64_t tie) {
+    if(node->key != key) {
+        return node->key < key ? -1 : 1;
+    }
+    if(node->tie != tie) {
+        return node->tie < tie ? -1 : 1;
+    }
+    return 0;
+}
+
+static void update_node(ExtentNode* node) {
+    uint64_t best = node->length;
+    if(node->left != NULL && node->left->max_length > best) {
+        best = node->left->max_length;
+    }
+    if(node->right != NULL && node->right->max_length > best) {
+        best = node->right->max_length;
+    }
+    node->max_length = best;
+}
+
+// Split into nodes below (key, tie) and nodes at or above it
+static void split_nodes(ExtentNode* node, uint64_t key, uint64_t tie,
+                        ExtentNode** below, ExtentNode** above) {
+    if(node == NULL) {
+        *below = NULL;
+        *above = NULL;
+        return;
+    }
+    if(compare_node(node, key, tie) < 0) {
+        split_nodes(node->right, key, tie, &node->right, above);
+        *below = node;
+    } else {
+        split_nodes(node->left, key, tie, below, &node->left);
+        *above = node;
+    }
+    update_node(node);
+}
+
+// Join two treaps where every node of low orders before every node of high
+static ExtentNode* merge_nodes(ExtentNode* low, ExtentNode* high) {
+    if(low == NULL) return high;
+    if(high == NULL) return low;
+
+    if(low->priority > high->priority) {
+        low->right = merge_nodes(low->right, high);
+        update_node(low);
+        return low;
+    }
+    high->left = merge_nodes(low, high->left);
+    update_node(high);
+    return high;
+}
+
+static ExtentNode* insert_node(ExtentNode* node, ExtentNode* fresh) {
+    if(node == NULL) {
+        return fresh;
+    }
+    if(fresh->priority > node->priority) {
+        split_nodes(node, fresh->key, fresh->tie, &fresh->left, &fresh->right);
+        update_node(fresh);
+        return fresh;
+    }
+    if(compare_node(node, fresh->key, fresh->tie) > 0) {
+        node->left = insert_node(node->left, fresh);
+    } else {
+        node->right = insert_node(node->right, fresh);
+    }
+    update_node(node);
+    return node;
+}
+
+static ExtentNode* remove_node(ExtentTree* tree, ExtentNode* node,
+                               uint64_t key, uint64_t tie, int* removed) {
+    if(node == NULL) {
+        return NULL;
+    }
+
+    int order = compare_node(node, key, tie);
+    if(order == 0) {
+        ExtentNode* joined = merge_nodes(node->left, node->right);
+        release_node(tree, node);
+        *removed = 1;
+        return joined;
+    }
+    if(order > 0) {
+        node->left = remove_node(tree, node->left, key, tie, removed);
+    } else {
+        node->right = remove_node(tree, node->right, key, tie, removed);
+    }
+    update_node(node);
+    return node;
+}
+
+// Add an extent; (key, tie) must not be present already
+int extent_tree_insert(ExtentTree* tree, uint64_t key, uint64_t tie, uint64_t length) {
+    ExtentNode* fresh = acquire_node(tree);
+    if(fresh == NULL) {
+        return -1;
+    }
+    fresh->key = key;
+    fresh->tie = tie;
+    fresh->length = length;
+    fresh->max_length = length;
+    fresh->priority = next_priority(tree);
+    fresh->left = NULL;
+    fresh->right = NULL;
+
+    tree->root = insert_node(tree->root, fresh);
+    tree->count++;
+    return 0;
+}
+
+// Remove an extent, returns 1 if it was present
+int extent_tree_remove(ExtentTree* tree, uint64_t key, uint64_t tie) {
+    int removed = 0;
+    tree->root = remove_node(tree, tree->root, key, tie, &removed);
+    tree->count -= removed;
+    return removed;
+}
+
+// ==================== QUERIES ====================
+
+// Exact (key, tie) lookup
+ExtentNode* extent_tree_find(ExtentTree* tree, uint64_t key, uint64_t tie) {
+    ExtentNode* node = tree->root;
+    while(node != NULL) {
+        tree->visits++;
+        int order = compare_node(node, key, tie);
+        if(order == 0) {
+            return node;
+        }
+        node = (order > 0) ? node->left : node->right;
+    }
+    return NULL;
+}
+
+// Smallest extent at or after (key, tie)
+ExtentNode* extent_tree_lower_bound(ExtentTree* tree, uint64_t key, uint64_t tie) {
+    ExtentNode* node = tree->root;
+    ExtentNode* best = NULL;
+    while(node != NULL) {
+        tree->visits++;
+        if(compare_node(node, key, tie) >= 0) {
+            best = node;
+            node = node->left;
+        } else {
+            node = node->right;
+        }
+    }
+    return best;
+}
+
+// Largest extent whose key is at most key
+ExtentNode* extent_tree_floor(ExtentTree* tree, uint64_t key) {
+    ExtentNode* node = tree->root;
+    ExtentNode* best = NULL;
+    while(node != NULL) {
+        tree->visits++;
+        if(node->key <= key) {
+            best = node;
+            node = node->right;
+        } else {
+            node = node->left;
+        }
+    }
+    return best;
+}
+
+static ExtentNode* first_fit_below(ExtentTree* tree, ExtentNode* node, uint64_t min_length) {
+    while(node != NULL && node->max_length >= min_length) {
+        tree->visits++;
+        if(node->left != NULL && node->left->max_length >= min_length) {
+            node = node->left;
+        } else if(node->length >= min_length) {
+            return node;
+        } else {
+            node = node->right;
+        }
+    }
+    return NULL;
+}
+
+// Lowest-keyed extent of at least min_length
+ExtentNode* extent_tree_first_fit(ExtentTree* tree, uint64_t min_length) {
+    return first_fit_below(tree, tree->root, min_length);
+}
+
+static ExtentNode* first_fit_after(ExtentTree* tree, ExtentNode* node,
+                                   uint64_t key, uint64_t min_length) {
+    while(node != NULL && node->max_length >= min_length) {
+        tree->visits++;
+        if(node->key < key) {
+            node = node->right;
+            continue;
+        }
+        ExtentNode* found = first_fit_after(tree, node->left, key, min_length);
+        if(found != NULL) {
+            return found;
+        }
+        if(node->length >= min_length) {
+            return node;
+        }
+        return first_fit_below(tree, node->right, min_length);
+    }
+    return NULL;
+}
+
+// Lowest-keyed extent of at least min_length at or after key
+ExtentNode* extent_tree_first_fit_from(ExtentTree* tree, uint64_t key, uint64_t min_length) {
+    return first_fit_after(tree, tree->root, key, min_length);
+}
+
+// Lowest-keyed extent among the longest ones
+ExtentNode* extent_tree_largest(ExtentTree* tree) {
+    ExtentNode* node = tree->root;
+    while(node != NULL) {
+        tree->visits++;
+        if(node->left != NULL && node->left->max_length == node->max_length) {
+            node = node->left;
+        } else if(node->length == node->max_length) {
+            return node;
+        } else {
+            node = node->right;
+        }
+    }
+    return NULL;
+}
+
+// Smallest extent
+ExtentNode* extent_tree_min(ExtentTree* tree) {
+    ExtentNode* node = tree->root;
+    while(node != NULL && node->left != NULL) {
+        tree->visits++;
+        node = node->left;
+    }
+    return node;
+}
+
+// Largest extent
+ExtentNode* extent_tree_max(ExtentTree* tree) {
+    ExtentNode* node = tree->root;
+    while(node != NULL && node->right != NULL) {
+        tree->visits++;
+        node = node->right;
+    }
+    return node;
+}
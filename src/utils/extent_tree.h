@@ -0,0 +1,46 @@
+/**
+ * extent_tree.h
+ * Balanced ordered map of extents with a max-length augmentation
+ */
+
+#ifndef EXTENT_TREE_H
+#define EXTENT_TREE_H
+
+#include <stdint.h>
+
+// Treap node ordered by (key, tie); max_length covers the whole subtree
+typedef struct ExtentNode {
+    uint64_t key;
+    uint64_t tie;
+    uint64_t length;
+    uint64_t max_length;
+    uint32_t priority;
+    struct ExtentNode* left;
+    struct ExtentNode* right;
+} ExtentNode;
+
+// Nodes come from chunked pools and are recycled through a spare list
+typedef struct {
+    ExtentNode* root;
+    ExtentNode* spare;
+    void* chunks;
+    uint64_t count;
+    uint64_t visits;            // Nodes examined by queries, for cost accounting
+    uint32_t seed;
+} ExtentTree;
+
+// Function Prototypes
+void extent_tree_init(ExtentTree* tree);
+void extent_tree_free(ExtentTree* tree);
+int extent_tree_insert(ExtentTree* tree, uint64_t key, uint64_t tie, uint64_t length);
+int extent_tree_remove(ExtentTree* tree, uint64_t key, uint64_t tie);
+ExtentNode* extent_tree_find(ExtentTree* tree, uint64_t key, uint64_t tie);
+ExtentNode* extent_tree_lower_bound(ExtentTree* tree, uint64_t key, uint64_t tie);
+ExtentNode* extent_tree_floor(ExtentTree* tree, uint64_t key);
+ExtentNode* extent_tree_first_fit(ExtentTree* tree, uint64_t min_length);
+ExtentNode* extent_tree_first_fit_from(ExtentTree* tree, uint64_t key, uint64_t min_length);
+ExtentNode* extent_tree_largest(ExtentTree* tree);
+ExtentNode* extent_tree_min(ExtentTree* tree);
+ExtentNode* extent_tree_max(ExtentTree* tree);
+
+#endif // EXTENT_TREE_H
@@ -0,0 +1,125 @@
+/**
+ * hdr_histogram.c
+ * Log-linear latency histogram implementation
+ *
+ * Buckets follow the HdrHistogram layout: a value's bit length picks a
+ * power-of-two range and its top bits below the leading one pick a linear
+ * step inside it, so every bucket is narrower than 1/32 of the values it
+ * holds. Recording is a shift and an increment, two histograms merge by
+ * adding their counts, and a percentile is read back as the highest value
+ * its bucket could hold.
+ */
+
+#include <string.h>
+#include "hdr_histogram.h"
+
+#define HDR_MAX_VALUE ((1ULL << HDR_MAX_BITS) - 1)
+
+static int bit_length(uint64_t value) {
+    int bits = 0;
+    while(value > 0) {
+        value >>= 1;
+        bits++;
+    }
+    return bits;
+}
+
+static int bucket_of(uint64_t value) {
+    int shift = bit_length(value) - (HDR_SUB_BUCKET_BITS + 1);
+    if(shift < 0) {
+        shift = 0;
+    }
+    return shift * HDR_SUB_BUCKETS + (int)(value >> shift);
+}
+
+// Largest value that falls into a bucket
+static uint64_t bucket_high(int bucket) {
+    if(bucket < 2 * HDR_SUB_BUCKETS) {
+        return (uint64_t)bucket;
+    }
+    int shift = bucket / HDR_SUB_BUCKETS - 1;
+    uint64_t mantissa = (uint64_t)(bucket - shift * HDR_SUB_BUCKETS);
+    return ((mantissa + 1) << shift) - 1;
+}
+
+// Empty the histogram
+void hdr_reset(HdrHistogram* histogram) {
+    memset(histogram, 0, sizeof(HdrHistogram));
+}
+
+// Count one value; values past the range land in the last bucket
+void hdr_record(HdrHistogram* histogram, uint64_t value) {
+    if(value > HDR_MAX_VALUE) {
+        value = HDR_MAX_VALUE;
+    }
+    histogram->counts[bucket_of(value)]++;
+    if(histogram->samples == 0 || value < histogram->min) {
+        histogram->min = value;
+    }
+    if(value > histogram->max) {
+        histogram->max = value;
+    }
+    histogram->samples++;
+    histogram->sum += value;
+}
+
+// Add another histogram's counts
+void hdr_merge(HdrHistogram* into, const HdrHistogram* from) {
+    if(from->samples == 0) {
+        return;
+    }
+    for(int b = 0; b < HDR_BUCKETS; b++) {
+        into->counts[b] += from->counts[b];
+    }
+    if(into->samples == 0 || from->min < into->min) {
+        into->min = from->min;
+    }
+    if(from->max > into->max) {
+        into->max = from->max;
+    }
+    into->samples += from->samples;
+    into->sum += from->sum;
+}
+
+// Value at or below which the given share of samples fall
+uint64_t hdr_value_at_percentile(const HdrHistogram* histogram, double percentile) {
+    return hdr_value_at_rank(histogram, (uint64_t)(percentile / 100.0 * histogram->samples + 0.999999));
+}
+
+// Value of the rank-th smallest sample, counting from 1
+uint64_t hdr_value_at_rank(const HdrHistogram* histogram, uint64_t rank) {
+    if(histogram->samples == 0) {
+        return 0;
+    }
+    if(rank < 1) {
+        rank = 1;
+    }
+
+    uint64_t seen = 0;
+    for(int b = 0; b < HDR_BUCKETS; b++) {
+        seen += histogram->counts[b];
+        if(seen >= rank) {
+            uint64_t value = bucket_high(b);
+            if(value < histogram->min) {
+                return histogram->min;
+            }
+            return value < histogram->max ? value : histogram->max;
+        }
+    }
+    return histogram->max;
+}
+
+// Samples below a value; exact when the value starts a bucket, as every
+// power of two does
+uint64_t hdr_count_below(const HdrHistogram* histogram, uint64_t value) {
+    uint64_t below = 0;
+    for(int b = 0; b < HDR_BUCKETS && bucket_high(b) < value; b++) {
+        below += histogram->counts[b];
+    }
+    return below;
+}
+
+// Exact mean of the recorded values
+double hdr_mean(const HdrHistogram* histogram) {
+    return histogram->samples ? (double)histogram->sum / histogram->samples : 0.0;
+}
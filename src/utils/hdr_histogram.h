@@ -0,0 +1,35 @@
+/**
+ * hdr_histogram.h
+ * Log-linear latency histogram with bounded relative error
+ */
+
+#ifndef HDR_HISTOGRAM_H
+#define HDR_HISTOGRAM_H
+
+#include <stdint.h>
+
+#define HDR_SUB_BUCKET_BITS 5                               // 32 linear steps per power of two, under 3.2% error
+#define HDR_SUB_BUCKETS (1 << HDR_SUB_BUCKET_BITS)
+#define HDR_MAX_BITS 44                                     // Values up to 2^44 ns, about 4.9 hours
+#define HDR_BUCKETS ((HDR_MAX_BITS - HDR_SUB_BUCKET_BITS + 1) * HDR_SUB_BUCKETS)
+
+// Values below 2 * HDR_SUB_BUCKETS are counted exactly; above that each
+// power of two is split into HDR_SUB_BUCKETS equal steps
+typedef struct {
+    uint64_t counts[HDR_BUCKETS];
+    uint64_t samples;
+    uint64_t sum;
+    uint64_t min;
+    uint64_t max;
+} HdrHistogram;
+
+// Function Prototypes
+void hdr_reset(HdrHistogram* histogram);
+void hdr_record(HdrHistogram* histogram, uint64_t value);
+void hdr_merge(HdrHistogram* into, const HdrHistogram* from);
+uint64_t hdr_value_at_percentile(const HdrHistogram* histogram, double percentile);
+uint64_t hdr_value_at_rank(const HdrHistogram* histogram, uint64_t rank);
+uint64_t hdr_count_below(const HdrHistogram* histogram, uint64_t value);
+double hdr_mean(const HdrHistogram* histogram);
+
+#endif // HDR_HISTOGRAM_H
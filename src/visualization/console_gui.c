@@ -72,7 +72,11 @@ void display_paging_menu() {
     printf("2. Translate Logical Address\n");
     printf("3. Display Page Table\n");
     printf("4. Simulate Page Fault\n");
-    printf("5. Back to Main Menu\n");
+    printf("5. Compact Memory\n");
+    printf("6. Fork Process (Copy-on-Write)\n");
+    printf("7. Merge Identical Pages (KSM Scan)\n");
+    printf("8. Set Overcommit Policy\n");
+    printf("9. Back to Main Menu\n");
     printf("════════════════════════════════════════════════════════════\n");
 }
 
@@ -87,7 +91,9 @@ void display_segmentation_menu() {
     printf("2. Translate Segmented Address\n");
     printf("3. Display Segment Table\n");
     printf("4. Create New Segment\n");
-    printf("5. Back to Main Menu\n");
+    printf("5. Reverse Translate Physical Address\n");
+    printf("6. Translate with Paged Segmentation\n");
+    printf("7. Back to Main Menu\n");
     printf("════════════════════════════════════════════════════════════\n");
 }
 
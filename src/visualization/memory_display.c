@@ -11,6 +11,21 @@
 #include "memory_display.h"
 #include "../../include/common_defs.h"
 #include "../core/memory_manager.h"
+#include "../core/cow.h"
+
+// Distinct processes among a frame's mappings (at most MAX_PROCESSES)
+static int frame_process_count(int frame_id) {
+    bool seen[MAX_PROCESSES] = {false};
+    int count = 0;
+    for(int i = 0; i < frame_rmap[frame_id].count; i++) {
+        int pid = frame_rmap[frame_id].entries[i].pid;
+        if(pid >= 0 && pid < MAX_PROCESSES && !seen[pid]) {
+            seen[pid] = true;
+            count++;
+        }
+    }
+    return count;
+}
 
 // Display memory as a map
 void display_memory_map() {
@@ -30,6 +45,16 @@ void display_memory_map() {
                 printf("Frame %2d: ", frame_idx);
                 if(physical_memory[frame_idx].is_free) {
                     printf("[  FREE  ]  ");
+                } else if(is_frame_reserved(frame_idx)) {
+                    printf("[ BLOCK  ]  ");
+                } else if(physical_memory[frame_idx].ref_count == 0) {
+                    printf("[ CACHE  ]  ");
+                } else if(frame_process_count(frame_idx) > 1) {
+                    printf("[SHARED%d ]  ", frame_process_count(frame_idx));
+                } else if(physical_memory[frame_idx].ref_count > 1) {
+                    printf("[P%2d:%2dx]  ",
+                           physical_memory[frame_idx].process_id,
+                           physical_memory[frame_idx].ref_count);
                 } else {
                     printf("[P%2d:P%2d]  ",
                            physical_memory[frame_idx].process_id,
@@ -46,6 +71,10 @@ void display_memory_map() {
     
     printf("\nLegend: [Ppid:Ppg] = Process ID : Page Number\n");
     printf("       [  FREE  ]  = Available memory frame\n");
+    printf("       [ BLOCK  ]  = Part of a contiguous frame block\n");
+    printf("       [SHAREDn ]  = Frame mapped by n processes\n");
+    printf("       [Ppid:nx]   = Frame mapped by n pages of one process\n");
+    printf("       [ CACHE  ]  = Cached file page no process maps\n");
     
     // Show usage statistics
     int used_frames = 0;
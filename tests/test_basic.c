@@ -8,12 +8,25 @@
 #include <assert.h>
 #include "../include/common_defs.h"
 #include "../src/core/memory_manager.h"
+#include "../src/core/compaction.h"
+#include "../src/core/cow.h"
+#include "../src/core/page_cache.h"
+#include "../src/core/vma.h"
+#include "../src/core/latency.h"
+#include "../src/core/timeline.h"
 
 // Test function prototypes
 void test_memory_initialization();
 void test_page_allocation();
 void test_page_fault_simulation();
 void test_statistics();
+void test_contiguous_frames();
+void test_compaction();
+void test_cow_fork();
+void test_demand_zero();
+void test_page_cache();
+void test_vma();
+void test_latency_histograms();
 
 int main() {
     printf("Running Memory Management Visualizer Tests\n");
@@ -31,6 +44,27 @@ int main() {
     test_statistics();
     printf("\n");
     
+    test_contiguous_frames();
+    printf("\n");
+    
+    test_compaction();
+    printf("\n");
+    
+    test_cow_fork();
+    printf("\n");
+    
+    test_demand_zero();
+    printf("\n");
+    
+    test_page_cache();
+    printf("\n");
+    
+    test_vma();
+    printf("\n");
+    
+    test_latency_histograms();
+    printf("\n");
+    
     printf("✅ All tests passed!\n");
     return 0;
 }
@@ -120,3 +154,245 @@ void test_statistics() {
     printf("✓ Hit/fault ratios calculated\n");
     printf("✓ Process statistics tracked\n");
 }
+
+void test_contiguous_frames() {
+    printf("Test 5: Contiguous Frame Blocks\n");
+    printf("-------------------------------\n");
+    
+    int free_before = frame_buddy.free_frames;
+    
+    // Four aligned frames alongside the pages allocated above
+    int first = allocate_frame_block(2);
+    assert(first >= 0 && first % 4 == 0);
+    for(int i = first; i < first + 4; i++) {
+        assert(is_frame_reserved(i));
+    }
+    assert(frame_buddy.free_frames == free_before - 4);
+    
+    // Reserved frames are never chosen as replacement victims
+    int victim = reclaim_frame();
+    assert(victim < first || victim >= first + 4);
+    
+    assert(free_frame_block(first, 2) == 0);
+    for(int i = first; i < first + 4; i++) {
+        assert(physical_memory[i].is_free);
+    }
+    assert(free_frame_block(first, 2) == -1);
+    
+    printf("✓ Aligned block reserved and released\n");
+    printf("✓ Reserved frames skipped by replacement\n");
+}
+
+void test_compaction() {
+    printf("Test 6: Memory Compaction\n");
+    printf("-------------------------\n");
+    
+    init_memory_system();
+    int pid = create_process("CompactProcess");
+    
+    // Fill every frame, then free every other one
+    for(int page = 0; page < MAX_FRAMES; page++) {
+        assert(allocate_page(pid, page) == 0);
+    }
+    for(int page = 1; page < MAX_FRAMES; page += 2) {
+        assert(deallocate_page(pid, page) == 0);
+    }
+    assert(frame_buddy.free_blocks[2] == 0);
+    
+    compact_memory();
+    
+    // The free frames now form an aligned four-frame block
+    assert(compaction_stats.frame_moves > 0);
+    assert(frame_buddy.free_blocks[2] + frame_buddy.free_blocks[3] > 0);
+    
+    // Every page is still reachable through its page table
+    for(int page = 0; page < MAX_FRAMES; page += 2) {
+        int frame = processes[pid].page_table[page].frame_number;
+        assert(processes[pid].page_table[page].present);
+        assert(physical_memory[frame].process_id == pid);
+        assert(physical_memory[frame].page_number == page);
+    }
+    
+    printf("✓ Free frames merged into a contiguous block\n");
+    printf("✓ Page tables follow migrated pages\n");
+}
+
+void test_cow_fork() {
+    printf("Test 7: Copy-on-Write Fork\n");
+    printf("--------------------------\n");
+    
+    init_memory_system();
+    int parent = create_process("ForkParent");
+    for(int page = 0; page < 3; page++) {
+        assert(allocate_page(parent, page) == 0);
+    }
+    
+    // The child maps the parent's frames instead of copying them
+    int child = fork_process(parent);
+    assert(child >= 0);
+    int frame = processes[parent].page_table[1].frame_number;
+    assert(processes[child].page_table[1].present);
+    assert(processes[child].page_table[1].frame_number == frame);
+    assert(physical_memory[frame].ref_count == 2);
+    assert(cow_saved_pages() == 3);
+    
+    // A write by the child copies only the written page
+    access_memory_ex(child, 1 * PAGE_SIZE, true);
+    int copy = processes[child].page_table[1].frame_number;
+    assert(copy != frame);
+    assert(physical_memory[frame].ref_count == 1);
+    assert(physical_memory[frame].process_id == parent);
+    assert(physical_memory[copy].process_id == child);
+    assert(cow_stats.pages_copied == 1);
+    
+    // The parent keeps its pages when the child exits
+    terminate_process(child);
+    for(int page = 0; page < 3; page++) {
+        int f = processes[parent].page_table[page].frame_number;
+        assert(processes[parent].page_table[page].present);
+        assert(physical_memory[f].ref_count == 1);
+        assert(physical_memory[f].process_id == parent);
+    }
+    assert(cow_saved_pages() == 0);
+    
+    printf("✓ Fork shares frames with reference counts\n");
+    printf("✓ Write fault copies the shared page\n");
+    printf("✓ Parent pages survive the child's exit\n");
+}
+
+void test_demand_zero() {
+    printf("Test 8: Demand-Zero Pages\n");
+    printf("-------------------------\n");
+    
+    init_memory_system();
+    int pid = create_process("SparseProcess");
+    
+    // Reads of untouched pages share one frame
+    access_memory(pid, 0);
+    access_memory(pid, 5 * PAGE_SIZE);
+    int zero = processes[pid].page_table[0].frame_number;
+    assert(zero == zero_frame);
+    assert(processes[pid].page_table[5].frame_number == zero);
+    assert(physical_memory[zero].ref_count == 2);
+    
+    // A write gets a private frame, leaving the zero frame clean
+    char byte = 7;
+    assert(write_memory(pid, 5 * PAGE_SIZE, &byte, 1) != -1);
+    int frame = processes[pid].page_table[5].frame_number;
+    assert(frame != zero && frame_data[frame][0] == 7);
+    assert(frame_data[zero][0] == 0);
+    assert(physical_memory[zero].ref_count == 1);
+    
+    printf("✓ Reads map the shared zero frame\n");
+    printf("✓ First write allocates a private frame\n");
+}
+
+void test_page_cache() {
+    printf("Test 9: Page Cache and Readahead\n");
+    printf("--------------------------------\n");
+    
+    init_memory_system();
+    int file = file_create("test.bin", 8, 1);
+    int reader = create_process("Reader");
+    int other = create_process("OtherReader");
+    assert(mmap_file(reader, file, 0, 0, 8, false) == 0);
+    assert(mmap_file(other, file, 0, 0, 8, true) == 0);
+    
+    // A sequential miss reads ahead; the next page is then a hit
+    access_memory(reader, 0);
+    assert(page_cache_stats.misses == 1 && page_cache_stats.readahead_pages > 0);
+    access_memory(reader, PAGE_SIZE);
+    assert(page_cache_stats.hits == 1 && page_cache_stats.readahead_used == 1);
+    
+    // Both processes map the same cached frame
+    access_memory(other, 0);
+    int frame = processes[reader].page_table[0].frame_number;
+    assert(processes[other].page_table[0].frame_number == frame);
+    assert(page_cache_holds(frame) && physical_memory[frame].ref_count == 2);
+    
+    // A private write copies the page out of the cache
+    char byte = 7;
+    assert(write_memory(reader, 0, &byte, 1) != -1);
+    assert(processes[reader].page_table[0].frame_number != frame);
+    assert(page_cache_holds(frame) && physical_memory[frame].ref_count == 1);
+    
+    printf("✓ Sequential faults are served by readahead\n");
+    printf("✓ Processes share cached file pages\n");
+}
+
+void test_vma() {
+    printf("Test 10: Address Space Regions\n");
+    printf("------------------------------\n");
+    
+    init_memory_system();
+    int pid = create_process("Mapped");
+    MmStruct* mm = process_mm(pid);
+    assert(mm->count == 2);
+    
+    // mprotect in the middle of the heap splits it, undoing it merges it back
+    assert(mprotect_region(pid, 2, 2, VMA_READ) == 0);
+    assert(mm->count == 4);
+    assert(access_memory_ex(pid, 2 * PAGE_SIZE, true) == -1);
+    assert(access_memory_ex(pid, 2 * PAGE_SIZE, false) != -1);
+    assert(mprotect_region(pid, 2, 2, VMA_READ | VMA_WRITE) == 0);
+    assert(mm->count == 2);
+    
+    // An unmapped page faults; one just below the stack grows it
+    int stack = MAX_PAGES / 2;
+    assert(munmap_region(pid, stack - 4, 6) == 0);
+    assert(access_memory(pid, (stack - 4) * PAGE_SIZE) == -1);
+    assert(access_memory(pid, (stack + 1) * PAGE_SIZE) != -1);
+    assert(vma_find(mm, stack + 1)->start == (uint64_t)(stack + 1));
+    assert(vma_stats.segfaults == 1 && vma_stats.stack_expansions == 1);
+    
+    printf("✓ mprotect splits and merges regions\n");
+    printf("✓ Unmapped pages fault and the stack grows down\n");
+}
+
+void test_latency_histograms() {
+    printf("Test 11: Latency Histograms and Windows\n");
+    printf("---------------------------------------\n");
+    
+    // Small values are exact, large ones within one sub-bucket
+    static HdrHistogram low, high;
+    hdr_reset(&low);
+    hdr_reset(&high);
+    for(uint64_t v = 1; v <= 50; v++) {
+        hdr_record(&low, v);
+    }
+    for(int i = 0; i < 50; i++) {
+        hdr_record(&high, 10000000);
+    }
+    assert(hdr_value_at_percentile(&low, 50.0) == 25);
+    uint64_t p99 = hdr_value_at_percentile(&high, 99.0);
+    assert(p99 >= 10000000 && p99 <= 10000000 + 10000000 / HDR_SUB_BUCKETS);
+    
+    // Merging keeps every sample
+    hdr_merge(&low, &high);
+    assert(low.samples == 100 && low.min == 1 && low.max == 10000000);
+    assert(hdr_value_at_percentile(&low, 50.0) == 50);
+    assert(hdr_value_at_percentile(&low, 51.0) >= 10000000);
+    
+    // Per-process shards merge into the totals; windows split the references
+    init_memory_system();
+    timeline_interval = 4;
+    int a = create_process("A");
+    int b = create_process("B");
+    for(int i = 0; i < 6; i++) {
+        assert(access_memory(i % 2 ? b : a, 0) != -1);
+    }
+    static LatencyAccount total;
+    latency_totals(&total);
+    assert(total.references == 6 && total.fault.samples == 2);
+    assert(latency_process[a].references == 3 && latency_process[b].references == 3);
+    assert(total.total_ns == latency_process[a].total_ns + latency_process[b].total_ns);
+    
+    StatsWindow windows[TIMELINE_WINDOWS];
+    assert(timeline_windows(windows, TIMELINE_WINDOWS) == 2);
+    assert(windows[0].references == 4 && windows[0].faults == 2);
+    assert(windows[1].references == 2 && windows[1].faults == 0);
+    timeline_interval = TIMELINE_DEFAULT_INTERVAL;
+    
+    printf("✓ Histograms merge with bounded error\n");
+    printf("✓ Shards and windows account every reference\n");
+}
@@ -0,0 +1,167 @@
+/**
+ * test_trace.c
+ * Binary trace format and heap event stream round-trip tests
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "../include/common_defs.h"
+#include "../src/trace/trace_binary.h"
+#include "../src/allocators/heap_sim.h"
+#include "../src/shim/heap_shim.h"
+
+#define TEST_TRACE_PATH "test_trace.dmvt"
+#define TEST_RECORDS 10000
+#define TEST_BLOCK_RECORDS 1000
+#define TEST_EVENTS_PATH "test_heap_events.bin"
+
+// Test function prototypes
+void test_round_trip();
+void test_corrupt_block();
+void test_heap_event_order();
+
+int main() {
+    printf("Running Binary Trace Tests\n");
+    printf("==========================\n\n");
+
+    test_round_trip();
+    printf("\n");
+
+    test_corrupt_block();
+    printf("\n");
+
+    test_heap_event_order();
+    printf("\n");
+
+    remove(TEST_TRACE_PATH);
+    remove(TEST_EVENTS_PATH);
+    printf("✅ All tests passed!\n");
+    return 0;
+}
+
+// Deterministic reference with forward, backward and far jumps
+static void make_reference(int i, MemoryReference* ref) {
+    unsigned long long page = (i % 7 == 0) ? 0x7ffff000ULL + i : (unsigned long long)(i % 50);
+    ref->address = page * PAGE_SIZE;
+    ref->timestamp = i;
+    ref->pid = (i / 300) % 3 == 0 ? 4242 : (i / 300) % 3;
+    ref->is_write = (i % 5) == 0;
+}
+
+void test_round_trip() {
+    printf("Test 1: Encode / Decode Round Trip\n");
+    printf("-----------------------------------\n");
+
+    TraceWriter* writer = trace_writer_open(TEST_TRACE_PATH, PAGE_SIZE, TEST_BLOCK_RECORDS);
+    assert(writer != NULL);
+    for(int i = 0; i < TEST_RECORDS; i++) {
+        MemoryReference ref;
+        make_reference(i, &ref);
+        assert(trace_writer_append(writer, &ref) == 0);
+    }
+    assert(trace_writer_close(writer) == 0);
+    printf("✓ Wrote %d references\n", TEST_RECORDS);
+
+    TraceBinaryReader* reader = trace_binary_open(TEST_TRACE_PATH);
+    assert(reader != NULL);
+    assert(reader->header.record_count == TEST_RECORDS);
+    assert(reader->header.block_count == TEST_RECORDS / TEST_BLOCK_RECORDS);
+    assert(reader->header.pid_count == 3);
+    printf("✓ Header records count, blocks and pid table\n");
+
+    MemoryReference refs[TEST_BLOCK_RECORDS];
+    int checked = 0;
+    for(uint64_t b = reader->header.block_count; b-- > 0; ) {
+        // Blocks decode independently, so read them back to front
+        int count = trace_binary_read_block(reader, b, refs);
+        assert(count == TEST_BLOCK_RECORDS);
+        for(int i = 0; i < count; i++) {
+            MemoryReference expected;
+            make_reference((int)reader->index[b].first_record + i, &expected);
+            assert(refs[i].address == expected.address);
+            assert(refs[i].timestamp == expected.timestamp);
+            assert(refs[i].pid == expected.pid);
+            assert(refs[i].is_write == expected.is_write);
+            checked++;
+        }
+    }
+    assert(checked == TEST_RECORDS);
+    printf("✓ All references decoded identically\n");
+
+    trace_binary_close(reader);
+}
+
+void test_corrupt_block() {
+    printf("Test 2: Truncated Block Detection\n");
+    printf("----------------------------------\n");
+
+    TraceBinaryReader* reader = trace_binary_open(TEST_TRACE_PATH);
+    assert(reader != NULL);
+
+    MemoryReference refs[TEST_BLOCK_RECORDS];
+    TraceBlockIndex* entry = &reader->index[0];
+    assert(trace_binary_read_block(reader, 0, refs) == TEST_BLOCK_RECORDS);
+    assert(trace_binary_decode_block(reader->block_buffer, entry->length / 2,
+                                     entry->record_count, &reader->header,
+                                     reader->pids, 0, refs) == -1);
+    printf("✓ Truncated block rejected\n");
+
+    trace_binary_close(reader);
+}
+
+static HeapEvent make_event(uint64_t sequence, uint32_t type, uint64_t address, uint64_t size,
+                            uint32_t thread) {
+    HeapEvent event;
+    memset(&event, 0, sizeof(event));
+    event.sequence = sequence;
+    event.timestamp_ns = 1000 + sequence;
+    event.address = address;
+    event.size = size;
+    event.thread = thread;
+    event.type = type;
+    return event;
+}
+
+void test_heap_event_order() {
+    printf("Test 3: Heap Event Stream Order\n");
+    printf("-------------------------------\n");
+
+    // As the shim can write them: a cross-thread free lands a batch ahead
+    // of the malloc it releases
+    HeapEvent events[] = {
+        make_event(1, HEAP_EVENT_MEMALIGN, 0x2000, 64, 2),
+        make_event(2, HEAP_EVENT_FREE, 0x1000, 0, 2),
+        make_event(0, HEAP_EVENT_MALLOC, 0x1000, 32, 1),
+        make_event(4, HEAP_EVENT_DROPPED, 0, 3, 0),
+        make_event(3, HEAP_EVENT_FREE, 0x2000, 0, 1),
+    };
+    HeapEventHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, HEAP_EVENT_MAGIC, 4);
+    header.version = HEAP_EVENT_VERSION;
+    header.pid = 4242;
+    header.event_size = sizeof(HeapEvent);
+
+    FILE* file = fopen(TEST_EVENTS_PATH, "wb");
+    assert(file != NULL);
+    assert(fwrite(&header, sizeof(header), 1, file) == 1);
+    assert(fwrite(events, sizeof(events), 1, file) == 1);
+    fclose(file);
+
+    HeapTrace trace;
+    assert(heap_trace_from_events(&trace, TEST_EVENTS_PATH) == 0);
+    assert(trace.ids == 2);
+    assert(trace.count == 4);
+    assert(trace.ops[0].id == 0 && trace.ops[0].size == 32);
+    assert(trace.ops[1].id == 1 && trace.ops[1].size == 64);
+    assert(trace.ops[2].id == 0 && trace.ops[2].size == 0);
+    assert(trace.ops[3].id == 1 && trace.ops[3].size == 0);
+    printf("✓ Events applied in sequence order, aligned allocations included\n");
+
+    assert(trace.dropped == 3);
+    printf("✓ Dropped events counted\n");
+
+    heap_trace_free(&trace);
+}